@@ -103,7 +103,8 @@ namespace
     row_to_string(const DataRow& row)
     {
         std::ostringstream out;
-        out << "row{id=" << row.id << ", flags=" << static_cast<int>(row.flags) << ", tokens=[";
+        out << "row{id=" << row.id << ", flags=" << static_cast<int>(row.flags)
+            << ", created_by=" << row.created_by << ", deleted_by=" << row.deleted_by << ", tokens=[";
 
         for (size_t i = 0; i < row.tokens.size(); ++i)
         {
@@ -269,14 +270,14 @@ main(int argc, char** argv)
                 std::cout << "path=" << page.path.string() << "\n";
                 std::cout << "min_rid=" << page.min_rid
                           << " max_rid=" << page.max_rid
-                          << " rows_count=" << page.rows_count
-                          << " rows_in_vector=" << page.rows.size()
+                          << " slots=" << page.slot_count
+                          << " rows_start=" << page.rows_start
                           << " size=" << page.size
                           << " last_lsn=" << page.last_lsn << "\n";
 
-                for (const auto& row : page.rows)
+                for (size_t slot = 0; slot < page.slot_count; ++slot)
                 {
-                    std::cout << "  " << row_to_string(row) << "\n";
+                    std::cout << "  " << row_to_string(page.row(slot).to_row()) << "\n";
                     rows_printed += 1;
                 }
 
@@ -273,19 +273,27 @@ main(int argc, char** argv)
                           << " table=" << table.name
                           << " root_page=" << index_file->root_page
                           << " last_page=" << index_file->last_page
-                          << " pages=" << index_file->pages.size()
                           << " unique=" << (is_unique ? "true" : "false")
                           << "\n";
 
                 index_files_printed += 1;
 
-                for (const auto& page : index_file->pages)
+                for (IndexPageId page_id = 1; page_id <= index_file->last_page; ++page_id)
                 {
-                    if (args.page_id.has_value() && page.id != *args.page_id)
+                    if (args.page_id.has_value() && page_id != *args.page_id)
                         continue;
 
+                    const auto stored_page = io->read_index_page(index_id, page_id);
+                    if (!stored_page)
+                    {
+                        std::cout << "  PAGE id=" << page_id << " <not written>\n";
+                        continue;
+                    }
+
+                    const auto& page = *stored_page;
                     std::cout << "  PAGE id=" << page.id
                               << " parent=" << page.parent
+                              << " last_lsn=" << page.last_lsn
                               << " type=" << (page.is_leaf ? "leaf" : "internal") << "\n";
 
                     pages_printed += 1;
@@ -0,0 +1,231 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "config.hpp"
+#include "convert.hpp"
+#include "db_instance_registry.hpp"
+#include "engine.hpp"
+#include "path.hpp"
+#include "static_storage.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Measures how the storage instance holds up under concurrent sessions. Every thread
+// works on a table of its own: even threads scan theirs whole, odd threads insert
+// batches into theirs. Run it with growing --threads to see throughput scale with
+// cores, and compare the insert latencies with and without scanners running.
+namespace
+{
+    using namespace types;
+    using Clock = std::chrono::steady_clock;
+
+    struct Args
+    {
+        std::string db_name;
+        size_t threads = 2;
+        size_t rows = 20000;
+        size_t batch = 100;
+        uint32_t seconds = 5;
+    };
+
+    struct WorkerStats
+    {
+        uint64_t rows_scanned = 0;
+        uint64_t rows_inserted = 0;
+        std::vector<Clock::duration> insert_latencies;
+    };
+
+    Args
+    parse_args(int argc, char** argv)
+    {
+        if (argc < 2)
+            throw std::runtime_error(
+                "Usage: latch_bench.exe <scratch_db_name> [--threads <n>] [--rows <n>] "
+                "[--batch <n>] [--seconds <n>]"
+            );
+
+        Args args;
+        args.db_name = argv[1];
+
+        for (int i = 2; i < argc; ++i)
+        {
+            std::string opt = argv[i];
+            if (i + 1 >= argc)
+                throw std::runtime_error(opt + " requires a value");
+
+            const auto value = std::stoull(argv[++i]);
+            if (opt == "--threads")
+                args.threads = value;
+            else if (opt == "--rows")
+                args.rows = value;
+            else if (opt == "--batch")
+                args.batch = value;
+            else if (opt == "--seconds")
+                args.seconds = static_cast<uint32_t>(value);
+            else
+                throw std::runtime_error("Unknown argument: " + opt);
+        }
+
+        if (args.threads == 0 || args.batch == 0)
+            throw std::runtime_error("--threads and --batch must be positive");
+
+        return args;
+    }
+
+    std::vector<std::vector<DataToken>>
+    make_rows(size_t first_id, size_t count)
+    {
+        std::vector<std::vector<DataToken>> rows;
+        rows.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto id = static_cast<int32_t>(first_id + i);
+            rows.push_back(
+                {DataToken(misc::convert(id), DataType::INTEGER),
+                 DataToken(misc::convert("payload_" + std::to_string(id)), DataType::STRING)}
+            );
+        }
+        return rows;
+    }
+
+    double
+    to_us(Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+    try
+    {
+        auto args = parse_args(argc, argv);
+
+        misc::StaticStorage::set_executable_path(std::filesystem::absolute(argv[0]).parent_path());
+
+        auto cfg = Config::std(args.db_name);
+        const auto db_dir = storage::path_db(cfg.db_path, args.db_name);
+        if (std::filesystem::exists(db_dir))
+            throw std::runtime_error("Database directory already exists: " + db_dir.string());
+
+        {
+            engine::Engine engine;
+            engine.create_db(cfg);
+            for (size_t t = 0; t < args.threads; ++t)
+                engine.execute_query(
+                    "create table common.t" + std::to_string(t) + "(id integer, payload string)"
+                );
+        }
+
+        std::vector<WorkerStats> stats(args.threads);
+        Clock::duration elapsed{};
+        {
+            // Closed at the end of the scope, as the last reference to it goes.
+            auto instance = storage::DbInstanceRegistry::shared()->acquire(cfg);
+
+            // Scanned tables get their rows up front; inserted ones start empty.
+            for (size_t t = 0; t < args.threads; t += 2)
+            {
+                auto txn = instance->make_txn();
+                txn.begin();
+                instance->insert_rows(
+                    "t" + std::to_string(t), "common", std::nullopt, make_rows(0, args.rows), txn
+                );
+                txn.commit();
+            }
+
+            std::atomic<bool> go = false;
+            std::atomic<bool> stop = false;
+            std::vector<std::thread> workers;
+            workers.reserve(args.threads);
+
+            for (size_t t = 0; t < args.threads; ++t)
+            {
+                workers.emplace_back(
+                    [&, t]
+                    {
+                        const auto table = "t" + std::to_string(t);
+                        auto& own = stats[t];
+
+                        while (!go.load(std::memory_order_acquire))
+                            std::this_thread::yield();
+
+                        if (t % 2 == 0)
+                        {
+                            while (!stop.load(std::memory_order_acquire))
+                                own.rows_scanned += instance->seq_scan(table, "common").rows.size();
+                            return;
+                        }
+
+                        // One transaction for the whole run, so that commits do not turn
+                        // the measurement into one of WAL flushes.
+                        auto txn = instance->make_txn();
+                        txn.begin();
+                        while (!stop.load(std::memory_order_acquire))
+                        {
+                            auto rows = make_rows(own.rows_inserted, args.batch);
+                            const auto start = Clock::now();
+                            instance->insert_rows(table, "common", std::nullopt, std::move(rows), txn);
+                            own.insert_latencies.push_back(Clock::now() - start);
+                            own.rows_inserted += args.batch;
+                        }
+                        txn.commit();
+                    }
+                );
+            }
+
+            const auto start = Clock::now();
+            go.store(true, std::memory_order_release);
+            std::this_thread::sleep_for(std::chrono::seconds(args.seconds));
+            stop.store(true, std::memory_order_release);
+            for (auto& worker : workers)
+                worker.join();
+            elapsed = Clock::now() - start;
+        }
+
+        std::filesystem::remove_all(db_dir);
+
+        uint64_t rows_scanned = 0;
+        uint64_t rows_inserted = 0;
+        std::vector<Clock::duration> latencies;
+        for (const auto& worker : stats)
+        {
+            rows_scanned += worker.rows_scanned;
+            rows_inserted += worker.rows_inserted;
+            latencies.insert(latencies.end(), worker.insert_latencies.begin(), worker.insert_latencies.end());
+        }
+        std::ranges::sort(latencies);
+
+        const auto percentile = [&](double p)
+        {
+            if (latencies.empty())
+                return 0.0;
+            return to_us(latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))]);
+        };
+
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        std::cout << "threads=" << args.threads << " seconds=" << seconds
+                  << " scanned_rows/sec=" << rows_scanned / seconds
+                  << " inserted_rows/sec=" << rows_inserted / seconds
+                  << " insert_us_p50=" << percentile(0.5) << " insert_us_p99=" << percentile(0.99)
+                  << " insert_us_max=" << percentile(1.0) << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "latch_bench: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
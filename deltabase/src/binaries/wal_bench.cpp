@@ -0,0 +1,171 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "config.hpp"
+#include "convert.hpp"
+#include "path.hpp"
+#include "static_storage.hpp"
+#include "wal_log.hpp"
+#include "wal_manager_factory.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Measures WAL commit throughput: every thread repeatedly appends a BEGIN/COMMIT pair
+// and waits until it is durable, which is the WAL work of a minimal transaction. With
+// --records, each transaction also logs that many row inserts, which measures how
+// appends from several threads scale.
+namespace
+{
+    using namespace types;
+
+    struct Args
+    {
+        std::string db_name;
+        size_t threads = 1;
+        size_t commits_per_thread = 1000;
+        uint32_t commit_delay_us = 0;
+        uint32_t group_commit_records = 64;
+        size_t records_per_commit = 0;
+    };
+
+    Args
+    parse_args(int argc, char** argv)
+    {
+        if (argc < 2)
+            throw std::runtime_error(
+                "Usage: wal_bench.exe <scratch_db_name> [--threads <n>] [--commits <n>] "
+                "[--delay-us <n>] [--batch <n>] [--records <n>]"
+            );
+
+        Args args;
+        args.db_name = argv[1];
+
+        for (int i = 2; i < argc; ++i)
+        {
+            std::string opt = argv[i];
+            if (i + 1 >= argc)
+                throw std::runtime_error(opt + " requires a value");
+
+            const auto value = std::stoull(argv[++i]);
+            if (opt == "--threads")
+                args.threads = value;
+            else if (opt == "--commits")
+                args.commits_per_thread = value;
+            else if (opt == "--delay-us")
+                args.commit_delay_us = static_cast<uint32_t>(value);
+            else if (opt == "--batch")
+                args.group_commit_records = static_cast<uint32_t>(value);
+            else if (opt == "--records")
+                args.records_per_commit = value;
+            else
+                throw std::runtime_error("Unknown argument: " + opt);
+        }
+
+        if (args.threads == 0)
+            throw std::runtime_error("--threads must be positive");
+
+        return args;
+    }
+
+    DataRow
+    make_row(RowId id)
+    {
+        DataRow row;
+        row.id = id;
+        row.tokens = {
+            DataToken(misc::convert(static_cast<int32_t>(id)), DataType::INTEGER),
+            DataToken(misc::convert("payload_" + std::to_string(id)), DataType::STRING)
+        };
+        return row;
+    }
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+    try
+    {
+        auto args = parse_args(argc, argv);
+
+        misc::StaticStorage::set_executable_path(std::filesystem::absolute(argv[0]).parent_path());
+
+        auto cfg = Config::std(args.db_name);
+        cfg.wal_commit_delay_us = args.commit_delay_us;
+        cfg.wal_group_commit_records = args.group_commit_records;
+
+        const auto db_dir = storage::path_db(cfg.db_path, args.db_name);
+        if (std::filesystem::exists(db_dir))
+            throw std::runtime_error("Database directory already exists: " + db_dir.string());
+
+        const size_t total_commits = args.threads * args.commits_per_thread;
+        const size_t total_records = total_commits * (args.records_per_commit + 2);
+        std::chrono::steady_clock::duration elapsed{};
+        {
+            wal::WalManagerFactory factory;
+            auto wal_manager = factory.make(cfg);
+
+            const auto table_id = UUID::make();
+            const auto page_id = UUID::make();
+            std::atomic<bool> go = false;
+            std::vector<std::thread> workers;
+            workers.reserve(args.threads);
+
+            for (size_t t = 0; t < args.threads; ++t)
+            {
+                workers.emplace_back(
+                    [&]
+                    {
+                        while (!go.load(std::memory_order_acquire))
+                            std::this_thread::yield();
+
+                        for (size_t i = 0; i < args.commits_per_thread; ++i)
+                        {
+                            const auto txn_id = UUID::make();
+                            LSN last_lsn = wal_manager->append_log(BeginTxnRecord(0, 0, txn_id));
+                            for (size_t r = 0; r < args.records_per_commit; ++r)
+                            {
+                                InsertRecord record(table_id, page_id, make_row(r));
+                                record.txn_id = txn_id;
+                                record.prev_lsn = last_lsn;
+                                last_lsn = wal_manager->append_log(record);
+                            }
+                            const LSN commit_lsn =
+                                wal_manager->append_log(CommitTxnRecord(0, last_lsn, txn_id));
+                            wal_manager->wait_for_durable(commit_lsn);
+                        }
+                    }
+                );
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            go.store(true, std::memory_order_release);
+            for (auto& worker : workers)
+                worker.join();
+            elapsed = std::chrono::steady_clock::now() - start;
+        }
+
+        std::filesystem::remove_all(db_dir);
+
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        std::cout << "threads=" << args.threads << " commits=" << total_commits
+                  << " delay_us=" << args.commit_delay_us << " seconds=" << seconds
+                  << " commits/sec=" << (seconds > 0 ? total_commits / seconds : 0)
+                  << " records/sec=" << (seconds > 0 ? total_records / seconds : 0) << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "wal_bench: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
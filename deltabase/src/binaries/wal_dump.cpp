@@ -90,7 +90,8 @@ namespace
     row_to_string(const DataRow& row)
     {
         std::ostringstream out;
-        out << "row{id=" << row.id << ", flags=" << static_cast<int>(row.flags) << ", tokens=[";
+        out << "row{id=" << row.id << ", flags=" << static_cast<int>(row.flags)
+            << ", created_by=" << row.created_by << ", deleted_by=" << row.deleted_by << ", tokens=[";
         for (size_t i = 0; i < row.tokens.size(); ++i)
         {
             if (i != 0)
@@ -208,6 +209,18 @@ namespace
             return "CREATE_INDEX";
         case WALRecordType::CLR_CREATE_INDEX:
             return "CLR_CREATE_INDEX";
+        case WALRecordType::CHECKPOINT:
+            return "CHECKPOINT";
+        case WALRecordType::TABLE_COUNTERS:
+            return "TABLE_COUNTERS";
+        case WALRecordType::CLR_TABLE_COUNTERS:
+            return "CLR_TABLE_COUNTERS";
+        case WALRecordType::INSERT_ROWS:
+            return "INSERT_ROWS";
+        case WALRecordType::CLR_INSERT_ROWS:
+            return "CLR_INSERT_ROWS";
+        case WALRecordType::LINK_PAGE:
+            return "LINK_PAGE";
         default:
             return "UNKNOWN";
         }
@@ -270,34 +283,17 @@ main(int argc, char** argv)
         wal::WalManagerFactory factory;
         auto wal_manager = factory.make(cfg);
 
-        auto records = wal_manager->read_all_logs();
-        std::sort(
-            records.begin(),
-            records.end(),
-            [](const types::WALRecord& lhs, const types::WALRecord& rhs)
-            {
-                return std::visit([](const auto& r) { return r.lsn; }, lhs)
-                    < std::visit([](const auto& r) { return r.lsn; }, rhs);
-            }
-        );
+        auto records = wal_manager->iterate(args.from_lsn.value_or(0));
 
         std::map<std::string, size_t> counts;
 
-        for (const auto& record : records)
+        types::WALRecord record;
+        while (records->next(record))
         {
-            bool in_range = std::visit(
-                [&](const auto& r)
-                {
-                    if (args.from_lsn.has_value() && r.lsn < *args.from_lsn)
-                        return false;
-                    if (args.to_lsn.has_value() && r.lsn > *args.to_lsn)
-                        return false;
-                    return true;
-                },
-                record
-            );
-            if (!in_range)
-                continue;
+            // Records arrive in LSN order, so nothing past the upper bound can follow.
+            const LSN lsn = std::visit([](const auto& r) { return r.lsn; }, record);
+            if (args.to_lsn.has_value() && lsn > *args.to_lsn)
+                break;
 
             std::visit(
                 [&](const auto& r)
@@ -316,6 +312,15 @@ main(int argc, char** argv)
                                   << " page=" << r.page_id.to_string()
                                   << " after=" << row_to_string(r.after);
                     }
+                    else if constexpr (std::is_same_v<R, InsertRowsRecord>)
+                    {
+                        std::cout << " table=" << r.table_id.to_string()
+                                  << " page=" << r.page_id.to_string()
+                                  << " rows=" << r.after.size();
+                        if (!r.after.empty())
+                            std::cout << " ids=" << r.after.front().id << ".."
+                                      << r.after.back().id;
+                    }
                     else if constexpr (std::is_same_v<R, UpdateRecord>)
                     {
                         std::cout << " table=" << r.table_id.to_string()
@@ -336,6 +341,13 @@ main(int argc, char** argv)
                                   << " undo_next=" << r.undo_next_lsn
                                   << " after=" << row_to_string(r.after);
                     }
+                    else if constexpr (std::is_same_v<R, CLRInsertRowsRecord>)
+                    {
+                        std::cout << " table=" << r.table_id.to_string()
+                                  << " page=" << r.page_id.to_string()
+                                  << " undo_next=" << r.undo_next_lsn
+                                  << " rows=" << r.row_ids.size();
+                    }
                     else if constexpr (std::is_same_v<R, CLRUpdateRecord>)
                     {
                         std::cout << " table=" << r.table_id.to_string()
@@ -418,6 +430,40 @@ main(int argc, char** argv)
                         std::cout << " undo_next=" << r.undo_next_lsn
                                   << " after=" << index_to_string(r.after);
                     }
+                    else if constexpr (std::is_same_v<R, TableCountersRecord>)
+                    {
+                        std::cout << " table=" << r.table_id.to_string()
+                                  << " last_rid=" << r.last_rid
+                                  << " total=" << r.total_rows << " (" << std::showpos
+                                  << r.total_rows_delta << std::noshowpos << ")"
+                                  << " live=" << r.live_rows << " (" << std::showpos
+                                  << r.live_rows_delta << std::noshowpos << ")";
+                    }
+                    else if constexpr (std::is_same_v<R, CLRTableCountersRecord>)
+                    {
+                        std::cout << " undo_next=" << r.undo_next_lsn
+                                  << " table=" << r.table_id.to_string()
+                                  << " total=" << r.total_rows
+                                  << " live=" << r.live_rows;
+                    }
+                    else if constexpr (std::is_same_v<R, LinkPageRecord>)
+                    {
+                        std::cout << " table=" << r.table_id.to_string()
+                                  << " page=" << r.page_id.to_string()
+                                  << " next=" << r.next_page_id.to_string();
+                    }
+                    else if constexpr (std::is_same_v<R, CheckpointRecord>)
+                    {
+                        std::cout << " redo=" << r.redo_lsn << " active=[";
+                        for (size_t i = 0; i < r.active_txns.size(); ++i)
+                        {
+                            if (i != 0)
+                                std::cout << ", ";
+                            std::cout << r.active_txns[i].first.to_string() << "@"
+                                      << r.active_txns[i].second;
+                        }
+                        std::cout << "] dirty_pages=" << r.dirty_pages.size();
+                    }
 
                     std::cout << "\n";
                 },
@@ -10,6 +10,7 @@
 #include "static_storage.hpp"
 
 #include "../misc/include/memory_stream.hpp"
+#include "../storage/include/db_instance_registry.hpp"
 #include "../storage/include/file_utils.hpp"
 #include "../storage/include/path.hpp"
 #include "../storage/include/std_db_instance.hpp"
@@ -47,9 +48,22 @@ namespace engine
         set_db_instance(std::move(db));
     }
 
+    Engine::~Engine()
+    {
+        try
+        {
+            rollback_open_txn();
+        }
+        catch (...)
+        {
+            // Left in progress; the next recovery of the database undoes it.
+        }
+    }
+
     void
-    Engine::set_db_instance(std::unique_ptr<IDbInstance> db)
+    Engine::set_db_instance(std::shared_ptr<IDbInstance> db)
     {
+        rollback_open_txn();
         db_ = std::move(db);
 
         if (!db_)
@@ -77,20 +91,21 @@ namespace engine
     Engine::attach_db(const std::string& db_name)
     {
         auto cfg = load_config(db_name, StaticStorage::get_executable_path());
-        auto db = std::make_unique<StdDbInstance>(cfg);
+        auto db = DbInstanceRegistry::shared()->acquire(cfg);
         set_db_instance(std::move(db));
     }
 
     void
     Engine::create_db(const Config& config)
     {
-        auto db = std::make_unique<StdDbInstance>(config);
+        auto db = DbInstanceRegistry::shared()->acquire(config);
         set_db_instance(std::move(db));
     }
 
     void
     Engine::detach_db()
     {
+        rollback_open_txn();
         planner_.reset();
         db_.reset();
         analyzer_.reset();
@@ -105,21 +120,26 @@ namespace engine
         parser_.set_tokens(tokens);
         auto ast = parser_.parse();
 
+        if (ast.type == AstNodeType::BEGIN || ast.type == AstNodeType::COMMIT ||
+            ast.type == AstNodeType::ROLLBACK)
+            return execute_txn_control(ast.type);
+
         auto analysis = analyzer_->analyze(ast);
         if (!analysis.is_valid)
             throw *analysis.err;
 
         auto plan = planner_->plan(std::move(ast));
 
-        auto executor = executor_factory_.from_plan(std::move(plan.root), *db_);
+        auto executor =
+            executor_factory_.from_plan(std::move(plan.root), *db_, txn_ ? &*txn_ : nullptr);
 
+        executor->open();
         if (plan.needs_stream)
             return std::make_unique<StreamedResult>(std::move(executor));
 
         DataTable result_table;
         DataRow row;
 
-        executor->open();
         while (executor->next(row))
             result_table.rows.push_back(row);
         executor->close();
@@ -127,4 +147,42 @@ namespace engine
 
         return std::make_unique<MaterializedResult>(std::move(result_table));
     }
+
+    std::unique_ptr<IExecutionResult>
+    Engine::execute_txn_control(AstNodeType statement)
+    {
+        if (statement == AstNodeType::BEGIN)
+        {
+            if (txn_)
+                throw std::runtime_error("Engine::execute_txn_control: a transaction is already open");
+
+            auto txn = db_->make_txn();
+            txn.begin();
+            txn_.emplace(std::move(txn));
+        }
+        else
+        {
+            if (!txn_)
+                throw std::runtime_error("Engine::execute_txn_control: no transaction is open");
+
+            if (statement == AstNodeType::COMMIT)
+                txn_->commit();
+            else
+                txn_->rollback();
+
+            txn_.reset();
+        }
+
+        return std::make_unique<MaterializedResult>(DataTable{});
+    }
+
+    void
+    Engine::rollback_open_txn()
+    {
+        if (!txn_)
+            return;
+
+        txn_->rollback();
+        txn_.reset();
+    }
 } // namespace engine
\ No newline at end of file
@@ -14,6 +14,8 @@
 #include "../../executor/include/node_executor.hpp"
 #include "../../executor/include/planner.hpp"
 
+#include <optional>
+
 namespace engine
 {
     class Engine
@@ -21,7 +23,10 @@ namespace engine
         sql::SqlParser parser_;
         std::unique_ptr<exq::SemanticAnalyzer> analyzer_;
         std::unique_ptr<exq::IPlanner> planner_;
-        std::unique_ptr<storage::IDbInstance> db_;
+        std::shared_ptr<storage::IDbInstance> db_;
+        // The session's transaction, open from BEGIN to COMMIT or ROLLBACK. Statements
+        // run outside of one commit on their own.
+        std::optional<txn::Transaction> txn_;
         exq::NodeExecutorFactory executor_factory_;
         exq::PlannerFactory planner_factory_;
 
@@ -29,11 +34,20 @@ namespace engine
         load_config(const std::string& name, const std::filesystem::path& executable_path) const;
 
         void
-        set_db_instance(std::unique_ptr<storage::IDbInstance> db = nullptr);
+        set_db_instance(std::shared_ptr<storage::IDbInstance> db = nullptr);
+
+        std::unique_ptr<types::IExecutionResult>
+        execute_txn_control(types::AstNodeType statement);
+
+        // Rolls back the session's transaction, if one is open.
+        void
+        rollback_open_txn();
 
     public:
         Engine();
 
+        ~Engine();
+
         void
         attach_db(const std::string& db_name);
 
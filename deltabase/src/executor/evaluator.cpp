@@ -5,54 +5,95 @@
 #include "include/evaluator.hpp"
 
 #include <iostream>
+#include <stdexcept>
 
 namespace exq
 {
     using namespace types;
 
+    namespace
+    {
+        int64_t
+        column_of(const MetaTable& table, const SqlToken& identifier)
+        {
+            const int64_t col_idx = table.get_column_idx(identifier.value);
+            if (col_idx < 0)
+                throw std::runtime_error("Evaluator::bind: unknown column " + identifier.value);
+
+            return col_idx;
+        }
+    } // namespace
+
     Evaluator::Evaluator(const MetaTable& table) : table_(table)
     {
     }
 
-    bool
-    Evaluator::evaluate(const MetaTable& table, const DataRow& row, const BinaryExpr& expr) const
+    Evaluator::Predicate
+    Evaluator::bind(const MetaTable& table, const BinaryExpr& expr) const
     {
-        auto left = std::get<SqlToken>(expr.left->value);
-        auto right = std::get<SqlToken>(expr.right->value);
+        const auto& left = std::get<SqlToken>(expr.left->value);
+        const auto& right = std::get<SqlToken>(expr.right->value);
+
+        Predicate predicate;
+        predicate.op = expr.op;
 
         if (left.is_identifier() && right.is_literal())
         {
-            int64_t col_idx = table.get_column_idx(left);
-
-            DataToken left_value(row.tokens.at(col_idx));
-            DataToken right_literal(right);
-
-            return evaluate(left_value, right_literal, expr.op);
+            predicate.left_column = column_of(table, left);
+            predicate.right_literal = DataToken(right);
+            return predicate;
         }
         if (left.is_identifier() && right.is_identifier())
         {
-            int64_t left_col_idx = table_.get_column_idx(left);
-            int64_t right_col_idx = table_.get_column_idx(right);
-
-            DataToken left_value(row.tokens[left_col_idx]);
-            DataToken right_value(row.tokens[right_col_idx]);
-
-            return evaluate(left_value, right_value, expr.op);
+            predicate.left_column = column_of(table, left);
+            predicate.right_column = column_of(table, right);
+            return predicate;
         }
         if (left.is_literal() && right.is_literal())
         {
-            DataToken left_literal(left);
-            DataToken right_literal(right);
-
-            return evaluate(left_literal, right_literal, expr.op);
+            predicate.left_literal = DataToken(left);
+            predicate.right_literal = DataToken(right);
+            return predicate;
         }
 
-        throw std::runtime_error("Evaluator::evaluate: Invalid comparison");
+        throw std::runtime_error("Evaluator::bind: Invalid comparison");
+    }
+
+    bool
+    Evaluator::evaluate(const Predicate& predicate, const DataRow& row) const
+    {
+        const TokenView left = predicate.left_column < 0
+                                   ? TokenView(predicate.left_literal)
+                                   : TokenView(row.tokens.at(predicate.left_column));
+        const TokenView right = predicate.right_column < 0
+                                    ? TokenView(predicate.right_literal)
+                                    : TokenView(row.tokens.at(predicate.right_column));
+
+        return evaluate(left, right, predicate.op);
+    }
+
+    bool
+    Evaluator::evaluate(const Predicate& predicate, const RowView& row) const
+    {
+        const TokenView left = predicate.left_column < 0
+                                   ? TokenView(predicate.left_literal)
+                                   : row.token(predicate.left_column);
+        const TokenView right = predicate.right_column < 0
+                                    ? TokenView(predicate.right_literal)
+                                    : row.token(predicate.right_column);
+
+        return evaluate(left, right, predicate.op);
+    }
+
+    bool
+    Evaluator::evaluate(const MetaTable& table, const DataRow& row, const BinaryExpr& expr) const
+    {
+        return evaluate(bind(table, expr), row);
     }
 
     bool
-    Evaluator::evaluate(const DataToken& left,
-                        const DataToken& right,
+    Evaluator::evaluate(const TokenView& left,
+                        const TokenView& right,
                         AstOperator op) const
     {
         switch (op)
@@ -77,7 +118,7 @@ namespace exq
     }
 
     bool
-    Evaluator::eq(const DataToken& left, const DataToken& right) const
+    Evaluator::eq(const TokenView& left, const TokenView& right) const
     {
         if (left.type == DataType::_NULL || right.type == DataType::_NULL)
             return left.type == right.type;
@@ -92,19 +133,19 @@ namespace exq
         case DataType::_NULL:
             return true;
         case DataType::INTEGER:
-            return eq(left.as<int>(), right.as<int>());
+            return eq(left.as_int(), right.as_int());
 
         case DataType::REAL:
-            return eq(left.as<double>(), right.as<double>());
+            return eq(left.as_real(), right.as_real());
 
         case DataType::STRING:
-            return eq(left.as<std::string>(), right.as<std::string>());
+            return eq(left.as_string(), right.as_string());
 
         case DataType::BOOL:
-            return eq(left.as<bool>(), right.as<bool>());
+            return eq(left.as_bool(), right.as_bool());
 
         case DataType::CHAR:
-            return eq(left.as<char>(), right.as<char>());
+            return eq(left.as_char(), right.as_char());
 
         default:
             return false;
@@ -124,7 +165,7 @@ namespace exq
     }
 
     bool
-    Evaluator::eq(const std::string& left, const std::string& right) const
+    Evaluator::eq(std::string_view left, std::string_view right) const
     {
         return left == right;
     }
@@ -142,7 +183,7 @@ namespace exq
     }
 
     bool
-    Evaluator::lt(const DataToken& left, const DataToken& right) const
+    Evaluator::lt(const TokenView& left, const TokenView& right) const
     {
         if (left.type != right.type)
         {
@@ -154,16 +195,16 @@ namespace exq
         switch (left.type)
         {
         case DataType::INTEGER:
-            return lt(left.as<int>(), right.as<int>());
+            return lt(left.as_int(), right.as_int());
 
         case DataType::REAL:
-            return lt(left.as<double>(), right.as<double>());
+            return lt(left.as_real(), right.as_real());
 
         case DataType::STRING:
-            return lt(left.as<std::string>(), right.as<std::string>());
+            return lt(left.as_string(), right.as_string());
 
         case DataType::CHAR:
-            return lt(left.as<char>(), right.as<char>());
+            return lt(left.as_char(), right.as_char());
 
         default:
             return false;
@@ -183,7 +224,7 @@ namespace exq
     }
 
     bool
-    Evaluator::lt(const std::string& left, const std::string& right) const
+    Evaluator::lt(std::string_view left, std::string_view right) const
     {
         return left > right;
     }
@@ -195,7 +236,7 @@ namespace exq
     }
 
     bool
-    Evaluator::lte(const DataToken& left, const DataToken& right) const
+    Evaluator::lte(const TokenView& left, const TokenView& right) const
     {
         if (left.type != right.type)
         {
@@ -207,16 +248,16 @@ namespace exq
         switch (left.type)
         {
         case DataType::INTEGER:
-            return lte(left.as<int>(), right.as<int>());
+            return lte(left.as_int(), right.as_int());
 
         case DataType::REAL:
-            return lte(left.as<double>(), right.as<double>());
+            return lte(left.as_real(), right.as_real());
 
         case DataType::STRING:
-            return lte(left.as<std::string>(), right.as<std::string>());
+            return lte(left.as_string(), right.as_string());
 
         case DataType::CHAR:
-            return lte(left.as<char>(), right.as<char>());
+            return lte(left.as_char(), right.as_char());
 
         default:
             return false;
@@ -236,7 +277,7 @@ namespace exq
     }
 
     bool
-    Evaluator::lte(const std::string& left, const std::string& right) const
+    Evaluator::lte(std::string_view left, std::string_view right) const
     {
         return left >= right;
     }
@@ -248,7 +289,7 @@ namespace exq
     }
 
     bool
-    Evaluator::gr(const DataToken& left, const DataToken& right) const
+    Evaluator::gr(const TokenView& left, const TokenView& right) const
     {
         if (left.type != right.type)
         {
@@ -260,16 +301,16 @@ namespace exq
         switch (left.type)
         {
         case DataType::INTEGER:
-            return gr(left.as<int>(), right.as<int>());
+            return gr(left.as_int(), right.as_int());
 
         case DataType::REAL:
-            return gr(left.as<double>(), right.as<double>());
+            return gr(left.as_real(), right.as_real());
 
         case DataType::STRING:
-            return gr(left.as<std::string>(), right.as<std::string>());
+            return gr(left.as_string(), right.as_string());
 
         case DataType::CHAR:
-            return gr(left.as<char>(), right.as<char>());
+            return gr(left.as_char(), right.as_char());
 
         default:
             return false;
@@ -289,7 +330,7 @@ namespace exq
     }
 
     bool
-    Evaluator::gr(const std::string& left, const std::string& right) const
+    Evaluator::gr(std::string_view left, std::string_view right) const
     {
         return left > right;
     }
@@ -301,7 +342,7 @@ namespace exq
     }
 
     bool
-    Evaluator::gre(const DataToken& left, const DataToken& right) const
+    Evaluator::gre(const TokenView& left, const TokenView& right) const
     {
         if (left.type != right.type)
         {
@@ -313,16 +354,16 @@ namespace exq
         switch (left.type)
         {
         case DataType::INTEGER:
-            return gre(left.as<int>(), right.as<int>());
+            return gre(left.as_int(), right.as_int());
 
         case DataType::REAL:
-            return gre(left.as<double>(), right.as<double>());
+            return gre(left.as_real(), right.as_real());
 
         case DataType::STRING:
-            return gre(left.as<std::string>(), right.as<std::string>());
+            return gre(left.as_string(), right.as_string());
 
         case DataType::CHAR:
-            return gre(left.as<char>(), right.as<char>());
+            return gre(left.as_char(), right.as_char());
 
         default:
             return false;
@@ -342,7 +383,7 @@ namespace exq
     }
 
     bool
-    Evaluator::gre(const std::string& left, const std::string& right) const
+    Evaluator::gre(std::string_view left, std::string_view right) const
     {
         return left >= right;
     }
@@ -5,6 +5,7 @@
 #ifndef DELTABASE_EVALUATOR_HPP
 #define DELTABASE_EVALUATOR_HPP
 #include "../../types/include/data_row.hpp"
+#include "../../types/include/row_view.hpp"
 #include "meta_table.hpp"
 
 namespace exq
@@ -14,27 +15,27 @@ namespace exq
         const types::MetaTable table_;
 
         bool
-        evaluate(const types::DataToken& left,
-                 const types::DataToken& right,
+        evaluate(const types::TokenView& left,
+                 const types::TokenView& right,
                  types::AstOperator op) const;
 
         bool
-        eq(const types::DataToken& left, const types::DataToken& right) const;
+        eq(const types::TokenView& left, const types::TokenView& right) const;
         bool
-        lt(const types::DataToken& left, const types::DataToken& right) const;
+        lt(const types::TokenView& left, const types::TokenView& right) const;
         bool
-        lte(const types::DataToken& left, const types::DataToken& right) const;
+        lte(const types::TokenView& left, const types::TokenView& right) const;
         bool
-        gr(const types::DataToken& left, const types::DataToken& right) const;
+        gr(const types::TokenView& left, const types::TokenView& right) const;
         bool
-        gre(const types::DataToken& left, const types::DataToken& right) const;
+        gre(const types::TokenView& left, const types::TokenView& right) const;
 
         bool
         eq(int left, int right) const;
         bool
         eq(double left, double right) const;
         bool
-        eq(const std::string& left, const std::string& right) const;
+        eq(std::string_view left, std::string_view right) const;
         bool
         eq(char left, char right) const;
         bool
@@ -45,7 +46,7 @@ namespace exq
         bool
         lt(double left, double right) const;
         bool
-        lt(const std::string& left, const std::string& right) const;
+        lt(std::string_view left, std::string_view right) const;
         bool
         lt(char left, char right) const;
 
@@ -54,7 +55,7 @@ namespace exq
         bool
         lte(double left, double right) const;
         bool
-        lte(const std::string& left, const std::string& right) const;
+        lte(std::string_view left, std::string_view right) const;
         bool
         lte(char left, char right) const;
 
@@ -63,7 +64,7 @@ namespace exq
         bool
         gr(double left, double right) const;
         bool
-        gr(const std::string& left, const std::string& right) const;
+        gr(std::string_view left, std::string_view right) const;
         bool
         gr(char left, char right) const;
 
@@ -72,14 +73,35 @@ namespace exq
         bool
         gre(double left, double right) const;
         bool
-        gre(const std::string& left, const std::string& right) const;
+        gre(std::string_view left, std::string_view right) const;
         bool
         gre(char left, char right) const;
 
     public:
+        // A condition with its columns looked up and its literals converted once, so that
+        // testing a row neither allocates nor copies it.
+        struct Predicate
+        {
+            types::AstOperator op;
+            // Column to compare, or -1 to compare the literal.
+            int64_t left_column = -1;
+            int64_t right_column = -1;
+            types::DataToken left_literal;
+            types::DataToken right_literal;
+        };
+
         explicit
         Evaluator(const types::MetaTable& table);
 
+        Predicate
+        bind(const types::MetaTable& table, const types::BinaryExpr& expr) const;
+
+        bool
+        evaluate(const Predicate& predicate, const types::DataRow& row) const;
+
+        bool
+        evaluate(const Predicate& predicate, const types::RowView& row) const;
+
         bool
         evaluate(
             const types::MetaTable& table, const types::DataRow& row, const types::BinaryExpr& expr
@@ -36,14 +36,28 @@ namespace exq
         std::string table_name_;
         std::string schema_name_;
         storage::IDbInstance& db_;
+        // Reads as the session's transaction sees the table; nullptr outside of one
+        txn::Transaction* txn_;
 
         types::ScanCursor cursor_;
+        // Condition pushed down from a filter directly above the scan, empty if none
+        storage::RowFilter filter_;
 
     public:
         explicit SeqScanNodeExecutor(
             storage::IDbInstance& storage,
             const std::string& table_name,
-            const std::string& schema_name
+            const std::string& schema_name,
+            txn::Transaction* txn
+        );
+
+        explicit SeqScanNodeExecutor(
+            storage::IDbInstance& storage,
+            const std::string& table_name,
+            const std::string& schema_name,
+            const types::MetaTable& table,
+            const types::BinaryExpr& condition,
+            txn::Transaction* txn
         );
 
         void
@@ -66,6 +80,7 @@ namespace exq
         types::IndexId index_id_;
         types::BinaryExpr condition_;
         storage::IDbInstance& db_;
+        txn::Transaction* txn_;
 
         types::DataTable table_;
         uint64_t index_ = 0;
@@ -76,7 +91,8 @@ namespace exq
             const std::string& schema_name,
             const types::IndexId& index_id,
             types::BinaryExpr condition,
-            storage::IDbInstance& db
+            storage::IDbInstance& db,
+            txn::Transaction* txn
         );
 
         void
@@ -94,9 +110,8 @@ namespace exq
 
     class FilterNodeExecutor final : public INodeExecutor
     {
-        types::BinaryExpr condition_;
         Evaluator evaluator_;
-        const types::MetaTable table_;
+        Evaluator::Predicate predicate_;
         std::unique_ptr<INodeExecutor> child_;
 
     public:
@@ -170,11 +185,17 @@ namespace exq
 
     class InsertNodeExecutor final : public INodeExecutor
     {
+        // Rows handed to the instance per insert_rows call; bounds the memory held
+        // for a large INSERT ... VALUES or INSERT ... SELECT.
+        static constexpr size_t INSERT_BATCH_ROWS = 4096;
+
         std::string table_name_;
         std::string schema_name_;
         storage::IDbInstance& db_;
         std::optional<std::vector<std::string>> col_names_;
         std::unique_ptr<INodeExecutor> child_;
+        // Writes in the session's transaction; nullptr commits a transaction of its own
+        txn::Transaction* txn_;
         bool executed_ = false;
 
     public:
@@ -183,7 +204,8 @@ namespace exq
             const std::string& schema_name,
             storage::IDbInstance& storage,
             const std::optional<std::vector<std::string>>& col_names,
-            std::unique_ptr<INodeExecutor> child
+            std::unique_ptr<INodeExecutor> child,
+            txn::Transaction* txn
         );
 
         void
@@ -227,6 +249,7 @@ namespace exq
         storage::IDbInstance& db_;
         std::vector<types::Assignment> assignments_;
         std::unique_ptr<INodeExecutor> child_;
+        txn::Transaction* txn_;
         bool executed_;
 
     public:
@@ -235,7 +258,8 @@ namespace exq
             const std::string& schema_name,
             storage::IDbInstance& db,
             const std::vector<types::Assignment>& asg,
-            std::unique_ptr<INodeExecutor> child
+            std::unique_ptr<INodeExecutor> child,
+            txn::Transaction* txn
         );
 
         void
@@ -257,6 +281,7 @@ namespace exq
         std::string schema_name_;
         storage::IDbInstance& db_;
         std::unique_ptr<INodeExecutor> child_;
+        txn::Transaction* txn_;
         bool executed_;
 
     public:
@@ -264,7 +289,8 @@ namespace exq
             const std::string& table_name,
             const std::string& schema_name,
             storage::IDbInstance& db,
-            std::unique_ptr<INodeExecutor> child
+            std::unique_ptr<INodeExecutor> child,
+            txn::Transaction* txn
         );
 
         void
@@ -392,8 +418,14 @@ namespace exq
     class NodeExecutorFactory
     {
     public:
+        // Statements read and write in txn, the session's open transaction, if given.
+        // Without one each statement commits on its own. DDL always does.
         std::unique_ptr<INodeExecutor>
-        from_plan(std::unique_ptr<types::IPlanNode>&& node, storage::IDbInstance& db);
+        from_plan(
+            std::unique_ptr<types::IPlanNode>&& node,
+            storage::IDbInstance& db,
+            txn::Transaction* txn = nullptr
+        );
     };
 } // namespace exq
 
@@ -5,31 +5,124 @@
 #include "node_executor.hpp"
 
 #include "../misc/include/convert.hpp"
+#include "../storage/include/db_instance_registry.hpp"
 #include "../storage/include/std_db_instance.hpp"
 
 #include <algorithm>
+#include <optional>
 #include <ranges>
 
 namespace exq
 {
     using namespace types;
 
+    namespace
+    {
+        // The transaction a statement writes in: the session's if one is open, otherwise
+        // one of its own that commits with the statement.
+        // A statement that does not commit is undone when this goes out of scope: its own
+        // transaction entirely, or the session's back to where the statement started.
+        class StatementTxn
+        {
+            std::optional<txn::Transaction> own_;
+            txn::Transaction* txn_;
+            types::LSN savepoint_ = 0;
+            bool committed_ = false;
+
+        public:
+            StatementTxn(storage::IDbInstance& db, txn::Transaction* session) : txn_(session)
+            {
+                if (txn_)
+                {
+                    savepoint_ = txn_->get_last_lsn();
+                    return;
+                }
+
+                own_.emplace(db.make_txn());
+                own_->begin();
+                txn_ = &*own_;
+            }
+
+            StatementTxn(const StatementTxn&) = delete;
+            StatementTxn&
+            operator=(const StatementTxn&) = delete;
+
+            ~StatementTxn()
+            {
+                if (committed_)
+                    return;
+
+                try
+                {
+                    if (own_)
+                        own_->rollback();
+                    else
+                        txn_->rollback_to(savepoint_);
+                }
+                catch (...)
+                {
+                    // Whatever is left undone is undone again by recovery.
+                }
+            }
+
+            txn::Transaction&
+            get()
+            {
+                return *txn_;
+            }
+
+            // Leaves the session's transaction open.
+            void
+            commit()
+            {
+                if (own_)
+                    own_->commit();
+                committed_ = true;
+            }
+        };
+    } // namespace
+
+    SeqScanNodeExecutor::SeqScanNodeExecutor(
+        storage::IDbInstance& storage,
+        const std::string& table_name,
+        const std::string& schema_name,
+        txn::Transaction* txn
+    )
+        : table_name_(table_name), schema_name_(schema_name), db_(storage), txn_(txn), cursor_{}
+    {
+    }
+
     SeqScanNodeExecutor::SeqScanNodeExecutor(
-        storage::IDbInstance& storage, const std::string& table_name, const std::string& schema_name
+        storage::IDbInstance& storage,
+        const std::string& table_name,
+        const std::string& schema_name,
+        const MetaTable& table,
+        const BinaryExpr& condition,
+        txn::Transaction* txn
     )
-        : table_name_(table_name), schema_name_(schema_name), db_(storage), cursor_{}
+        : SeqScanNodeExecutor(storage, table_name, schema_name, txn)
     {
+        Evaluator evaluator(table);
+        auto predicate = evaluator.bind(table, condition);
+
+        filter_ = [evaluator = std::move(evaluator),
+                   predicate = std::move(predicate)](const RowView& row)
+        { return evaluator.evaluate(predicate, row); };
     }
 
     void
     SeqScanNodeExecutor::open()
     {
-        cursor_ = db_.seq_scan_begin(table_name_, schema_name_);
+        cursor_ = txn_ ? db_.seq_scan_begin(table_name_, schema_name_, *txn_)
+                       : db_.seq_scan_begin(table_name_, schema_name_);
     }
 
     bool
     SeqScanNodeExecutor::next(DataRow& out)
     {
+        if (filter_)
+            return db_.seq_scan_next(cursor_, out, filter_);
+
         return db_.seq_scan_next(cursor_, out);
     }
 
@@ -55,7 +148,7 @@ namespace exq
     FilterNodeExecutor::FilterNodeExecutor(
         const MetaTable& table, BinaryExpr&& condition, std::unique_ptr<INodeExecutor> child
     )
-        : condition_(std::move(condition)), evaluator_(table), table_(table),
+        : evaluator_(table), predicate_(evaluator_.bind(table, condition)),
           child_(std::move(child))
     {
     }
@@ -65,17 +158,19 @@ namespace exq
         const std::string& schema_name,
         const IndexId& index_id,
         BinaryExpr condition,
-        storage::IDbInstance& db
+        storage::IDbInstance& db,
+        txn::Transaction* txn
     )
-        : schema_name_(schema_name), index_id_(index_id), condition_(std::move(condition)),
-          db_(db), table_name_(table_name)
+        : table_name_(table_name), schema_name_(schema_name), index_id_(index_id),
+          condition_(std::move(condition)), db_(db), txn_(txn)
     {
     }
 
     void
     IndexScanNodeExecutor::open()
     {
-        table_ = db_.index_scan(table_name_, schema_name_, index_id_, condition_);
+        table_ = txn_ ? db_.index_scan(table_name_, schema_name_, index_id_, condition_, *txn_)
+                      : db_.index_scan(table_name_, schema_name_, index_id_, condition_);
     }
 
     bool
@@ -123,7 +218,7 @@ namespace exq
             if (!child_->next(row))
                 break;
 
-            if (!evaluator_.evaluate(table_, row, condition_))
+            if (!evaluator_.evaluate(predicate_, row))
                 continue;
 
             out = std::move(row);
@@ -245,10 +340,11 @@ namespace exq
         const std::string& schema_name,
         storage::IDbInstance& storage,
         const std::optional<std::vector<std::string>>& col_names,
-        std::unique_ptr<INodeExecutor> child
+        std::unique_ptr<INodeExecutor> child,
+        txn::Transaction* txn
     )
         : table_name_(table_name), schema_name_(schema_name), db_(storage),
-          col_names_(col_names), child_(std::move(child))
+          col_names_(col_names), child_(std::move(child)), txn_(txn)
     {
     }
 
@@ -266,8 +362,10 @@ namespace exq
 
         int inserted_count = 0;
 
-        auto txn = db_.make_txn();
-        txn.begin();
+        StatementTxn txn(db_, txn_);
+
+        std::vector<std::vector<DataToken>> batch;
+        batch.reserve(INSERT_BATCH_ROWS);
 
         while (true)
         {
@@ -275,10 +373,20 @@ namespace exq
             if (!child_->next(row))
                 break;
 
-            db_.insert_row(table_name_, schema_name_, col_names_, row.tokens, txn);
+            batch.push_back(std::move(row.tokens));
             inserted_count++;
+
+            if (batch.size() == INSERT_BATCH_ROWS)
+            {
+                db_.insert_rows(table_name_, schema_name_, col_names_, std::move(batch), txn.get());
+                batch.clear();
+                batch.reserve(INSERT_BATCH_ROWS);
+            }
         }
 
+        if (!batch.empty())
+            db_.insert_rows(table_name_, schema_name_, col_names_, std::move(batch), txn.get());
+
         txn.commit();
         executed_ = true;
 
@@ -334,10 +442,11 @@ namespace exq
         const std::string& schema_name,
         storage::IDbInstance& db,
         const std::vector<Assignment>& asg,
-        std::unique_ptr<INodeExecutor> child
+        std::unique_ptr<INodeExecutor> child,
+        txn::Transaction* txn
     )
         : table_name_(table_name), schema_name_(schema_name), db_(db), assignments_(asg),
-          child_(std::move(child)), executed_(false)
+          child_(std::move(child)), txn_(txn), executed_(false)
     {
     }
 
@@ -356,8 +465,7 @@ namespace exq
         int updated_count = 0;
         std::vector<DataRow> rows;
 
-        auto txn = db_.make_txn();
-        txn.begin();
+        StatementTxn txn(db_, txn_);
 
         while (true)
         {
@@ -369,7 +477,7 @@ namespace exq
             updated_count++;
         }
 
-        db_.update_row(table_name_, schema_name_, assignments_, rows, txn);
+        db_.update_row(table_name_, schema_name_, assignments_, rows, txn.get());
         executed_ = true;
 
         txn.commit();
@@ -395,10 +503,11 @@ namespace exq
         const std::string& table_name,
         const std::string& schema_name,
         storage::IDbInstance& db,
-        std::unique_ptr<INodeExecutor> child
+        std::unique_ptr<INodeExecutor> child,
+        txn::Transaction* txn
     )
         : table_name_(table_name), schema_name_(schema_name), db_(db), child_(std::move(child)),
-          executed_(false)
+          txn_(txn), executed_(false)
     {
     }
 
@@ -417,8 +526,7 @@ namespace exq
         int deleted_count = 0;
         std::vector<DataRow> rows;
 
-        auto txn = db_.make_txn();
-        txn.begin();
+        StatementTxn txn(db_, txn_);
 
         while (true)
         {
@@ -430,7 +538,7 @@ namespace exq
             deleted_count++;
         }
 
-        db_.delete_rows(table_name_, schema_name_, rows, txn);
+        db_.delete_rows(table_name_, schema_name_, rows, txn.get());
         executed_ = true;
 
         txn.commit();
@@ -500,8 +608,9 @@ namespace exq
     bool
     CreateDbNodeExecutor::next(DataRow& out)
     {
+        // Through the registry, so that a database this process has open is not opened twice.
         auto config = Config::std(db_name_);
-        auto db = storage::StdDbInstance(config);
+        storage::DbInstanceRegistry::shared()->acquire(config);
         return false;
     }
 
@@ -592,14 +701,18 @@ namespace exq
     }
 
     std::unique_ptr<INodeExecutor>
-    NodeExecutorFactory::from_plan(std::unique_ptr<IPlanNode>&& node, storage::IDbInstance& db)
+    NodeExecutorFactory::from_plan(
+        std::unique_ptr<IPlanNode>&& node, storage::IDbInstance& db, txn::Transaction* txn
+    )
     {
         switch (node->type())
         {
         case IPlanNode::Type::SEQ_SCAN:
         {
             const auto& seq_scan_node = static_cast<const SeqScanPlanNode&>(*node);
-            SeqScanNodeExecutor executor(db, seq_scan_node.table_name, seq_scan_node.schema_name);
+            SeqScanNodeExecutor executor(
+                db, seq_scan_node.table_name, seq_scan_node.schema_name, txn
+            );
 
             return std::make_unique<SeqScanNodeExecutor>(std::move(executor));
         }
@@ -611,7 +724,8 @@ namespace exq
                 index_scan_node.schema_name,
                 index_scan_node.index_id,
                 std::move(index_scan_node.condition),
-                db
+                db,
+                txn
             );
 
             return std::make_unique<IndexScanNodeExecutor>(std::move(executor));
@@ -619,10 +733,26 @@ namespace exq
         case IPlanNode::Type::FILTER:
         {
             auto& filter_node = static_cast<FilterPlanNode&>(*node);
+            if (filter_node.child->type() == IPlanNode::Type::SEQ_SCAN)
+            {
+                // Test rows in place inside the page rather than copying each one out
+                const auto& seq_scan_node = static_cast<const SeqScanPlanNode&>(*filter_node.child);
+                SeqScanNodeExecutor executor(
+                    db,
+                    seq_scan_node.table_name,
+                    seq_scan_node.schema_name,
+                    filter_node.table,
+                    filter_node.where,
+                    txn
+                );
+
+                return std::make_unique<SeqScanNodeExecutor>(std::move(executor));
+            }
+
             FilterNodeExecutor executor(
                 filter_node.table,
                 std::move(filter_node.where),
-                from_plan(std::move(filter_node.child), db)
+                from_plan(std::move(filter_node.child), db, txn)
             );
 
             return std::make_unique<FilterNodeExecutor>(std::move(executor));
@@ -633,7 +763,7 @@ namespace exq
             ProjectionNodeExecutor executor(
                 project_node.table,
                 project_node.columns,
-                from_plan(std::move(project_node.child), db)
+                from_plan(std::move(project_node.child), db, txn)
             );
             return std::make_unique<ProjectionNodeExecutor>(std::move(executor));
         }
@@ -641,7 +771,7 @@ namespace exq
         {
             auto& limit_node = static_cast<LimitPlanNode&>(*node);
             LimitNodeExecutor executor(
-                limit_node.limit, from_plan(std::move(limit_node.child), db)
+                limit_node.limit, from_plan(std::move(limit_node.child), db, txn)
             );
             return std::make_unique<LimitNodeExecutor>(std::move(executor));
         }
@@ -653,7 +783,8 @@ namespace exq
                 insert_node.schema_name,
                 db,
                 insert_node.column_names,
-                from_plan(std::move(insert_node.child), db)
+                from_plan(std::move(insert_node.child), db, txn),
+                txn
             );
             return std::make_unique<InsertNodeExecutor>(std::move(executor));
         }
@@ -671,7 +802,8 @@ namespace exq
                 update_node.schema_name,
                 db,
                 update_node.assignments,
-                from_plan(std::move(update_node.child), db)
+                from_plan(std::move(update_node.child), db, txn),
+                txn
             );
             return std::make_unique<UpdateNodeExecutor>(std::move(executor));
         }
@@ -682,7 +814,8 @@ namespace exq
                 delete_node.table_name,
                 delete_node.schema_name,
                 db,
-                from_plan(std::move(delete_node.child), db)
+                from_plan(std::move(delete_node.child), db, txn),
+                txn
             );
             return std::make_unique<DeleteNodeExecutor>(std::move(executor));
         }
@@ -122,23 +122,6 @@ namespace exq
         );
     }
 
-    double
-    estimate_selectivity(const BinaryExpr& condition, const MetaIndex& idx)
-    {
-        switch (condition.op)
-        {
-        case AstOperator::EQ:
-            return idx.is_unique ? 0.1 : 1.0;
-        case AstOperator::LT:
-        case AstOperator::LTE:
-        case AstOperator::GR:
-        case AstOperator::GRE:
-            return 0.3;
-        default:
-            return 1.0;
-        }
-    }
-
     bool
     is_null_literal(const std::unique_ptr<AstNode>& node)
     {
@@ -163,27 +146,23 @@ namespace exq
     }
 
     double
-    estimate_index_scan(const MetaTable& table, const MetaIndex& idx, const BinaryExpr& condition)
+    estimate_index_scan(const MetaTable& table, uint64_t entries)
     {
-        double N = table.total_rows;
-        double live = table.live_rows;
-
-        if (live == 0)
+        if (table.live_rows == 0)
             return 0;
 
-        double live_ratio = live / N;
-
-        double sel = estimate_selectivity(condition, idx);
-        double K_live = live * sel;
-        double K_index = K_live / live_ratio;
-        double btree_cost = std::log2(N);
-
-        return btree_cost + K_index;
+        // Every entry in the key range costs a row fetch, whether the row is live or not.
+        double btree_cost = std::log2(table.total_rows);
+        return btree_cost + entries;
     }
 
     IPlanNode::Type
     choose_scan_type(
-        const MetaTable& table, const BinaryExpr* condition, const MetaIndex** chosen_index
+        storage::IDbInstance& db,
+        const std::string& schema_name,
+        const MetaTable& table,
+        const BinaryExpr* condition,
+        const MetaIndex** chosen_index
     )
     {
         double best_cost = table.total_rows;
@@ -195,17 +174,25 @@ namespace exq
         if (is_null_predicate(*condition))
             return best;
 
+        // The column may be on either side of the comparison.
+        const AstNode* column_node = condition->left.get();
+        if (column_node->type != AstNodeType::IDENTIFIER)
+            column_node = condition->right.get();
+        if (column_node->type != AstNodeType::IDENTIFIER)
+            return best;
+
+        auto& column = table.get_column(std::get<SqlToken>(column_node->value).value);
+
         for (const auto& idx : table.indexes)
         {
-            // TODO
-            if (condition->left->type != AstNodeType::IDENTIFIER)
-                throw std::runtime_error("choose_scan_type: left token must be column identifier");
-
-            auto& column = table.get_column(std::get<SqlToken>(condition->left->value).value);
             if (idx.column_id != column.id)
                 continue;
 
-            auto cost = estimate_index_scan(table, idx, *condition);
+            // Counting stops where a sequential scan would be cheaper anyway.
+            const auto entries =
+                db.index_range_count(table.name, schema_name, idx.id, *condition, table.total_rows);
+
+            auto cost = estimate_index_scan(table, entries);
             if (cost < best_cost)
             {
                 best_cost = cost;
@@ -222,9 +209,12 @@ namespace exq
     {
         auto table = db_.get_table(stmt.table);
         const auto* condition_ptr = stmt.where ? &(*stmt.where) : nullptr;
+        const auto schema_name = stmt.table.schema_name.has_value()
+                                     ? stmt.table.schema_name.value().value
+                                     : db_config_.default_schema;
 
         const MetaIndex* chosen_index = nullptr;
-        auto scan_type = choose_scan_type(*table, condition_ptr, &chosen_index);
+        auto scan_type = choose_scan_type(db_, schema_name, *table, condition_ptr, &chosen_index);
 
         std::unique_ptr<IPlanNode> node;
 
@@ -0,0 +1,103 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#ifndef DELTABASE_CLOCK_POLICY_HPP
+#define DELTABASE_CLOCK_POLICY_HPP
+#include <cstddef>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace cache
+{
+    // Second-chance replacement. A hit only sets the reference bit of the key's slot,
+    // so it neither allocates nor reorders anything; the hand clears bits while it
+    // sweeps and evicts the first unreferenced key.
+    template <typename TKey>
+    class ClockPolicy
+    {
+        struct Slot
+        {
+            TKey key;
+            bool referenced = false;
+            bool occupied = false;
+        };
+
+        std::vector<Slot> slots_;
+        std::vector<size_t> free_slots_;
+        std::unordered_map<TKey, size_t> pos_;
+        size_t hand_ = 0;
+
+    public:
+        void touch(const TKey& key)
+        {
+            auto it = pos_.find(key);
+            if (it != pos_.end())
+                slots_[it->second].referenced = true;
+        }
+
+        void insert(const TKey& key)
+        {
+            if (pos_.contains(key))
+            {
+                touch(key);
+                return;
+            }
+
+            size_t idx;
+            if (!free_slots_.empty())
+            {
+                idx = free_slots_.back();
+                free_slots_.pop_back();
+            }
+            else
+            {
+                idx = slots_.size();
+                slots_.emplace_back();
+            }
+
+            slots_[idx] = Slot{key, false, true};
+            pos_[key] = idx;
+        }
+
+        // Sweeps at most two full turns: the first one may only clear reference bits.
+        template <typename TPredicate>
+        std::optional<TKey> evict(TPredicate&& evictable)
+        {
+            if (pos_.empty())
+                return std::nullopt;
+
+            for (size_t step = 0; step < slots_.size() * 2; ++step)
+            {
+                if (hand_ >= slots_.size())
+                    hand_ = 0;
+
+                auto& slot = slots_[hand_++];
+                if (!slot.occupied)
+                    continue;
+
+                if (slot.referenced)
+                {
+                    slot.referenced = false;
+                    continue;
+                }
+
+                if (!evictable(slot.key))
+                    continue;
+
+                TKey old = slot.key;
+                slot.occupied = false;
+                pos_.erase(old);
+                free_slots_.push_back(hand_ - 1);
+                return old;
+            }
+
+            return std::nullopt;
+        }
+
+        size_t size() const { return pos_.size(); }
+    };
+}
+
+#endif // DELTABASE_CLOCK_POLICY_HPP
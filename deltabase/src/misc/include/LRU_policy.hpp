@@ -4,7 +4,9 @@
 
 #ifndef DELTABASE_LRU_POLICY_HPP
 #define DELTABASE_LRU_POLICY_HPP
+#include <cstddef>
 #include <list>
+#include <optional>
 #include <unordered_map>
 
 namespace cache
@@ -19,10 +21,16 @@ namespace cache
     public:
         void touch(const TKey& key)
         {
-            if (pos_.count(key))
-                lru_list_.erase(pos_[key]);
-            lru_list_.push_front(key);
-            pos_[key] = lru_list_.begin();
+            auto it = pos_.find(key);
+            if (it == pos_.end())
+            {
+                lru_list_.push_front(key);
+                pos_[key] = lru_list_.begin();
+                return;
+            }
+
+            // Relinks the existing node, so a hit does not allocate.
+            lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
         }
 
         void insert(const TKey& key)
@@ -30,12 +38,22 @@ namespace cache
             touch(key);
         }
 
-        TKey evict()
+        // Evicts the least recently used key accepted by the predicate.
+        template <typename TPredicate>
+        std::optional<TKey> evict(TPredicate&& evictable)
         {
-            TKey old = lru_list_.back();
-            lru_list_.pop_back();
-            pos_.erase(old);
-            return old;
+            for (auto it = lru_list_.rbegin(); it != lru_list_.rend(); ++it)
+            {
+                if (!evictable(*it))
+                    continue;
+
+                TKey old = *it;
+                lru_list_.erase(std::next(it).base());
+                pos_.erase(old);
+                return old;
+            }
+
+            return std::nullopt;
         }
 
         size_t size() const { return lru_list_.size(); }
@@ -5,9 +5,13 @@
 #ifndef DELTABASE_CACHE_HPP
 #define DELTABASE_CACHE_HPP
 
+#include <atomic>
 #include <bits/basic_ios.h>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <shared_mutex>
 #include <unordered_map>
 #include <utility>
 
@@ -21,22 +25,57 @@ namespace misc
         using iterator = std::unordered_map<TKey, CacheEntry>::iterator;
         using const_iterator = std::unordered_map<TKey, CacheEntry>::const_iterator;
 
+        using Flusher = std::function<void(CacheEntry&)>;
+        // Returns how many bytes a value occupies; the cache capacity is a byte budget.
+        using Sizer = std::function<std::size_t(const TValue&)>;
+        // Asked about each unpinned entry before it is evicted; an entry it refuses stays.
+        using EvictFilter = std::function<bool(CacheEntry&)>;
+
+        // Lookup and replacement counters, used to compare replacement policies.
+        struct Stats
+        {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t evictions = 0;
+        };
+
     private:
-        std::size_t max_size_ = 100;
+        std::size_t capacity_bytes_;
+        std::size_t used_bytes_ = 0;
+        Sizer sizer_;
+        EvictFilter evict_filter_;
         std::unordered_map<TKey, CacheEntry> map_;
         TPolicy policy_;
+        Stats stats_;
+
+        void
+        recharge(CacheEntry& entry)
+        {
+            used_bytes_ -= entry.charge;
+            entry.charge = sizer_(entry.value);
+            used_bytes_ += entry.charge;
+        }
 
     public:
-        Cache(TPolicy policy) : policy_(policy)
+        Cache(TPolicy policy, std::size_t capacity_bytes, Sizer sizer)
+            : capacity_bytes_(capacity_bytes), sizer_(std::move(sizer)), policy_(policy)
         {
         }
 
-        using Flusher = std::function<void(CacheEntry&)>;
         struct CacheEntry
         {
             TValue value;
             bool dirty;
             Flusher flush;
+            std::size_t charge = 0;
+            // When the entry last went from clean to dirty.
+            std::chrono::steady_clock::time_point dirty_since{};
+            // Number of live Pin handles; a pinned entry is never evicted.
+            std::atomic<uint32_t> pins = 0;
+            // Guards the value's contents. Taken only by holders of a Pin, shared to read
+            // and exclusive to change it, so an entry that can be evicted is never latched.
+            // The cache itself does not take it.
+            std::shared_mutex latch;
 
             CacheEntry(TValue&& value, Flusher flush)
                 : value(std::move(value)), dirty(false), flush(std::forward<Flusher>(flush))
@@ -44,22 +83,118 @@ namespace misc
             }
         };
 
-        void
+        // RAII handle that keeps an entry resident. Entries live in unordered_map nodes,
+        // so the pointer stays valid while the entry cannot be evicted.
+        class Pin
+        {
+            CacheEntry* entry_ = nullptr;
+
+        public:
+            Pin() = default;
+
+            explicit Pin(CacheEntry* entry) : entry_(entry)
+            {
+                if (entry_)
+                    entry_->pins.fetch_add(1, std::memory_order_acq_rel);
+            }
+
+            Pin(const Pin&) = delete;
+            Pin&
+            operator=(const Pin&) = delete;
+
+            Pin(Pin&& other) noexcept : entry_(std::exchange(other.entry_, nullptr))
+            {
+            }
+
+            Pin&
+            operator=(Pin&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    entry_ = std::exchange(other.entry_, nullptr);
+                }
+                return *this;
+            }
+
+            ~Pin()
+            {
+                reset();
+            }
+
+            void
+            reset()
+            {
+                if (entry_)
+                    entry_->pins.fetch_sub(1, std::memory_order_acq_rel);
+                entry_ = nullptr;
+            }
+
+            // Another handle on the same entry.
+            Pin
+            clone() const
+            {
+                return Pin(entry_);
+            }
+
+            std::shared_mutex&
+            latch() const
+            {
+                return entry_->latch;
+            }
+
+            TValue*
+            get() const
+            {
+                return entry_ ? &entry_->value : nullptr;
+            }
+
+            TValue*
+            operator->() const
+            {
+                return get();
+            }
+
+            TValue&
+            operator*() const
+            {
+                return entry_->value;
+            }
+
+            explicit
+            operator bool() const
+            {
+                return entry_ != nullptr;
+            }
+        };
+
+        CacheEntry*
         put(const TKey& key, TValue&& val, Flusher flush)
         {
             auto it = map_.find(key);
             if (it != map_.end())
             {
                 it->second.value = std::move(val);
+                recharge(it->second);
                 policy_.touch(key);
-                return;
+                return &it->second;
             }
 
-            if (map_.size() >= max_size_)
-                evict_one();
+            // When every resident entry is pinned the cache temporarily exceeds its budget.
+            const std::size_t incoming = sizer_(val);
+            while (!map_.empty() && used_bytes_ + incoming > capacity_bytes_)
+                if (!evict_one())
+                    break;
 
-            map_.emplace(key, CacheEntry(std::move(val), std::forward<Flusher>(flush)));
+            auto [inserted, _] = map_.emplace(
+                std::piecewise_construct,
+                std::forward_as_tuple(key),
+                std::forward_as_tuple(std::move(val), std::forward<Flusher>(flush))
+            );
+            inserted->second.charge = incoming;
+            used_bytes_ += incoming;
             policy_.insert(key);
+            return &inserted->second;
         }
 
         CacheEntry*
@@ -67,11 +202,29 @@ namespace misc
         {
             auto it = map_.find(key);
             if (it == map_.end())
+            {
+                ++stats_.misses;
                 return nullptr;
+            }
+            ++stats_.hits;
             policy_.touch(key);
             return &it->second;
         }
 
+        // Looks an entry up without counting it as an access.
+        CacheEntry*
+        peek(const TKey& key)
+        {
+            auto it = map_.find(key);
+            return it == map_.end() ? nullptr : &it->second;
+        }
+
+        Pin
+        pin(const TKey& key)
+        {
+            return Pin(get(key));
+        }
+
         void
         mark_dirty(const TKey& key)
         {
@@ -79,16 +232,39 @@ namespace misc
             if (it == map_.end())
                 return;
             policy_.touch(key);
+            if (!it->second.dirty)
+                it->second.dirty_since = std::chrono::steady_clock::now();
             it->second.dirty = true;
+            // Dirty values were changed in place, so their footprint may have changed too.
+            recharge(it->second);
         }
 
         void
+        set_evict_filter(EvictFilter filter)
+        {
+            evict_filter_ = std::move(filter);
+        }
+
+        bool
         evict_one()
         {
-            TKey victim_key = policy_.evict();
-            auto it = map_.find(victim_key);
+            auto victim_key = policy_.evict(
+                [this](const TKey& key)
+                {
+                    auto candidate = map_.find(key);
+                    if (candidate == map_.end())
+                        return true;
+
+                    return candidate->second.pins.load(std::memory_order_acquire) == 0 &&
+                           (!evict_filter_ || evict_filter_(candidate->second));
+                }
+            );
+            if (!victim_key)
+                return false;
+
+            auto it = map_.find(*victim_key);
             if (it == map_.end())
-                return;
+                return true;
 
             auto& victim = it->second;
 
@@ -97,7 +273,10 @@ namespace misc
                 victim.flush(victim);
             }
 
+            used_bytes_ -= victim.charge;
             map_.erase(it);
+            ++stats_.evictions;
+            return true;
         }
 
         iterator
@@ -141,6 +320,24 @@ namespace misc
         {
             return map_.size();
         }
+
+        std::size_t
+        used_bytes() const
+        {
+            return used_bytes_;
+        }
+
+        std::size_t
+        capacity_bytes() const
+        {
+            return capacity_bytes_;
+        }
+
+        const Stats&
+        stats() const
+        {
+            return stats_;
+        }
     };
 } // namespace buffer
 
@@ -76,6 +76,19 @@ public:
     }
 };
 
+// A write hit a row version that a transaction the writer does not see already deleted
+// or replaced. The first writer wins; the statement fails rather than changing nothing.
+class SerializationFailure : public std::runtime_error
+{
+public:
+    SerializationFailure(const std::string& table_name)
+        : std::runtime_error(
+              "Could not serialize access to table '" + table_name + "' due to a concurrent update"
+          )
+    {
+    }
+};
+
 class IndexDoesntExist : public std::runtime_error
 {
 public:
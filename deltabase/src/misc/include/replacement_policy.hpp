@@ -0,0 +1,54 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#ifndef DELTABASE_REPLACEMENT_POLICY_HPP
+#define DELTABASE_REPLACEMENT_POLICY_HPP
+#include "2Q_policy.hpp"
+#include "CLOCK_policy.hpp"
+#include "LRU_policy.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <variant>
+
+namespace cache
+{
+    // Policy whose algorithm is chosen at runtime, for caches configured per database.
+    // Plugs into misc::Cache like any of the concrete policies it wraps.
+    template <typename TKey>
+    class ReplacementPolicy
+    {
+        std::variant<LRUPolicy<TKey>, ClockPolicy<TKey>, TwoQueuePolicy<TKey>> policy_;
+
+    public:
+        template <typename TPolicy>
+        ReplacementPolicy(TPolicy policy) : policy_(std::move(policy))
+        {
+        }
+
+        void touch(const TKey& key)
+        {
+            std::visit([&](auto& policy) { policy.touch(key); }, policy_);
+        }
+
+        void insert(const TKey& key)
+        {
+            std::visit([&](auto& policy) { policy.insert(key); }, policy_);
+        }
+
+        template <typename TPredicate>
+        std::optional<TKey> evict(TPredicate&& evictable)
+        {
+            return std::visit([&](auto& policy) { return policy.evict(evictable); }, policy_);
+        }
+
+        size_t size() const
+        {
+            return std::visit([](const auto& policy) { return policy.size(); }, policy_);
+        }
+    };
+}
+
+#endif // DELTABASE_REPLACEMENT_POLICY_HPP
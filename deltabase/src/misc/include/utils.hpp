@@ -94,6 +94,10 @@ namespace misc
 
     void
     print_ram_usage();
+
+    // CRC-32 (IEEE 802.3) of a byte range.
+    uint32_t
+    crc32(const void* data, size_t size);
 }
 
 template <typename E>
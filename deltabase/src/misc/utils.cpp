@@ -1,5 +1,6 @@
 #include "include/utils.hpp"
 
+#include <array>
 #include <sstream>
 #include <fstream>
 #include <iostream>
@@ -57,4 +58,28 @@ namespace misc
             }
         }
     }
+
+    uint32_t
+    crc32(const void* data, size_t size)
+    {
+        static const auto table = []
+        {
+            std::array<uint32_t, 256> t{};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[i] = c;
+            }
+            return t;
+        }();
+
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; ++i)
+            crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+
+        return crc ^ 0xFFFFFFFFu;
+    }
 }
@@ -481,7 +481,7 @@ namespace net
         auto session_id = UUID::make();
         {
             std::lock_guard lock(sessions_mutex_);
-            sessions_[session_id] = engine::Engine();
+            sessions_.try_emplace(session_id);
         }
 
         PongNetMessage pong(session_id, NetErrorCode::SUCCESS, ping.request_id);
@@ -8,14 +8,63 @@
 #include "../../wal/include/wal_manager.hpp"
 #include "../../transactions/include/transaction.hpp"
 
+#include <functional>
+#include <optional>
+#include <span>
+#include <unordered_set>
+
 namespace recovery
 {
+    // What undo changes. Recovery changes the files; a running instance changes its
+    // buffered pages and cached catalog instead, under the latches its writers take.
+    class IUndoTarget
+    {
+    public:
+        virtual ~IUndoTarget() = default;
+
+        // Calls change on the page and keeps what it did. Returns false, without calling
+        // it, if the page does not exist.
+        virtual bool
+        change_page(
+            const types::TableId& table_id,
+            const types::DataPageId& page_id,
+            const std::function<void(types::DataPage&)>& change
+        ) = 0;
+
+        virtual void
+        change_table(
+            const types::TableId& table_id, const std::function<void(types::MetaTable&)>& change
+        ) = 0;
+
+        // Drops the index entries of versions on the page that undo left dead. lsn is the
+        // CLR that killed them.
+        virtual void
+        unindex(
+            const types::TableId& table_id,
+            const types::DataPageId& page_id,
+            std::span<const types::DataRow> rows,
+            types::LSN lsn
+        ) = 0;
+    };
+
     class RecoveryManager
     {
         types::Config& cfg_;
         wal::IWALManager& wal_;
         storage::IIOManager& io_;
 
+        // Checkpoint named by the config, if any, and its dirty page table. Redo starts at
+        // its redo_lsn, and skips records logged before it for pages that were clean.
+        std::optional<types::CheckpointRecord> checkpoint_;
+        std::unordered_set<types::DataPageId> checkpoint_dirty_pages_;
+
+        // Tables with row changes, or indexes created, among the records recover() redid
+        // or undid.
+        std::unordered_set<types::TableId> changed_tables_;
+
+        void
+        load_checkpoint();
+
         void
         redo(
             const types::WALRecord& record,
@@ -29,12 +78,16 @@ namespace recovery
         void
         redo(const types::InsertRecord& record, types::DataPage& page);
         void
+        redo(const types::InsertRowsRecord& record, types::DataPage& page);
+        void
         redo(const types::UpdateRecord& record, types::DataPage& page);
         void
         redo(const types::DeleteRecord& record, types::DataPage& page);
         void
         redo(const types::CLRInsertRecord& record, types::DataPage& page);
         void
+        redo(const types::CLRInsertRowsRecord& record, types::DataPage& page);
+        void
         redo(const types::CLRUpdateRecord& record, types::DataPage& page);
         void
         redo(const types::CLRDeleteRecord& record, types::DataPage& page);
@@ -74,6 +127,14 @@ namespace recovery
         void
         redo(const types::CLRDropIndexRecord& record);
 
+        void
+        redo(const types::LinkPageRecord& record);
+
+        void
+        redo(const types::TableCountersRecord& record);
+        void
+        redo(const types::CLRTableCountersRecord& record);
+
         void
         redo(const types::BeginTxnRecord& record);
         void
@@ -84,6 +145,8 @@ namespace recovery
         types::WALRecord
         make_clr(const types::InsertRecord& record) const;
         types::WALRecord
+        make_clr(const types::InsertRowsRecord& record) const;
+        types::WALRecord
         make_clr(const types::UpdateRecord& record) const;
         types::WALRecord
         make_clr(const types::DeleteRecord& record) const;
@@ -104,14 +167,20 @@ namespace recovery
         types::WALRecord
         make_clr(const types::DropIndexRecord& record) const;
         types::WALRecord
+        make_clr(const types::TableCountersRecord& record, const types::MetaTable& table) const;
+        types::WALRecord
         make_clr(const types::RollbackTxnRecord& record) const;
 
-        std::unordered_map<txn::TxnId, types::LSN>
-        get_commit_lsns(const std::vector<types::WALRecord>& wal) const;
-        std::unordered_map<txn::TxnId, types::LSN>
-        get_rollback_lsns(const std::vector<types::WALRecord>& wal) const;
-        std::unordered_map<txn::TxnId, types::LSN>
-        get_last_lsns(const std::vector<types::WALRecord>& wal) const;
+        // Per-transaction LSNs gathered by the analysis pass.
+        struct TxnTable
+        {
+            std::unordered_map<txn::TxnId, types::LSN> commit_lsns;
+            std::unordered_map<txn::TxnId, types::LSN> rollback_lsns;
+            std::unordered_map<txn::TxnId, types::LSN> last_lsns;
+        };
+
+        TxnTable
+        analyze(types::LSN from_lsn);
         std::unordered_map<txn::TxnId, types::LSN>
         get_active_txns(
             const std::unordered_map<txn::TxnId, types::LSN>& last,
@@ -121,9 +190,15 @@ namespace recovery
         void
         undo(const std::unordered_map<txn::TxnId, types::LSN>& active_lsns);
 
+        // Appends a CLR as the transaction's record after prev_lsn.
+        types::LSN
+        append_clr(types::WALRecord clr, types::LSN prev_lsn);
+
         void
         undo_record(const types::InsertRecord& record, types::DataPage& page);
         void
+        undo_record(const types::InsertRowsRecord& record, types::DataPage& page);
+        void
         undo_record(const types::UpdateRecord& record, types::DataPage& page);
         void
         undo_record(const types::DeleteRecord& record, types::DataPage& page);
@@ -144,14 +219,30 @@ namespace recovery
         void
         undo_record(const types::DropIndexRecord& record);
         void
+        undo_record(const types::TableCountersRecord& record, types::MetaTable& table);
+        void
         undo_record(const types::RollbackTxnRecord& record);
 
     public:
         explicit
         RecoveryManager(types::Config& cfg, wal::IWALManager& wal, storage::IIOManager& io);
 
-        void
+        // Index contents are not logged, so an index may have lost entries of committed
+        // rows, or kept entries of rows undone. Returns the tables whose rows redo or undo
+        // changed: their indexes must be rebuilt from the rows.
+        std::unordered_set<types::TableId>
         recover();
+
+        // Takes back what the transaction did after until, walking its records back from
+        // last_lsn and logging a CLR for each one undone. Undone down to its first record,
+        // it is ended with a rollback record. Catalog changes other than row counters are
+        // undone in the files only, so a running instance must not pass a transaction
+        // that made any.
+        // Returns the LSN of the transaction's last record once done.
+        types::LSN
+        rollback(
+            const txn::TxnId& txn_id, types::LSN last_lsn, IUndoTarget& target, types::LSN until = 0
+        );
     };
 } // namespace recovery
 
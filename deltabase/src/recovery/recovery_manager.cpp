@@ -13,24 +13,165 @@ namespace recovery
     using namespace types;
     using namespace txn;
 
+    namespace
+    {
+        // Marks a version obsolete with no deleter, which no snapshot sees: it was rolled
+        // back. Clearing the mark revives a version whose deletion was rolled back.
+        void
+        set_obsolete(DataPage& page, RowId row_id, bool obsolete)
+        {
+            const auto slot = page.find(row_id);
+            if (!slot)
+                return;
+
+            const auto flags = page.row(*slot).flags();
+            page.set_flags(
+                *slot, obsolete ? flags | DataRowFlags::OBSOLETE : flags & ~DataRowFlags::OBSOLETE
+            );
+            page.set_deleted_by(*slot, 0);
+        }
+
+        // Versions the record created, which its undo leaves dead.
+        std::span<const DataRow>
+        created_versions(const InsertRecord& record)
+        {
+            return {&record.after, 1};
+        }
+
+        std::span<const DataRow>
+        created_versions(const InsertRowsRecord& record)
+        {
+            return record.after;
+        }
+
+        std::span<const DataRow>
+        created_versions(const UpdateRecord& record)
+        {
+            return {&record.after, 1};
+        }
+
+        std::span<const DataRow>
+        created_versions(const DeleteRecord&)
+        {
+            return {};
+        }
+
+        void
+        set_deleted(DataPage& page, const DataRow& before)
+        {
+            const auto slot = page.find(before.id);
+            if (!slot)
+                return;
+
+            page.set_flags(*slot, page.row(*slot).flags() | DataRowFlags::OBSOLETE);
+            page.set_deleted_by(*slot, before.deleted_by);
+        }
+
+        // Undo during recovery, straight in the files. Nothing else holds the WAL ahead
+        // of what is written here, so it is flushed before every write. The tables whose
+        // rows it changes are added to changed_tables.
+        class FileUndoTarget final : public IUndoTarget
+        {
+            wal::IWALManager& wal_;
+            storage::IIOManager& io_;
+            std::unordered_set<TableId>& changed_tables_;
+
+        public:
+            FileUndoTarget(
+                wal::IWALManager& wal, storage::IIOManager& io, std::unordered_set<TableId>& changed_tables
+            )
+                : wal_(wal), io_(io), changed_tables_(changed_tables)
+            {
+            }
+
+            bool
+            change_page(
+                const TableId& table_id,
+                const DataPageId& page_id,
+                const std::function<void(DataPage&)>& change
+            ) override
+            {
+                auto page = io_.read_data_page(page_id);
+                if (!page)
+                    return false;
+
+                changed_tables_.insert(table_id);
+                change(*page);
+                wal_.flush();
+                io_.write_page(*page, true);
+                return true;
+            }
+
+            void
+            change_table(const TableId& table_id, const std::function<void(MetaTable&)>& change) override
+            {
+                MetaTable table = io_.read_table_meta(table_id);
+                change(table);
+                wal_.flush();
+                io_.write_mt(table, true);
+            }
+
+            // Index contents are not logged: the indexes of changed tables are rebuilt from
+            // their rows once recovery is done.
+            void
+            unindex(const TableId&, const DataPageId&, std::span<const DataRow>, LSN) override
+            {
+            }
+        };
+    } // namespace
+
     RecoveryManager::RecoveryManager(Config& cfg, wal::IWALManager& wal, storage::IIOManager& io)
         : cfg_(cfg), wal_(wal), io_(io)
     {
     }
 
-    void
+    std::unordered_set<TableId>
     RecoveryManager::recover()
     {
-        auto wal = wal_.read_all_logs();
-        auto commit_lsns = get_commit_lsns(wal);
-        auto rollback_lsns = get_rollback_lsns(wal);
-        auto last_lsn_per_txn = get_last_lsns(wal);
+        changed_tables_.clear();
+
+        // Two streaming passes from the checkpoint's redo point: analysis collects the
+        // transaction table, redo replays. Neither holds more than one WAL segment in memory.
+        // Pages and metas are written synced: they bypass the buffer pool, so the next
+        // checkpoint would not write them, yet it drops the segments replayed here.
+        load_checkpoint();
+        const LSN redo_lsn = checkpoint_ ? checkpoint_->redo_lsn : 0;
+
+        auto txns = analyze(redo_lsn);
 
-        for (const auto& record : wal)
-            redo(record, commit_lsns);
+        auto records = wal_.iterate(redo_lsn);
+        WALRecord record;
+        while (records->next(record))
+            redo(record, txns.commit_lsns);
 
-        auto active_txns = get_active_txns(last_lsn_per_txn, commit_lsns, rollback_lsns);
+        auto active_txns =
+            get_active_txns(txns.last_lsns, txns.commit_lsns, txns.rollback_lsns);
         undo(active_txns);
+
+        return std::move(changed_tables_);
+    }
+
+    void
+    RecoveryManager::load_checkpoint()
+    {
+        checkpoint_.reset();
+        checkpoint_dirty_pages_.clear();
+
+        if (cfg_.last_checkpoint_lsn == 0)
+            return;
+
+        auto record = wal_.read_log(cfg_.last_checkpoint_lsn);
+        auto* checkpoint = std::get_if<CheckpointRecord>(&record);
+        if (!checkpoint)
+            throw std::runtime_error(
+                "RecoveryManager::load_checkpoint: LSN " +
+                std::to_string(cfg_.last_checkpoint_lsn) + " is not a checkpoint record"
+            );
+
+        checkpoint_dirty_pages_.insert(
+            checkpoint->dirty_pages.begin(), checkpoint->dirty_pages.end()
+        );
+        checkpoint_ = std::move(*checkpoint);
     }
 
     // ### REDO ###
@@ -40,20 +181,28 @@ namespace recovery
         const WALRecord& record, const std::unordered_map<TxnId, LSN>& commit_lsns
     )
     {
-        LSN last_checkpoint = cfg_.last_checkpoint_lsn;
-
         std::visit(
             [&]<typename TRecord>(const TRecord& r)
             {
                 using R = std::decay_t<TRecord>;
 
-                if constexpr (misc::is_in_variant_v<R, WALCLRRecord>)
+                if constexpr (std::is_same_v<R, CheckpointRecord>)
+                    return;
+
+                // Page links do not belong to a transaction and are always redone.
+                if constexpr (std::is_same_v<R, LinkPageRecord>)
                 {
-                    if (r.lsn <= last_checkpoint)
-                        return;
+                    redo(r);
+                    return;
+                }
 
+                if constexpr (misc::is_in_variant_v<R, WALCLRRecord>)
+                {
                     if constexpr (wal_log::has_page_id_v<R>)
+                    {
+                        changed_tables_.insert(r.table_id);
                         redo_data(r);
+                    }
                     else
                         redo_meta(r);
 
@@ -64,16 +213,15 @@ namespace recovery
                 if (!commit_lsns.contains(r.txn_id))
                     return;
 
-                // Skip records not needing redo by checkpoint boundary
-                if (r.lsn <= last_checkpoint)
-                    return;
-
                 // Safety: ignore records after commit marker (if malformed WAL)
                 if (r.lsn > commit_lsns.at(r.txn_id))
                     return;
 
                 if constexpr (misc::is_in_variant_v<R, WALDataRecord>)
+                {
+                    changed_tables_.insert(r.table_id);
                     redo_data(r);
+                }
                 else if constexpr (misc::is_in_variant_v<R, WALMetaRecord>)
                     redo_meta(r);
             },
@@ -86,6 +234,12 @@ namespace recovery
         std::visit(
             [&](const auto& r)
             {
+                // Pages missing from the checkpoint's dirty page table were on disk with
+                // every change logged before the checkpoint.
+                if (checkpoint_ && r.lsn < checkpoint_->lsn &&
+                    !checkpoint_dirty_pages_.contains(r.page_id))
+                    return;
+
                 auto page = io_.read_data_page(r.page_id);
                 auto mt = io_.read_table_meta(r.table_id);
                 if (!page)
@@ -95,7 +249,7 @@ namespace recovery
                 {
                     redo(r, *page);
                     page->last_lsn = r.lsn;
-                    io_.write_page(*page);
+                    io_.write_page(*page, true);
                 }
             },
             record
@@ -157,13 +311,13 @@ namespace recovery
     void
     RecoveryManager::redo(const CreateTableRecord& record)
     {
-        io_.write_mt(record.after);
+        io_.write_mt(record.after, true);
     }
 
     void
     RecoveryManager::redo(const UpdateTableRecord& record)
     {
-        io_.write_mt(record.after);
+        io_.write_mt(record.after, true);
     }
 
     void
@@ -181,13 +335,13 @@ namespace recovery
     void
     RecoveryManager::redo(const CLRUpdateTableRecord& record)
     {
-        io_.write_mt(record.before);
+        io_.write_mt(record.before, true);
     }
 
     void
     RecoveryManager::redo(const CLRDeleteTableRecord& record)
     {
-        io_.write_mt(record.before);
+        io_.write_mt(record.before, true);
     }
 
     void
@@ -195,7 +349,8 @@ namespace recovery
     {
         auto table = io_.read_table_meta(record.after.table_id);
         table.indexes.push_back(record.after);
-        io_.write_mt(table);
+        io_.write_mt(table, true);
+        changed_tables_.insert(table.id);
     }
 
     void
@@ -203,7 +358,7 @@ namespace recovery
     {
         auto table = io_.read_table_meta(record.after.table_id);
         std::erase_if(table.indexes, [&](const MetaIndex& value) { return value.id == record.after.id; });
-        io_.write_mt(table);
+        io_.write_mt(table, true);
     }
 
     void
@@ -211,7 +366,7 @@ namespace recovery
     {
         auto table = io_.read_table_meta(record.before.table_id);
         std::erase_if(table.indexes, [&](const MetaIndex& value) { return value.id == record.before.id; });
-        io_.write_mt(table);
+        io_.write_mt(table, true);
     }
 
     void
@@ -219,7 +374,49 @@ namespace recovery
     {
         auto table = io_.read_table_meta(record.before.table_id);
         table.indexes.push_back(record.before);
-        io_.write_mt(table);
+        io_.write_mt(table, true);
+        changed_tables_.insert(table.id);
+    }
+
+    void
+    RecoveryManager::redo(const LinkPageRecord& record)
+    {
+        auto mt = io_.read_table_meta(record.table_id);
+
+        auto page = io_.read_data_page(record.page_id);
+        if (!page)
+            page = std::make_unique<DataPage>(io_.create_page(mt, record.page_id));
+
+        if (page->last_lsn < record.lsn)
+        {
+            page->next = record.next_page_id;
+            page->last_lsn = record.lsn;
+            io_.write_page(*page, true);
+        }
+
+        // The linked page may never have been written, e.g. when only a rolled back
+        // transaction had rows in it; an empty page keeps the chain walkable.
+        if (!io_.read_data_page(record.next_page_id))
+            io_.write_page(io_.create_page(mt, record.next_page_id), true);
+    }
+
+    void
+    RecoveryManager::redo(const TableCountersRecord& record)
+    {
+        auto table = io_.read_table_meta(record.table_id);
+        table.last_rid = std::max(table.last_rid, record.last_rid);
+        table.total_rows = record.total_rows;
+        table.live_rows = record.live_rows;
+        io_.write_mt(table, true);
+    }
+
+    void
+    RecoveryManager::redo(const CLRTableCountersRecord& record)
+    {
+        auto table = io_.read_table_meta(record.table_id);
+        table.total_rows = record.total_rows;
+        table.live_rows = record.live_rows;
+        io_.write_mt(table, true);
     }
 
     void
@@ -240,206 +437,197 @@ namespace recovery
     void
     RecoveryManager::redo(const InsertRecord& record, DataPage& page)
     {
-        page.rows.push_back(record.after);
+        page.append(record.after);
+    }
+    void
+    RecoveryManager::redo(const InsertRowsRecord& record, DataPage& page)
+    {
+        for (const auto& row : record.after)
+            page.append(row);
     }
     void
     RecoveryManager::redo(const UpdateRecord& record, DataPage& page)
     {
-        for (auto& row : page.rows)
-        {
-            if (row.id != record.before.id)
-                continue;
-
-            row.flags |= DataRowFlags::OBSOLETE;
-            break;
-        }
-
-        page.rows.push_back(record.after);
+        set_deleted(page, record.before);
+        page.append(record.after);
     }
     void
     RecoveryManager::redo(const DeleteRecord& record, DataPage& page)
     {
-        for (auto& row : page.rows)
-        {
-            if (row.id != record.before.id)
-                continue;
-
-            row.flags |= DataRowFlags::OBSOLETE;
-            break;
-        }
+        set_deleted(page, record.before);
     }
 
     void
     RecoveryManager::redo(const CLRInsertRecord& record, DataPage& page)
     {
-        for (auto& row : page.rows)
-        {
-            if (row.id != record.after.id)
-                continue;
+        set_obsolete(page, record.after.id, true);
+    }
 
-            row.flags |= DataRowFlags::OBSOLETE;
-            break;
+    void
+    RecoveryManager::redo(const CLRInsertRowsRecord& record, DataPage& page)
+    {
+        const std::unordered_set<RowId> ids(record.row_ids.begin(), record.row_ids.end());
+        for (size_t slot = 0; slot < page.slot_count; ++slot)
+        {
+            const auto row = page.row(slot);
+            if (ids.contains(row.id()))
+            {
+                page.set_flags(slot, row.flags() | DataRowFlags::OBSOLETE);
+                page.set_deleted_by(slot, 0);
+            }
         }
     }
 
     void
     RecoveryManager::redo(const CLRUpdateRecord& record, DataPage& page)
     {
-        for (auto& row : page.rows)
-        {
-            if (row.id != record.after.id)
-                continue;
-
-            row.tokens = record.before.tokens;
-            row.flags &= ~DataRowFlags::OBSOLETE;
-            break;
-        }
+        set_obsolete(page, record.after.id, true);
+        set_obsolete(page, record.before.id, false);
     }
 
     void
     RecoveryManager::redo(const CLRDeleteRecord& record, DataPage& page)
     {
-        for (auto& row : page.rows)
-        {
-            if (row.id != record.before.id)
-                continue;
-
-            row.flags &= ~DataRowFlags::OBSOLETE;
-            break;
-        }
+        set_obsolete(page, record.before.id, false);
     }
 
     void
     RecoveryManager::undo(const std::unordered_map<TxnId, LSN>& active_lsns)
     {
+        FileUndoTarget target(wal_, io_, changed_tables_);
         for (const auto& [txn_id, last_lsn] : active_lsns)
-        {
-            LSN current = last_lsn;
-            LSN txn_prev_lsn = last_lsn;
-            bool rollback_marker_seen = false;
+            rollback(txn_id, last_lsn, target);
+
+        wal_.flush();
+    }
 
-            while (current != 0)
+    LSN
+    RecoveryManager::append_clr(WALRecord clr, LSN prev_lsn)
+    {
+        clr = std::visit(
+            [&](auto rec) -> WALRecord
             {
-                auto record = wal_.read_log(current);
+                rec.prev_lsn = prev_lsn;
+                return rec;
+            },
+            clr
+        );
+
+        return wal_.append_log(clr);
+    }
+
+    LSN
+    RecoveryManager::rollback(const TxnId& txn_id, LSN last_lsn, IUndoTarget& target, LSN until)
+    {
+        LSN current = last_lsn;
+        LSN txn_prev_lsn = last_lsn;
+        bool rollback_marker_seen = false;
+
+        while (current != 0 && current > until)
+        {
+            auto record = wal_.read_log(current);
+
+            std::visit(
+                [&]<typename TRecord>(const TRecord& r)
+                {
+                    using R = std::decay_t<TRecord>;
+
+                    if constexpr (std::is_same_v<R, RollbackTxnRecord>)
+                    {
+                        // Undone already, before a crash.
+                        rollback_marker_seen = true;
+                        current = 0;
+                        return;
+                    }
 
-                std::visit(
-                    [&]<typename TRecord>(const TRecord& r)
+                    if constexpr (misc::is_in_variant_v<R, WALCLRRecord>)
                     {
-                        using R = std::decay_t<TRecord>;
-
-                        if constexpr (std::is_same_v<R, RollbackTxnRecord>)
-                        {
-                            txn_prev_lsn = r.lsn;
-                            rollback_marker_seen = true;
-                            current = 0;
-                            return;
-                        }
-
-                        if constexpr (misc::is_in_variant_v<R, WALCLRRecord>)
-                        {
-                            txn_prev_lsn = r.lsn;
-                            current = r.undo_next_lsn;
-                            return;
-                        }
-                        else if constexpr (misc::is_in_variant_v<R, WALDataRecord>)
-                        {
-                            auto page = io_.read_data_page(r.page_id);
-                            if (!page)
+                        // What it undid is skipped; txn_prev_lsn stays at the newest record.
+                        current = r.undo_next_lsn;
+                        return;
+                    }
+                    else if constexpr (misc::is_in_variant_v<R, WALDataRecord>)
+                    {
+                        const bool undone = target.change_page(
+                            r.table_id,
+                            r.page_id,
+                            [&](DataPage& page)
                             {
-                                current = r.prev_lsn;
-                                return;
+                                const LSN clr_lsn = append_clr(make_clr(r), txn_prev_lsn);
+                                undo_record(r, page);
+                                page.last_lsn = clr_lsn;
+                                txn_prev_lsn = clr_lsn;
                             }
+                        );
 
-                            auto clr = make_clr(r);
-                            clr = std::visit(
-                                [&](auto rec) -> WALRecord
-                                {
-                                    rec.lsn = txn_prev_lsn;
-                                    return rec;
-                                },
-                                clr
-                            );
-
-                            LSN clr_lsn = wal_.get_next_lsn();
-                            wal_.append_log(clr);
-                            wal_.flush();
-
-                            undo_record(r, *page);
-                            page->last_lsn = clr_lsn;
-                            io_.write_page(*page);
-
-                            txn_prev_lsn = clr_lsn;
-                        }
-                        else if constexpr (misc::is_in_variant_v<R, WALMetaRecord>)
-                        {
-                            auto clr = make_clr(r);
-                            clr = std::visit(
-                                [&](auto rec) -> WALRecord
-                                {
-                                    rec.lsn = txn_prev_lsn;
-                                    return rec;
-                                },
-                                clr
-                            );
-
-                            LSN clr_lsn = wal_.get_next_lsn();
-                            wal_.append_log(clr);
-                            wal_.flush();
-
-                            undo_record(r);
-                            txn_prev_lsn = clr_lsn;
-                        }
-
-                        current = r.prev_lsn;
-                    },
-                    record
-                );
-            }
+                        if (const auto dead = created_versions(r); undone && !dead.empty())
+                            target.unindex(r.table_id, r.page_id, dead, txn_prev_lsn);
+                    }
+                    else if constexpr (std::is_same_v<R, TableCountersRecord>)
+                    {
+                        // The CLR carries the resulting counters, computed from the same
+                        // table image the undo changes.
+                        target.change_table(
+                            r.table_id,
+                            [&](MetaTable& table)
+                            {
+                                txn_prev_lsn = append_clr(make_clr(r, table), txn_prev_lsn);
+                                undo_record(r, table);
+                            }
+                        );
+                    }
+                    else if constexpr (misc::is_in_variant_v<R, WALMetaRecord>)
+                    {
+                        txn_prev_lsn = append_clr(make_clr(r), txn_prev_lsn);
+                        wal_.flush();
+                        undo_record(r);
+                    }
 
-            if (!rollback_marker_seen)
-            {
-                RollbackTxnRecord rollback_marker(txn_prev_lsn, 0, txn_id);
-                wal_.append_log(rollback_marker);
-                wal_.flush();
-            }
+                    current = r.prev_lsn;
+                },
+                record
+            );
         }
+
+        if (until != 0 || rollback_marker_seen)
+            return txn_prev_lsn;
+
+        return wal_.append_log(RollbackTxnRecord(0, txn_prev_lsn, txn_id));
     }
+
     void
     RecoveryManager::undo_record(const InsertRecord& record, DataPage& page)
     {
-        for (auto& row : page.rows)
-        {
-            if (row.id != record.after.id)
-                continue;
+        set_obsolete(page, record.after.id, true);
+    }
+    void
+    RecoveryManager::undo_record(const InsertRowsRecord& record, DataPage& page)
+    {
+        std::unordered_set<RowId> ids;
+        for (const auto& row : record.after)
+            ids.insert(row.id);
 
-            row.flags |= DataRowFlags::OBSOLETE;
-            break;
+        for (size_t slot = 0; slot < page.slot_count; ++slot)
+        {
+            const auto row = page.row(slot);
+            if (ids.contains(row.id()))
+            {
+                page.set_flags(slot, row.flags() | DataRowFlags::OBSOLETE);
+                page.set_deleted_by(slot, 0);
+            }
         }
     }
     void
     RecoveryManager::undo_record(const UpdateRecord& record, DataPage& page)
     {
-        for (auto& row : page.rows)
-        {
-            if (row.id != record.after.id)
-                continue;
-
-            row.tokens = record.before.tokens;
-            row.flags &= ~DataRowFlags::OBSOLETE;
-            break;
-        }
+        // The old version is still on the page, only marked obsolete.
+        set_obsolete(page, record.after.id, true);
+        set_obsolete(page, record.before.id, false);
     }
     void
     RecoveryManager::undo_record(const DeleteRecord& record, DataPage& page)
     {
-        for (auto& row : page.rows)
-        {
-            if (row.id != record.before.id)
-                continue;
-
-            row.flags &= ~DataRowFlags::OBSOLETE;
-            break;
-        }
+        set_obsolete(page, record.before.id, false);
     }
 
     void
@@ -469,13 +657,13 @@ namespace recovery
     void
     RecoveryManager::undo_record(const UpdateTableRecord& record)
     {
-        io_.write_mt(record.before);
+        io_.write_mt(record.before, true);
     }
 
     void
     RecoveryManager::undo_record(const DeleteTableRecord& record)
     {
-        io_.write_mt(record.before);
+        io_.write_mt(record.before, true);
     }
 
     void
@@ -483,7 +671,7 @@ namespace recovery
     {
         MetaTable table = io_.read_table_meta(record.after.table_id);
         std::erase_if(table.indexes, [&](MetaIndex& value) { return value.id == record.after.id; });
-        io_.write_mt(table);
+        io_.write_mt(table, true);
     }
 
     void
@@ -491,7 +679,14 @@ namespace recovery
     {
         MetaTable table = io_.read_table_meta(record.before.table_id);
         table.indexes.push_back(record.before);
-        io_.write_mt(table);
+        io_.write_mt(table, true);
+    }
+
+    void
+    RecoveryManager::undo_record(const TableCountersRecord& record, MetaTable& table)
+    {
+        table.total_rows -= record.total_rows_delta;
+        table.live_rows -= record.live_rows_delta;
     }
 
     WALRecord
@@ -508,6 +703,25 @@ namespace recovery
         );
     }
 
+    WALRecord
+    RecoveryManager::make_clr(const InsertRowsRecord& record) const
+    {
+        std::vector<RowId> row_ids;
+        row_ids.reserve(record.after.size());
+        for (const auto& row : record.after)
+            row_ids.push_back(row.id);
+
+        return CLRInsertRowsRecord(
+            record.lsn,
+            0,
+            record.txn_id,
+            record.table_id,
+            record.page_id,
+            record.prev_lsn,
+            std::move(row_ids)
+        );
+    }
+
     WALRecord
     RecoveryManager::make_clr(const UpdateRecord& record) const
     {
@@ -589,64 +803,59 @@ namespace recovery
         return CLRDropIndexRecord(record.lsn, 0, record.txn_id, record.prev_lsn, record.before);
     }
 
-    std::unordered_map<TxnId, LSN>
-    RecoveryManager::get_commit_lsns(const std::vector<WALRecord>& wal) const
+    WALRecord
+    RecoveryManager::make_clr(const TableCountersRecord& record, const MetaTable& table) const
     {
-        std::unordered_map<TxnId, LSN> commit_lsns;
-
-        for (const auto& record : wal)
-        {
-            std::visit(
-                [&](const auto& rec)
-                {
-                    using R = std::decay_t<decltype(rec)>;
-
-                    if constexpr (std::is_same_v<R, CommitTxnRecord>)
-                    {
-                        commit_lsns[rec.txn_id] = rec.lsn;
-                    }
-                },
-                record
-            );
-        }
-        return commit_lsns;
+        return CLRTableCountersRecord(
+            record.lsn,
+            0,
+            record.txn_id,
+            record.prev_lsn,
+            record.table_id,
+            table.total_rows - record.total_rows_delta,
+            table.live_rows - record.live_rows_delta
+        );
     }
 
-    std::unordered_map<TxnId, LSN>
-    RecoveryManager::get_rollback_lsns(const std::vector<WALRecord>& wal) const
+    RecoveryManager::TxnTable
+    RecoveryManager::analyze(LSN from_lsn)
     {
-        std::unordered_map<TxnId, LSN> rollback_lsns;
+        TxnTable txns;
+
+        // Transactions active at the redo point may have logged nothing since.
+        if (checkpoint_)
+        {
+            for (const auto& [txn_id, last_lsn] : checkpoint_->active_txns)
+                txns.last_lsns[txn_id] = last_lsn;
+        }
 
-        for (const auto& record : wal)
+        auto records = wal_.iterate(from_lsn);
+        WALRecord record;
+        while (records->next(record))
         {
             std::visit(
                 [&](const auto& rec)
                 {
                     using R = std::decay_t<decltype(rec)>;
 
-                    if constexpr (std::is_same_v<R, RollbackTxnRecord>)
-                    {
-                        rollback_lsns[rec.txn_id] = rec.lsn;
-                    }
+                    if constexpr (std::is_same_v<R, CheckpointRecord> ||
+                                  std::is_same_v<R, LinkPageRecord>)
+                        return;
+
+                    txns.last_lsns[rec.txn_id] = rec.lsn;
+
+                    if constexpr (std::is_same_v<R, CommitTxnRecord>)
+                        txns.commit_lsns[rec.txn_id] = rec.lsn;
+                    else if constexpr (std::is_same_v<R, RollbackTxnRecord>)
+                        txns.rollback_lsns[rec.txn_id] = rec.lsn;
                 },
                 record
             );
         }
 
-        return rollback_lsns;
+        return txns;
     }
-    std::unordered_map<TxnId, LSN>
-    RecoveryManager::get_last_lsns(const std::vector<WALRecord>& wal) const
-    {
-        std::unordered_map<TxnId, LSN> last;
-
-        for (const auto& record : wal)
-        {
-            std::visit([&](const auto& r) { last[r.txn_id] = r.lsn; }, record);
-        }
 
-        return last;
-    }
     std::unordered_map<TxnId, LSN>
     RecoveryManager::get_active_txns(
         const std::unordered_map<TxnId, LSN>& last,
@@ -22,9 +22,11 @@ namespace sql
             {"add", SqlKeyword::ADD},
             {"alter", SqlKeyword::ALTER},
             {"autoincrement", SqlKeyword::AUTOINCREMENT},
+            {"begin", SqlKeyword::BEGIN},
             {"bool", SqlKeyword::BOOL},
             {"char", SqlKeyword::CHAR},
             {"column", SqlKeyword::COLUMN},
+            {"commit", SqlKeyword::COMMIT},
             {"create", SqlKeyword::CREATE},
             {"database", SqlKeyword::DATABASE},
             {"delete", SqlKeyword::DELETE},
@@ -41,6 +43,7 @@ namespace sql
             {"on", SqlKeyword::ON},
             {"primary", SqlKeyword::PRIMARY},
             {"real", SqlKeyword::REAL},
+            {"rollback", SqlKeyword::ROLLBACK},
             {"schema", SqlKeyword::SCHEMA},
             {"select", SqlKeyword::SELECT},
             {"set", SqlKeyword::SET},
@@ -124,6 +124,19 @@ namespace sql
             else
                 throw InvalidStatementSyntax("Unsupported statement");
         }
+        // Transaction control takes no arguments; the node holds the keyword token.
+        else if (match(SqlKeyword::BEGIN))
+        {
+            parsed = AstNode(AstNodeType::BEGIN, SqlToken(*current()));
+        }
+        else if (match(SqlKeyword::COMMIT))
+        {
+            parsed = AstNode(AstNodeType::COMMIT, SqlToken(*current()));
+        }
+        else if (match(SqlKeyword::ROLLBACK))
+        {
+            parsed = AstNode(AstNodeType::ROLLBACK, SqlToken(*current()));
+        }
         else if (match(SqlKeyword::ALTER))
         {
             if (!advance())
@@ -234,28 +247,40 @@ namespace sql
         advance_or_throw();
         match_or_throw(SqlKeyword::VALUES, "Expected 'VALUES' keyword");
 
-        advance_or_throw();
-        match_or_throw(SqlSymbol::LPAREN, "Expected left parenthesis");
-
-        ValuesExpr values{};
+        // VALUES (...), (...), ...
         while (true)
         {
-            advance_or_throw("Invalid statement syntax");
-            if (!match(SqlTokenType::LITERAL))
-                throw InvalidStatementSyntax("Expected a literal in VALUES expression");
+            advance_or_throw();
+            match_or_throw(SqlSymbol::LPAREN, "Expected left parenthesis");
+
+            ValuesExpr values{};
+            while (true)
+            {
+                advance_or_throw("Invalid statement syntax");
+                if (!match(SqlTokenType::LITERAL))
+                    throw InvalidStatementSyntax("Expected a literal in VALUES expression");
 
-            values.values.push_back(*current());
+                values.values.push_back(*current());
 
-            if (!advance() || !match(SqlSymbol::COMMA))
+                if (!advance() || !match(SqlSymbol::COMMA))
+                {
+                    current_--;
+                    break;
+                }
+            }
+            stmt.values.push_back(std::move(values));
+
+            advance_or_throw();
+            match_or_throw(SqlSymbol::RPAREN, "Expected right parenthesis");
+
+            if (!advance())
+                break;
+            if (!match(SqlSymbol::COMMA))
             {
                 current_--;
                 break;
             }
         }
-        stmt.values.push_back(values);
-
-        advance_or_throw();
-        match_or_throw(SqlSymbol::RPAREN, "Expected right parenthesis");
 
         return stmt;
     }
@@ -3,24 +3,29 @@
 //
 
 #include "BP_index_pager.hpp"
+
+#include <algorithm>
+#include <ranges>
+
 namespace storage
 {
     using namespace types;
 
     BPIndexPager::BPIndexPager(
-        BufferPool& buffer_pool, const TableId& table_id, const types::IndexId& index_id
+        BufferPool& buffer_pool, const TableId& table_id, const types::IndexId& index_id, LSN lsn
     )
-        : buffer_pool_(buffer_pool), table_id_(table_id), index_id_(index_id)
+        : buffer_pool_(buffer_pool), table_id_(table_id), index_id_(index_id), lsn_(lsn)
     {
     }
 
     IndexFile*
     BPIndexPager::file_or_throw() const
     {
-        auto* file = buffer_pool_.get_table_index(table_id_, index_id_);
-        if (!file)
+        if (!file_)
+            file_ = buffer_pool_.get_table_index(table_id_, index_id_);
+        if (!file_)
             throw std::runtime_error("BPIndexPager::file_or_throw");
-        return file;
+        return file_;
     }
 
     const IndexId&
@@ -32,57 +37,142 @@ namespace storage
     IndexPageId
     BPIndexPager::root_page_id() const
     {
-        auto* file = file_or_throw();
-        return file->root_page;
+        file_or_throw();
+        return buffer_pool_.root_ip(index_id_);
     }
 
     void
     BPIndexPager::set_root_page_id(IndexPageId root)
     {
-        auto* file = buffer_pool_.dirty_if(index_id_);
-        if (!file)
+        file_or_throw();
+        if (!buffer_pool_.set_root_ip(index_id_, root))
             throw std::runtime_error("BPIndexPager::set_root_page_id");
-        file->root_page = root;
     }
 
     IndexPage*
     BPIndexPager::get_page(IndexPageId page_id)
     {
-        auto* file = file_or_throw();
-        for (auto& p : file->pages)
-            if (p.id == page_id)
-                return &p;
+        if (auto it = pages_.find(page_id); it != pages_.end())
+            return it->second.page.get();
+
+        file_or_throw();
+        auto page = buffer_pool_.get_ip({index_id_, page_id});
+        if (!page)
+            return nullptr;
 
-        return nullptr;
+        return pages_.emplace(page_id, HeldPage{std::move(page)}).first->second.page.get();
     }
 
     IndexPage*
     BPIndexPager::create_page(bool is_leaf, IndexPageId parent)
     {
-        auto* file = buffer_pool_.dirty_if(index_id_);
-        if (!file)
+        file_or_throw();
+        auto page = buffer_pool_.create_ip(index_id_, is_leaf, parent);
+        if (!page)
             throw std::runtime_error("BPIndexPager::create_page");
 
-        IndexPage page;
-        page.id = ++file->last_page;
-        page.is_leaf = is_leaf;
-        page.parent = parent;
-        page.index_id = index_id_;
-        if (is_leaf)
-            page.data = LeafIndexNode{};
+        const auto page_id = page->id;
+        auto& held = pages_.emplace(page_id, HeldPage{std::move(page)}).first->second;
+        held.exclusive = std::unique_lock(held.page.latch());
+
+        held.page->last_lsn = std::max(held.page->last_lsn, lsn_);
+        return held.page.get();
+    }
+
+    bool
+    BPIndexPager::fits(const IndexPage& page)
+    {
+        return buffer_pool_.fits_ip(page);
+    }
+
+    bool
+    BPIndexPager::fits(const IndexPage& page, uint32_t fill_percent)
+    {
+        return buffer_pool_.fits_ip(page, fill_percent);
+    }
+
+    void
+    BPIndexPager::release(IndexPageId page_id)
+    {
+        pages_.erase(page_id);
+    }
+
+    void
+    BPIndexPager::latch(IndexPageId page_id, bool exclusive)
+    {
+        auto it = pages_.find(page_id);
+        if (it == pages_.end())
+            throw std::runtime_error("BPIndexPager::latch: page was not handed out");
+
+        auto& held = it->second;
+        if (held.exclusive.owns_lock())
+            return;
+
+        if (held.shared.owns_lock())
+        {
+            if (exclusive)
+                throw std::runtime_error("BPIndexPager::latch: a shared latch cannot be upgraded");
+            return;
+        }
+
+        if (exclusive)
+            held.exclusive = std::unique_lock(held.page.latch());
         else
-            page.data = InternalIndexNode{};
+            held.shared = std::shared_lock(held.page.latch());
+    }
 
-        file->pages.push_back(std::move(page));
-        return &file->pages.back();
+    bool
+    BPIndexPager::try_latch(IndexPageId page_id, bool exclusive)
+    {
+        auto it = pages_.find(page_id);
+        if (it == pages_.end())
+            throw std::runtime_error("BPIndexPager::try_latch: page was not handed out");
+
+        auto& held = it->second;
+        if (held.exclusive.owns_lock() || held.shared.owns_lock())
+        {
+            if (exclusive && !held.exclusive.owns_lock())
+                throw std::runtime_error("BPIndexPager::try_latch: a shared latch cannot be upgraded");
+            return true;
+        }
+
+        if (exclusive)
+        {
+            held.exclusive = std::unique_lock(held.page.latch(), std::try_to_lock);
+            return held.exclusive.owns_lock();
+        }
+
+        held.shared = std::shared_lock(held.page.latch(), std::try_to_lock);
+        return held.shared.owns_lock();
+    }
+
+    void
+    BPIndexPager::unlatch(IndexPageId page_id)
+    {
+        auto it = pages_.find(page_id);
+        if (it == pages_.end())
+            return;
+
+        if (it->second.exclusive.owns_lock())
+            it->second.exclusive.unlock();
+        if (it->second.shared.owns_lock())
+            it->second.shared.unlock();
+    }
+
+    void
+    BPIndexPager::unlatch_all()
+    {
+        for (const auto& page_id : pages_ | std::views::keys)
+            unlatch(page_id);
     }
 
     void
-    BPIndexPager::mark_dirty()
+    BPIndexPager::mark_dirty(IndexPageId page_id)
     {
-        auto* file = buffer_pool_.dirty_if(index_id_);
-        if (!file)
+        auto* page = buffer_pool_.dirty_ip({index_id_, page_id});
+        if (!page)
             throw std::runtime_error("BPIndexPager::mark_dirty");
+        page->last_lsn = std::max(page->last_lsn, lsn_);
     }
 
     void
@@ -6,11 +6,61 @@
 
 #include <algorithm>
 #include <ranges>
+#include <unordered_set>
 
 namespace storage
 {
     using namespace types;
 
+    void
+    PageLatches::lock(const PageGuard& page)
+    {
+        for (const auto& held : held_)
+            if (held.page->id == page->id)
+                return;
+
+        auto& held = held_.emplace_back(page.clone());
+        held.lock = std::unique_lock(held.page.latch());
+    }
+
+    void
+    PageLatches::unlock(const DataPageId& page_id)
+    {
+        std::erase_if(held_, [&](const Held& held) { return held.page->id == page_id; });
+    }
+
+    void
+    PageLatches::unlock_all()
+    {
+        held_.clear();
+    }
+
+    BufferPool::PoolGuard::PoolGuard(const BufferPool& pool) : pool_(pool)
+    {
+        pool_.mtx_.lock();
+        ++pool_.guard_depth_;
+    }
+
+    BufferPool::PoolGuard::~PoolGuard()
+    {
+        LSN wanted = 0;
+        if (--pool_.guard_depth_ == 0)
+            wanted = std::exchange(pool_.barrier_wanted_, 0);
+        pool_.mtx_.unlock();
+
+        if (wanted == 0 || !pool_.wal_barrier_)
+            return;
+
+        // Only lets eviction write those frames sooner: if the WAL fails, they stay.
+        try
+        {
+            pool_.wal_barrier_(wanted);
+        }
+        catch (const std::exception&)
+        {
+        }
+    }
+
     void
     BufferPool::flush(DataPageBuffer::CacheEntry& page_entry)
     {
@@ -22,101 +72,336 @@ namespace storage
     }
 
     void
-    BufferPool::flush(IndexFileBuffer::CacheEntry& index_file_entry)
+    BufferPool::flush(IndexPageBuffer::CacheEntry& index_page_entry)
     {
-        if (index_file_entry.dirty)
+        if (index_page_entry.dirty)
         {
-            io_.write_index_file(index_file_entry.value, true);
-            index_file_entry.dirty = false;
+            io_.write_index_page(index_page_entry.value, true);
+            index_page_entry.dirty = false;
         }
     }
 
+    void
+    BufferPool::flush(IndexFile& index_file)
+    {
+        if (index_file.dirty)
+        {
+            io_.write_index_file(index_file, true);
+            index_file.dirty = false;
+        }
+    }
+
+    bool
+    BufferPool::evictable(bool dirty, LSN last_lsn) const
+    {
+        if (!dirty || !durable_lsn_ || last_lsn <= durable_lsn_())
+            return true;
+
+        barrier_wanted_ = std::max(barrier_wanted_, last_lsn);
+        return false;
+    }
+
+    std::size_t
+    BufferPool::footprint(const DataPage& page)
+    {
+        return sizeof(DataPage) + page.body.capacity();
+    }
+
+    std::size_t
+    BufferPool::footprint(const IndexPage&)
+    {
+        // Charged as the block it is read from, whatever its keys take in memory.
+        return MAX_IP_SIZE;
+    }
+
     void
     BufferPool::initialize()
     {
+        PoolGuard guard(*this);
         data_pages_per_table_ = io_.map_data_pages_for_table();
         index_files_per_table_ = io_.map_index_files_for_table();
     };
 
-    DataPage*
+    PageGuard
     BufferPool::create_dp(const MetaTable& mt)
     {
         DataPageId id = DataPageId::make();
         DataPage new_page = io_.create_page(mt, id);
-        data_pages_.put(id, std::move(new_page), data_page_flusher_);
+        PageGuard page(data_pages_.put(id, std::move(new_page), data_page_flusher_));
 
         auto it = data_pages_per_table_.find(mt.id);
+        const bool first = it == data_pages_per_table_.end() || it->second.empty();
         if (it == data_pages_per_table_.end())
             data_pages_per_table_[mt.id] = { id };
         else
             data_pages_per_table_.at(mt.id).push_back(id);
 
-        return &data_pages_.get(id)->value;
+        auto& fsm = load_fsm(mt.id);
+        fsm.set(id, free_bytes(*page));
+        if (first)
+            fsm.head = id;
+        fsm.tail = id;
+        fsm.dirty = true;
+
+        return page;
+    }
+
+    PageGuard
+    BufferPool::load_dp(const DataPageId& page_id)
+    {
+        auto pinned = data_pages_.pin(page_id);
+        if (pinned)
+            return pinned;
+
+        auto loaded_page = io_.read_data_page(page_id);
+        if (!loaded_page)
+            return {};
+
+        return PageGuard(data_pages_.put(page_id, std::move(*loaded_page), data_page_flusher_));
+    }
+
+    IndexPageGuard
+    BufferPool::load_ip(const IndexPageKey& key)
+    {
+        auto pinned = index_pages_.pin(key);
+        if (pinned)
+            return pinned;
+
+        auto loaded_page = io_.read_index_page(key.index_id, key.page_id);
+        if (!loaded_page)
+            return {};
+
+        return IndexPageGuard(index_pages_.put(key, std::move(*loaded_page), index_page_flusher_));
     }
 
     void
     BufferPool::put_dp(const DataPageId& page_id, DataPage&& page)
     {
+        PoolGuard guard(*this);
         data_pages_.put(page_id, {std::move(page)}, data_page_flusher_);
     }
 
-    DataPage*
+    PageGuard
     BufferPool::get_dp(const DataPageId& page_id)
     {
-        auto* entry = data_pages_.get(page_id);
+        PoolGuard guard(*this);
+        return load_dp(page_id);
+    }
 
-        if (!entry)
+    uint64_t
+    BufferPool::free_bytes(const DataPage& page)
+    {
+        return page.size < DataPage::MAX_SIZE ? DataPage::MAX_SIZE - page.size : 0;
+    }
+
+    FreeSpaceMap&
+    BufferPool::load_fsm(const TableId& table_id)
+    {
+        auto it = free_space_.find(table_id);
+        if (it != free_space_.end())
+            return it->second;
+
+        auto stored = io_.read_fsm(table_id);
+        FreeSpaceMap fsm = stored ? std::move(*stored) : FreeSpaceMap(table_id);
+        reconcile_fsm(fsm);
+
+        return free_space_.emplace(table_id, std::move(fsm)).first->second;
+    }
+
+    void
+    BufferPool::reconcile_fsm(FreeSpaceMap& fsm)
+    {
+        const auto pages_it = data_pages_per_table_.find(fsm.table_id);
+        if (pages_it == data_pages_per_table_.end())
         {
-            auto loaded_page = io_.read_data_page(page_id);
-            if (!loaded_page)
-                return nullptr;
+            fsm = FreeSpaceMap(fsm.table_id);
+            return;
+        }
 
-            data_pages_.put(page_id, std::move(*loaded_page), data_page_flusher_);
+        const std::unordered_set<DataPageId> existing(pages_it->second.begin(), pages_it->second.end());
 
-            entry = data_pages_.get(page_id);
+        std::vector<DataPageId> gone;
+        for (const auto& page_id : fsm.pages() | std::views::keys)
+        {
+            if (!existing.contains(page_id))
+                gone.push_back(page_id);
         }
 
-        return entry ? &entry->value : nullptr;
+        for (const auto& page_id : gone)
+            fsm.erase(page_id);
+
+        for (const auto& page_id : pages_it->second)
+        {
+            if (fsm.contains(page_id))
+                continue;
+
+            if (const auto* entry = data_pages_.peek(page_id))
+            {
+                fsm.set(page_id, free_bytes(entry->value));
+                continue;
+            }
+
+            if (const auto page = io_.read_data_page(page_id))
+                fsm.set(page_id, free_bytes(*page));
+        }
+
+        if (fsm.head != DataPageId::null() && !fsm.contains(fsm.head))
+        {
+            fsm.head = DataPageId::null();
+            fsm.dirty = true;
+        }
+
+        if (fsm.tail != DataPageId::null() && !fsm.contains(fsm.tail))
+        {
+            fsm.tail = DataPageId::null();
+            fsm.dirty = true;
+        }
     }
 
-    DataPage*
+    DataPageId
+    BufferPool::find_tail(const TableId& table_id)
+    {
+        const auto pages_it = data_pages_per_table_.find(table_id);
+        if (pages_it == data_pages_per_table_.end())
+            return DataPageId::null();
+
+        std::unordered_set<DataPageId> linked;
+        std::vector<DataPageId> ends;
+        for (const auto& page_id : pages_it->second)
+        {
+            auto page = load_dp(page_id);
+            if (!page)
+                continue;
+
+            if (page->next == DataPageId::null())
+                ends.push_back(page_id);
+            else
+                linked.insert(page->next);
+        }
+
+        // Prefer an end that another page is chained to over a page never linked.
+        for (const auto& page_id : ends)
+        {
+            if (ends.size() == 1 || linked.contains(page_id))
+                return page_id;
+        }
+
+        return ends.empty() ? DataPageId::null() : ends.front();
+    }
+
+    PageGuard
     BufferPool::prepare_dp(size_t size, const MetaTable& mt)
     {
-        auto table_pages_it = data_pages_per_table_.find(mt.id);
-        if (table_pages_it == data_pages_per_table_.end())
-            return create_dp(mt);
+        PoolGuard guard(*this);
+        auto& fsm = load_fsm(mt.id);
 
-        for (const auto& page_id : table_pages_it->second)
+        // The map may be stale after a crash; a page that turns out to be fuller than it
+        // says is corrected and the search goes on.
+        while (const auto page_id = fsm.find(size))
         {
-            auto* page = get_dp(page_id);
+            auto page = load_dp(*page_id);
             if (!page)
+            {
+                fsm.erase(*page_id);
                 continue;
+            }
 
-            if (page->size + size <= DataPage::MAX_SIZE)
+            const auto free = free_bytes(*page);
+            fsm.set(*page_id, free);
+            if (free >= size)
                 return page;
         }
 
         return create_dp(mt);
     }
 
-    std::vector<DataPage*>
-    BufferPool::get_table_data(const TableId& table_id)
+    DataPageId
+    BufferPool::tail_dp(const TableId& table_id)
+    {
+        PoolGuard guard(*this);
+        auto& fsm = load_fsm(table_id);
+
+        if (fsm.tail == DataPageId::null() && !fsm.pages().empty())
+        {
+            fsm.tail = find_tail(table_id);
+            fsm.dirty = true;
+        }
+
+        // The stored tail may be behind the chain if pages were linked after the map
+        // was last written.
+        DataPageId tail = fsm.tail;
+        while (tail != DataPageId::null())
+        {
+            auto page = load_dp(tail);
+            if (!page)
+            {
+                tail = find_tail(table_id);
+                break;
+            }
+
+            if (page->next == DataPageId::null())
+                break;
+
+            tail = page->next;
+        }
+
+        if (tail != fsm.tail)
+        {
+            fsm.tail = tail;
+            fsm.dirty = true;
+        }
+
+        return tail;
+    }
+
+    DataPageId
+    BufferPool::head_dp(const TableId& table_id)
+    {
+        PoolGuard guard(*this);
+        return load_fsm(table_id).head;
+    }
+
+    void
+    BufferPool::set_head_dp(const TableId& table_id, const DataPageId& page_id)
+    {
+        PoolGuard guard(*this);
+        auto& fsm = load_fsm(table_id);
+        if (fsm.head == page_id)
+            return;
+
+        fsm.head = page_id;
+        fsm.dirty = true;
+    }
+
+    void
+    BufferPool::flush_fsm()
+    {
+        PoolGuard guard(*this);
+        for (auto& fsm : free_space_ | std::views::values)
+        {
+            if (!fsm.dirty)
+                continue;
+
+            io_.write_fsm(fsm);
+            fsm.dirty = false;
+        }
+    }
+
+    std::vector<DataPageId>
+    BufferPool::table_pages(const TableId& table_id) const
     {
+        PoolGuard guard(*this);
         auto pages_list_it = data_pages_per_table_.find(table_id);
         if (pages_list_it == data_pages_per_table_.end())
             return {};
 
-        std::vector<DataPage*> pages;
-
-        for (const auto& page_id : pages_list_it->second)
-            pages.push_back(get_dp(page_id));
-
-        return pages;
+        return pages_list_it->second;
     }
 
     IndexFile*
     BufferPool::get_table_index(const UUID& table_id, const IndexId& index_id)
     {
+        PoolGuard guard(*this);
         auto index_files_list_it = index_files_per_table_.find(table_id);
         if (index_files_list_it == index_files_per_table_.end())
             return nullptr;
@@ -129,106 +414,330 @@ namespace storage
         if (!found)
             return nullptr;
 
-        auto* entry = index_files_.get(index_id);
+        if (auto it = index_files_.find(index_id); it != index_files_.end())
+            return &it->second;
 
-        if (!entry)
-        {
-            auto loaded_file = io_.read_index_file(index_id);
-            if (!loaded_file)
-                return nullptr;
-
-            index_files_.put(index_id, std::move(*loaded_file), index_file_flusher_);
-            entry = index_files_.get(index_id);
-        }
+        auto loaded_file = io_.read_index_file(index_id);
+        if (!loaded_file)
+            return nullptr;
 
-        return entry ? &entry->value : nullptr;
+        return &index_files_.emplace(index_id, std::move(*loaded_file)).first->second;
     }
 
     void
     BufferPool::create_table_index(
-        const std::string& schema_name,
-        const MetaTable& table,
-        const MetaIndex& index,
-        LSN last_lsn
+        const std::string& schema_name, const MetaTable& table, const MetaIndex& index
     )
     {
+        PoolGuard guard(*this);
         IndexFile file = io_.create_index_file(schema_name, table.name, index);
-        file.last_lsn = last_lsn;
+        index_files_.insert_or_assign(index.id, std::move(file));
 
-        index_files_.put(index.id, std::move(file), index_file_flusher_);
-        index_files_.mark_dirty(file.index_id);
-
-        auto it = index_files_per_table_.find(table.id);
-        if (it == index_files_per_table_.end())
-            index_files_per_table_[table.id] = {index.id};
-        else
-            it->second.push_back(index.id);
+        // An index rebuilt after recovery is created again under its own id.
+        auto& ids = index_files_per_table_[table.id];
+        if (std::find(ids.begin(), ids.end(), index.id) == ids.end())
+            ids.push_back(index.id);
     }
 
     IndexFile*
     BufferPool::dirty_if(const IndexId& index_id)
     {
-        index_files_.mark_dirty(index_id);
-        auto* entry = index_files_.get(index_id);
-        return entry ? &entry->value : nullptr;
+        PoolGuard guard(*this);
+        auto it = index_files_.find(index_id);
+        if (it == index_files_.end())
+            return nullptr;
+
+        it->second.dirty = true;
+        return &it->second;
     }
 
-    void
-    BufferPool::set_if_lsn(const IndexId& index_id, LSN last_lsn)
+    IndexPageId
+    BufferPool::root_ip(const IndexId& index_id) const
     {
-        auto* entry = index_files_.get(index_id);
-        if (!entry)
-            return;
+        PoolGuard guard(*this);
+        auto it = index_files_.find(index_id);
+        if (it == index_files_.end())
+            throw std::runtime_error("BufferPool::root_ip: index is not opened");
 
-        entry->value.last_lsn = std::max(entry->value.last_lsn, last_lsn);
+        return it->second.root_page;
+    }
+
+    bool
+    BufferPool::set_root_ip(const IndexId& index_id, IndexPageId root)
+    {
+        PoolGuard guard(*this);
+        auto* file = dirty_if(index_id);
+        if (!file)
+            return false;
+
+        file->root_page = root;
+        return true;
+    }
+
+    IndexPageGuard
+    BufferPool::get_ip(const IndexPageKey& key)
+    {
+        PoolGuard guard(*this);
+        return load_ip(key);
+    }
+
+    IndexPageGuard
+    BufferPool::create_ip(const IndexId& index_id, bool is_leaf, IndexPageId parent)
+    {
+        PoolGuard guard(*this);
+        auto* file = dirty_if(index_id);
+        if (!file)
+            return {};
+
+        IndexPage page;
+        page.id = ++file->last_page;
+        page.parent = parent;
+        page.index_id = index_id;
+        page.is_leaf = is_leaf;
+        if (is_leaf)
+            page.data = LeafIndexNode{};
+        else
+            page.data = InternalIndexNode{};
+
+        const IndexPageKey key{index_id, page.id};
+        IndexPageGuard pinned(index_pages_.put(key, std::move(page), index_page_flusher_));
+        index_pages_.mark_dirty(key);
+        return pinned;
+    }
+
+    IndexPage*
+    BufferPool::dirty_ip(const IndexPageKey& key)
+    {
+        PoolGuard guard(*this);
+        index_pages_.mark_dirty(key);
+        auto* entry = index_pages_.peek(key);
+        return entry ? &entry->value : nullptr;
+    }
+
+    bool
+    BufferPool::fits_ip(const IndexPage& page, uint32_t fill_percent)
+    {
+        return io_.estimate_size(page) * 100 <= MAX_IP_SIZE * fill_percent;
     }
 
     DataPage*
     BufferPool::dirty_dp(const DataPageId& page_id)
     {
+        PoolGuard guard(*this);
         data_pages_.mark_dirty(page_id);
-        auto* entry = data_pages_.get(page_id);
-        return entry ? &entry->value : nullptr;
+        auto* entry = data_pages_.peek(page_id);
+        if (!entry)
+            return nullptr;
+
+        if (auto it = free_space_.find(entry->value.table_id); it != free_space_.end())
+            it->second.set(page_id, free_bytes(entry->value));
+
+        return &entry->value;
     }
 
     void
-    BufferPool::flush_dirty()
+    BufferPool::flush_dp(const DataPageId& page_id, LSN max_lsn)
     {
-        for (auto& page : data_pages_ | std::views::values)
+        PageGuard page;
         {
-            flush(page);
+            PoolGuard guard(*this);
+            page = PageGuard(data_pages_.peek(page_id));
         }
+        if (!page)
+            return;
 
-        for (auto& index : index_files_ | std::views::values)
+        // The latch comes first, so that a writer holding it is not left waiting for
+        // the pool. It also keeps last_lsn from moving while the WAL is waited for.
+        std::shared_lock latch(page.latch());
+        if (page->last_lsn > max_lsn)
+            return;
+
+        if (wal_barrier_)
+            wal_barrier_(page->last_lsn);
+
+        PoolGuard guard(*this);
+        if (auto* entry = data_pages_.peek(page_id))
+            flush(*entry);
+    }
+
+    void
+    BufferPool::flush_ip(const IndexPageKey& key, LSN max_lsn)
+    {
+        IndexPageGuard page;
+        {
+            PoolGuard guard(*this);
+            page = IndexPageGuard(index_pages_.peek(key));
+        }
+        if (!page)
+            return;
+
+        std::shared_lock latch(page.latch());
+        if (page->last_lsn > max_lsn)
+            return;
+
+        if (wal_barrier_)
+            wal_barrier_(page->last_lsn);
+
+        PoolGuard guard(*this);
+        if (auto* entry = index_pages_.peek(key))
+            flush(*entry);
+    }
+
+    void
+    BufferPool::flush_index_files()
+    {
+        // A root created after the last round of page writes goes first.
+        std::vector<IndexPageKey> roots;
+        {
+            PoolGuard guard(*this);
+            for (const auto& index_file : index_files_ | std::views::values)
+            {
+                if (index_file.dirty)
+                    roots.push_back({index_file.index_id, index_file.root_page});
+            }
+        }
+
+        for (const auto& key : roots)
+            flush_ip(key);
+
+        PoolGuard guard(*this);
+        for (auto& index_file : index_files_ | std::views::values)
+            flush(index_file);
+    }
+
+    std::vector<DataPageId>
+    BufferPool::dirty_data_pages() const
+    {
+        PoolGuard guard(*this);
+        std::vector<DataPageId> ids;
+        for (const auto& [id, page] : data_pages_)
         {
-            flush(index);
+            if (page.dirty)
+                ids.push_back(id);
         }
+
+        return ids;
+    }
+
+    std::vector<IndexPageKey>
+    BufferPool::dirty_index_pages() const
+    {
+        PoolGuard guard(*this);
+        std::vector<IndexPageKey> keys;
+        for (const auto& [key, page] : index_pages_)
+        {
+            if (page.dirty)
+                keys.push_back(key);
+        }
+
+        return keys;
+    }
+
+    void
+    BufferPool::flush_dirty()
+    {
+        flush_dirty(std::numeric_limits<LSN>::max());
+        flush_index_files();
     }
 
     void
     BufferPool::flush_dirty(LSN max_lsn)
     {
+        for (const auto& page_id : dirty_data_pages())
+            flush_dp(page_id, max_lsn);
+
+        for (const auto& key : dirty_index_pages())
+            flush_ip(key, max_lsn);
+    }
+
+    void
+    BufferPool::set_wal_barrier(
+        std::function<void(LSN)> wal_barrier, std::function<LSN()> durable_lsn
+    )
+    {
+        PoolGuard guard(*this);
+        wal_barrier_ = std::move(wal_barrier);
+        durable_lsn_ = std::move(durable_lsn);
+    }
+
+    size_t
+    BufferPool::write_dirty(
+        LSN durable_lsn,
+        std::chrono::steady_clock::time_point dirty_before,
+        uint32_t dirty_percent,
+        size_t max_frames
+    )
+    {
+        PoolGuard guard(*this);
+
+        size_t dirty_bytes = 0;
+        std::vector<DataPageBuffer::CacheEntry*> candidates;
         for (auto& page : data_pages_ | std::views::values)
         {
             if (!page.dirty)
                 continue;
 
-            if (page.value.last_lsn > max_lsn)
+            dirty_bytes += page.charge;
+            if (page.value.last_lsn <= durable_lsn)
+                candidates.push_back(&page);
+        }
+
+        std::ranges::sort(candidates, {}, &DataPageBuffer::CacheEntry::dirty_since);
+
+        const size_t dirty_limit = data_pages_.capacity_bytes() / 100 * dirty_percent;
+        size_t written = 0;
+
+        for (auto* page : candidates)
+        {
+            if (written == max_frames)
+                return written;
+
+            // Candidates are ordered by age, so the remaining ones are younger still.
+            if (page->dirty_since > dirty_before && dirty_bytes <= dirty_limit)
+                break;
+
+            std::shared_lock latch(page->latch, std::try_to_lock);
+            if (!latch)
                 continue;
 
-            flush(page);
+            dirty_bytes -= page->charge;
+            flush(*page);
+            ++written;
         }
 
-        for (auto& index : index_files_ | std::views::values)
+        for (auto& index_page : index_pages_ | std::views::values)
         {
-            if (!index.dirty)
+            if (written == max_frames)
+                break;
+
+            if (!index_page.dirty || index_page.value.last_lsn > durable_lsn)
                 continue;
 
-            if (index.value.last_lsn > max_lsn)
+            if (index_page.dirty_since > dirty_before)
                 continue;
 
-            flush(index);
+            std::shared_lock latch(index_page.latch, std::try_to_lock);
+            if (!latch)
+                continue;
+
+            flush(index_page);
+            ++written;
         }
+
+        return written;
     }
 
+    DataPageBuffer::Stats
+    BufferPool::data_page_stats() const
+    {
+        PoolGuard guard(*this);
+        return data_pages_.stats();
+    }
+
+    IndexPageBuffer::Stats
+    BufferPool::index_page_stats() const
+    {
+        PoolGuard guard(*this);
+        return index_pages_.stats();
+    }
 } // namespace storage
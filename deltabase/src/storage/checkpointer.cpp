@@ -0,0 +1,150 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "include/checkpointer.hpp"
+
+#include "../misc/include/logger.hpp"
+
+#include <algorithm>
+
+namespace storage
+{
+    using namespace types;
+
+    Checkpointer::Checkpointer(
+        BufferPool& buffer_pool,
+        CatalogCache& catalog,
+        wal::IWALManager& wal_manager,
+        IIOManager& io_manager,
+        std::shared_mutex& catalog_latch,
+        Config& cfg
+    )
+        : buffer_pool_(buffer_pool), catalog_(catalog), wal_manager_(wal_manager),
+          io_manager_(io_manager), catalog_latch_(catalog_latch), cfg_(cfg),
+          interval_(cfg.checkpoint_interval_ms)
+    {
+    }
+
+    Checkpointer::~Checkpointer()
+    {
+        stop();
+    }
+
+    void
+    Checkpointer::start()
+    {
+        std::lock_guard lk(mtx_);
+        if (thread_.joinable())
+            return;
+
+        stopping_ = false;
+        thread_ = std::thread([this] { run(); });
+    }
+
+    void
+    Checkpointer::stop()
+    {
+        {
+            std::lock_guard lk(mtx_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+    void
+    Checkpointer::run()
+    {
+        std::unique_lock lk(mtx_);
+        while (!stopping_)
+        {
+            cv_.wait_for(lk, interval_, [this] { return stopping_; });
+            if (stopping_)
+                break;
+
+            lk.unlock();
+
+            try
+            {
+                checkpoint();
+            }
+            catch (const std::exception& e)
+            {
+                // The previous checkpoint stays in effect; the next round tries again.
+                misc::Logger::error(std::string("Checkpointer::run: ") + e.what());
+            }
+
+            lk.lock();
+        }
+    }
+
+    LSN
+    Checkpointer::checkpoint()
+    {
+        std::lock_guard checkpoint_guard(checkpoint_mtx_);
+
+        // Every change below the redo point has already been applied to a frame or to
+        // the catalog, since both are only modified by statements, and none is running.
+        wal::TxnSnapshot txns;
+        std::vector<DataPageId> pages;
+        std::vector<IndexPageKey> index_pages;
+        {
+            std::unique_lock latch(catalog_latch_);
+            txns = wal_manager_.snapshot_txns();
+            pages = buffer_pool_.dirty_data_pages();
+            index_pages = buffer_pool_.dirty_index_pages();
+            catalog_.flush();
+            buffer_pool_.flush_fsm();
+        }
+
+        const LSN redo_lsn = txns.next_lsn;
+
+        // Frames dirtied after the snapshot only hold changes at or above the redo point,
+        // so writing the snapshot is enough. Frames evicted meanwhile were written then.
+        // Statements go on meanwhile; each frame is latched only while it is written.
+        for (const auto& page_id : pages)
+            buffer_pool_.flush_dp(page_id);
+
+        for (const auto& key : index_pages)
+            buffer_pool_.flush_ip(key);
+
+        // Headers name roots, which only change in the middle of a statement.
+        {
+            std::unique_lock latch(catalog_latch_);
+            buffer_pool_.flush_index_files();
+        }
+
+        std::vector<std::pair<UUID, LSN>> active_txns;
+        active_txns.reserve(txns.active.size());
+        LSN keep_from = redo_lsn;
+        for (const auto& txn : txns.active)
+        {
+            active_txns.emplace_back(txn.txn_id, txn.last_lsn);
+            keep_from = std::min(keep_from, txn.first_lsn);
+        }
+
+        // The dirty page table is taken together with the append: a page missing from it
+        // had every change logged before the record on disk.
+        LSN checkpoint_lsn;
+        {
+            std::unique_lock latch(catalog_latch_);
+            CheckpointRecord record(redo_lsn, std::move(active_txns), buffer_pool_.dirty_data_pages());
+            checkpoint_lsn = wal_manager_.append_log(record);
+        }
+
+        wal_manager_.wait_for_durable(checkpoint_lsn);
+
+        {
+            std::unique_lock latch(catalog_latch_);
+            cfg_.last_checkpoint_lsn = checkpoint_lsn;
+            io_manager_.write_cfg(cfg_);
+        }
+
+        // Only once the config points past them may the old segments go.
+        wal_manager_.truncate(keep_from);
+        return checkpoint_lsn;
+    }
+} // namespace storage
@@ -0,0 +1,88 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "include/db_instance_registry.hpp"
+
+#include <stdexcept>
+
+namespace storage
+{
+    using namespace types;
+
+    std::string
+    DbInstanceRegistry::make_key(const fs::path& db_path, const std::string& db_name)
+    {
+        return fs::weakly_canonical(db_path).string() + "::" + db_name;
+    }
+
+    std::shared_ptr<DbInstanceRegistry>
+    DbInstanceRegistry::shared()
+    {
+        static auto registry = std::make_shared<DbInstanceRegistry>();
+        return registry;
+    }
+
+    std::shared_ptr<StdDbInstance>
+    DbInstanceRegistry::acquire(const Config& cfg)
+    {
+        if (!cfg.db_name.has_value())
+            throw std::runtime_error("DbInstanceRegistry::acquire: config has no database name");
+
+        const auto key = make_key(cfg.db_path, cfg.db_name.value());
+
+        std::unique_lock<std::mutex> guard(registry_mutex_);
+
+        while (true)
+        {
+            auto it = instances_.find(key);
+            if (it == instances_.end())
+                break;
+
+            if (auto instance = it->second.lock())
+                return instance;
+
+            // Either another attach is still opening it, so that recovery runs once, or it
+            // was released and is still closing, so its files are not free yet.
+            changed_.wait(guard);
+        }
+
+        // The instance is constructed without the registry lock, so that a slow recovery
+        // holds up only the attaches of this database.
+        instances_[key] = {};
+        guard.unlock();
+
+        std::shared_ptr<StdDbInstance> instance;
+        try
+        {
+            instance = std::shared_ptr<StdDbInstance>(
+                new StdDbInstance(cfg),
+                [registry = shared_from_this(), key](StdDbInstance* released)
+                { registry->release(key, released); }
+            );
+        }
+        catch (...)
+        {
+            // The waiting attaches try to open it themselves.
+            guard.lock();
+            instances_.erase(key);
+            changed_.notify_all();
+            throw;
+        }
+
+        guard.lock();
+        instances_[key] = instance;
+        changed_.notify_all();
+        return instance;
+    }
+
+    void
+    DbInstanceRegistry::release(const std::string& key, StdDbInstance* instance)
+    {
+        delete instance;
+
+        std::lock_guard<std::mutex> guard(registry_mutex_);
+        instances_.erase(key);
+        changed_.notify_all();
+    }
+} // namespace storage
@@ -43,12 +43,28 @@ namespace storage
         throw std::logic_error("DetachedDbInstance::seq_scan_begin: this method is not supported");
     }
 
+    ScanCursor
+    DetachedDbInstance::seq_scan_begin(
+        const std::string& table_name, const std::string& schema_name, const txn::Transaction& txn
+    )
+    {
+        throw std::logic_error("DetachedDbInstance::seq_scan_begin: this method is not supported");
+    }
+
     bool
     DetachedDbInstance::seq_scan_next(types::ScanCursor& cursor, types::DataRow& out)
     {
         throw std::logic_error("DetachedDbInstance::seq_scan_next: this method is not supported");
     }
 
+    bool
+    DetachedDbInstance::seq_scan_next(
+        types::ScanCursor& cursor, types::DataRow& out, const RowFilter& filter
+    )
+    {
+        throw std::logic_error("DetachedDbInstance::seq_scan_next: this method is not supported");
+    }
+
     DataTable
     DetachedDbInstance::index_scan(
         const std::string& table_name,
@@ -60,6 +76,30 @@ namespace storage
         throw std::logic_error("DetachedDbInstance::index_scan: this method is not supported");
     }
 
+    DataTable
+    DetachedDbInstance::index_scan(
+        const std::string& table_name,
+        const std::string& schema_name,
+        const IndexId& index_id,
+        const BinaryExpr& condition,
+        const txn::Transaction& txn
+    )
+    {
+        throw std::logic_error("DetachedDbInstance::index_scan: this method is not supported");
+    }
+
+    uint64_t
+    DetachedDbInstance::index_range_count(
+        const std::string& table_name,
+        const std::string& schema_name,
+        const IndexId& index_id,
+        const BinaryExpr& condition,
+        uint64_t limit
+    )
+    {
+        throw std::logic_error("DetachedDbInstance::index_range_count: this method is not supported");
+    }
+
     txn::Transaction
     DetachedDbInstance::make_txn()
     {
@@ -78,6 +118,18 @@ namespace storage
         throw std::logic_error("DetachedDbInstance::insert_row: this method is not supported");
     }
 
+    void
+    DetachedDbInstance::insert_rows(
+        const std::string& table_name,
+        const std::string& schema_name,
+        const std::optional<std::vector<std::string>>& cols,
+        std::vector<std::vector<DataToken>> rows,
+        txn::Transaction& txn
+    )
+    {
+        throw std::logic_error("DetachedDbInstance::insert_rows: this method is not supported");
+    }
+
     bool
     DetachedDbInstance::exists_table(const std::string& table_name, const std::string& schema_name)
     {
@@ -168,7 +220,7 @@ namespace storage
 
     std::vector<types::IndexId>
     DetachedDbInstance::insert_row_into_indexes(
-        const MetaTable& mt, const DataRow& row, const DataPageId& page_id
+        const MetaTable& mt, const DataRow& row, const DataPageId& page_id, const txn::Transaction& txn
     )
     {
         throw std::logic_error("DetachedDbInstance::insert_row_into_indexes: this method is not supported");
@@ -93,6 +93,12 @@ namespace storage
         throw std::logic_error("DetachedFileIOManager::estimate_size: unsupported method");
     }
 
+    uint64_t
+    DetachedFileIOManager::estimate_size(const types::IndexPage& page)
+    {
+        throw std::logic_error("DetachedFileIOManager::estimate_size: unsupported method");
+    }
+
     void
     DetachedFileIOManager::write_page(const types::DataPage& page, bool fsync)
     {
@@ -201,4 +207,28 @@ namespace storage
     {
         throw std::logic_error("DetachedFileIOManager::write_index_file: unsupported method");
     }
+
+    std::unique_ptr<types::IndexPage>
+    DetachedFileIOManager::read_index_page(const types::IndexId& index_id, types::IndexPageId page_id)
+    {
+        throw std::logic_error("DetachedFileIOManager::read_index_page: unsupported method");
+    }
+
+    void
+    DetachedFileIOManager::write_index_page(const types::IndexPage& page, bool fsync)
+    {
+        throw std::logic_error("DetachedFileIOManager::write_index_page: unsupported method");
+    }
+
+    std::unique_ptr<types::FreeSpaceMap>
+    DetachedFileIOManager::read_fsm(const types::TableId& table_id)
+    {
+        throw std::logic_error("DetachedFileIOManager::read_fsm: unsupported method");
+    }
+
+    void
+    DetachedFileIOManager::write_fsm(const types::FreeSpaceMap& fsm)
+    {
+        throw std::logic_error("DetachedFileIOManager::write_fsm: unsupported method");
+    }
 } // namespace storage
\ No newline at end of file
@@ -12,13 +12,27 @@
 #include <chrono>
 #include <fstream>
 #include <iostream>
-#include <optional>
 
 namespace storage
 {
     using namespace types;
     using DbGuard = std::lock_guard<DatabaseIoLockService::Mutex>;
 
+    namespace
+    {
+        // Pads an encoded index header or page out to a whole block.
+        Bytes
+        to_block(const misc::MemoryStream& serialized)
+        {
+            auto block = serialized.to_vector();
+            if (block.size() > MAX_IP_SIZE)
+                throw std::runtime_error("FileIOManager::to_block: index page does not fit in a block");
+
+            block.resize(MAX_IP_SIZE);
+            return block;
+        }
+    } // namespace
+
     FileIOManager::FileIOManager(
         const fs::path& db_path,
         const std::string& db_name,
@@ -168,13 +182,155 @@ namespace storage
 
         for (const auto& entry : fs::directory_iterator(path))
         {
-            if (entry.is_directory())
+            if (entry.is_directory() || is_tmp_path(entry.path()))
                 continue;
 
             func(entry);
         }
     }
 
+    void
+    FileIOManager::remember_dir(const fs::path& dir)
+    {
+        std::error_code ec;
+        auto mtime = fs::last_write_time(dir, ec);
+        if (!ec)
+            scanned_dirs_[dir] = mtime;
+    }
+
+    bool
+    FileIOManager::directory_changed() const
+    {
+        for (const auto& [dir, mtime] : scanned_dirs_)
+        {
+            std::error_code ec;
+            if (fs::last_write_time(dir, ec) != mtime || ec)
+                return true;
+        }
+
+        return false;
+    }
+
+    void
+    FileIOManager::build_directory()
+    {
+        page_directory_.clear();
+        index_directory_.clear();
+        fsm_directory_.clear();
+        scanned_dirs_.clear();
+
+        scan_directory();
+        directory_built_ = true;
+    }
+
+    void
+    FileIOManager::scan_directory()
+    {
+        // Taken before listing, so that a file created meanwhile triggers the next scan.
+        remember_dir(path_db(db_path_, db_name_));
+        for_each_schema([this](const fs::directory_entry& schema_dir) { remember_dir(schema_dir.path()); });
+
+        for_each_table(
+            [this](const fs::directory_entry& table_dir)
+            {
+                // The meta file and the data and index directories of a table appear in it.
+                remember_dir(table_dir.path());
+                const auto table_name = table_dir.path().filename().string();
+                const auto meta_path = table_dir.path() / make_meta_filename(table_name);
+
+                if (!fs::exists(meta_path) || !fs::is_regular_file(meta_path))
+                    return;
+
+                auto content = read_file(meta_path);
+                MetaTable table;
+                misc::ReadOnlyMemoryStream stream(content);
+                if (!serializer_->deserialize_mt(stream, table))
+                    throw std::runtime_error(
+                        "FileIOManager::scan_directory: failed to deserialize meta table " +
+                        meta_path.string()
+                    );
+
+                fsm_directory_[table.id] = table_dir.path() / make_fsm_filename(table_name);
+
+                auto data_dir = table_dir.path() / PATH_DATA;
+                if (fs::exists(data_dir) && fs::is_directory(data_dir))
+                {
+                    remember_dir(data_dir);
+                    for (const auto& page_entry : fs::directory_iterator(data_dir))
+                    {
+                        if (!page_entry.is_regular_file() || is_tmp_path(page_entry.path()))
+                            continue;
+
+                        DataPageId page_id(page_entry.path().filename().string());
+                        page_directory_[page_id] = FileLocation{page_entry.path(), table.id};
+                    }
+                }
+
+                auto index_dir = table_dir.path() / PATH_INDEX;
+                if (fs::exists(index_dir) && fs::is_directory(index_dir))
+                {
+                    remember_dir(index_dir);
+                    for (const auto& index_entry : fs::directory_iterator(index_dir))
+                    {
+                        if (!index_entry.is_regular_file())
+                            continue;
+
+                        IndexId index_id(index_entry.path().filename().string());
+                        index_directory_[index_id] = FileLocation{index_entry.path(), table.id};
+                    }
+                }
+            }
+        );
+    }
+
+    const FileIOManager::FileLocation*
+    FileIOManager::locate_page(const DataPageId& page_id)
+    {
+        if (!directory_built_)
+            build_directory();
+
+        // The directory follows every file this instance creates or removes. A page it does
+        // not list can only come from another process, which shows in a directory mtime, so
+        // a miss costs a stat per directory and a scan only when one of them moved.
+        auto it = page_directory_.find(page_id);
+        if (it == page_directory_.end() && directory_changed())
+        {
+            scan_directory();
+            it = page_directory_.find(page_id);
+        }
+        return it == page_directory_.end() ? nullptr : &it->second;
+    }
+
+    const FileIOManager::FileLocation*
+    FileIOManager::locate_index(const IndexId& index_id)
+    {
+        if (!directory_built_)
+            build_directory();
+
+        auto it = index_directory_.find(index_id);
+        if (it == index_directory_.end() && directory_changed())
+        {
+            scan_directory();
+            it = index_directory_.find(index_id);
+        }
+        return it == index_directory_.end() ? nullptr : &it->second;
+    }
+
+    fs::path
+    FileIOManager::locate_fsm(const TableId& table_id)
+    {
+        if (!directory_built_)
+            build_directory();
+
+        auto it = fsm_directory_.find(table_id);
+        if (it == fsm_directory_.end() && directory_changed())
+        {
+            scan_directory();
+            it = fsm_directory_.find(table_id);
+        }
+        return it == fsm_directory_.end() ? fs::path() : it->second;
+    }
+
     std::vector<MetaSchema>
     FileIOManager::read_schemas_meta()
     {
@@ -345,7 +501,7 @@ namespace storage
                         for (const auto& entry_in_data :
                              fs::directory_iterator(entry_in_table.path()))
                         {
-                            if (entry_in_data.is_directory())
+                            if (entry_in_data.is_directory() || is_tmp_path(entry_in_data.path()))
                                 continue;
 
                             auto content = read_file(entry_in_data.path());
@@ -462,7 +618,6 @@ namespace storage
                     );
 
                 page.path = entry.path();
-                page.size = content.size();
 
                 pages.push_back(std::move(page));
             }
@@ -475,55 +630,27 @@ namespace storage
     FileIOManager::read_data_page(DataPageId id)
     {
         DbGuard guard(*db_mutex_);
-        const auto page_filename = id.to_string();
-        std::unique_ptr<DataPage> result;
+        const auto* location = locate_page(id);
+        if (!location || !fs::exists(location->path))
+            return nullptr;
 
-        for_each_table(
-            [this, &id, &page_filename, &result](const fs::directory_entry& table_dir)
-            {
-                if (result)
-                    return;
-
-                auto data_dir = table_dir.path() / PATH_DATA;
-                if (!fs::exists(data_dir) || !fs::is_directory(data_dir))
-                    return;
-
-                for (const auto& page_entry : fs::directory_iterator(data_dir))
-                {
-                    if (result)
-                        return;
-
-                    if (!page_entry.is_regular_file())
-                        continue;
-
-                    if (page_entry.path().filename().string() != page_filename)
-                        continue;
-
-                    auto content = read_file(page_entry.path());
-                    DataPage page;
-                    misc::ReadOnlyMemoryStream stream(content);
-                    if (!serializer_->deserialize_dp(stream, page))
-                        throw std::runtime_error(
-                            "FileIOManager::load_data_page: failed to deserialize data page " +
-                            page_entry.path().filename().string()
-                        );
-
-                    page.path = page_entry.path();
-                    page.size = content.size();
+        auto content = read_file(location->path);
+        DataPage page;
+        misc::ReadOnlyMemoryStream stream(content);
+        if (!serializer_->deserialize_dp(stream, page))
+            throw std::runtime_error(
+                "FileIOManager::load_data_page: failed to deserialize data page " +
+                location->path.filename().string()
+            );
 
-                    if (page.id != id)
-                        throw std::runtime_error(
-                            "FileIOManager::load_data_page: page id mismatch for " +
-                            page_entry.path().string()
-                        );
+        page.path = location->path;
 
-                    result = std::make_unique<DataPage>(std::move(page));
-                    return;
-                }
-            }
-        );
+        if (page.id != id)
+            throw std::runtime_error(
+                "FileIOManager::load_data_page: page id mismatch for " + location->path.string()
+            );
 
-        return result;
+        return std::make_unique<DataPage>(std::move(page));
     }
 
     void
@@ -531,10 +658,12 @@ namespace storage
     {
         DbGuard guard(*db_mutex_);
         auto serialized = serializer_->serialize_dp(page);
-        if (fsync)
-            fsync_file(page.path, serialized.to_vector());
-        else
-            write_file(page.path, serialized.to_vector());
+        // Pages are replaced whole: the WAL only holds changes on top of a page, so a torn
+        // page could not be rebuilt once the segments before the checkpoint are gone.
+        replace_file(page.path, serialized.to_vector(), fsync);
+
+        if (directory_built_)
+            page_directory_[page.id] = FileLocation{page.path, page.table_id};
     }
 
     uint64_t
@@ -543,16 +672,22 @@ namespace storage
         return serializer_->estimate_size(row);
     }
 
+    uint64_t
+    FileIOManager::estimate_size(const IndexPage& page)
+    {
+        return serializer_->estimate_size(page);
+    }
+
     void
     FileIOManager::write_mt(const MetaTable& table, const std::string& schema_name, bool fsync)
     {
         DbGuard guard(*db_mutex_);
         auto path = path_db_schema_table_meta(db_path_, db_name_, schema_name, table.name);
         auto serialized = serializer_->serialize_mt(table);
-        if (fsync)
-            fsync_file(path, serialized.to_vector());
-        else
-            write_file(path, serialized.to_vector());
+        replace_file(path, serialized.to_vector(), fsync);
+
+        if (directory_built_)
+            fsm_directory_[table.id] = path.parent_path() / make_fsm_filename(table.name);
     }
 
     void
@@ -569,11 +704,7 @@ namespace storage
         DbGuard guard(*db_mutex_);
         auto path = path_db_schema_meta(db_path_, db_name_, ms.name);
         auto serialized = serializer_->serialize_ms(ms);
-
-        if (fsync)
-            fsync_file(path, serialized.to_vector());
-        else
-            write_file(path, serialized.to_vector());
+        replace_file(path, serialized.to_vector(), fsync);
     }
 
     void
@@ -583,6 +714,10 @@ namespace storage
         auto schema = read_schema_meta(table.schema_id);
         auto path = path_db_schema_table(db_path_, db_name_, schema.name, table.name);
         fs::remove_all(path);
+
+        std::erase_if(page_directory_, [&](const auto& entry) { return entry.second.table_id == table.id; });
+        std::erase_if(index_directory_, [&](const auto& entry) { return entry.second.table_id == table.id; });
+        fsm_directory_.erase(table.id);
     }
 
     void
@@ -591,6 +726,9 @@ namespace storage
         DbGuard guard(*db_mutex_);
         auto path = path_db_schema(db_path_, db_name_, schema.name);
         fs::remove_all(path);
+
+        // Tables of the schema are not known here, so let the next lookup rebuild.
+        directory_built_ = false;
     }
 
     void
@@ -599,7 +737,9 @@ namespace storage
         DbGuard guard(*db_mutex_);
         auto path = path_db_meta(db_path_, cfg.db_name.value());
         auto serialized = serializer_->serialize_cfg(cfg);
-        write_file(path, serialized.to_vector());
+        // The config holds the checkpoint LSN and the settings, and WAL truncation relies on
+        // it, so it is replaced whole and never left half written.
+        replace_file(path, serialized.to_vector(), true);
     }
 
     bool
@@ -623,7 +763,12 @@ namespace storage
         DbGuard guard(*db_mutex_);
         auto ms = read_schema_meta(mt.schema_id);
         auto data_path = path_db_schema_table_data(db_path_, db_name_, ms.name, mt.name);
-        return DataPage::make(data_path, mt.id, page_id);
+        auto page = DataPage::make(data_path, mt.id, page_id);
+
+        if (directory_built_)
+            page_directory_[page.id] = FileLocation{page.path, mt.id};
+
+        return page;
     }
 
     bool
@@ -638,42 +783,14 @@ namespace storage
     FileIOManager::map_data_pages_for_table()
     {
         DbGuard guard(*db_mutex_);
-        std::unordered_map<TableId, std::vector<DataPageId>> result;
-
-        for_each_table(
-            [this, &result](const fs::directory_entry& table_dir)
-            {
-                const auto table_name = table_dir.path().filename().string();
-                const auto meta_path = table_dir.path() / make_meta_filename(table_name);
-
-                if (!fs::exists(meta_path) || !fs::is_regular_file(meta_path))
-                    return;
-
-                auto content = read_file(meta_path);
-                MetaTable table;
-                misc::ReadOnlyMemoryStream stream(content);
-                if (!serializer_->deserialize_mt(stream, table))
-                    throw std::runtime_error(
-                        "FileIOManager::map_tables_pages: failed to deserialize meta table " +
-                        meta_path.string()
-                    );
+        if (!directory_built_)
+            build_directory();
+        else if (directory_changed())
+            scan_directory();
 
-                auto data_dir = table_dir.path() / PATH_DATA;
-                if (!fs::exists(data_dir) || !fs::is_directory(data_dir))
-                    return;
-
-                std::vector<DataPageId> page_ids;
-                for (const auto& page_entry : fs::directory_iterator(data_dir))
-                {
-                    if (!page_entry.is_regular_file())
-                        continue;
-
-                    page_ids.push_back(DataPageId(page_entry.path().filename().string()));
-                }
-
-                result[table.id] = std::move(page_ids);
-            }
-        );
+        std::unordered_map<TableId, std::vector<DataPageId>> result;
+        for (const auto& [page_id, location] : page_directory_)
+            result[location.table_id].push_back(page_id);
 
         return result;
     }
@@ -682,42 +799,14 @@ namespace storage
     FileIOManager::map_index_files_for_table()
     {
         DbGuard guard(*db_mutex_);
-        std::unordered_map<TableId, std::vector<IndexId>> result;
-
-        for_each_table(
-            [this, &result](const fs::directory_entry& table_dir)
-            {
-                const auto table_name = table_dir.path().filename().string();
-                const auto meta_path = table_dir.path() / make_meta_filename(table_name);
-
-                if (!fs::exists(meta_path) || !fs::is_regular_file(meta_path))
-                    return;
-
-                auto content = read_file(meta_path);
-                MetaTable table;
-                misc::ReadOnlyMemoryStream stream(content);
-                if (!serializer_->deserialize_mt(stream, table))
-                    throw std::runtime_error(
-                        "FileIOManager::map_tables_pages: failed to deserialize meta table " +
-                        meta_path.string()
-                    );
-
-                auto data_dir = table_dir.path() / PATH_INDEX;
-                if (!fs::exists(data_dir) || !fs::is_directory(data_dir))
-                    return;
+        if (!directory_built_)
+            build_directory();
+        else if (directory_changed())
+            scan_directory();
 
-                std::vector<IndexId> page_ids;
-                for (const auto& index_file_entry : fs::directory_iterator(data_dir))
-                {
-                    if (!index_file_entry.is_regular_file())
-                        continue;
-
-                    page_ids.push_back(IndexId(index_file_entry.path().filename().string()));
-                }
-
-                result[table.id] = std::move(page_ids);
-            }
-        );
+        std::unordered_map<TableId, std::vector<IndexId>> result;
+        for (const auto& [index_id, location] : index_directory_)
+            result[location.table_id].push_back(index_id);
 
         return result;
     }
@@ -739,14 +828,14 @@ namespace storage
         file.index_id = mi.id;
         file.root_page = root.id;
         file.last_page = root.id;
-        file.pages.push_back(std::move(root));
-
-        auto serialized = serializer_->serialize_if(file);
-        auto content = serialized.to_vector();
 
         auto path = path_db_schema_table_index(db_path_, db_name_, schema_name, table_name, mi.id.to_string());
         fs::create_directories(path.parent_path());
-        write_file(path, content);
+        write_file(path, to_block(serializer_->serialize_if(file)));
+        write_file_block(path, root.id * MAX_IP_SIZE, to_block(serializer_->serialize_ip(root)), false);
+
+        if (directory_built_)
+            index_directory_[mi.id] = FileLocation{path, mi.table_id};
 
         return file;
     }
@@ -755,66 +844,121 @@ namespace storage
     FileIOManager::read_index_file(const IndexId& index_id)
     {
         DbGuard guard(*db_mutex_);
-        std::unique_ptr<IndexFile> result;
+        const auto* location = locate_index(index_id);
+        if (!location || !fs::exists(location->path))
+            return nullptr;
 
-        for_each_table(
-            [this, &index_id, &result](const fs::directory_entry& table_dir)
-            {
-                if (result)
-                    return;
+        auto content = read_file_block(location->path, 0, MAX_IP_SIZE);
 
-                const auto index_path = table_dir.path() / PATH_INDEX / index_id.to_string();
-                if (!fs::exists(index_path) || !fs::is_regular_file(index_path))
-                    return;
+        IndexFile file;
+        misc::ReadOnlyMemoryStream stream(content);
+        if (!serializer_->deserialize_if(stream, file))
+            throw std::runtime_error(
+                "FileIOManager::read_index_file: failed to deserialize index file " +
+                location->path.string()
+            );
 
-                auto content = read_file(index_path);
+        if (file.index_id != index_id)
+            throw std::runtime_error(
+                "FileIOManager::read_index_file: index id mismatch for " + location->path.string()
+            );
 
-                IndexFile file;
-                misc::ReadOnlyMemoryStream stream(content);
-                if (!serializer_->deserialize_if(stream, file))
-                    throw std::runtime_error(
-                        "FileIOManager::read_index_file: failed to deserialize index file " +
-                        index_path.string()
-                    );
+        // Pages may reach the disk before the header that counts them, and their ids
+        // must not be handed out again.
+        const auto blocks = fs::file_size(location->path) / MAX_IP_SIZE;
+        if (blocks > 0)
+            file.last_page = std::max(file.last_page, blocks - 1);
 
-                if (file.index_id != index_id)
-                    throw std::runtime_error(
-                        "FileIOManager::read_index_file: index id mismatch for " +
-                        index_path.string()
-                    );
+        return std::make_unique<IndexFile>(std::move(file));
+    }
 
-                result = std::make_unique<IndexFile>(std::move(file));
-            }
-        );
+    void
+    FileIOManager::write_index_file(const IndexFile& index_file, bool fsync)
+    {
+        DbGuard guard(*db_mutex_);
+        const auto* location = locate_index(index_file.index_id);
 
-        return result;
+        if (!location)
+            throw std::runtime_error(
+                "FileIOManager::write_index_file: index file with id " +
+                index_file.index_id.to_string() + " not found"
+            );
+
+        write_file_block(location->path, 0, to_block(serializer_->serialize_if(index_file)), fsync);
+    }
+
+    std::unique_ptr<IndexPage>
+    FileIOManager::read_index_page(const IndexId& index_id, IndexPageId page_id)
+    {
+        DbGuard guard(*db_mutex_);
+        const auto* location = locate_index(index_id);
+        if (!location || !fs::exists(location->path))
+            return nullptr;
+
+        auto content = read_file_block(location->path, page_id * MAX_IP_SIZE, MAX_IP_SIZE);
+        if (content.size() < MAX_IP_SIZE)
+            return nullptr;
+
+        IndexPage page;
+        misc::ReadOnlyMemoryStream stream(content);
+        if (!serializer_->deserialize_ip(stream, page))
+            throw std::runtime_error(
+                "FileIOManager::read_index_page: failed to deserialize page " +
+                std::to_string(page_id) + " of " + location->path.string()
+            );
+
+        // A block inside the file that was never written reads back as zeros.
+        if (page.id != page_id)
+            return nullptr;
+
+        return std::make_unique<IndexPage>(std::move(page));
     }
 
     void
-    FileIOManager::write_index_file(const IndexFile& index_file, bool fsync)
+    FileIOManager::write_index_page(const IndexPage& page, bool fsync)
     {
         DbGuard guard(*db_mutex_);
-        std::optional<fs::path> index_path;
+        const auto* location = locate_index(page.index_id);
 
-        for_each_table(
-            [&index_file, &index_path](const fs::directory_entry& table_dir)
-            {
-                if (index_path)
-                    return;
+        if (!location)
+            throw std::runtime_error(
+                "FileIOManager::write_index_page: index file with id " +
+                page.index_id.to_string() + " not found"
+            );
 
-                const auto candidate = table_dir.path() / PATH_INDEX / index_file.index_id.to_string();
-                if (fs::exists(candidate) && fs::is_regular_file(candidate))
-                    index_path = candidate;
-            }
-        );
+        write_file_block(location->path, page.id * MAX_IP_SIZE, to_block(serializer_->serialize_ip(page)), fsync);
+    }
 
-        if (!index_path)
+    std::unique_ptr<FreeSpaceMap>
+    FileIOManager::read_fsm(const TableId& table_id)
+    {
+        DbGuard guard(*db_mutex_);
+        const auto path = locate_fsm(table_id);
+        if (path.empty() || !fs::exists(path))
+            return nullptr;
+
+        auto content = read_file(path);
+
+        auto fsm = std::make_unique<FreeSpaceMap>();
+        misc::ReadOnlyMemoryStream stream(content);
+        // The map is only a hint, so a torn or foreign file is rebuilt rather than fatal.
+        if (!serializer_->deserialize_fsm(stream, *fsm) || fsm->table_id != table_id)
+            return nullptr;
+
+        return fsm;
+    }
+
+    void
+    FileIOManager::write_fsm(const FreeSpaceMap& fsm)
+    {
+        DbGuard guard(*db_mutex_);
+        const auto path = locate_fsm(fsm.table_id);
+        if (path.empty())
             throw std::runtime_error(
-                "FileIOManager::write_index_file: index file with id " +
-                index_file.index_id.to_string() + " not found"
+                "FileIOManager::write_fsm: table with id " + fsm.table_id.to_string() + " not found"
             );
 
-        auto serialized = serializer_->serialize_if(index_file);
-        write_file(*index_path, serialized.to_vector());
+        auto serialized = serializer_->serialize_fsm(fsm);
+        write_file(path, serialized.to_vector());
     }
-} // namespace storage
\ No newline at end of file
+} // namespace storage
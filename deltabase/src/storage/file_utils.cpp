@@ -4,6 +4,10 @@
 
 #include "file_utils.hpp"
 
+#include "path.hpp"
+
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #ifdef _WIN32
@@ -210,4 +214,148 @@ namespace storage
 #endif
     }
 
+    void
+    replace_file(const fs::path& path, const Bytes& content, bool fsync)
+    {
+        const auto tmp = make_tmp_path(path);
+        if (fsync)
+            fsync_file(tmp, content);
+        else
+            write_file(tmp, content);
+
+#ifdef _WIN32
+        DWORD flags = MOVEFILE_REPLACE_EXISTING;
+        if (fsync)
+            flags |= MOVEFILE_WRITE_THROUGH;
+
+        if (!MoveFileExW(tmp.c_str(), path.c_str(), flags))
+            throw std::runtime_error("Cannot replace file: " + path.string());
+#else
+        if (::rename(tmp.c_str(), path.c_str()) < 0)
+            throw std::runtime_error("Cannot replace file: " + path.string());
+
+        if (!fsync)
+            return;
+
+        // The rename is an entry of the directory, which is synced on its own.
+        const int dir_fd = open(path.parent_path().c_str(), O_RDONLY | O_DIRECTORY);
+        if (dir_fd < 0)
+            throw std::runtime_error("Cannot open directory: " + path.parent_path().string());
+
+        if (::fsync(dir_fd) < 0)
+        {
+            close(dir_fd);
+            throw std::runtime_error("Cannot sync directory: " + path.parent_path().string());
+        }
+
+        close(dir_fd);
+#endif
+    }
+
+    Bytes
+    read_file_block(const fs::path& path, uint64_t offset, uint64_t size)
+    {
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            throw std::runtime_error("Cannot open file: " + path.string());
+
+        Bytes buffer(size);
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(size));
+        buffer.resize(static_cast<size_t>(std::max<std::streamsize>(file.gcount(), 0)));
+        return buffer;
+#else
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Cannot open file: " + path.string());
+
+        if (flock(fd, LOCK_SH) < 0)
+        {
+            close(fd);
+            throw std::runtime_error("Cannot acquire shared lock for file: " + path.string());
+        }
+
+        Bytes buffer(size);
+        size_t total = 0;
+        while (total < size)
+        {
+            const auto read_bytes =
+                pread(fd, buffer.data() + total, size - total, static_cast<off_t>(offset + total));
+            if (read_bytes < 0)
+            {
+                flock(fd, LOCK_UN);
+                close(fd);
+                throw std::runtime_error("Error reading file: " + path.string());
+            }
+
+            if (read_bytes == 0)
+                break;
+
+            total += static_cast<size_t>(read_bytes);
+        }
+
+        buffer.resize(total);
+        flock(fd, LOCK_UN);
+        close(fd);
+
+        return buffer;
+#endif
+    }
+
+    void
+    write_file_block(const fs::path& path, uint64_t offset, const Bytes& content, bool fsync)
+    {
+        if (!fs::exists(path.parent_path()))
+            fs::create_directories(path.parent_path());
+
+#ifdef _WIN32
+        if (!fs::exists(path))
+            std::ofstream(path, std::ios::binary).close();
+
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!file)
+            throw std::runtime_error("Cannot open file for writing: " + path.string());
+
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.write(reinterpret_cast<const char*>(content.data()), static_cast<std::streamsize>(content.size()));
+        file.flush();
+#else
+        const int fd = open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+        if (fd < 0)
+            throw std::runtime_error("Cannot open file for writing: " + path.string());
+
+        if (flock(fd, LOCK_EX) < 0)
+        {
+            close(fd);
+            throw std::runtime_error("Cannot acquire exclusive lock for file: " + path.string());
+        }
+
+        size_t total = 0;
+        while (total < content.size())
+        {
+            const auto written = pwrite(
+                fd, content.data() + total, content.size() - total, static_cast<off_t>(offset + total)
+            );
+            if (written < 0)
+            {
+                flock(fd, LOCK_UN);
+                close(fd);
+                throw std::runtime_error("Error writing file: " + path.string());
+            }
+
+            total += static_cast<size_t>(written);
+        }
+
+        if (fsync && ::fsync(fd) < 0)
+        {
+            flock(fd, LOCK_UN);
+            close(fd);
+            throw std::runtime_error("Error syncing file: " + path.string());
+        }
+
+        flock(fd, LOCK_UN);
+        close(fd);
+#endif
+    }
 } // namespace storage
\ No newline at end of file
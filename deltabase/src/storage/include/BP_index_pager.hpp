@@ -11,16 +11,34 @@ namespace storage
 {
     class BPIndexPager : public IIndexPager
     {
+        // A page handed out, with the latch taken on it, if any.
+        struct HeldPage
+        {
+            IndexPageGuard page;
+            std::shared_lock<std::shared_mutex> shared{};
+            std::unique_lock<std::shared_mutex> exclusive{};
+        };
+
         BufferPool& buffer_pool_;
         types::TableId table_id_;
         types::IndexId index_id_;
+        // Stamped on every page marked dirty: the log record the changes belong to.
+        types::LSN lsn_;
+        mutable types::IndexFile* file_ = nullptr;
+        // Pins every page handed out for the pager's lifetime, so the tree's page
+        // pointers are not invalidated by an eviction in the middle of an operation.
+        // Latches come and go while the pin stays.
+        std::unordered_map<types::IndexPageId, HeldPage> pages_;
 
         types::IndexFile*
         file_or_throw() const;
 
     public:
         BPIndexPager(
-            BufferPool& buffer_pool, const types::TableId& table_id, const types::IndexId& index_id
+            BufferPool& buffer_pool,
+            const types::TableId& table_id,
+            const types::IndexId& index_id,
+            types::LSN lsn = 0
         );
 
         const types::IndexId&
@@ -38,8 +56,29 @@ namespace storage
         types::IndexPage*
         create_page(bool is_leaf, types::IndexPageId parent) override;
 
+        bool
+        fits(const types::IndexPage& page) override;
+
+        bool
+        fits(const types::IndexPage& page, uint32_t fill_percent) override;
+
+        void
+        release(types::IndexPageId page_id) override;
+
+        void
+        latch(types::IndexPageId page_id, bool exclusive) override;
+
+        bool
+        try_latch(types::IndexPageId page_id, bool exclusive) override;
+
+        void
+        unlatch(types::IndexPageId page_id) override;
+
+        void
+        unlatch_all() override;
+
         void
-        mark_dirty() override;
+        mark_dirty(types::IndexPageId page_id) override;
 
         void
         flush() override;
@@ -5,50 +5,189 @@
 #ifndef DELTABASE_BUFFER_POOL_HPP
 #define DELTABASE_BUFFER_POOL_HPP
 
-#include "../../misc/include/LRU_policy.hpp"
 #include "../../misc/include/cache.hpp"
+#include "../../misc/include/replacement_policy.hpp"
 #include "../../types/include/data_page.hpp"
+#include "../../types/include/free_space_map.hpp"
 #include "../../types/include/index_file.hpp"
 #include "io_manager.hpp"
 
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+
 namespace storage
 {
     template <typename TKey, typename TValue>
-    using Buffer = misc::Cache<TKey, TValue, cache::LRUPolicy<TKey>>;
+    using Buffer = misc::Cache<TKey, TValue, cache::ReplacementPolicy<TKey>>;
     using DataPageBuffer = Buffer<types::DataPageId, types::DataPage>;
-    using IndexFileBuffer = Buffer<types::IndexId, types::IndexFile>;
+    using IndexPageBuffer = Buffer<types::IndexPageKey, types::IndexPage>;
+
+    // Pinned references to buffered frames. A frame stays resident (and its address
+    // stable) while at least one guard for it is alive; release guards promptly.
+    using PageGuard = DataPageBuffer::Pin;
+    using IndexPageGuard = IndexPageBuffer::Pin;
+
+    // Exclusive latches a writer holds on data pages, at most one per page, so that code
+    // changing several pages can latch each one it touches without knowing which ones its
+    // callers hold already. A latched page stays pinned until it is unlocked.
+    class PageLatches
+    {
+        struct Held
+        {
+            PageGuard page;
+            std::unique_lock<std::shared_mutex> lock;
+        };
+
+        std::vector<Held> held_;
+
+    public:
+        void
+        lock(const PageGuard& page);
+
+        void
+        unlock(const types::DataPageId& page_id);
+
+        void
+        unlock_all();
+    };
 
     class BufferPool
     {
         DataPageBuffer data_pages_;
-        IndexFileBuffer index_files_;
+        IndexPageBuffer index_pages_;
         IIOManager& io_;
+        // Guards the pool's own structures. Frame latches are taken before it, never while
+        // holding it, except by try_lock. Nor is the WAL waited for while holding it.
+        mutable std::recursive_mutex mtx_;
+
+        // Holds mtx_. Eviction passes over dirty frames the WAL has not yet made durable;
+        // the thread's outermost guard, once it has unlocked, waits for the WAL to reach
+        // them, so that a later eviction can write them.
+        class PoolGuard
+        {
+            const BufferPool& pool_;
+
+        public:
+            explicit
+            PoolGuard(const BufferPool& pool);
+
+            PoolGuard(const PoolGuard&) = delete;
+            PoolGuard&
+            operator=(const PoolGuard&) = delete;
+
+            ~PoolGuard();
+        };
+
+        // Nesting depth of the guards of the thread holding mtx_, and the largest LSN of
+        // the frames eviction passed over under them.
+        mutable uint32_t guard_depth_ = 0;
+        mutable types::LSN barrier_wanted_ = 0;
 
         std::unordered_map<types::TableId, std::vector<types::DataPageId>> data_pages_per_table_;
 
         std::unordered_map<types::TableId, std::vector<types::IndexId>> index_files_per_table_;
 
+        // Headers of the indexes opened so far. They are a few bytes each and stay loaded.
+        std::unordered_map<types::IndexId, types::IndexFile> index_files_;
+
+        // Loaded on first use of a table and written by flush_fsm.
+        std::unordered_map<types::TableId, types::FreeSpaceMap> free_space_;
+
+        // Writes a dirty frame. The WAL must be durable up to its last_lsn already.
         void
         flush(DataPageBuffer::CacheEntry& page_entry);
 
         void
-        flush(IndexFileBuffer::CacheEntry& index_file_entry);
+        flush(IndexPageBuffer::CacheEntry& index_page_entry);
+
+        void
+        flush(types::IndexFile& index_file);
+
+        // Whether eviction can write a frame without waiting for the WAL. Notes the LSN
+        // to wait for if not.
+        bool
+        evictable(bool dirty, types::LSN last_lsn) const;
 
         std::function<void(DataPageBuffer::CacheEntry&)> data_page_flusher_ =
             [this](DataPageBuffer::CacheEntry& page_entry) { flush(page_entry); };
 
-        std::function<void(IndexFileBuffer::CacheEntry&)> index_file_flusher_ =
-            [this](IndexFileBuffer::CacheEntry& index_file_entry) { flush(index_file_entry); };
+        std::function<void(IndexPageBuffer::CacheEntry&)> index_page_flusher_ =
+            [this](IndexPageBuffer::CacheEntry& index_page_entry) { flush(index_page_entry); };
 
-        types::DataPage*
+        // Makes the WAL durable up to the given LSN; called before any frame is written.
+        std::function<void(types::LSN)> wal_barrier_;
+        std::function<types::LSN()> durable_lsn_;
+
+        PageGuard
         create_dp(const types::MetaTable& mt);
 
+        PageGuard
+        load_dp(const types::DataPageId& page_id);
+
+        IndexPageGuard
+        load_ip(const types::IndexPageKey& key);
+
+        types::FreeSpaceMap&
+        load_fsm(const types::TableId& table_id);
+
+        // Measures every page of the table the map does not know yet and forgets pages
+        // that no longer exist. Reads pages that are not buffered without caching them.
+        void
+        reconcile_fsm(types::FreeSpaceMap& fsm);
+
+        // Walks the table's pages for the page no other page is chained to.
+        types::DataPageId
+        find_tail(const types::TableId& table_id);
+
+        static uint64_t
+        free_bytes(const types::DataPage& page);
+
+        static std::size_t
+        footprint(const types::DataPage& page);
+
+        static std::size_t
+        footprint(const types::IndexPage& index_page);
+
+        template <typename TKey>
+        static cache::ReplacementPolicy<TKey>
+        make_policy(types::Config::CachePolicyType type)
+        {
+            switch (type)
+            {
+            case types::Config::CachePolicyType::LRU:
+                return cache::LRUPolicy<TKey>{};
+            case types::Config::CachePolicyType::Clock:
+                return cache::ClockPolicy<TKey>{};
+            case types::Config::CachePolicyType::TwoQueue:
+                return cache::TwoQueuePolicy<TKey>{};
+            default:
+                throw std::runtime_error("BufferPool::make_policy: unknown cache policy");
+            }
+        }
+
     public:
-        BufferPool(IIOManager& io)
-            : data_pages_(cache::LRUPolicy<types::DataPageId>{}),
-              index_files_(cache::LRUPolicy<types::IndexId>{}),
+        BufferPool(IIOManager& io, const types::Config& cfg)
+            : data_pages_(
+                  make_policy<types::DataPageId>(cfg.buffer_pool_policy),
+                  cfg.buffer_pool_bytes,
+                  [](const types::DataPage& page) { return footprint(page); }
+              ),
+              index_pages_(
+                  make_policy<types::IndexPageKey>(cfg.index_pool_policy),
+                  cfg.index_pool_bytes,
+                  [](const types::IndexPage& index_page) { return footprint(index_page); }
+              ),
               io_(io)
         {
+            data_pages_.set_evict_filter(
+                [this](DataPageBuffer::CacheEntry& entry) { return evictable(entry.dirty, entry.value.last_lsn); }
+            );
+            index_pages_.set_evict_filter(
+                [this](IndexPageBuffer::CacheEntry& entry) { return evictable(entry.dirty, entry.value.last_lsn); }
+            );
         }
 
         void
@@ -57,40 +196,135 @@ namespace storage
         void
         put_dp(const types::DataPageId& page_id, types::DataPage&& page);
 
-        types::DataPage*
+        PageGuard
         get_dp(const types::DataPageId& page_id);
 
-        types::DataPage*
+        // Returns a page with room for size more bytes, found through the free space
+        // map. A page it has to create becomes the table's tail; the caller chains it
+        // after the previous one.
+        PageGuard
         prepare_dp(size_t size, const types::MetaTable& mt);
 
-        std::vector<types::DataPage*>
-        get_table_data(const types::UUID& table_id);
+        // The last page of the table's chain, or a null id if the table has no pages.
+        types::DataPageId
+        tail_dp(const types::TableId& table_id);
+
+        // The first page of the table's chain as the free space map records it, or a null
+        // id if the table has no pages or the map does not know it.
+        types::DataPageId
+        head_dp(const types::TableId& table_id);
+
+        void
+        set_head_dp(const types::TableId& table_id, const types::DataPageId& page_id);
+
+        // Writes the free space maps that changed since they were last written.
+        void
+        flush_fsm();
+
+        // Ids of the table's data pages. Nothing is pinned: callers pin each page through
+        // get_dp as they get to it, so a table larger than the pool still fits through it.
+        std::vector<types::DataPageId>
+        table_pages(const types::TableId& table_id) const;
 
         types::DataPage*
         dirty_dp(const types::DataPageId& page_id);
 
+        // Writes one data page through the WAL barrier right away, if it is dirty and its
+        // last_lsn is at most max_lsn. Waits for a writer holding the page's latch; the
+        // caller must hold no frame latch.
+        void
+        flush_dp(
+            const types::DataPageId& page_id,
+            types::LSN max_lsn = std::numeric_limits<types::LSN>::max()
+        );
+
+        // The header of one of the table's indexes, or nullptr if the table has no such
+        // index. Headers are never evicted, so the pointer stays valid.
         types::IndexFile*
         get_table_index(const types::UUID& table_id, const types::IndexId& index_id);
 
         void
         create_table_index(
-            const std::string& schema_name,
-            const types::MetaTable& table,
-            const types::MetaIndex& index,
-            types::LSN last_lsn
+            const std::string& schema_name, const types::MetaTable& table, const types::MetaIndex& index
         );
 
         types::IndexFile*
         dirty_if(const types::IndexId& index_id);
 
+        // The root page of an opened index. Readers of the root do not hold the latch of
+        // the page a split makes the new root, so it is read and set under the pool mutex.
+        types::IndexPageId
+        root_ip(const types::IndexId& index_id) const;
+
+        // Returns false if the index is not opened.
+        bool
+        set_root_ip(const types::IndexId& index_id, types::IndexPageId root);
+
+        IndexPageGuard
+        get_ip(const types::IndexPageKey& key);
+
+        // Takes the next page id of an opened index. The page is dirty from the start.
+        IndexPageGuard
+        create_ip(const types::IndexId& index_id, bool is_leaf, types::IndexPageId parent);
+
+        types::IndexPage*
+        dirty_ip(const types::IndexPageKey& key);
+
+        // Whether the page, once encoded, takes no more than fill_percent of its block.
+        bool
+        fits_ip(const types::IndexPage& page, uint32_t fill_percent = 100);
+
+        // Writes one index page like flush_dp writes a data page.
         void
-        set_if_lsn(const types::IndexId& index_id, types::LSN last_lsn);
+        flush_ip(
+            const types::IndexPageKey& key,
+            types::LSN max_lsn = std::numeric_limits<types::LSN>::max()
+        );
+
+        // Writes the index headers that changed. Called after the pages, so that a
+        // header on disk does not name a root that is not.
+        void
+        flush_index_files();
 
+        // Writes every dirty frame, or those with a last_lsn of at most max_lsn, a frame at
+        // a time like flush_dp. The caller must hold no frame latch.
         void
         flush_dirty();
 
         void
         flush_dirty(types::LSN max_lsn);
+
+        // durable_lsn tells how far the WAL is durable; wal_barrier waits for it to get
+        // further.
+        void
+        set_wal_barrier(
+            std::function<void(types::LSN)> wal_barrier, std::function<types::LSN()> durable_lsn
+        );
+
+        std::vector<types::DataPageId>
+        dirty_data_pages() const;
+
+        std::vector<types::IndexPageKey>
+        dirty_index_pages() const;
+
+        // Writes up to max_frames dirty frames whose last_lsn is already durable, oldest
+        // first: frames dirtied before dirty_before, plus as many data pages as needed to
+        // bring the dirty share of the data page budget down to dirty_percent. Frames a
+        // writer holds latched are left for a later round.
+        // Returns the number of frames written.
+        size_t
+        write_dirty(
+            types::LSN durable_lsn,
+            std::chrono::steady_clock::time_point dirty_before,
+            uint32_t dirty_percent,
+            size_t max_frames
+        );
+
+        DataPageBuffer::Stats
+        data_page_stats() const;
+
+        IndexPageBuffer::Stats
+        index_page_stats() const;
     };
 } // namespace storage
 
@@ -0,0 +1,82 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#ifndef DELTABASE_CHECKPOINTER_HPP
+#define DELTABASE_CHECKPOINTER_HPP
+
+#include "../../types/include/config.hpp"
+#include "../../wal/include/wal_manager.hpp"
+#include "buffer_pool.hpp"
+#include "catalog.hpp"
+#include "io_manager.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+namespace storage
+{
+    // Background thread taking fuzzy checkpoints. A checkpoint notes the next LSN as
+    // its redo point, writes every frame that was dirty at that moment (latching one
+    // frame at a time), logs a CheckpointRecord, records its LSN in the config and drops
+    // WAL segments older than both the redo point and the first record of every
+    // transaction that was still active.
+    class Checkpointer
+    {
+
+        BufferPool& buffer_pool_;
+        CatalogCache& catalog_;
+        wal::IWALManager& wal_manager_;
+        IIOManager& io_manager_;
+        // Every statement holds it shared, so holding it exclusive waits until no
+        // statement is halfway through its changes.
+        std::shared_mutex& catalog_latch_;
+        types::Config& cfg_;
+
+        std::chrono::milliseconds interval_;
+
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        bool stopping_ = false;
+        std::thread thread_;
+
+        // Serializes checkpoints taken by the thread and by checkpoint() callers.
+        std::mutex checkpoint_mtx_;
+
+        void
+        run();
+
+    public:
+        Checkpointer(
+            BufferPool& buffer_pool,
+            CatalogCache& catalog,
+            wal::IWALManager& wal_manager,
+            IIOManager& io_manager,
+            std::shared_mutex& catalog_latch,
+            types::Config& cfg
+        );
+
+        ~Checkpointer();
+
+        Checkpointer(const Checkpointer&) = delete;
+        Checkpointer&
+        operator=(const Checkpointer&) = delete;
+
+        void
+        start();
+
+        // Joins the thread. Must not be called while holding the catalog latch.
+        void
+        stop();
+
+        // Takes a checkpoint now and returns its LSN. Must not be called while holding
+        // the catalog latch or any frame latch.
+        types::LSN
+        checkpoint();
+    };
+} // namespace storage
+
+#endif // DELTABASE_CHECKPOINTER_HPP
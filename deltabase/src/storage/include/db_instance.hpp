@@ -11,9 +11,15 @@
 #include "../../types/include/data_table.hpp"
 #include "../../types/include/meta_schema.hpp"
 #include "../../types/include/query_plan.hpp"
+#include "../../types/include/row_view.hpp"
+
+#include <functional>
 
 namespace storage
 {
+    // Decides on a row while it is still in its page, before it is copied out.
+    using RowFilter = std::function<bool(const types::RowView&)>;
+
     class IDbInstance
     {
     public:
@@ -22,12 +28,24 @@ namespace storage
         virtual types::DataTable
         seq_scan(const std::string& table_name, const std::string& schema_name) = 0;
 
+        // Readers see the rows of the transactions committed when they begin, and are not
+        // held up by writers. The overloads taking a transaction read as it sees the
+        // table instead: from the snapshot it took at begin, its own changes included.
         virtual types::ScanCursor
         seq_scan_begin(const std::string& table_name, const std::string& schema_name) = 0;
 
+        virtual types::ScanCursor
+        seq_scan_begin(
+            const std::string& table_name, const std::string& schema_name, const txn::Transaction& txn
+        ) = 0;
+
         virtual bool
         seq_scan_next(types::ScanCursor& cursor, types::DataRow& out) = 0;
 
+        // Like seq_scan_next, but only copies out rows the filter accepts.
+        virtual bool
+        seq_scan_next(types::ScanCursor& cursor, types::DataRow& out, const RowFilter& filter) = 0;
+
         virtual types::DataTable
         index_scan(
             const std::string& table_name,
@@ -36,6 +54,28 @@ namespace storage
             const types::BinaryExpr& condition
         ) = 0;
 
+        virtual types::DataTable
+        index_scan(
+            const std::string& table_name,
+            const std::string& schema_name,
+            const types::IndexId& index_id,
+            const types::BinaryExpr& condition,
+            const txn::Transaction& txn
+        ) = 0;
+
+        // Index entries inside the condition's key range on the index, counting no
+        // further than limit.
+        virtual uint64_t
+        index_range_count(
+            const std::string& table_name,
+            const std::string& schema_name,
+            const types::IndexId& index_id,
+            const types::BinaryExpr& condition,
+            uint64_t limit
+        ) = 0;
+
+        // A rolled back transaction must not have changed the catalog: DDL runs in
+        // transactions of its own.
         virtual txn::Transaction
         make_txn() = 0;
 
@@ -48,9 +88,25 @@ namespace storage
             txn::Transaction& txn
         ) = 0;
 
+        // Inserts several rows in one go: pages are filled in bulk with one WAL record
+        // per page, and index entries are added in key order.
+        virtual void
+        insert_rows(
+            const std::string& table_name,
+            const std::string& schema_name,
+            const std::optional<std::vector<std::string>>& cols,
+            std::vector<std::vector<types::DataToken>> rows,
+            txn::Transaction& txn
+        ) = 0;
+
+        // The last log record of txn, that of the row, is stamped on every index page it
+        // dirties.
         virtual std::vector<types::IndexId>
         insert_row_into_indexes(
-            const types::MetaTable& mt, const types::DataRow& row, const types::DataPageId& page_id
+            const types::MetaTable& mt,
+            const types::DataRow& row,
+            const types::DataPageId& page_id,
+            const txn::Transaction& txn
         ) = 0;
 
         virtual void
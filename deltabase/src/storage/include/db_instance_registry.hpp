@@ -0,0 +1,51 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#ifndef DELTABASE_DB_INSTANCE_REGISTRY_HPP
+#define DELTABASE_DB_INSTANCE_REGISTRY_HPP
+
+#include "../../types/include/config.hpp"
+#include "std_db_instance.hpp"
+
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace storage
+{
+    namespace fs = std::filesystem;
+
+    // Process-wide registry of opened databases. Every session attaching the same
+    // (db_path, db_name) shares one StdDbInstance, so buffer pool, catalog and WAL
+    // writer exist once per database and recovery runs only on the first attach.
+    // The instance is closed when the last session releases it, and only then leaves
+    // the registry: an attach made while it is opening or closing waits for it.
+    class DbInstanceRegistry : public std::enable_shared_from_this<DbInstanceRegistry>
+    {
+        mutable std::mutex registry_mutex_;
+        // Notified whenever an entry finishes opening or closing.
+        std::condition_variable changed_;
+        // An empty pointer stands for an instance that is still opening or already closing.
+        std::unordered_map<std::string, std::weak_ptr<StdDbInstance>> instances_;
+
+        // Closes the instance, then forgets it.
+        void
+        release(const std::string& key, StdDbInstance* instance);
+
+        static std::string
+        make_key(const fs::path& db_path, const std::string& db_name);
+
+    public:
+        static std::shared_ptr<DbInstanceRegistry>
+        shared();
+
+        std::shared_ptr<StdDbInstance>
+        acquire(const types::Config& cfg);
+    };
+} // namespace storage
+
+#endif // DELTABASE_DB_INSTANCE_REGISTRY_HPP
@@ -31,9 +31,17 @@ namespace storage
         types::ScanCursor
         seq_scan_begin(const std::string& table_name, const std::string& schema_name) override;
 
+        types::ScanCursor
+        seq_scan_begin(
+            const std::string& table_name, const std::string& schema_name, const txn::Transaction& txn
+        ) override;
+
         bool
         seq_scan_next(types::ScanCursor& cursor, types::DataRow& out) override;
 
+        bool
+        seq_scan_next(types::ScanCursor& cursor, types::DataRow& out, const RowFilter& filter) override;
+
         types::DataTable
         index_scan(
             const std::string& table_name,
@@ -42,6 +50,24 @@ namespace storage
             const types::BinaryExpr& condition
         ) override;
 
+        types::DataTable
+        index_scan(
+            const std::string& table_name,
+            const std::string& schema_name,
+            const types::IndexId& index_id,
+            const types::BinaryExpr& condition,
+            const txn::Transaction& txn
+        ) override;
+
+        uint64_t
+        index_range_count(
+            const std::string& table_name,
+            const std::string& schema_name,
+            const types::IndexId& index_id,
+            const types::BinaryExpr& condition,
+            uint64_t limit
+        ) override;
+
         txn::Transaction
         make_txn() override;
 
@@ -54,6 +80,15 @@ namespace storage
             txn::Transaction& txn
         ) override;
 
+        void
+        insert_rows(
+            const std::string& table_name,
+            const std::string& schema_name,
+            const std::optional<std::vector<std::string>>& cols,
+            std::vector<std::vector<types::DataToken>> rows,
+            txn::Transaction& txn
+        ) override;
+
         bool
         exists_table(const std::string& table_name, const std::string& schema_name) override;
 
@@ -112,7 +147,10 @@ namespace storage
 
         std::vector<types::IndexId>
         insert_row_into_indexes(
-            const types::MetaTable& mt, const types::DataRow& row, const types::DataPageId& page_id
+            const types::MetaTable& mt,
+            const types::DataRow& row,
+            const types::DataPageId& page_id,
+            const txn::Transaction& txn
         ) override;
 
         bool
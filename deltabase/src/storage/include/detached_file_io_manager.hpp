@@ -61,6 +61,9 @@ namespace storage
         uint64_t
         estimate_size(const types::DataRow& row) override;
 
+        uint64_t
+        estimate_size(const types::IndexPage& page) override;
+
         void
         write_page(const types::DataPage& page, bool fsync) override;
 
@@ -118,6 +121,18 @@ namespace storage
 
         void
         write_index_file(const types::IndexFile& index_file, bool fsync) override;
+
+        std::unique_ptr<types::IndexPage>
+        read_index_page(const types::IndexId& index_id, types::IndexPageId page_id) override;
+
+        void
+        write_index_page(const types::IndexPage& page, bool fsync) override;
+
+        std::unique_ptr<types::FreeSpaceMap>
+        read_fsm(const types::TableId& table_id) override;
+
+        void
+        write_fsm(const types::FreeSpaceMap& fsm) override;
     };
 } // namespace storage
 
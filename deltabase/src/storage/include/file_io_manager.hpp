@@ -11,7 +11,9 @@
 
 #include <filesystem>
 #include <functional>
+#include <map>
 #include <memory>
+#include <unordered_map>
 
 namespace storage
 {
@@ -25,6 +27,52 @@ namespace storage
         std::shared_ptr<DatabaseIoLockService> io_lock_service_;
         std::shared_ptr<DatabaseIoLockService::Mutex> db_mutex_;
 
+        struct FileLocation
+        {
+            fs::path path;
+            types::TableId table_id;
+        };
+
+        // Where every data page, index file and free space map lives, so that a buffer
+        // pool miss is a single open instead of a walk over all table directories. Built
+        // on first use and kept current by create_page, write_page, write_mt,
+        // create_index_file and delete_mt; delete_ms has it rebuilt on the next lookup.
+        std::unordered_map<types::DataPageId, FileLocation> page_directory_;
+        std::unordered_map<types::IndexId, FileLocation> index_directory_;
+        std::unordered_map<types::TableId, fs::path> fsm_directory_;
+        bool directory_built_ = false;
+
+        // Modification times of the directories the last scan listed. Files created by
+        // other processes attached to the database change them, so a miss scans again
+        // only when one of them moved.
+        std::map<fs::path, fs::file_time_type> scanned_dirs_;
+
+        void
+        build_directory();
+
+        // Adds the files found on disk to the directory. Entries are kept for files this
+        // instance registered whose table meta is not on disk yet.
+        void
+        scan_directory();
+
+        // Records the modification time of a directory before scan_directory lists it.
+        void
+        remember_dir(const fs::path& dir);
+
+        bool
+        directory_changed() const;
+
+        const FileLocation*
+        locate_page(const types::DataPageId& page_id);
+
+        const FileLocation*
+        locate_index(const types::IndexId& index_id);
+
+        // Path of the free space map file of a table, or an empty path if the table
+        // is unknown.
+        fs::path
+        locate_fsm(const types::TableId& table_id);
+
         void
         for_each_in_db(const std::function<void(fs::directory_entry)>& func) const;
 
@@ -103,6 +151,9 @@ namespace storage
         uint64_t
         estimate_size(const types::DataRow& row) override;
 
+        uint64_t
+        estimate_size(const types::IndexPage& page) override;
+
         void
         write_mt(const types::MetaTable& table, const std::string& schema_name, bool fsync) override;
 
@@ -151,6 +202,18 @@ namespace storage
 
         void
         write_index_file(const types::IndexFile& index_file, bool fsync) override;
+
+        std::unique_ptr<types::IndexPage>
+        read_index_page(const types::IndexId& index_id, types::IndexPageId page_id) override;
+
+        void
+        write_index_page(const types::IndexPage& page, bool fsync) override;
+
+        std::unique_ptr<types::FreeSpaceMap>
+        read_fsm(const types::TableId& table_id) override;
+
+        void
+        write_fsm(const types::FreeSpaceMap& fsm) override;
     };
 }
 
@@ -21,6 +21,20 @@ namespace storage
 
     void
     fsync_file(const fs::path& path, const types::Bytes& content);
+
+    // Writes the content to a temporary file next to path and renames it over path, so
+    // that a crash leaves either the old or the new file, never a torn one. With fsync the
+    // new content and the rename are both on disk when it returns.
+    void
+    replace_file(const fs::path& path, const types::Bytes& content, bool fsync);
+
+    // Reads size bytes at offset; shorter, or empty, where the file ends before that.
+    types::Bytes
+    read_file_block(const fs::path& path, uint64_t offset, uint64_t size);
+
+    // Overwrites the bytes at offset and leaves the rest of the file in place.
+    void
+    write_file_block(const fs::path& path, uint64_t offset, const types::Bytes& content, bool fsync);
 }
 
 #endif //DELTABASE_UTILS_HPP
\ No newline at end of file
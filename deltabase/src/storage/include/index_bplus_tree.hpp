@@ -6,23 +6,104 @@
 #define DELTABASE_INDEX_BPLUS_TREE_HPP
 #include "index_pager.hpp"
 
+#include <functional>
+
 namespace storage
 {
+    // One end of a key range. An exclusive bound leaves out keys equal to it.
+    struct KeyBound
+    {
+        types::DataToken key;
+        bool inclusive = true;
+    };
+
+    // Walks leaf entries in key order, from where the tree positioned it up to an
+    // optional upper bound. The leaf it is on stays latched shared; the next leaf is
+    // latched before the current one is let go, unless a writer holds it. Entries added
+    // after the iterator was positioned may then be passed over.
+    class IndexRangeIterator
+    {
+        IIndexPager& pager_;
+        const types::IndexPage* page_;
+        size_t pos_;
+        std::optional<KeyBound> upper_;
+
+        void
+        finish();
+
+    public:
+        IndexRangeIterator(
+            IIndexPager& pager, const types::IndexPage* page, size_t pos, std::optional<KeyBound> upper
+        );
+
+        IndexRangeIterator(IndexRangeIterator&& other) noexcept;
+
+        IndexRangeIterator(const IndexRangeIterator&) = delete;
+        IndexRangeIterator&
+        operator=(const IndexRangeIterator&) = delete;
+
+        ~IndexRangeIterator();
+
+        // Moves to the next entry in range; returns false once the range is exhausted.
+        bool
+        next(types::RowPtr& out);
+    };
+
     class IndexBPlusTree
     {
+        // Internal node a bulk load is currently filling on one level.
+        struct BulkNode
+        {
+            types::IndexPageId id;
+            types::DataToken first_key;
+        };
+
         IIndexPager& pager_;
         size_t max_leaf_keys_;
         size_t max_internal_keys_;
 
-        static int
-        compare_token(const types::DataToken& l, const types::DataToken& r);
+        // Index of the first key not less than / greater than the given one.
+        static size_t
+        lower_bound(const std::vector<types::DataToken>& keys, const types::DataToken& key);
+
+        static size_t
+        upper_bound(const std::vector<types::DataToken>& keys, const types::DataToken& key);
 
+        // Where to split a node's keys, kept within [min, max].
+        static size_t
+        split_point(const std::vector<types::DataToken>& keys, size_t min, size_t max);
+
+        // Like split_point, but keeps equal keys on one leaf where it can.
+        static size_t
+        leaf_split_point(const std::vector<types::DataToken>& keys, size_t min, size_t max);
+
+        // The root, latched. Taken again if the root moves while the latch is awaited.
+        types::IndexPage*
+        root(bool exclusive);
+
+        // Whether one more entry cannot make the node split.
+        bool
+        is_safe(const types::IndexPage& page);
+
+        // Latches the child shared, then lets go of the parent. A writer splitting the
+        // child may latch the parent again from below, so a reader never waits for the
+        // child while holding the parent: it lets go, waits the writer out and returns
+        // the root, for the descent to start over.
         types::IndexPage*
-        root();
+        step_down(types::IndexPage& parent, types::IndexPageId child_id);
 
+        // Descends to the leaf for the key, latching each node before letting go of its
+        // parent. Without a path the leaf is latched shared. With one, it is latched
+        // exclusive, as is every ancestor a split of it could reach; those are listed in
+        // path, and every other ancestor is let go on the way down.
         types::IndexPage*
         find_leaf(const types::DataToken& key, std::vector<types::IndexPageId>* path = nullptr);
 
+        // Leaf holding the first key not less than (inclusive) or greater than the bound,
+        // latched shared.
+        types::IndexPage*
+        seek_leaf(const KeyBound& bound);
+
         void
         insert_into_leaf(types::LeafIndexNode& leaf, const types::DataToken& key, const types::RowPtr& row_ptr);
 
@@ -40,17 +121,72 @@ namespace storage
         void
         split_internal_and_propagate(types::IndexPage& internal_page, std::vector<types::IndexPageId>& path);
 
+        // Moves into the leaf as many of the pending entries as fit in fill_percent of a
+        // page, at least one, and returns how many it took.
+        size_t
+        fill_leaf(
+            types::IndexPage& page,
+            const std::vector<types::DataToken>& keys,
+            const std::vector<types::RowPtr>& rows,
+            uint32_t fill_percent
+        );
+
+        // Adds a finished child to the open node of the level, closing that node into
+        // the level above once it is full.
+        void
+        push_child(
+            std::vector<BulkNode>& levels,
+            size_t level,
+            const types::DataToken& first_key,
+            types::IndexPageId child_id,
+            uint32_t fill_percent
+        );
+
     public:
-        IndexBPlusTree(IIndexPager& pager, size_t max_leaf_keys = 64, size_t max_internal_keys = 64)
+        // Entries for a bulk load in key order; returns false once there are no more.
+        using EntrySource = std::function<bool(types::DataToken& key, types::RowPtr& row_ptr)>;
+
+        // Nodes split when they exceed the key count or no longer fit a page, so the
+        // defaults leave fan-out to the page size.
+        static constexpr size_t DEFAULT_MAX_KEYS = 1024;
+
+        IndexBPlusTree(
+            IIndexPager& pager,
+            size_t max_leaf_keys = DEFAULT_MAX_KEYS,
+            size_t max_internal_keys = DEFAULT_MAX_KEYS
+        )
             : pager_(pager), max_leaf_keys_(max_leaf_keys), max_internal_keys_(max_internal_keys)
         {
         }
 
+        // One entry with the key. Keys repeated in non-unique indexes need equal_range.
         std::optional<types::RowPtr>
         find(const types::DataToken& key);
 
+        // Lets go of every latch taken through the pager once done, so no iterator over
+        // the same pager may be open.
         void
         insert(const types::DataToken& key, const types::RowPtr& row_ptr);
+
+        // Removes the entry with the key that points at the row, and returns false if
+        // there is none. Leaves it empties stay in the tree. Called, like insert, by the
+        // table's writer only.
+        bool
+        erase(const types::DataToken& key, const types::RowPtr& row_ptr);
+
+        // Entries with keys between the bounds; a missing bound leaves that side open.
+        IndexRangeIterator
+        range(const std::optional<KeyBound>& lower, const std::optional<KeyBound>& upper);
+
+        // Every entry with the key, in one pass over the leaves that hold it.
+        IndexRangeIterator
+        equal_range(const types::DataToken& key);
+
+        // Builds an empty tree bottom-up from sorted entries: leaves are packed to
+        // fill_percent of a page and chained, and each internal level is filled as the
+        // level below completes. Pages are released as soon as they are finished.
+        void
+        bulk_load(const EntrySource& next, uint32_t fill_percent);
     };
 }
 
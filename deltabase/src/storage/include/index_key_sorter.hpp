@@ -0,0 +1,87 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#ifndef DELTABASE_INDEX_KEY_SORTER_HPP
+#define DELTABASE_INDEX_KEY_SORTER_HPP
+
+#include "../../types/include/index_page.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+namespace storage
+{
+    // Sorts the (key, row) entries of an index being built. Entries are kept in memory
+    // up to a byte budget; beyond it, sorted runs are spilled to files in the spill
+    // directory and merged when the entries are read back.
+    class IndexKeySorter
+    {
+    public:
+        using Entry = std::pair<types::DataToken, types::RowPtr>;
+
+    private:
+        // A spilled run being read back, with the entry it is positioned at.
+        struct RunReader
+        {
+            std::ifstream in;
+            Entry current;
+            bool valid = false;
+        };
+
+        std::filesystem::path spill_dir_;
+        uint64_t memory_bytes_;
+
+        std::vector<Entry> entries_;
+        uint64_t entries_bytes_ = 0;
+        size_t next_entry_ = 0;
+
+        std::vector<std::filesystem::path> runs_;
+        std::vector<std::unique_ptr<RunReader>> readers_;
+
+        static uint64_t
+        footprint(const Entry& entry);
+
+        static void
+        write_entry(std::ofstream& out, const Entry& entry);
+
+        static bool
+        read_entry(std::ifstream& in, Entry& out);
+
+        void
+        spill();
+
+        void
+        open_readers();
+
+        // Takes the smallest entry among the run readers.
+        bool
+        next_merged(Entry& out);
+
+    public:
+        IndexKeySorter(std::filesystem::path spill_dir, uint64_t memory_bytes);
+
+        ~IndexKeySorter();
+
+        IndexKeySorter(const IndexKeySorter&) = delete;
+        IndexKeySorter&
+        operator=(const IndexKeySorter&) = delete;
+
+        void
+        add(types::DataToken key, const types::RowPtr& row_ptr);
+
+        // Sorts everything added so far. With unique set, also checks that no key occurs
+        // twice: spilled runs are then merged into one run up front, so that a violation
+        // shows before anything is read. Returns false on a repeated key.
+        bool
+        sort(bool unique);
+
+        // Entries in key order, after sort.
+        bool
+        next(Entry& out);
+    };
+} // namespace storage
+
+#endif // DELTABASE_INDEX_KEY_SORTER_HPP
@@ -29,8 +29,37 @@ namespace storage
         virtual types::IndexPage*
         create_page(bool is_leaf, types::IndexPageId parent) = 0;
 
+        // Whether the page, as it is now, can still be written to its block.
+        virtual bool
+        fits(const types::IndexPage& page) = 0;
+
+        // Whether the page takes no more than fill_percent of its block.
+        virtual bool
+        fits(const types::IndexPage& page, uint32_t fill_percent) = 0;
+
+        // Unpins a page the tree is done with; it stays buffered until evicted.
+        virtual void
+        release(types::IndexPageId page_id) = 0;
+
+        // Latches a page handed out by get_page, shared to read it or exclusive to change
+        // it, until it is unlatched or released. A page latched already keeps its latch;
+        // a shared latch cannot be upgraded. Pages from create_page come latched exclusive.
+        virtual void
+        latch(types::IndexPageId page_id, bool exclusive) = 0;
+
+        // Like latch, but gives up instead of waiting for another holder of the page.
+        virtual bool
+        try_latch(types::IndexPageId page_id, bool exclusive) = 0;
+
+        virtual void
+        unlatch(types::IndexPageId page_id) = 0;
+
+        virtual void
+        unlatch_all() = 0;
+
+        // Every page the tree changes is marked, and only marked pages are written.
         virtual void
-        mark_dirty() = 0;
+        mark_dirty(types::IndexPageId page_id) = 0;
 
         virtual void
         flush() = 0;
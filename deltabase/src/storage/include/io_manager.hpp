@@ -6,6 +6,7 @@
 #define DELTABASE_IO_MANAGER_HPP
 #include "../../types/include/config.hpp"
 #include "../../types/include/data_page.hpp"
+#include "../../types/include/free_space_map.hpp"
 #include "../../types/include/meta_schema.hpp"
 #include "../../types/include/meta_table.hpp"
 #include "../../types/include/index_file.hpp"
@@ -55,6 +56,9 @@ namespace storage
         virtual uint64_t
         estimate_size(const types::DataRow& row) = 0;
 
+        virtual uint64_t
+        estimate_size(const types::IndexPage& page) = 0;
+
         virtual void
         write_page(const types::DataPage& page, bool fsync = false) = 0;
 
@@ -94,16 +98,32 @@ namespace storage
         virtual std::unordered_map<types::TableId, std::vector<types::IndexId>>
         map_index_files_for_table() = 0;
 
+        // Writes the header and an empty root leaf.
         virtual types::IndexFile
         create_index_file(
             const std::string& string, const std::string& table_name, const types::MetaIndex& mi
         ) = 0;
 
+        // Reads the header block only.
         virtual std::unique_ptr<types::IndexFile>
         read_index_file(const types::IndexId& index_id) = 0;
 
         virtual void
         write_index_file(const types::IndexFile& index_file, bool fsync = false) = 0;
+
+        // Returns nullptr if the page was never written.
+        virtual std::unique_ptr<types::IndexPage>
+        read_index_page(const types::IndexId& index_id, types::IndexPageId page_id) = 0;
+
+        virtual void
+        write_index_page(const types::IndexPage& page, bool fsync = false) = 0;
+
+        // Returns nullptr if the table has no free space map yet.
+        virtual std::unique_ptr<types::FreeSpaceMap>
+        read_fsm(const types::TableId& table_id) = 0;
+
+        virtual void
+        write_fsm(const types::FreeSpaceMap& fsm) = 0;
     };
 } // namespace storage
 
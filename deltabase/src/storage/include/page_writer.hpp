@@ -0,0 +1,69 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#ifndef DELTABASE_PAGE_WRITER_HPP
+#define DELTABASE_PAGE_WRITER_HPP
+
+#include "../../types/include/config.hpp"
+#include "../../wal/include/wal_manager.hpp"
+#include "buffer_pool.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace storage
+{
+    // Background thread that trickles dirty buffer pool frames to disk, so that commits
+    // only wait for the WAL. A frame is written once the WAL is durable up to its
+    // last_lsn and it has either stayed dirty longer than the configured age, or the
+    // dirty share of the pool exceeds the configured ratio.
+    class PageWriter
+    {
+        // Upper bound on frames written per round; the pool lock is released between rounds.
+        static constexpr size_t FRAMES_PER_ROUND = 32;
+
+        BufferPool& buffer_pool_;
+        wal::IWALManager& wal_manager_;
+
+        std::chrono::milliseconds interval_;
+        std::chrono::milliseconds max_dirty_age_;
+        uint32_t dirty_percent_;
+
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        bool stopping_ = false;
+        bool woken_ = false;
+        std::thread thread_;
+
+        void
+        run();
+
+        void
+        write_round();
+
+    public:
+        PageWriter(BufferPool& buffer_pool, wal::IWALManager& wal_manager, const types::Config& cfg);
+
+        ~PageWriter();
+
+        PageWriter(const PageWriter&) = delete;
+        PageWriter&
+        operator=(const PageWriter&) = delete;
+
+        void
+        start();
+
+        // Joins the thread.
+        void
+        stop();
+
+        // Requests a round before the interval elapses.
+        void
+        wake();
+    };
+} // namespace storage
+
+#endif // DELTABASE_PAGE_WRITER_HPP
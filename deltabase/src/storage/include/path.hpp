@@ -12,10 +12,12 @@
 // data/db_name/schema_name/schema_name.meta
 // data/db_name/schema_name/table_name/
 // data/db_name/schema_name/table_name/table_name.meta
+// data/db_name/schema_name/table_name/table_name.fsm <-> free space map of the table
 // data/db_name/schema_name/table_name/data/
 // data/db_name/schema_name/table_name/data/2093ru20rj2039j2f29jf209fej <-> page (name is page_id)
 // data/db_name/wal/
-// data/db_name/wal/wal_logfile
+// data/db_name/wal/0000000000000001.wal <-> WAL segment (name is its sequence number)
+// <any file>.tmp <-> next version of the file, renamed over it once written
 
 namespace storage
 {
@@ -25,6 +27,8 @@ namespace storage
     static const std::string PATH_WAL = "wal";
     static const std::string PATH_META = "meta";
     static const std::string PATH_INDEX = "index";
+    static const std::string PATH_FSM = "fsm";
+    static const std::string PATH_TMP = "tmp";
 
     inline std::string
     make_meta_filename(const std::string& name)
@@ -32,6 +36,27 @@ namespace storage
         return name + "." + PATH_META;
     }
 
+    inline std::string
+    make_fsm_filename(const std::string& name)
+    {
+        return name + "." + PATH_FSM;
+    }
+
+    inline fs::path
+    make_tmp_path(const fs::path& path)
+    {
+        auto tmp = path;
+        tmp += "." + PATH_TMP;
+        return tmp;
+    }
+
+    // A crash can leave one behind; whoever lists a directory skips it.
+    inline bool
+    is_tmp_path(const fs::path& path)
+    {
+        return path.extension() == "." + PATH_TMP;
+    }
+
     inline fs::path
     path_data(const fs::path& data_dir)
     {
@@ -50,16 +75,13 @@ namespace storage
         return data_dir / db_name / PATH_WAL;
     }
 
+    // Segments are named by sequence number; the LSNs they hold are in their header.
     inline fs::path
-    path_db_wal_logfile(
-        const fs::path& data_dir,
-        const std::string& db_name,
-        uint64_t first_lsn,
-        uint64_t last_lsn
-    )
+    path_db_wal_segment(const fs::path& data_dir, const std::string& db_name, uint64_t seq)
     {
-        return data_dir / db_name / PATH_WAL
-            / (std::to_string(first_lsn) + "_" + std::to_string(last_lsn));
+        auto name = std::to_string(seq);
+        name.insert(0, name.size() < 16 ? 16 - name.size() : 0, '0');
+        return data_dir / db_name / PATH_WAL / (name + ".wal");
     }
 
     inline fs::path
@@ -11,14 +11,22 @@
 #include "../../wal/include/wal_manager.hpp"
 #include "buffer_pool.hpp"
 #include "catalog.hpp"
+#include "checkpointer.hpp"
 #include "db_instance.hpp"
 #include "io_manager.hpp"
+#include "page_writer.hpp"
 
 #include <mutex>
+#include <shared_mutex>
 
 namespace storage
 {
-    class StdDbInstance final : public IDbInstance
+    class IndexBPlusTree;
+    class IndexKeySorter;
+
+    // Rolls transactions back through the recovery manager's undo, as its own undo
+    // target: undo then changes the buffered pages and the cached catalog.
+    class StdDbInstance final : public IDbInstance, private recovery::IUndoTarget
     {
         types::Config cfg_;
         std::unique_ptr<IIOManager> io_manager_;
@@ -27,16 +35,122 @@ namespace storage
         std::unique_ptr<recovery::RecoveryManager> recovery_manager_;
         std::unique_ptr<BufferPool> buffer_pool_;
         std::unique_ptr<CatalogCache> catalog_;
-        mutable std::recursive_mutex mtx_;
+
+        // Latches are taken in this order: catalog, table, data pages, index pages. The
+        // catalog latch is held shared by every statement and exclusive by DDL and by
+        // the checkpointer. A table latch is held by statements that change the table,
+        // so writers of a table take turns while other tables go on; readers do without
+        // it and latch only the frame they read. Frames are latched through the buffer
+        // pool.
+        mutable std::shared_mutex catalog_latch_;
+        std::mutex table_latches_mtx_;
+        std::unordered_map<types::TableId, std::unique_ptr<std::shared_mutex>> table_latches_;
+
+        std::unique_ptr<PageWriter> page_writer_;
+        std::unique_ptr<Checkpointer> checkpointer_;
 
         void
         init();
 
+        std::shared_mutex&
+        table_latch(const types::TableId& table_id);
+
         ssize_t
         has_available_page(const std::vector<const types::DataPage*>& vec, size_t size) const;
 
+        types::ScanCursor
+        seq_scan_begin(
+            const std::string& table_name, const std::string& schema_name, types::Snapshot snapshot
+        );
+
+        // Walks the table's pages for the one no other page is chained to, for when the free
+        // space map does not know the head, and records it there.
+        types::DataPageId
+        find_head(const types::TableId& table_id);
+
+        types::DataTable
+        index_scan(
+            const std::string& table_name,
+            const std::string& schema_name,
+            const types::IndexId& index_id,
+            const types::BinaryExpr& condition,
+            const types::Snapshot& snapshot
+        );
+
+        // What a writer goes by when it checks unique keys: every transaction committed
+        // so far, and its own.
+        types::Snapshot
+        latest_snapshot(const txn::Transaction& txn) const;
+
+        // Obsolete for good: rolled back, or deleted by a transaction latest sees. A
+        // deleter that may still roll back can bring the row back.
         bool
-        is_row_obsolete(const types::RowPtr& row_ptr) const;
+        is_row_obsolete(const types::RowPtr& row_ptr, const types::Snapshot& latest) const;
+
+        // Whether any entry with the key points at a row that is not obsolete for good.
+        bool
+        has_live_entry(
+            IndexBPlusTree& tree, const types::DataToken& key, const types::Snapshot& latest
+        ) const;
+
+        // prepare_dp, plus chaining the page after the table's tail if it is a new one.
+        // The page, and the tail if it was changed, are latched in latches.
+        PageGuard
+        prepare_page(const types::MetaTable& mt, size_t size, PageLatches& latches);
+
+        // Throws UniqueConstraintViolation if the rows repeat a key of a unique index,
+        // among themselves or against a live row.
+        void
+        check_unique_keys(
+            const types::MetaTable& mt,
+            const std::vector<types::DataRow>& rows,
+            const txn::Transaction& txn
+        ) const;
+
+        // Adds the key and place of every version of the table some snapshot may still see
+        // to sorter, as index_scan expects them all. With unique_keys, those of the versions
+        // not obsolete go there too, for the unique check.
+        void
+        collect_index_keys(
+            const types::MetaTable& table,
+            size_t col_idx,
+            IndexKeySorter& sorter,
+            IndexKeySorter* unique_keys = nullptr
+        );
+
+        // Fills the index, just created and still empty, with the sorted entries.
+        void
+        load_index(
+            const types::MetaTable& table,
+            const types::MetaIndex& mi,
+            IndexKeySorter& sorter,
+            types::LSN lsn
+        );
+
+        // Builds the table's indexes anew from its rows. Used after recovery, since index
+        // contents are not logged.
+        void
+        rebuild_indexes(const types::TableId& table_id);
+
+        bool
+        change_page(
+            const types::TableId& table_id,
+            const types::DataPageId& page_id,
+            const std::function<void(types::DataPage&)>& change
+        ) override;
+
+        void
+        change_table(
+            const types::TableId& table_id, const std::function<void(types::MetaTable&)>& change
+        ) override;
+
+        void
+        unindex(
+            const types::TableId& table_id,
+            const types::DataPageId& page_id,
+            std::span<const types::DataRow> rows,
+            types::LSN lsn
+        ) override;
 
     public:
         explicit StdDbInstance(const types::Config& cfg);
@@ -49,9 +163,17 @@ namespace storage
         types::ScanCursor
         seq_scan_begin(const std::string& table_name, const std::string& schema_name) override;
 
+        types::ScanCursor
+        seq_scan_begin(
+            const std::string& table_name, const std::string& schema_name, const txn::Transaction& txn
+        ) override;
+
         bool
         seq_scan_next(types::ScanCursor& cursor, types::DataRow& out) override;
 
+        bool
+        seq_scan_next(types::ScanCursor& cursor, types::DataRow& out, const RowFilter& filter) override;
+
         types::DataTable
         index_scan(
             const std::string& table_name,
@@ -60,6 +182,24 @@ namespace storage
             const types::BinaryExpr& condition
         ) override;
 
+        types::DataTable
+        index_scan(
+            const std::string& table_name,
+            const std::string& schema_name,
+            const types::IndexId& index_id,
+            const types::BinaryExpr& condition,
+            const txn::Transaction& txn
+        ) override;
+
+        uint64_t
+        index_range_count(
+            const std::string& table_name,
+            const std::string& schema_name,
+            const types::IndexId& index_id,
+            const types::BinaryExpr& condition,
+            uint64_t limit
+        ) override;
+
         txn::Transaction
         make_txn() override;
 
@@ -72,9 +212,21 @@ namespace storage
             txn::Transaction& txn
         ) override;
 
+        void
+        insert_rows(
+            const std::string& table_name,
+            const std::string& schema_name,
+            const std::optional<std::vector<std::string>>& cols,
+            std::vector<std::vector<types::DataToken>> rows,
+            txn::Transaction& txn
+        ) override;
+
         std::vector<types::IndexId>
         insert_row_into_indexes(
-            const types::MetaTable& mt, const types::DataRow& row, const types::DataPageId& page_id
+            const types::MetaTable& mt,
+            const types::DataRow& row,
+            const types::DataPageId& page_id,
+            const txn::Transaction& txn
         ) override;
 
         void
@@ -103,6 +255,10 @@ namespace storage
         const types::Config&
         get_config() const override;
 
+        // Buffer pool statistics, for comparing replacement policies.
+        const BufferPool&
+        get_buffer_pool() const;
+
         types::MetaSchema*
         get_schema(const std::string& name) override;
 
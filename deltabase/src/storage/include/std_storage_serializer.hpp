@@ -23,6 +23,16 @@ namespace storage
         uint64_t
         get_data_type_size(types::DataType data_type) const;
 
+        // Keys of an index page, prefix-compressed when they all have one type.
+        void
+        write_keys(const std::vector<types::DataToken>& keys, misc::MemoryStream& stream) const;
+
+        bool
+        read_keys(misc::ReadOnlyMemoryStream& stream, std::vector<types::DataToken>& out) const;
+
+        uint64_t
+        estimate_keys_size(const std::vector<types::DataToken>& keys) const;
+
     public:
         misc::MemoryStream
         serialize_mt(const types::MetaTable& table) const override;
@@ -45,6 +55,9 @@ namespace storage
         misc::MemoryStream
         serialize_ip(const types::IndexPage& page) const override;
 
+        misc::MemoryStream
+        serialize_fsm(const types::FreeSpaceMap& fsm) const override;
+
         misc::MemoryStream
         serialize_dr(const types::DataRow& row) const override;
 
@@ -72,6 +85,9 @@ namespace storage
         bool
         deserialize_if(misc::ReadOnlyMemoryStream& content, types::IndexFile& out) const override;
 
+        bool
+        deserialize_fsm(misc::ReadOnlyMemoryStream& content, types::FreeSpaceMap& out) const override;
+
         bool
         deserialize_ip(misc::ReadOnlyMemoryStream& content, types::IndexPage& out) const override;
 
@@ -89,6 +105,9 @@ namespace storage
 
         uint64_t
         estimate_size(const types::DataToken& token) const override;
+
+        uint64_t
+        estimate_size(const types::IndexPage& page) const override;
     };
 }
 
@@ -7,6 +7,7 @@
 #include "../../misc/include/memory_stream.hpp"
 #include "../../types/include/config.hpp"
 #include "../../types/include/data_page.hpp"
+#include "../../types/include/free_space_map.hpp"
 #include "../../types/include/meta_schema.hpp"
 #include "../../types/include/meta_table.hpp"
 #include "index_file.hpp"
@@ -43,6 +44,9 @@ namespace storage
         virtual misc::MemoryStream
         serialize_if(const types::IndexFile& file) const = 0;
 
+        virtual misc::MemoryStream
+        serialize_fsm(const types::FreeSpaceMap& fsm) const = 0;
+
         virtual misc::MemoryStream
         serialize_dr(const types::DataRow& row) const = 0;
 
@@ -67,6 +71,9 @@ namespace storage
         virtual bool
         deserialize_if(misc::ReadOnlyMemoryStream& content, types::IndexFile& out) const = 0;
 
+        virtual bool
+        deserialize_fsm(misc::ReadOnlyMemoryStream& content, types::FreeSpaceMap& out) const = 0;
+
         virtual bool
         deserialize_ip(misc::ReadOnlyMemoryStream& content, types::IndexPage& out) const = 0;
 
@@ -84,6 +91,9 @@ namespace storage
 
         virtual uint64_t
         estimate_size(const types::DataToken& token) const = 0;
+
+        virtual uint64_t
+        estimate_size(const types::IndexPage& page) const = 0;
     };
 }
 
@@ -3,34 +3,187 @@
 //
 
 #include "index_bplus_tree.hpp"
+
+#include <algorithm>
+#include <utility>
+
 namespace storage
 {
+    namespace
+    {
+        // Splits weigh entries by bytes rather than by count, so that long keys do not
+        // all end up on one side. Every entry also carries a fixed cost besides its key.
+        constexpr size_t ENTRY_OVERHEAD = 32;
+
+        // A node filled up to this share of its block takes one more entry of the longest
+        // key without splitting, unless the entry also shortens the prefix its keys share.
+        constexpr uint32_t SAFE_FILL_PERCENT =
+            (types::MAX_IP_SIZE - types::MAX_IP_KEY_SIZE - ENTRY_OVERHEAD) * 100 / types::MAX_IP_SIZE;
+    } // namespace
+
+    IndexRangeIterator::IndexRangeIterator(
+        IIndexPager& pager, const types::IndexPage* page, size_t pos, std::optional<KeyBound> upper
+    )
+        : pager_(pager), page_(page), pos_(pos), upper_(std::move(upper))
+    {
+    }
+
+    IndexRangeIterator::IndexRangeIterator(IndexRangeIterator&& other) noexcept
+        : pager_(other.pager_), page_(std::exchange(other.page_, nullptr)), pos_(other.pos_),
+          upper_(std::move(other.upper_))
+    {
+    }
+
+    IndexRangeIterator::~IndexRangeIterator()
+    {
+        finish();
+    }
+
+    void
+    IndexRangeIterator::finish()
+    {
+        if (page_)
+            pager_.unlatch(page_->id);
+        page_ = nullptr;
+    }
+
+    bool
+    IndexRangeIterator::next(types::RowPtr& out)
+    {
+        while (page_)
+        {
+            const auto& leaf = std::get<types::LeafIndexNode>(page_->data);
+            if (pos_ < leaf.keys.size())
+            {
+                if (upper_)
+                {
+                    const int res = types::compare(leaf.keys[pos_], upper_->key);
+                    if (res > 0 || (res == 0 && !upper_->inclusive))
+                    {
+                        finish();
+                        return false;
+                    }
+                }
+
+                out = leaf.rows[pos_++];
+                return true;
+            }
+
+            if (leaf.next_leaf == 0)
+            {
+                finish();
+                return false;
+            }
+
+            const auto* next_page = pager_.get_page(leaf.next_leaf);
+            if (!next_page)
+                throw std::runtime_error("IndexRangeIterator: broken leaf chain");
+
+            // A writer holding the next leaf may be waiting to re-parent this one. Letting
+            // go first breaks that wait; entries a split then moves out of this leaf were
+            // all read already.
+            const bool coupled = pager_.try_latch(next_page->id, false);
+            pager_.unlatch(page_->id);
+            if (!coupled)
+                pager_.latch(next_page->id, false);
+            page_ = next_page;
+            pos_ = 0;
+        }
+
+        return false;
+    }
+
     std::optional<types::RowPtr>
     IndexBPlusTree::find(const types::DataToken& key)
     {
         auto* leaf_page = find_leaf(key, nullptr);
         auto& leaf = std::get<types::LeafIndexNode>(leaf_page->data);
 
-        for (size_t i = 0; i < leaf.keys.size(); ++i)
-            if (compare_token(leaf.keys[i], key) == 0)
-                return leaf.rows[i];
+        std::optional<types::RowPtr> found;
+        const size_t pos = lower_bound(leaf.keys, key);
+        if (pos < leaf.keys.size() && types::compare(leaf.keys[pos], key) == 0)
+            found = leaf.rows[pos];
 
-        return std::nullopt;
+        pager_.unlatch(leaf_page->id);
+        return found;
     }
 
     void
     IndexBPlusTree::insert(const types::DataToken& key, const types::RowPtr& row_ptr)
     {
-        std::vector<types::IndexPageId> path;
-        auto* leaf_page = find_leaf(key, &path);
-        auto& leaf = std::get<types::LeafIndexNode>(leaf_page->data);
+        if (key.bytes.size() > types::MAX_IP_KEY_SIZE)
+            throw std::runtime_error("IndexBpTree: key is too long to be indexed");
+
+        try
+        {
+            std::vector<types::IndexPageId> path;
+            auto* leaf_page = find_leaf(key, &path);
+            auto& leaf = std::get<types::LeafIndexNode>(leaf_page->data);
+
+            insert_into_leaf(leaf, key, row_ptr);
+            pager_.mark_dirty(leaf_page->id);
 
-        insert_into_leaf(leaf, key, row_ptr);
+            if (leaf.keys.size() > max_leaf_keys_ || !pager_.fits(*leaf_page))
+                split_leaf_and_propagate(*leaf_page, path);
+        }
+        catch (...)
+        {
+            pager_.unlatch_all();
+            throw;
+        }
+
+        pager_.unlatch_all();
+    }
 
-        if (leaf.keys.size() > max_leaf_keys_)
-            split_leaf_and_propagate(*leaf_page, path);
+    bool
+    IndexBPlusTree::erase(const types::DataToken& key, const types::RowPtr& row_ptr)
+    {
+        bool erased = false;
+        try
+        {
+            // No other writer changes the leaves, so the leaf found under a shared latch
+            // is still the one to look in once latched exclusive.
+            auto* leaf_page = seek_leaf(KeyBound{key, true});
+            pager_.unlatch(leaf_page->id);
+            pager_.latch(leaf_page->id, true);
+
+            // Equal keys may go on over the next leaves.
+            while (true)
+            {
+                auto& leaf = std::get<types::LeafIndexNode>(leaf_page->data);
+                size_t pos = lower_bound(leaf.keys, key);
+                for (; pos < leaf.keys.size() && types::compare(leaf.keys[pos], key) == 0; ++pos)
+                {
+                    if (leaf.rows[pos] != row_ptr)
+                        continue;
+
+                    leaf.keys.erase(leaf.keys.begin() + static_cast<long>(pos));
+                    leaf.rows.erase(leaf.rows.begin() + static_cast<long>(pos));
+                    pager_.mark_dirty(leaf_page->id);
+                    erased = true;
+                    break;
+                }
+
+                if (erased || pos < leaf.keys.size() || leaf.next_leaf == 0)
+                    break;
+
+                auto* next_page = pager_.get_page(leaf.next_leaf);
+                if (!next_page)
+                    throw std::runtime_error("IndexBpTree: broken leaf chain");
+
+                pager_.latch(next_page->id, true);
+                pager_.unlatch(leaf_page->id);
+                leaf_page = next_page;
+            }
+        }
+        catch (...)
+        {
+            pager_.unlatch_all();
+            throw;
+        }
 
-        pager_.mark_dirty();
+        pager_.unlatch_all();
+        return erased;
     }
 
     void
@@ -38,11 +191,16 @@ namespace storage
         types::IndexPage& leaf_page, std::vector<types::IndexPageId>& path
     )
     {
-        auto& leaf = std::get<types::LeafIndexNode>(leaf_page.data);
-        const size_t mid = leaf.keys.size() / 2;
+        const auto leaf_id = leaf_page.id;
 
         auto* right_page = pager_.create_page(true, leaf_page.parent);
+        auto* left_page = pager_.get_page(leaf_id);
+        if (!left_page)
+            throw std::runtime_error("IndexBpTree: leaf missing during split");
+
+        auto& leaf = std::get<types::LeafIndexNode>(left_page->data);
         auto& right_leaf = std::get<types::LeafIndexNode>(right_page->data);
+        const size_t mid = leaf_split_point(leaf.keys, 1, leaf.keys.size() - 1);
 
         right_leaf.keys.assign(leaf.keys.begin() + static_cast<long>(mid), leaf.keys.end());
         right_leaf.rows.assign(leaf.rows.begin() + static_cast<long>(mid), leaf.rows.end());
@@ -51,9 +209,11 @@ namespace storage
 
         right_leaf.next_leaf = leaf.next_leaf;
         leaf.next_leaf = right_page->id;
+        pager_.mark_dirty(leaf_id);
+        pager_.mark_dirty(right_page->id);
 
         const auto separator = right_leaf.keys.front();
-        insert_into_parent(path, leaf_page.id, separator, right_page->id);
+        insert_into_parent(path, leaf_id, separator, right_page->id);
     }
 
     void
@@ -64,6 +224,21 @@ namespace storage
         types::IndexPageId right_id
     )
     {
+        // The descent let go of the parent, judging the node safe, but the new key also
+        // shortened the prefix its keys share. Writers of a table take turns, so the
+        // parent can be latched again out of order without risking a deadlock.
+        if (path.size() == 1 && left_id != pager_.root_page_id())
+        {
+            const auto* left = pager_.get_page(left_id);
+            if (!left)
+                throw std::runtime_error("IndexBpTree: node missing during split");
+
+            if (!pager_.get_page(left->parent))
+                throw std::runtime_error("IndexBpTree: invalid parent");
+            pager_.latch(left->parent, true);
+            path.insert(path.begin(), left->parent);
+        }
+
         if (path.size() == 1)
         {
             auto* new_root = pager_.create_page(false, 0);
@@ -79,6 +254,9 @@ namespace storage
 
             left->parent = new_root->id;
             right->parent = new_root->id;
+            pager_.mark_dirty(left_id);
+            pager_.mark_dirty(right_id);
+            pager_.mark_dirty(new_root->id);
             pager_.set_root_page_id(new_root->id);
             return;
         }
@@ -106,8 +284,10 @@ namespace storage
         if (!right)
             throw std::runtime_error("IndexBpTree: right child not found");
         right->parent = parent_id;
+        pager_.mark_dirty(right_id);
+        pager_.mark_dirty(parent_id);
 
-        if (parent.keys.size() > max_internal_keys_)
+        if (parent.keys.size() > max_internal_keys_ || !pager_.fits(*parent_page))
         {
             path.pop_back();
             split_internal_and_propagate(*parent_page, path);
@@ -119,12 +299,18 @@ namespace storage
         types::IndexPage& internal_page, std::vector<types::IndexPageId>& path
     )
     {
-        auto& node = std::get<types::InternalIndexNode>(internal_page.data);
-        const size_t mid = node.keys.size() / 2;
-        const auto up_key = node.keys[mid];
+        const auto node_id = internal_page.id;
 
         auto* right_page = pager_.create_page(false, internal_page.parent);
+        auto* left_page = pager_.get_page(node_id);
+        if (!left_page)
+            throw std::runtime_error("IndexBpTree: node missing during split");
+
+        auto& node = std::get<types::InternalIndexNode>(left_page->data);
         auto& right_node = std::get<types::InternalIndexNode>(right_page->data);
+        // The key at mid moves up, so each side keeps at least one key.
+        const size_t mid = split_point(node.keys, 1, node.keys.size() - 2);
+        const auto up_key = node.keys[mid];
 
         right_node.keys.assign(node.keys.begin() + static_cast<long>(mid + 1), node.keys.end());
         right_node.children.assign(
@@ -134,15 +320,21 @@ namespace storage
         node.keys.resize(mid);
         node.children.resize(mid + 1);
 
+        const auto right_id = right_page->id;
         for (const auto child_id : right_node.children)
         {
             auto* child = pager_.get_page(child_id);
             if (!child)
                 throw std::runtime_error("IndexBpTree: child missing during split");
-            child->parent = right_page->id;
+            pager_.latch(child_id, true);
+            child->parent = right_id;
+            pager_.mark_dirty(child_id);
         }
 
-        insert_into_parent(path, internal_page.id, up_key, right_page->id);
+        pager_.mark_dirty(node_id);
+        pager_.mark_dirty(right_id);
+
+        insert_into_parent(path, node_id, up_key, right_id);
     }
 
     void
@@ -150,57 +342,361 @@ namespace storage
         types::LeafIndexNode& leaf, const types::DataToken& key, const types::RowPtr& row_ptr
     )
     {
-        size_t pos = 0;
-        while (pos < leaf.keys.size() && compare_token(leaf.keys[pos], key) < 0)
-            ++pos;
+        const size_t pos = lower_bound(leaf.keys, key);
 
         leaf.keys.insert(leaf.keys.begin() + static_cast<long>(pos), key);
         leaf.rows.insert(leaf.rows.begin() + static_cast<long>(pos), row_ptr);
     }
 
+    types::IndexPage*
+    IndexBPlusTree::step_down(types::IndexPage& parent, types::IndexPageId child_id)
+    {
+        auto* child = pager_.get_page(child_id);
+        if (!child)
+            throw std::runtime_error("IndexBpTree: child page not found");
+
+        if (!pager_.try_latch(child_id, false))
+        {
+            pager_.unlatch(parent.id);
+            pager_.latch(child_id, false);
+            pager_.unlatch(child_id);
+            return root(false);
+        }
+
+        pager_.unlatch(parent.id);
+        return child;
+    }
+
+    bool
+    IndexBPlusTree::is_safe(const types::IndexPage& page)
+    {
+        const size_t keys = page.is_leaf ? std::get<types::LeafIndexNode>(page.data).keys.size()
+                                         : std::get<types::InternalIndexNode>(page.data).keys.size();
+        const size_t max_keys = page.is_leaf ? max_leaf_keys_ : max_internal_keys_;
+
+        return keys < max_keys && pager_.fits(page, SAFE_FILL_PERCENT);
+    }
+
     types::IndexPage*
     IndexBPlusTree::find_leaf(const types::DataToken& key, std::vector<types::IndexPageId>* path)
     {
-        auto* cur = root();
+        const bool exclusive = path != nullptr;
+        auto* cur = root(exclusive);
         while (!cur->is_leaf)
         {
-            if (path)
-                path->push_back(cur->id);
-
             auto& node = std::get<types::InternalIndexNode>(cur->data);
-            size_t i = 0;
-            while (i < node.keys.size() && compare_token(node.keys[i], key) <= 0)
-                ++i;
+            const size_t i = upper_bound(node.keys, key);
 
             if (i >= node.children.size())
                 throw std::runtime_error("IndexBpTree: broken internal node");
 
-            cur = pager_.get_page(node.children[i]);
-            if (!cur)
+            if (!exclusive)
+            {
+                cur = step_down(*cur, node.children[i]);
+                continue;
+            }
+
+            auto* child = pager_.get_page(node.children[i]);
+            if (!child)
                 throw std::runtime_error("IndexBpTree: child page not found");
+
+            pager_.latch(child->id, true);
+            path->push_back(cur->id);
+
+            // A split of the child stops at the child, so nothing above it will change.
+            if (is_safe(*child))
+            {
+                for (const auto ancestor_id : *path)
+                    pager_.unlatch(ancestor_id);
+                path->clear();
+            }
+
+            cur = child;
         }
+
         if (path)
-        {
             path->push_back(cur->id);
+
+        return cur;
+    }
+
+    types::IndexPage*
+    IndexBPlusTree::seek_leaf(const KeyBound& bound)
+    {
+        // Equal keys may sit left of an equal separator, so an inclusive seek takes the
+        // child before it.
+        auto* cur = root(false);
+        while (!cur->is_leaf)
+        {
+            auto& node = std::get<types::InternalIndexNode>(cur->data);
+            const size_t i = bound.inclusive ? lower_bound(node.keys, bound.key)
+                                             : upper_bound(node.keys, bound.key);
+
+            if (i >= node.children.size())
+                throw std::runtime_error("IndexBpTree: broken internal node");
+
+            cur = step_down(*cur, node.children[i]);
         }
 
         return cur;
     }
 
+    IndexRangeIterator
+    IndexBPlusTree::range(const std::optional<KeyBound>& lower, const std::optional<KeyBound>& upper)
+    {
+        if (!lower)
+        {
+            auto* cur = root(false);
+            while (!cur->is_leaf)
+            {
+                const auto& node = std::get<types::InternalIndexNode>(cur->data);
+                if (node.children.empty())
+                    throw std::runtime_error("IndexBpTree: broken internal node");
+
+                cur = step_down(*cur, node.children.front());
+            }
+            return IndexRangeIterator(pager_, cur, 0, upper);
+        }
+
+        auto* leaf_page = seek_leaf(*lower);
+        const auto& leaf = std::get<types::LeafIndexNode>(leaf_page->data);
+        const size_t pos = lower->inclusive ? lower_bound(leaf.keys, lower->key)
+                                            : upper_bound(leaf.keys, lower->key);
+
+        return IndexRangeIterator(pager_, leaf_page, pos, upper);
+    }
+
+    void
+    IndexBPlusTree::bulk_load(const EntrySource& next, uint32_t fill_percent)
+    {
+        auto* leaf_page = root(true);
+        if (!leaf_page->is_leaf || !std::get<types::LeafIndexNode>(leaf_page->data).keys.empty())
+            throw std::runtime_error("IndexBpTree: bulk load needs an empty tree");
+
+        const auto first_leaf = leaf_page->id;
+        std::vector<BulkNode> levels;
+        std::vector<types::DataToken> keys;
+        std::vector<types::RowPtr> rows;
+
+        types::DataToken key;
+        types::RowPtr row_ptr;
+        bool more = next(key, row_ptr);
+
+        while (more || !keys.empty())
+        {
+            while (more && keys.size() < max_leaf_keys_)
+            {
+                keys.push_back(std::move(key));
+                rows.push_back(row_ptr);
+                more = next(key, row_ptr);
+            }
+
+            const size_t taken = fill_leaf(*leaf_page, keys, rows, fill_percent);
+            keys.erase(keys.begin(), keys.begin() + static_cast<long>(taken));
+            rows.erase(rows.begin(), rows.begin() + static_cast<long>(taken));
+
+            auto& leaf = std::get<types::LeafIndexNode>(leaf_page->data);
+            types::IndexPage* next_page = nullptr;
+            if (more || !keys.empty())
+            {
+                next_page = pager_.create_page(true, 0);
+                leaf.next_leaf = next_page->id;
+            }
+            pager_.mark_dirty(leaf_page->id);
+
+            // A single leaf stays the root, without a level above it.
+            if (next_page || leaf_page->id != first_leaf)
+                push_child(levels, 0, leaf.keys.front(), leaf_page->id, fill_percent);
+
+            pager_.release(leaf_page->id);
+            leaf_page = next_page;
+        }
+
+        // Every level but the top closes its open node into the level above; the top
+        // level has one node, which becomes the root.
+        for (size_t level = 0; level < levels.size(); ++level)
+        {
+            const auto node = levels[level];
+            if (level + 1 == levels.size())
+            {
+                pager_.set_root_page_id(node.id);
+                pager_.release(node.id);
+                break;
+            }
+
+            push_child(levels, level + 1, node.first_key, node.id, fill_percent);
+            pager_.release(node.id);
+        }
+    }
+
+    size_t
+    IndexBPlusTree::fill_leaf(
+        types::IndexPage& page,
+        const std::vector<types::DataToken>& keys,
+        const std::vector<types::RowPtr>& rows,
+        uint32_t fill_percent
+    )
+    {
+        auto& leaf = std::get<types::LeafIndexNode>(page.data);
+        const auto take = [&](size_t count)
+        {
+            leaf.keys.assign(keys.begin(), keys.begin() + static_cast<long>(count));
+            leaf.rows.assign(rows.begin(), rows.begin() + static_cast<long>(count));
+        };
+
+        // Largest count that fits; the encoded size only grows with more entries.
+        size_t lo = 1;
+        size_t hi = std::min(keys.size(), max_leaf_keys_);
+        while (lo < hi)
+        {
+            const size_t mid = (lo + hi + 1) / 2;
+            take(mid);
+            if (pager_.fits(page, fill_percent))
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+
+        take(lo);
+        return lo;
+    }
+
+    void
+    IndexBPlusTree::push_child(
+        std::vector<BulkNode>& levels,
+        size_t level,
+        const types::DataToken& first_key,
+        types::IndexPageId child_id,
+        uint32_t fill_percent
+    )
+    {
+        if (level == levels.size())
+            levels.push_back({pager_.create_page(false, 0)->id, first_key});
+
+        auto* page = pager_.get_page(levels[level].id);
+        auto& node = std::get<types::InternalIndexNode>(page->data);
+
+        if (node.children.empty())
+        {
+            levels[level].first_key = first_key;
+            node.children.push_back(child_id);
+        }
+        else
+        {
+            node.keys.push_back(first_key);
+            node.children.push_back(child_id);
+
+            if (node.keys.size() > max_internal_keys_ || !pager_.fits(*page, fill_percent))
+            {
+                node.keys.pop_back();
+                node.children.pop_back();
+
+                // The open node is full: it goes to the level above, and a new one
+                // starts with this child.
+                const auto full = levels[level];
+                push_child(levels, level + 1, full.first_key, full.id, fill_percent);
+                pager_.release(full.id);
+
+                page = pager_.create_page(false, 0);
+                levels[level] = {page->id, first_key};
+                std::get<types::InternalIndexNode>(page->data).children.push_back(child_id);
+            }
+        }
+
+        auto* child = pager_.get_page(child_id);
+        if (!child)
+            throw std::runtime_error("IndexBpTree: child missing during bulk load");
+        child->parent = page->id;
+        pager_.mark_dirty(child_id);
+        pager_.mark_dirty(page->id);
+    }
+
+    size_t
+    IndexBPlusTree::split_point(const std::vector<types::DataToken>& keys, size_t min, size_t max)
+    {
+        size_t total = 0;
+        for (const auto& key : keys)
+            total += key.bytes.size() + ENTRY_OVERHEAD;
+
+        size_t mid = 0;
+        for (size_t left = 0; mid < keys.size() && left * 2 < total; ++mid)
+            left += keys[mid].bytes.size() + ENTRY_OVERHEAD;
+
+        return std::clamp(mid, min, std::max(min, max));
+    }
+
+    size_t
+    IndexBPlusTree::leaf_split_point(const std::vector<types::DataToken>& keys, size_t min, size_t max)
+    {
+        const size_t mid = split_point(keys, min, max);
+        if (mid == 0 || mid >= keys.size() || types::compare(keys[mid - 1], keys[mid]) != 0)
+            return mid;
+
+        // The split would cut a run of equal keys. Move it to the nearest boundary
+        // between different keys, as long as each side keeps a quarter of the bytes.
+        std::vector<size_t> offsets(keys.size() + 1, 0);
+        for (size_t i = 0; i < keys.size(); ++i)
+            offsets[i + 1] = offsets[i] + keys[i].bytes.size() + ENTRY_OVERHEAD;
+        const size_t total = offsets.back();
+
+        const auto is_boundary = [&](size_t i)
+        {
+            return i >= min && i <= max && offsets[i] * 4 >= total && offsets[i] * 4 <= total * 3 &&
+                   types::compare(keys[i - 1], keys[i]) != 0;
+        };
+
+        for (size_t d = 1; d < keys.size(); ++d)
+        {
+            if (d <= mid && is_boundary(mid - d))
+                return mid - d;
+            if (mid + d < keys.size() && is_boundary(mid + d))
+                return mid + d;
+        }
+
+        return mid;
+    }
+
+    IndexRangeIterator
+    IndexBPlusTree::equal_range(const types::DataToken& key)
+    {
+        return range(KeyBound{key, true}, KeyBound{key, true});
+    }
+
     types::IndexPage*
-    IndexBPlusTree::root()
+    IndexBPlusTree::root(bool exclusive)
     {
-        auto* r = pager_.get_page(pager_.root_page_id());
-        if (!r)
-            throw std::runtime_error("IndexBpTree: root page not found");
-        return r;
+        while (true)
+        {
+            const auto root_id = pager_.root_page_id();
+            auto* r = pager_.get_page(root_id);
+            if (!r)
+                throw std::runtime_error("IndexBpTree: root page not found");
+
+            pager_.latch(root_id, exclusive);
+            if (pager_.root_page_id() == root_id)
+                return r;
+
+            pager_.unlatch(root_id);
+        }
+    }
+
+    size_t
+    IndexBPlusTree::lower_bound(const std::vector<types::DataToken>& keys, const types::DataToken& key)
+    {
+        const auto it = std::lower_bound(
+            keys.begin(), keys.end(), key,
+            [](const types::DataToken& l, const types::DataToken& r) { return types::compare(l, r) < 0; }
+        );
+        return static_cast<size_t>(it - keys.begin());
     }
 
-    int
-    IndexBPlusTree::compare_token(const types::DataToken& a, const types::DataToken& b)
+    size_t
+    IndexBPlusTree::upper_bound(const std::vector<types::DataToken>& keys, const types::DataToken& key)
     {
-        if (a == b)
-            return 0;
-        return a < b ? -1 : 1;
+        const auto it = std::upper_bound(
+            keys.begin(), keys.end(), key,
+            [](const types::DataToken& l, const types::DataToken& r) { return types::compare(l, r) < 0; }
+        );
+        return static_cast<size_t>(it - keys.begin());
     }
 } // namespace storage
@@ -0,0 +1,218 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "index_key_sorter.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace storage
+{
+    using namespace types;
+
+    namespace
+    {
+        bool
+        entry_less(const IndexKeySorter::Entry& lhs, const IndexKeySorter::Entry& rhs)
+        {
+            return compare(lhs.first, rhs.first) < 0;
+        }
+    } // namespace
+
+    IndexKeySorter::IndexKeySorter(std::filesystem::path spill_dir, uint64_t memory_bytes)
+        : spill_dir_(std::move(spill_dir)), memory_bytes_(memory_bytes)
+    {
+    }
+
+    IndexKeySorter::~IndexKeySorter()
+    {
+        readers_.clear();
+
+        std::error_code ec;
+        for (const auto& run : runs_)
+            std::filesystem::remove(run, ec);
+        if (!runs_.empty())
+            std::filesystem::remove(spill_dir_, ec);
+    }
+
+    uint64_t
+    IndexKeySorter::footprint(const Entry& entry)
+    {
+        return sizeof(Entry) + entry.first.bytes.capacity();
+    }
+
+    void
+    IndexKeySorter::write_entry(std::ofstream& out, const Entry& entry)
+    {
+        const auto& [key, row_ptr] = entry;
+        const auto size = static_cast<uint32_t>(key.bytes.size());
+
+        out.write(reinterpret_cast<const char*>(&key.type), sizeof(key.type));
+        out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        out.write(reinterpret_cast<const char*>(key.bytes.data()), size);
+        out.write(reinterpret_cast<const char*>(row_ptr.first.raw()), sizeof(uuid_t));
+        out.write(reinterpret_cast<const char*>(&row_ptr.second), sizeof(row_ptr.second));
+    }
+
+    bool
+    IndexKeySorter::read_entry(std::ifstream& in, Entry& out)
+    {
+        auto& [key, row_ptr] = out;
+        uint32_t size = 0;
+
+        if (!in.read(reinterpret_cast<char*>(&key.type), sizeof(key.type)))
+            return false;
+        if (!in.read(reinterpret_cast<char*>(&size), sizeof(size)))
+            throw std::runtime_error("IndexKeySorter::read_entry: truncated run");
+
+        key.bytes.resize(size);
+        if (!in.read(reinterpret_cast<char*>(key.bytes.data()), size) ||
+            !in.read(reinterpret_cast<char*>(row_ptr.first.raw()), sizeof(uuid_t)) ||
+            !in.read(reinterpret_cast<char*>(&row_ptr.second), sizeof(row_ptr.second)))
+            throw std::runtime_error("IndexKeySorter::read_entry: truncated run");
+
+        return true;
+    }
+
+    void
+    IndexKeySorter::add(DataToken key, const RowPtr& row_ptr)
+    {
+        entries_.emplace_back(std::move(key), row_ptr);
+        entries_bytes_ += footprint(entries_.back());
+
+        if (entries_bytes_ > memory_bytes_)
+            spill();
+    }
+
+    void
+    IndexKeySorter::spill()
+    {
+        std::stable_sort(entries_.begin(), entries_.end(), entry_less);
+
+        std::filesystem::create_directories(spill_dir_);
+        const auto path = spill_dir_ / ("run_" + std::to_string(runs_.size()));
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("IndexKeySorter::spill: cannot create " + path.string());
+
+        for (const auto& entry : entries_)
+            write_entry(out, entry);
+        if (!out.flush())
+            throw std::runtime_error("IndexKeySorter::spill: cannot write " + path.string());
+
+        runs_.push_back(path);
+        entries_.clear();
+        entries_.shrink_to_fit();
+        entries_bytes_ = 0;
+    }
+
+    void
+    IndexKeySorter::open_readers()
+    {
+        readers_.clear();
+        for (const auto& run : runs_)
+        {
+            auto reader = std::make_unique<RunReader>();
+            reader->in.open(run, std::ios::binary);
+            if (!reader->in)
+                throw std::runtime_error("IndexKeySorter::open_readers: cannot open " + run.string());
+
+            reader->valid = read_entry(reader->in, reader->current);
+            readers_.push_back(std::move(reader));
+        }
+    }
+
+    bool
+    IndexKeySorter::next_merged(Entry& out)
+    {
+        // Runs are few, one per memory budget's worth of keys, so a linear pick will do.
+        RunReader* min = nullptr;
+        for (const auto& reader : readers_)
+        {
+            if (reader->valid && (!min || entry_less(reader->current, min->current)))
+                min = reader.get();
+        }
+
+        if (!min)
+            return false;
+
+        out = std::move(min->current);
+        min->valid = read_entry(min->in, min->current);
+        return true;
+    }
+
+    bool
+    IndexKeySorter::sort(bool unique)
+    {
+        next_entry_ = 0;
+
+        if (runs_.empty())
+        {
+            std::stable_sort(entries_.begin(), entries_.end(), entry_less);
+            if (unique)
+            {
+                for (size_t i = 1; i < entries_.size(); ++i)
+                    if (compare(entries_[i - 1].first, entries_[i].first) == 0)
+                        return false;
+            }
+            return true;
+        }
+
+        if (!entries_.empty())
+            spill();
+        open_readers();
+
+        if (!unique)
+            return true;
+
+        const auto merged_path = spill_dir_ / "merged";
+        {
+            std::ofstream out(merged_path, std::ios::binary | std::ios::trunc);
+            if (!out)
+                throw std::runtime_error("IndexKeySorter::sort: cannot create " + merged_path.string());
+            // Listed with the runs, so that it is cleaned up with them on a violation.
+            runs_.push_back(merged_path);
+
+            Entry previous;
+            Entry entry;
+            bool first = true;
+            while (next_merged(entry))
+            {
+                if (!first && compare(previous.first, entry.first) == 0)
+                    return false;
+
+                write_entry(out, entry);
+                previous = std::move(entry);
+                first = false;
+            }
+
+            if (!out.flush())
+                throw std::runtime_error("IndexKeySorter::sort: cannot write " + merged_path.string());
+        }
+
+        readers_.clear();
+        std::error_code ec;
+        for (const auto& run : runs_)
+            if (run != merged_path)
+                std::filesystem::remove(run, ec);
+
+        runs_ = {merged_path};
+        open_readers();
+        return true;
+    }
+
+    bool
+    IndexKeySorter::next(Entry& out)
+    {
+        if (!runs_.empty())
+            return next_merged(out);
+
+        if (next_entry_ >= entries_.size())
+            return false;
+
+        out = std::move(entries_[next_entry_++]);
+        return true;
+    }
+} // namespace storage
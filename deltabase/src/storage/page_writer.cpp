@@ -0,0 +1,100 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "include/page_writer.hpp"
+
+#include "../misc/include/logger.hpp"
+
+namespace storage
+{
+    using namespace types;
+
+    PageWriter::PageWriter(BufferPool& buffer_pool, wal::IWALManager& wal_manager, const Config& cfg)
+        : buffer_pool_(buffer_pool), wal_manager_(wal_manager), interval_(cfg.page_writer_interval_ms),
+          max_dirty_age_(cfg.page_writer_max_dirty_age_ms),
+          dirty_percent_(cfg.page_writer_dirty_percent)
+    {
+    }
+
+    PageWriter::~PageWriter()
+    {
+        stop();
+    }
+
+    void
+    PageWriter::start()
+    {
+        std::lock_guard lk(mtx_);
+        if (thread_.joinable())
+            return;
+
+        stopping_ = false;
+        thread_ = std::thread([this] { run(); });
+    }
+
+    void
+    PageWriter::stop()
+    {
+        {
+            std::lock_guard lk(mtx_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+    void
+    PageWriter::wake()
+    {
+        {
+            std::lock_guard lk(mtx_);
+            woken_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    void
+    PageWriter::run()
+    {
+        std::unique_lock lk(mtx_);
+        while (!stopping_)
+        {
+            cv_.wait_for(lk, interval_, [this] { return stopping_ || woken_; });
+            if (stopping_)
+                break;
+
+            woken_ = false;
+            lk.unlock();
+
+            try
+            {
+                write_round();
+            }
+            catch (const std::exception& e)
+            {
+                // Frames that failed to write stay dirty and are retried next round.
+                misc::Logger::error(std::string("PageWriter::run: ") + e.what());
+            }
+
+            lk.lock();
+        }
+    }
+
+    void
+    PageWriter::write_round()
+    {
+        // Frames are latched one at a time by the pool, and the ones a writer is changing
+        // are left for a later round.
+        size_t written;
+        do
+        {
+            const auto dirty_before = std::chrono::steady_clock::now() - max_dirty_age_;
+            written = buffer_pool_.write_dirty(
+                wal_manager_.get_durable_lsn(), dirty_before, dirty_percent_, FRAMES_PER_ROUND
+            );
+        } while (written == FRAMES_PER_ROUND);
+    }
+} // namespace storage
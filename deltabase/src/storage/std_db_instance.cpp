@@ -7,6 +7,7 @@
 #include "BP_index_pager.hpp"
 #include "exceptions.hpp"
 #include "index_bplus_tree.hpp"
+#include "index_key_sorter.hpp"
 #include "io_manager_factory.hpp"
 #include "logger.hpp"
 #include "std_storage_serializer.hpp"
@@ -16,13 +17,214 @@
 #include "../types/include/config.hpp"
 #include "../wal/include/wal_manager_factory.hpp"
 
+#include <algorithm>
 #include <unordered_set>
 
 namespace storage
 {
     using namespace types;
     using namespace misc;
-    using InstanceGuard = std::lock_guard<std::recursive_mutex>;
+    using SharedLatch = std::shared_lock<std::shared_mutex>;
+    using ExclusiveLatch = std::unique_lock<std::shared_mutex>;
+
+    namespace
+    {
+        struct KeyRange
+        {
+            std::optional<KeyBound> lower;
+            std::optional<KeyBound> upper;
+        };
+
+        const MetaIndex*
+        index_of(const MetaTable& table, const IndexId& index_id)
+        {
+            for (const auto& index : table.indexes)
+                if (index.id == index_id)
+                    return &index;
+
+            return nullptr;
+        }
+
+        bool
+        is_column(const AstNode& node)
+        {
+            return node.type == AstNodeType::IDENTIFIER || node.type == AstNodeType::COLUMN_IDENTIFIER;
+        }
+
+        DataToken
+        value_of(const MetaTable& table, const AstNode& node, const DataRow& row)
+        {
+            if (is_column(node))
+            {
+                const auto& col = std::get<SqlToken>(node.value);
+                const int64_t col_idx = table.get_column_idx(col.value);
+                if (col_idx < 0)
+                    throw std::runtime_error("StdDbInstance::index_scan: column not found");
+
+                return row.tokens[static_cast<size_t>(col_idx)];
+            }
+
+            if (node.type == AstNodeType::LITERAL)
+                return DataToken(std::get<SqlToken>(node.value));
+
+            throw std::runtime_error("StdDbInstance::index_scan: unsupported condition node");
+        }
+
+        bool
+        matches(const MetaTable& table, const BinaryExpr& condition, const DataRow& row)
+        {
+            if (condition.op == AstOperator::AND || condition.op == AstOperator::OR)
+            {
+                if (condition.left->type != AstNodeType::BINARY_EXPR ||
+                    condition.right->type != AstNodeType::BINARY_EXPR)
+                    throw std::runtime_error("StdDbInstance::index_scan: unsupported condition node");
+
+                const auto& left = std::get<BinaryExpr>(condition.left->value);
+                const auto& right = std::get<BinaryExpr>(condition.right->value);
+                if (condition.op == AstOperator::AND)
+                    return matches(table, left, row) && matches(table, right, row);
+                return matches(table, left, row) || matches(table, right, row);
+            }
+
+            const auto left = value_of(table, *condition.left, row);
+            const auto right = value_of(table, *condition.right, row);
+
+            switch (condition.op)
+            {
+            case AstOperator::EQ:
+                return left == right;
+            case AstOperator::NEQ:
+                return left != right;
+            case AstOperator::LT:
+                return left < right;
+            case AstOperator::LTE:
+                return left <= right;
+            case AstOperator::GR:
+                return left > right;
+            case AstOperator::GRE:
+                return left >= right;
+            default:
+                throw std::runtime_error("StdDbInstance::index_scan: unsupported condition op");
+            }
+        }
+
+        // Operator with its sides swapped, so that "5 < id" reads as "id > 5".
+        AstOperator
+        mirrored(AstOperator op)
+        {
+            switch (op)
+            {
+            case AstOperator::LT:
+                return AstOperator::GR;
+            case AstOperator::LTE:
+                return AstOperator::GRE;
+            case AstOperator::GR:
+                return AstOperator::LT;
+            case AstOperator::GRE:
+                return AstOperator::LTE;
+            default:
+                return op;
+            }
+        }
+
+        void
+        tighten_lower(KeyRange& range, KeyBound bound)
+        {
+            if (range.lower)
+            {
+                const int res = compare(bound.key, range.lower->key);
+                if (res < 0 || (res == 0 && range.lower->inclusive <= bound.inclusive))
+                    return;
+            }
+            range.lower = std::move(bound);
+        }
+
+        void
+        tighten_upper(KeyRange& range, KeyBound bound)
+        {
+            if (range.upper)
+            {
+                const int res = compare(bound.key, range.upper->key);
+                if (res > 0 || (res == 0 && range.upper->inclusive <= bound.inclusive))
+                    return;
+            }
+            range.upper = std::move(bound);
+        }
+
+        // Narrows the range by every comparison of the indexed column with a literal that
+        // the condition requires. Anything else leaves the range as it is.
+        void
+        narrow(KeyRange& range, const MetaTable& table, const MetaIndex& index, const BinaryExpr& condition)
+        {
+            if (condition.op == AstOperator::AND)
+            {
+                for (const auto* side : {condition.left.get(), condition.right.get()})
+                    if (side->type == AstNodeType::BINARY_EXPR)
+                        narrow(range, table, index, std::get<BinaryExpr>(side->value));
+                return;
+            }
+
+            const AstNode* column = condition.left.get();
+            const AstNode* literal = condition.right.get();
+            auto op = condition.op;
+            if (!is_column(*column))
+            {
+                std::swap(column, literal);
+                op = mirrored(op);
+            }
+
+            if (!is_column(*column) || literal->type != AstNodeType::LITERAL)
+                return;
+
+            const int64_t col_idx = table.get_column_idx(std::get<SqlToken>(column->value).value);
+            if (col_idx < 0 || table.columns[static_cast<size_t>(col_idx)].id != index.column_id)
+                return;
+
+            DataToken key(std::get<SqlToken>(literal->value));
+            if (key.type == DataType::_NULL)
+                return;
+
+            switch (op)
+            {
+            case AstOperator::EQ:
+                tighten_lower(range, {key, true});
+                tighten_upper(range, {std::move(key), true});
+                break;
+            case AstOperator::GR:
+                tighten_lower(range, {std::move(key), false});
+                break;
+            case AstOperator::GRE:
+                tighten_lower(range, {std::move(key), true});
+                break;
+            case AstOperator::LT:
+                tighten_upper(range, {std::move(key), false});
+                break;
+            case AstOperator::LTE:
+                tighten_upper(range, {std::move(key), true});
+                break;
+            default:
+                break;
+            }
+        }
+
+        // The version was deleted or replaced by a transaction the writer does not see:
+        // one still in progress, or one that committed after the writer's snapshot. A
+        // rolled back deletion clears the deleter, and the writer sees its own.
+        bool
+        is_write_conflict(const RowView& row, const txn::Transaction& txn)
+        {
+            const LSN deleted_by = row.deleted_by();
+            return deleted_by != 0 && !txn.get_snapshot().sees(deleted_by);
+        }
+
+        KeyRange
+        key_range_of(const MetaTable& table, const MetaIndex& index, const BinaryExpr& condition)
+        {
+            KeyRange range;
+            narrow(range, table, index, condition);
+            return range;
+        }
+    } // namespace
 
     StdDbInstance::StdDbInstance(const Config& cfg) : cfg_(cfg)
     {
@@ -33,41 +235,90 @@ namespace storage
         io_manager_ = io_factory.make(cfg);
         wal::WalManagerFactory wal_factory;
         wal_manager_ = wal_factory.make(cfg);
-        buffer_pool_ = std::make_unique<BufferPool>(*io_manager_);
+        buffer_pool_ = std::make_unique<BufferPool>(*io_manager_, cfg_);
+        buffer_pool_->set_wal_barrier(
+            [this](LSN lsn) { wal_manager_->wait_for_durable(lsn); },
+            [this] { return wal_manager_->get_durable_lsn(); }
+        );
         catalog_ = std::make_unique<CatalogCache>(*io_manager_);
         txn_manager_ = std::make_unique<txn::TransactionManager>(*wal_manager_, *buffer_pool_);
         recovery_manager_ =
             std::make_unique<recovery::RecoveryManager>(cfg_, *wal_manager_, *io_manager_);
+        txn_manager_->set_undo(
+            [this](const txn::Transaction& txn, LSN until)
+            {
+                SharedLatch latch(catalog_latch_);
+                return recovery_manager_->rollback(txn.get_id(), txn.get_last_lsn(), *this, until);
+            }
+        );
 
         init();
+
+        page_writer_ = std::make_unique<PageWriter>(*buffer_pool_, *wal_manager_, cfg_);
+        page_writer_->start();
+
+        checkpointer_ = std::make_unique<Checkpointer>(
+            *buffer_pool_, *catalog_, *wal_manager_, *io_manager_, catalog_latch_, cfg_
+        );
+        checkpointer_->start();
     }
 
     void
     StdDbInstance::init()
     {
-        InstanceGuard guard(mtx_);
+        ExclusiveLatch latch(catalog_latch_);
         io_manager_->init();
-        recovery_manager_->recover();
+        const auto changed_tables = recovery_manager_->recover();
         catalog_->hydrate();
         buffer_pool_->initialize();
+
+        for (const auto& table_id : changed_tables)
+            rebuild_indexes(table_id);
     }
 
     StdDbInstance::~StdDbInstance()
     {
-        InstanceGuard guard(mtx_);
-        io_manager_->write_cfg(cfg_);
+        // Both threads are joined first, so that the shutdown checkpoint is the last one.
+        page_writer_->stop();
+        checkpointer_->stop();
+
+        // A shutdown checkpoint writes every frame and leaves nothing to replay. If it fails,
+        // the previous checkpoint stays in effect and the next attach recovers from it; the
+        // destructor must not throw, as the registry may run it on any thread.
+        try
+        {
+            checkpointer_->checkpoint();
+        }
+        catch (const std::exception& e)
+        {
+            misc::Logger::error(
+                std::string("StdDbInstance::~StdDbInstance: shutdown checkpoint failed: ") + e.what()
+            );
+        }
+    }
+
+    std::shared_mutex&
+    StdDbInstance::table_latch(const TableId& table_id)
+    {
+        std::lock_guard guard(table_latches_mtx_);
+        auto& latch = table_latches_[table_id];
+        if (!latch)
+            latch = std::make_unique<std::shared_mutex>();
+        return *latch;
     }
 
     DataTable
     StdDbInstance::seq_scan(const std::string& table_name, const std::string& schema_name)
     {
-        InstanceGuard guard(mtx_);
-        const auto* ms = catalog_->get_schema(schema_name);
-        const auto* mt = catalog_->get_table(table_name, ms->id);
-
         DataTable dt;
-        dt.output_schema = convert(*mt);
-        dt.rows.reserve(mt->total_rows);
+        {
+            SharedLatch latch(catalog_latch_);
+            const auto* ms = catalog_->get_schema(schema_name);
+            const auto* mt = catalog_->get_table(table_name, ms->id);
+
+            dt.output_schema = convert(*mt);
+            dt.rows.reserve(mt->total_rows);
+        }
 
         auto cursor = seq_scan_begin(table_name, schema_name);
         DataRow row;
@@ -80,79 +331,112 @@ namespace storage
     ScanCursor
     StdDbInstance::seq_scan_begin(const std::string& table_name, const std::string& schema_name)
     {
-        InstanceGuard guard(mtx_);
+        return seq_scan_begin(table_name, schema_name, txn_manager_->snapshot());
+    }
+
+    ScanCursor
+    StdDbInstance::seq_scan_begin(
+        const std::string& table_name, const std::string& schema_name, const txn::Transaction& txn
+    )
+    {
+        return seq_scan_begin(table_name, schema_name, txn.get_snapshot());
+    }
+
+    ScanCursor
+    StdDbInstance::seq_scan_begin(
+        const std::string& table_name, const std::string& schema_name, Snapshot snapshot
+    )
+    {
+        SharedLatch latch(catalog_latch_);
         const auto* ms = catalog_->get_schema(schema_name);
         const auto* mt = catalog_->get_table(table_name, ms->id);
-        const auto pages = buffer_pool_->get_table_data(mt->id);
 
         ScanCursor cursor{};
-        cursor.page = DataPageId::null();
+        cursor.page = buffer_pool_->head_dp(mt->id);
         cursor.slot = 0;
         cursor.chunk_size = 0;
         cursor.initialized = true;
+        cursor.snapshot = std::move(snapshot);
 
-        if (pages.empty())
-            return cursor;
+        if (cursor.page == DataPageId::null())
+            cursor.page = find_head(mt->id);
 
+        return cursor;
+    }
+
+    DataPageId
+    StdDbInstance::find_head(const TableId& table_id)
+    {
+        const auto page_ids = buffer_pool_->table_pages(table_id);
+        if (page_ids.empty())
+            return DataPageId::null();
+
+        // One page pinned at a time, so that the walk fits through any pool.
         std::unordered_set<DataPageId> referenced_pages;
-        referenced_pages.reserve(pages.size());
+        referenced_pages.reserve(page_ids.size());
+        std::vector<DataPageId> present;
+        present.reserve(page_ids.size());
 
-        for (const auto* page : pages)
+        for (const auto& page_id : page_ids)
         {
+            auto page = buffer_pool_->get_dp(page_id);
             if (!page)
                 continue;
 
+            // A writer may be chaining a new page after this one.
+            SharedLatch page_latch(page.latch());
             if (page->next != DataPageId::null())
                 referenced_pages.insert(page->next);
+            present.push_back(page_id);
         }
 
-        for (const auto* page : pages)
+        for (const auto& page_id : present)
         {
-            if (!page)
-                continue;
-
-            if (!referenced_pages.contains(page->id))
+            if (!referenced_pages.contains(page_id))
             {
-                cursor.page = page->id;
-                return cursor;
+                buffer_pool_->set_head_dp(table_id, page_id);
+                return page_id;
             }
         }
 
-        for (const auto* page : pages)
-        {
-            if (!page)
-                continue;
-
-            cursor.page = page->id;
-            return cursor;
-        }
-
-        return cursor;
+        return present.empty() ? DataPageId::null() : present.front();
     }
 
     bool
     StdDbInstance::seq_scan_next(ScanCursor& cursor, DataRow& out)
     {
-        InstanceGuard guard(mtx_);
+        return seq_scan_next(cursor, out, {});
+    }
+
+    bool
+    StdDbInstance::seq_scan_next(ScanCursor& cursor, DataRow& out, const RowFilter& filter)
+    {
+        // Only the page being read is latched, against a writer changing it meanwhile.
+        // Versions written after the cursor's snapshot are passed over.
         if (!cursor.initialized)
             return false;
 
         while (cursor.page != DataPageId::null())
         {
-            auto* page = buffer_pool_->get_dp(cursor.page);
+            auto page = buffer_pool_->get_dp(cursor.page);
             if (!page)
             {
                 cursor.page = DataPageId::null();
                 return false;
             }
 
-            while (cursor.slot < static_cast<int>(page->rows.size()))
+            SharedLatch latch(page.latch());
+
+            while (cursor.slot < static_cast<int>(page->slot_count))
             {
-                const auto& row = page->rows[static_cast<size_t>(cursor.slot++)];
-                if (has_flag(row.flags, DataRowFlags::OBSOLETE))
+                const auto row = page->row(static_cast<size_t>(cursor.slot++));
+                if (!cursor.snapshot.is_visible(row))
                     continue;
 
-                out = row;
+                if (filter && !filter(row))
+                    continue;
+
+                row.to_row(out);
                 return true;
             }
 
@@ -171,166 +455,175 @@ namespace storage
         const BinaryExpr& condition
     )
     {
-        InstanceGuard guard(mtx_);
+        return index_scan(table_name, schema_name, index_id, condition, txn_manager_->snapshot());
+    }
+
+    DataTable
+    StdDbInstance::index_scan(
+        const std::string& table_name,
+        const std::string& schema_name,
+        const IndexId& index_id,
+        const BinaryExpr& condition,
+        const txn::Transaction& txn
+    )
+    {
+        return index_scan(table_name, schema_name, index_id, condition, txn.get_snapshot());
+    }
+
+    DataTable
+    StdDbInstance::index_scan(
+        const std::string& table_name,
+        const std::string& schema_name,
+        const IndexId& index_id,
+        const BinaryExpr& condition,
+        const Snapshot& snapshot
+    )
+    {
+        SharedLatch latch(catalog_latch_);
         const auto* ms = catalog_->get_schema(schema_name);
         const auto* mt = catalog_->get_table(table_name, ms->id);
 
-        const MetaIndex* meta_index = nullptr;
-        for (const auto& index : mt->indexes)
-        {
-            if (index.id == index_id)
-            {
-                meta_index = &index;
-                break;
-            }
-        }
-
+        const MetaIndex* meta_index = index_of(*mt, index_id);
         if (!meta_index)
             throw std::runtime_error("StdDbInstance::index_scan: index is not part of table");
 
         DataTable dt;
         dt.output_schema = convert(*mt);
 
-        auto value_of_node = [&](const AstNode& node, const DataRow& row) -> DataToken
-        {
-            if (node.type == AstNodeType::IDENTIFIER)
-            {
-                const auto& col = std::get<SqlToken>(node.value);
-                const int64_t col_idx = mt->get_column_idx(col.value);
-                if (col_idx < 0)
-                    throw std::runtime_error("StdDbInstance::index_scan: column not found");
-
-                return row.tokens[static_cast<size_t>(col_idx)];
-            }
-
-            if (node.type == AstNodeType::LITERAL)
-                return DataToken(std::get<SqlToken>(node.value));
-
-            throw std::runtime_error("StdDbInstance::index_scan: unsupported condition node");
-        };
-
-        auto matches_condition = [&](const DataRow& row) -> bool
-        {
-            const auto left = value_of_node(*condition.left, row);
-            const auto right = value_of_node(*condition.right, row);
-
-            switch (condition.op)
-            {
-            case AstOperator::EQ:
-                return left == right;
-            case AstOperator::NEQ:
-                return left != right;
-            case AstOperator::LT:
-                return left < right;
-            case AstOperator::LTE:
-                return left <= right;
-            case AstOperator::GR:
-                return left > right;
-            case AstOperator::GRE:
-                return left >= right;
-            default:
-                throw std::runtime_error("StdDbInstance::index_scan: unsupported condition op");
-            }
-        };
-
+        // Every version ever indexed keeps its entry, so the snapshot picks among them.
         auto append_row_by_ptr = [&](const RowPtr& row_ptr)
         {
-            const auto* page = buffer_pool_->get_dp(row_ptr.first);
+            const auto page = buffer_pool_->get_dp(row_ptr.first);
             if (!page)
                 return;
 
-            for (const auto& row : page->rows)
-            {
-                if (row.id != row_ptr.second)
-                    continue;
-
-                if (has_flag(row.flags, DataRowFlags::OBSOLETE))
-                    return;
-
-                if (matches_condition(row))
-                    dt.rows.push_back(row);
-
+            SharedLatch page_latch(page.latch());
+            const auto slot = page->find(row_ptr.second);
+            if (!slot)
                 return;
-            }
-        };
 
-        auto is_eq_for_indexed_column = [&](const AstNode* id_node, const AstNode* lit_node) -> bool
-        {
-            if (id_node->type != AstNodeType::COLUMN_IDENTIFIER ||
-                lit_node->type != AstNodeType::LITERAL)
-                return false;
-
-            const auto& column_token = std::get<SqlToken>(id_node->value);
-            const int64_t col_idx = mt->get_column_idx(column_token.value);
-            if (col_idx < 0)
-                return false;
+            const auto view = page->row(*slot);
+            if (!snapshot.is_visible(view))
+                return;
 
-            return mt->columns[static_cast<size_t>(col_idx)].id == meta_index->column_id;
+            auto row = view.to_row();
+            if (matches(*mt, condition, row))
+                dt.rows.push_back(std::move(row));
         };
 
-        BPIndexPager pager(*buffer_pool_, mt->id, index_id);
-        IndexBPlusTree tree(pager);
-
-        if (condition.op == AstOperator::EQ)
+        // Only entries inside the condition's key range are visited; the condition is
+        // still checked on every row, for parts of it the range cannot express. Rows are
+        // read once the entries are collected: writers latch data pages before index
+        // pages, so a reader must not wait for one while holding the other.
+        std::vector<RowPtr> row_ptrs;
         {
-            if (is_eq_for_indexed_column(condition.left.get(), condition.right.get()))
-            {
-                const auto key = DataToken(std::get<SqlToken>(condition.right->value));
-                auto row_ptr = tree.find(key);
-                if (row_ptr.has_value())
-                    append_row_by_ptr(row_ptr.value());
-                return dt;
-            }
+            BPIndexPager pager(*buffer_pool_, mt->id, index_id);
+            IndexBPlusTree tree(pager);
 
-            if (is_eq_for_indexed_column(condition.right.get(), condition.left.get()))
-            {
-                const auto key = DataToken(std::get<SqlToken>(condition.left->value));
-                auto row_ptr = tree.find(key);
-                if (row_ptr.has_value())
-                    append_row_by_ptr(row_ptr.value());
-                return dt;
-            }
+            const auto range = key_range_of(*mt, *meta_index, condition);
+            auto it = tree.range(range.lower, range.upper);
+
+            RowPtr row_ptr;
+            while (it.next(row_ptr))
+                row_ptrs.push_back(row_ptr);
         }
 
-        auto* page = pager.get_page(pager.root_page_id());
-        if (!page)
-            return dt;
+        for (const auto& row_ptr : row_ptrs)
+            append_row_by_ptr(row_ptr);
 
-        while (!page->is_leaf)
-        {
-            const auto& internal = std::get<InternalIndexNode>(page->data);
-            if (internal.children.empty())
-                return dt;
+        return dt;
+    }
 
-            page = pager.get_page(internal.children.front());
-            if (!page)
-                throw std::runtime_error("StdDbInstance::index_scan: broken index tree");
-        }
+    uint64_t
+    StdDbInstance::index_range_count(
+        const std::string& table_name,
+        const std::string& schema_name,
+        const IndexId& index_id,
+        const BinaryExpr& condition,
+        uint64_t limit
+    )
+    {
+        SharedLatch latch(catalog_latch_);
+        const auto* ms = catalog_->get_schema(schema_name);
+        const auto* mt = catalog_->get_table(table_name, ms->id);
 
-        while (page)
-        {
-            const auto& leaf = std::get<LeafIndexNode>(page->data);
-            for (const auto& row_ptr : leaf.rows)
-                append_row_by_ptr(row_ptr);
+        const MetaIndex* meta_index = index_of(*mt, index_id);
+        if (!meta_index)
+            throw std::runtime_error("StdDbInstance::index_range_count: index is not part of table");
 
-            if (leaf.next_leaf == 0)
-                break;
+        BPIndexPager pager(*buffer_pool_, mt->id, index_id);
+        IndexBPlusTree tree(pager);
 
-            page = pager.get_page(leaf.next_leaf);
-            if (!page)
-                throw std::runtime_error("StdDbInstance::index_scan: broken leaf chain");
-        }
+        const auto range = key_range_of(*mt, *meta_index, condition);
+        auto it = tree.range(range.lower, range.upper);
 
-        return dt;
+        uint64_t count = 0;
+        RowPtr row_ptr;
+        while (count < limit && it.next(row_ptr))
+            ++count;
+
+        return count;
     }
 
     txn::Transaction
     StdDbInstance::make_txn()
     {
-        InstanceGuard guard(mtx_);
         return txn_manager_->make_transaction();
     }
 
+    bool
+    StdDbInstance::change_page(
+        const TableId& table_id, const DataPageId& page_id, const std::function<void(DataPage&)>& change
+    )
+    {
+        // Latched as a writer of the table latches it, one undone record at a time. The
+        // WAL barrier keeps the page from being written before the CLR is durable.
+        ExclusiveLatch table(table_latch(table_id));
+        auto page = buffer_pool_->get_dp(page_id);
+        if (!page)
+            return false;
+
+        ExclusiveLatch page_latch(page.latch());
+        change(*page);
+        buffer_pool_->dirty_dp(page_id);
+        return true;
+    }
+
+    void
+    StdDbInstance::change_table(const TableId& table_id, const std::function<void(MetaTable&)>& change)
+    {
+        ExclusiveLatch table(table_latch(table_id));
+        if (auto* mt = catalog_->get_table(table_id))
+            change(*mt);
+    }
+
+    void
+    StdDbInstance::unindex(
+        const TableId& table_id, const DataPageId& page_id, std::span<const DataRow> rows, LSN lsn
+    )
+    {
+        ExclusiveLatch table(table_latch(table_id));
+        const auto* mt = catalog_->get_table(table_id);
+        if (!mt)
+            return;
+
+        for (const auto& mi : mt->indexes)
+        {
+            const auto col_idx = mt->get_column_idx(mi.column_id);
+            if (col_idx < 0)
+                throw std::runtime_error("Index column not found in table schema");
+
+            BPIndexPager pager(*buffer_pool_, mt->id, mi.id, lsn);
+            IndexBPlusTree tree(pager);
+            for (const auto& row : rows)
+            {
+                const auto& key = row.tokens[static_cast<size_t>(col_idx)];
+                if (key.type != DataType::_NULL)
+                    tree.erase(key, RowPtr{page_id, row.id});
+            }
+        }
+    }
+
     ssize_t
     StdDbInstance::has_available_page(const std::vector<const DataPage*>& vec, size_t size) const
     {
@@ -344,21 +637,69 @@ namespace storage
         return -1;
     }
 
+    Snapshot
+    StdDbInstance::latest_snapshot(const txn::Transaction& txn) const
+    {
+        auto snapshot = txn_manager_->snapshot();
+        snapshot.own = txn.get_begin_lsn();
+        return snapshot;
+    }
+
     bool
-    StdDbInstance::is_row_obsolete(const RowPtr& row_ptr) const
+    StdDbInstance::is_row_obsolete(const RowPtr& row_ptr, const Snapshot& latest) const
     {
-        InstanceGuard guard(mtx_);
-        const auto* page = buffer_pool_->get_dp(row_ptr.first);
+        const auto page = buffer_pool_->get_dp(row_ptr.first);
         if (!page)
             return false;
 
-        for (const auto& row : page->rows)
+        const auto slot = page->find(row_ptr.second);
+        if (!slot)
+            return false;
+
+        const auto view = page->row(*slot);
+        if (!has_flag(view.flags(), DataRowFlags::OBSOLETE))
+            return false;
+
+        // A rolled back version has no deleter.
+        const LSN deleted_by = view.deleted_by();
+        return deleted_by == 0 || latest.sees(deleted_by);
+    }
+
+    bool
+    StdDbInstance::has_live_entry(
+        IndexBPlusTree& tree, const DataToken& key, const Snapshot& latest
+    ) const
+    {
+        // Updated rows leave their old entries behind, so every entry with the key counts.
+        auto it = tree.equal_range(key);
+        RowPtr row_ptr;
+        while (it.next(row_ptr))
+            if (!is_row_obsolete(row_ptr, latest))
+                return true;
+
+        return false;
+    }
+
+    PageGuard
+    StdDbInstance::prepare_page(const MetaTable& mt, size_t size, PageLatches& latches)
+    {
+        const auto tail_id = buffer_pool_->tail_dp(mt.id);
+        auto page = buffer_pool_->prepare_dp(size, mt);
+        latches.lock(page);
+
+        // A page prepare_dp had to create is the new tail. The link is logged on its
+        // own, outside of the transaction: it must survive even if the rows that needed
+        // the page are rolled back.
+        if (tail_id != DataPageId::null() && buffer_pool_->tail_dp(mt.id) != tail_id)
         {
-            if (row.id == row_ptr.second)
-                return has_flag(row.flags, DataRowFlags::OBSOLETE);
+            auto tail_page = buffer_pool_->get_dp(tail_id);
+            latches.lock(tail_page);
+            tail_page->next = page->id;
+            tail_page->last_lsn = wal_manager_->append_log(LinkPageRecord(mt.id, tail_id, page->id));
+            buffer_pool_->dirty_dp(tail_id);
         }
 
-        return false;
+        return page;
     }
 
     void
@@ -370,81 +711,190 @@ namespace storage
         txn::Transaction& txn
     )
     {
-        InstanceGuard guard(mtx_);
+        std::vector<std::vector<DataToken>> rows;
+        rows.push_back(std::move(row));
+        insert_rows(table_name, schema_name, cols, std::move(rows), txn);
+    }
+
+    void
+    StdDbInstance::insert_rows(
+        const std::string& table_name,
+        const std::string& schema_name,
+        const std::optional<std::vector<std::string>>& cols,
+        std::vector<std::vector<DataToken>> rows,
+        txn::Transaction& txn
+    )
+    {
+        if (rows.empty())
+            return;
+
+        SharedLatch latch(catalog_latch_);
         const auto* ms = catalog_->get_schema(schema_name);
         auto* mt = catalog_->get_table(table_name, ms->id);
-        const auto mt_unchanged = *mt;
+        ExclusiveLatch table(table_latch(mt->id));
 
-        auto new_row = mt->make_row(cols, row);
-        size_t row_size = io_manager_->estimate_size(new_row);
+        const RowId last_rid = mt->last_rid;
+        const uint64_t total_rows = mt->total_rows;
+        const uint64_t live_rows = mt->live_rows;
 
-        const auto pages_before = buffer_pool_->get_table_data(mt->id);
+        std::vector<DataRow> new_rows;
+        new_rows.reserve(rows.size());
+        try
+        {
+            for (const auto& row : rows)
+            {
+                new_rows.push_back(mt->make_row(cols, row));
+                new_rows.back().created_by = txn.get_begin_lsn();
+            }
 
-        auto* page = buffer_pool_->prepare_dp(row_size, *mt);
+            // Checked before anything is written, so a violation leaves neither rows
+            // nor index entries behind.
+            check_unique_keys(*mt, new_rows, txn);
+        }
+        catch (...)
+        {
+            mt->last_rid = last_rid;
+            mt->total_rows = total_rows;
+            mt->live_rows = live_rows;
+            throw;
+        }
 
-        bool is_new_page = true;
-        for (const auto* existing_page : pages_before)
+        // Rows are appended to the current page until it is full, and every page gets
+        // one InsertRowsRecord for the rows it received. A page stays latched until its
+        // record is written.
+        PageLatches latches;
+        PageGuard page;
+        std::vector<DataRow> page_rows;
+        std::vector<DataPageId> row_pages;
+        row_pages.reserve(new_rows.size());
+        LSN last_lsn = 0;
+
+        auto log_page_rows = [&]
         {
-            if (!existing_page)
-                continue;
+            if (page_rows.empty())
+                return;
+
+            page->max_rid = std::max(page->max_rid, page_rows.back().id);
+            txn.append_log(InsertRowsRecord(mt->id, page->id, std::move(page_rows)));
+            page_rows.clear();
+
+            last_lsn = txn.get_last_lsn();
+            page->last_lsn = last_lsn;
+            buffer_pool_->dirty_dp(page->id);
+        };
 
-            if (existing_page->id == page->id)
+        for (const auto& row : new_rows)
+        {
+            const size_t row_size = DataPage::row_size(row);
+            if (!page || page->size + row_size > DataPage::MAX_SIZE)
             {
-                is_new_page = false;
-                break;
+                log_page_rows();
+                latches.unlock_all();
+                page = prepare_page(*mt, row_size, latches);
             }
+
+            page->append(row);
+            page_rows.push_back(row);
+            row_pages.push_back(page->id);
         }
+        log_page_rows();
+        latches.unlock_all();
+
+        const int64_t inserted = static_cast<int64_t>(new_rows.size());
+        txn.append_log(TableCountersRecord(*mt, inserted, inserted));
 
-        if (is_new_page)
+        for (const auto& mi : mt->indexes)
         {
-            DataPage* tail_page = nullptr;
+            const auto col_idx = mt->get_column_idx(mi.column_id);
+            if (col_idx < 0)
+                throw std::runtime_error("Index column not found in table schema");
 
-            for (auto* existing_page : pages_before)
+            std::vector<std::pair<const DataToken*, RowPtr>> entries;
+            entries.reserve(new_rows.size());
+            for (size_t i = 0; i < new_rows.size(); ++i)
             {
-                if (!existing_page)
-                    continue;
+                const auto& key = new_rows[i].tokens[static_cast<size_t>(col_idx)];
 
-                if (existing_page->next != DataPageId::null())
+                // NULL values are not indexed
+                if (key.type == DataType::_NULL)
                     continue;
 
-                if (!tail_page || existing_page->max_rid > tail_page->max_rid)
-                    tail_page = existing_page;
+                entries.emplace_back(&key, RowPtr{row_pages[i], new_rows[i].id});
             }
 
-            if (tail_page)
-            {
-                tail_page->next = page->id;
-                buffer_pool_->dirty_dp(tail_page->id);
-            }
+            if (entries.empty())
+                continue;
+
+            // Sorted keys descend into neighbouring leaves one after another.
+            std::stable_sort(
+                entries.begin(),
+                entries.end(),
+                [](const auto& lhs, const auto& rhs) { return *lhs.first < *rhs.first; }
+            );
+
+            BPIndexPager pager(*buffer_pool_, mt->id, mi.id, last_lsn);
+            IndexBPlusTree tree(pager);
+            for (const auto& [key, row_ptr] : entries)
+                tree.insert(*key, row_ptr);
         }
+    }
 
-        std::vector<IndexId> touched_indexes;
-        if (mt->indexes.size() > 0)
-            touched_indexes = insert_row_into_indexes(*mt, new_row, page->id);
+    void
+    StdDbInstance::check_unique_keys(
+        const MetaTable& mt, const std::vector<DataRow>& rows, const txn::Transaction& txn
+    ) const
+    {
+        std::optional<Snapshot> latest;
+        for (const auto& mi : mt.indexes)
+        {
+            if (!mi.is_unique)
+                continue;
 
-        page->rows.push_back(new_row);
+            const auto col_idx = mt.get_column_idx(mi.column_id);
+            if (col_idx < 0)
+                throw std::runtime_error("Index column not found in table schema");
 
-        InsertRecord insert_record(mt->id, page->id, new_row);
-        UpdateTableRecord update_table_record(mt_unchanged, *mt);
-        txn.append_log(insert_record);
-        txn.append_log(update_table_record);
-        const LSN page_lsn = txn.get_last_lsn();
+            std::vector<const DataToken*> keys;
+            keys.reserve(rows.size());
+            for (const auto& row : rows)
+            {
+                const auto& key = row.tokens[static_cast<size_t>(col_idx)];
+                if (key.type != DataType::_NULL)
+                    keys.push_back(&key);
+            }
+
+            std::sort(
+                keys.begin(),
+                keys.end(),
+                [](const DataToken* lhs, const DataToken* rhs) { return *lhs < *rhs; }
+            );
+            for (size_t i = 1; i < keys.size(); ++i)
+            {
+                if (*keys[i - 1] == *keys[i])
+                    throw UniqueConstraintViolation(mi.name);
+            }
 
-        page->last_lsn = page_lsn;
-        for (const auto& index_id : touched_indexes)
-            buffer_pool_->set_if_lsn(index_id, page_lsn);
+            if (!latest)
+                latest = latest_snapshot(txn);
 
-        buffer_pool_->dirty_dp(page->id);
+            BPIndexPager pager(*buffer_pool_, mt.id, mi.id);
+            IndexBPlusTree tree(pager);
+            for (const auto* key : keys)
+            {
+                if (has_live_entry(tree, *key, *latest))
+                    throw UniqueConstraintViolation(mi.name);
+            }
+        }
     }
 
     std::vector<IndexId>
     StdDbInstance::insert_row_into_indexes(
-        const MetaTable& mt, const DataRow& row, const DataPageId& page_id
+        const MetaTable& mt, const DataRow& row, const DataPageId& page_id, const txn::Transaction& txn
     )
     {
-        InstanceGuard guard(mtx_);
         std::vector<IndexId> touched_indexes;
         touched_indexes.reserve(mt.indexes.size());
+        std::optional<Snapshot> latest;
 
         for (auto& mi : mt.indexes)
         {
@@ -460,13 +910,14 @@ namespace storage
             
             const RowPtr row_ptr{page_id, row.id};
 
-            BPIndexPager pager(*buffer_pool_, mt.id, mi.id);
+            BPIndexPager pager(*buffer_pool_, mt.id, mi.id, txn.get_last_lsn());
             IndexBPlusTree tree(pager);
 
             if (mi.is_unique)
             {
-                auto existing = tree.find(key);
-                if (existing.has_value() && !is_row_obsolete(existing.value()))
+                if (!latest)
+                    latest = latest_snapshot(txn);
+                if (has_live_entry(tree, key, *latest))
                     throw UniqueConstraintViolation(mi.name);
             }
 
@@ -486,72 +937,122 @@ namespace storage
         txn::Transaction& txn
     )
     {
-        InstanceGuard guard(mtx_);
+        SharedLatch latch(catalog_latch_);
         auto* ms = catalog_->get_schema(schema_name);
         auto* mt = catalog_->get_table(table_name, ms->id);
-        const auto unchanged_mt = *mt;
-        auto pages = buffer_pool_->get_table_data(mt->id);
+        ExclusiveLatch table(table_latch(mt->id));
 
         std::unordered_set<RowId> ids;
         for (const auto& row : rows)
             ids.insert(row.id);
 
-        for (DataPage* page : pages)
+        int64_t updated_rows = 0;
+        PageLatches latches;
+        // Pages the statement creates for new versions are not in the list, so they are
+        // not visited.
+        for (const auto& page_id : buffer_pool_->table_pages(mt->id))
         {
+            auto page = buffer_pool_->get_dp(page_id);
+            if (!page)
+                continue;
+
+            latches.lock(page);
             bool updated = false;
             LSN page_lsn = page->last_lsn;
 
-            for (auto& row : page->rows)
+            // New versions appended to this page are not visited again.
+            const size_t slot_count = page->slot_count;
+            try
             {
-                if (!ids.contains(row.id))
-                    continue;
+                for (size_t slot = 0; slot < slot_count; ++slot)
+                {
+                    const auto view = page->row(slot);
+                    if (!ids.contains(view.id()))
+                        continue;
 
-                if (has_flag(row.flags, DataRowFlags::OBSOLETE))
-                    continue;
+                    if (has_flag(view.flags(), DataRowFlags::OBSOLETE))
+                    {
+                        if (is_write_conflict(view, txn))
+                            throw SerializationFailure(table_name);
+                        continue;
+                    }
 
-                DataRow new_row = row;
-                new_row.id = ++mt->last_rid;
+                    DataRow row = view.to_row();
+                    DataRow new_row = row;
+                    new_row.id = mt->last_rid++;
+                    new_row.created_by = txn.get_begin_lsn();
 
-                row.flags |= DataRowFlags::OBSOLETE;
+                    // The old version stays for the snapshots that still see it.
+                    row.flags |= DataRowFlags::OBSOLETE;
+                    row.deleted_by = txn.get_begin_lsn();
+                    page->set_flags(slot, row.flags);
+                    page->set_deleted_by(slot, row.deleted_by);
 
-                for (const auto& assignment : update)
-                {
-                    ColumnId col_id = std::visit([](auto& a) { return a.first; }, assignment);
-                    int64_t col_idx = mt->get_column_idx(col_id);
-                    MetaColumn cola = mt->get_column(col_idx);
+                    for (const auto& assignment : update)
+                    {
+                        ColumnId col_id = std::visit([](auto& a) { return a.first; }, assignment);
+                        int64_t col_idx = mt->get_column_idx(col_id);
+                        MetaColumn cola = mt->get_column(col_idx);
+
+                        if (auto* lit = std::get_if<AssignLiteral>(&assignment))
+                        {
+                            new_row.tokens[col_idx] = lit->second;
+                        }
+                        else
+                        {
+                            auto* col = std::get_if<AssignColumn>(&assignment);
+                            int src_idx = mt->get_column_idx(col->second);
+                            new_row.tokens[col_idx] = row.tokens[src_idx];
+                        }
+                    }
 
-                    if (auto* lit = std::get_if<AssignLiteral>(&assignment))
+                    mt->total_rows++;
+                    updated_rows++;
+
+                    const size_t new_row_size = DataPage::row_size(new_row);
+                    DataPageId new_row_page = page->id;
+                    if (page->size + new_row_size <= DataPage::MAX_SIZE)
                     {
-                        new_row.tokens[col_idx] = lit->second;
+                        UpdateRecord update_record(mt->id, page->id, row, new_row);
+                        txn.append_log(update_record);
+                        page_lsn = std::max(page_lsn, txn.get_last_lsn());
+
+                        page->append(new_row);
+                        page->max_rid = std::max(page->max_rid, new_row.id);
                     }
                     else
                     {
-                        auto* col = std::get_if<AssignColumn>(&assignment);
-                        int src_idx = mt->get_column_idx(col->second);
-                        new_row.tokens[col_idx] = row.tokens[src_idx];
+                        // No room left here: the new version goes to another page, which is
+                        // logged as a delete plus an insert.
+                        txn.append_log(DeleteRecord(mt->id, page->id, row));
+                        page_lsn = std::max(page_lsn, txn.get_last_lsn());
+
+                        auto target = prepare_page(*mt, new_row_size, latches);
+                        txn.append_log(InsertRecord(mt->id, target->id, new_row));
+                        target->append(new_row);
+                        target->max_rid = std::max(target->max_rid, new_row.id);
+                        target->last_lsn = txn.get_last_lsn();
+                        buffer_pool_->dirty_dp(target->id);
+                        new_row_page = target->id;
                     }
-                }
-
-                mt->total_rows++;
-
-                UpdateRecord update_record(mt->id, page->id, row, new_row);
-                txn.append_log(update_record);
-                page_lsn = std::max(page_lsn, txn.get_last_lsn());
+                    updated = true;
 
-                UpdateTableRecord update_table_record(unchanged_mt, *mt);
-                txn.append_log(update_table_record);
-
-                page->rows.push_back(new_row);
-                page->max_rid = std::max(page->max_rid, new_row.id);
-
-                if (mt->indexes.size() > 0)
+                    if (mt->indexes.size() > 0)
+                        insert_row_into_indexes(*mt, new_row, new_row_page, txn);
+                }
+            }
+            catch (...)
+            {
+                // What the statement changed so far is logged, its count included, for
+                // the rollback that follows to take back.
+                if (updated)
                 {
-                    auto touched_indexes = insert_row_into_indexes(*mt, new_row, page->id);
-                    for (const auto& index_id : touched_indexes)
-                        buffer_pool_->set_if_lsn(index_id, page_lsn);
+                    page->last_lsn = page_lsn;
+                    buffer_pool_->dirty_dp(page->id);
                 }
-
-                updated = true;
+                if (updated_rows > 0)
+                    txn.append_log(TableCountersRecord(*mt, updated_rows, 0));
+                throw;
             }
 
             if (updated)
@@ -559,7 +1060,12 @@ namespace storage
                 page->last_lsn = page_lsn;
                 buffer_pool_->dirty_dp(page->id);
             }
+            latches.unlock_all();
         }
+
+        // One counters record for the whole statement rather than one per row.
+        if (updated_rows > 0)
+            txn.append_log(TableCountersRecord(*mt, updated_rows, 0));
     }
 
     void
@@ -570,40 +1076,70 @@ namespace storage
         txn::Transaction& txn
     )
     {
-        InstanceGuard guard(mtx_);
+        SharedLatch latch(catalog_latch_);
         auto* ms = catalog_->get_schema(schema_name);
         auto* mt = catalog_->get_table(table_name, ms->id);
-        const auto unchanged_mt = *mt;
-        auto pages = buffer_pool_->get_table_data(mt->id);
+        ExclusiveLatch table(table_latch(mt->id));
 
         std::unordered_set<RowId> ids;
         for (const auto& row : rows)
             ids.insert(row.id);
 
-        for (auto& page : pages)
+        int64_t deleted_rows = 0;
+        for (const auto& page_id : buffer_pool_->table_pages(mt->id))
         {
+            auto page = buffer_pool_->get_dp(page_id);
+            if (!page)
+                continue;
+
+            ExclusiveLatch page_latch(page.latch());
             bool deleted = false;
             LSN page_lsn = page->last_lsn;
 
-            for (auto& row : page->rows)
+            try
             {
-                if (!ids.contains(row.id))
-                    continue;
+                for (size_t slot = 0; slot < page->slot_count; ++slot)
+                {
+                    const auto view = page->row(slot);
+                    if (!ids.contains(view.id()))
+                        continue;
 
-                if (has_flag(row.flags, DataRowFlags::OBSOLETE))
-                    continue;
+                    if (has_flag(view.flags(), DataRowFlags::OBSOLETE))
+                    {
+                        if (is_write_conflict(view, txn))
+                            throw SerializationFailure(table_name);
+                        continue;
+                    }
 
-                deleted = true;
+                    deleted = true;
 
-                row.flags |= DataRowFlags::OBSOLETE;
+                    // The version is only marked: snapshots that still see it keep reading it.
+                    DataRow row = view.to_row();
+                    row.flags |= DataRowFlags::OBSOLETE;
+                    row.deleted_by = txn.get_begin_lsn();
+                    page->set_flags(slot, row.flags);
+                    page->set_deleted_by(slot, row.deleted_by);
 
-                mt->live_rows--;
+                    DeleteRecord record(mt->id, page->id, std::move(row));
 
-                DeleteRecord record(mt->id, page->id, row);
-                txn.append_log(record);
-                page_lsn = std::max(page_lsn, txn.get_last_lsn());
-                UpdateTableRecord update_table_record(unchanged_mt, *mt);
-                txn.append_log(update_table_record);
+                    mt->live_rows--;
+                    deleted_rows++;
+
+                    txn.append_log(record);
+                    page_lsn = std::max(page_lsn, txn.get_last_lsn());
+                }
+            }
+            catch (...)
+            {
+                // As in update_row: what was deleted so far is logged for the rollback.
+                if (deleted)
+                {
+                    page->last_lsn = page_lsn;
+                    buffer_pool_->dirty_dp(page->id);
+                }
+                if (deleted_rows > 0)
+                    txn.append_log(TableCountersRecord(*mt, 0, -deleted_rows));
+                throw;
             }
 
             if (deleted)
@@ -612,13 +1148,16 @@ namespace storage
                 buffer_pool_->dirty_dp(page->id);
             }
         }
+
+        if (deleted_rows > 0)
+            txn.append_log(TableCountersRecord(*mt, 0, -deleted_rows));
     }
 
     MetaTable*
     StdDbInstance::get_table(const std::string& table_name, const std::string& schema_name)
     {
-        InstanceGuard guard(mtx_);
-        auto* ms = get_schema(schema_name);
+        SharedLatch latch(catalog_latch_);
+        auto* ms = catalog_->get_schema(schema_name);
         if (!ms) return nullptr;
         return catalog_->get_table(table_name, ms->id);
     }
@@ -626,7 +1165,6 @@ namespace storage
     MetaTable*
     StdDbInstance::get_table(const TableIdentifier& identifier)
     {
-        InstanceGuard guard(mtx_);
         return get_table(
             identifier.table_name.value,
             identifier.schema_name.has_value() ? identifier.schema_name.value().value
@@ -637,28 +1175,31 @@ namespace storage
     const Config&
     StdDbInstance::get_config() const
     {
-        InstanceGuard guard(mtx_);
         return cfg_;
     }
 
+    const BufferPool&
+    StdDbInstance::get_buffer_pool() const
+    {
+        return *buffer_pool_;
+    }
+
     MetaSchema*
     StdDbInstance::get_schema(const std::string& name)
     {
-        InstanceGuard guard(mtx_);
+        SharedLatch latch(catalog_latch_);
         return catalog_->get_schema(name);
     }
 
     bool
     StdDbInstance::exists_table(const std::string& table_name, const std::string& schema_name)
     {
-        InstanceGuard guard(mtx_);
         return get_table(table_name, schema_name) != nullptr;
     }
 
     bool
     StdDbInstance::exists_table(const TableIdentifier& identifier)
     {
-        InstanceGuard guard(mtx_);
         std::string schema_name = identifier.schema_name.has_value()
                                       ? identifier.schema_name.value().value
                                       : cfg_.default_schema;
@@ -669,7 +1210,6 @@ namespace storage
     bool
     StdDbInstance::exists_db(const std::string& name)
     {
-        InstanceGuard guard(mtx_);
         return io_manager_->exists_db(name);
     }
 
@@ -681,7 +1221,7 @@ namespace storage
         txn::Transaction& txn
     )
     {
-        InstanceGuard guard(mtx_);
+        ExclusiveLatch latch(catalog_latch_);
         auto* schema = catalog_->get_schema(schema_name);
 
         MetaTable mt;
@@ -707,7 +1247,7 @@ namespace storage
     void
     StdDbInstance::create_schema(const std::string& schema_name, txn::Transaction& txn)
     {
-        InstanceGuard guard(mtx_);
+        ExclusiveLatch latch(catalog_latch_);
         MetaSchema ms;
         ms.id = UUID::make();
         ms.name = schema_name;
@@ -722,7 +1262,7 @@ namespace storage
     bool
     StdDbInstance::exists_schema(const std::string& schema_name)
     {
-        InstanceGuard guard(mtx_);
+        SharedLatch latch(catalog_latch_);
         return catalog_->exists_schema(schema_name);
     }
 
@@ -736,11 +1276,16 @@ namespace storage
         txn::Transaction& txn
     )
     {
-        InstanceGuard guard(mtx_);
+        // Holding the catalog exclusive also keeps every writer away from the table.
+        ExclusiveLatch latch(catalog_latch_);
         const auto* schema = catalog_->get_schema(schema_name);
         auto* table = catalog_->get_table(table_name, schema->id);
         const auto& column = table->get_column(column_name);
 
+        const auto col_idx = table->get_column_idx(column.id);
+        if (col_idx < 0)
+            throw std::runtime_error("Index column not found in table schema");
+
         MetaIndex mi;
         mi.id = UUID::make();
         mi.name = index_name;
@@ -749,76 +1294,118 @@ namespace storage
         mi.is_unique = is_unique;
         mi.table_id = table->id;
 
-        CreateIndexRecord record(mi);
-        txn.append_log(record);
-
-        buffer_pool_->create_table_index(schema_name, *table, mi, txn.get_last_lsn());
+        // Existing rows are sorted, and checked for duplicates, before anything is logged
+        // or written, so that a violation leaves no index behind. Versions kept for older
+        // snapshots repeat the key of their successor, so the unique check sorts those not
+        // obsolete apart, on half the memory; a key an uncommitted deletion may bring back
+        // cannot have been taken since.
+        const auto build_bytes = is_unique ? cfg_.index_build_bytes / 2 : cfg_.index_build_bytes;
+        IndexKeySorter sorter(cfg_.db_path / ("index_build_" + mi.id.to_string()), build_bytes);
 
-        const auto col_idx = table->get_column_idx(column.id);
-        if (col_idx < 0)
-            throw std::runtime_error("Index column not found in table schema");
-
-        // Pre-validate unique constraint on existing data before creating index file
+        std::optional<IndexKeySorter> unique_keys;
         if (is_unique)
-        {
-            auto pages = buffer_pool_->get_table_data(table->id);
-            std::unordered_set<std::string> seen_values;
+            unique_keys.emplace(cfg_.db_path / ("index_check_" + mi.id.to_string()), build_bytes);
 
-            for (const auto& page : pages)
-            {
-                for (const auto& row : page->rows)
-                {
-                    if (has_flag(row.flags, DataRowFlags::OBSOLETE))
-                        continue;
+        collect_index_keys(
+            *table, static_cast<size_t>(col_idx), sorter, unique_keys ? &*unique_keys : nullptr
+        );
+        sorter.sort(false);
 
-                    const auto& key = row.tokens[static_cast<size_t>(col_idx)];
-                    
-                    // NULL values are not indexed and don't violate uniqueness
-                    if (key.type == DataType::_NULL)
-                        continue;
-                    
-                    std::string key_str(key.bytes.begin(), key.bytes.end());
-                    
-                    if (seen_values.count(key_str) > 0)
-                    {
-                        throw UniqueConstraintViolation(
-                            "Cannot create unique index '" + index_name + "' on column '" + 
-                            column_name + "': table '" + table_name + "' contains duplicate values"
-                        );
-                    }
-                    
-                    seen_values.insert(key_str);
-                }
-            }
+        if (unique_keys && !unique_keys->sort(true))
+        {
+            throw UniqueConstraintViolation(
+                "Cannot create unique index '" + index_name + "' on column '" + column_name +
+                "': table '" + table_name + "' contains duplicate values"
+            );
         }
 
-        BPIndexPager pager(*buffer_pool_, table->id, mi.id);
-        IndexBPlusTree tree(pager);
+        CreateIndexRecord record(mi);
+        txn.append_log(record);
 
-        auto pages = buffer_pool_->get_table_data(table->id);
+        buffer_pool_->create_table_index(schema_name, *table, mi);
+        load_index(*table, mi, sorter, txn.get_last_lsn());
 
-        for (const auto& page : pages)
+        table->indexes.push_back(std::move(mi));
+    }
+
+    void
+    StdDbInstance::collect_index_keys(
+        const MetaTable& table,
+        size_t col_idx,
+        IndexKeySorter& sorter,
+        IndexKeySorter* unique_keys
+    )
+    {
+        for (const auto& page_id : buffer_pool_->table_pages(table.id))
         {
-            for (const auto& row : page->rows)
+            auto page = buffer_pool_->get_dp(page_id);
+            if (!page)
+                continue;
+
+            for (size_t slot = 0; slot < page->slot_count; ++slot)
             {
-                if (has_flag(row.flags, DataRowFlags::OBSOLETE))
+                const auto row = page->row(slot);
+
+                // A rolled back version is seen by no one.
+                if (has_flag(row.flags(), DataRowFlags::OBSOLETE) && row.deleted_by() == 0)
                     continue;
 
-                const auto& key = row.tokens[static_cast<size_t>(col_idx)];
-                
-                // NULL values are not indexed
+                const auto key = row.token(col_idx);
+
+                // NULL values are not indexed and don't violate uniqueness
                 if (key.type == DataType::_NULL)
                     continue;
-                
-                const RowPtr row_ptr{page->id, row.id};
 
-                tree.insert(key, row_ptr);
+                if (unique_keys && !has_flag(row.flags(), DataRowFlags::OBSOLETE))
+                    unique_keys->add(key.to_token(), {page->id, row.id()});
+
+                sorter.add(key.to_token(), {page->id, row.id()});
             }
         }
+    }
 
-        buffer_pool_->set_if_lsn(mi.id, txn.get_last_lsn());
+    void
+    StdDbInstance::load_index(const MetaTable& table, const MetaIndex& mi, IndexKeySorter& sorter, LSN lsn)
+    {
+        BPIndexPager pager(*buffer_pool_, table.id, mi.id, lsn);
+        IndexBPlusTree tree(pager);
+        tree.bulk_load(
+            [&](DataToken& key, RowPtr& row_ptr)
+            {
+                IndexKeySorter::Entry entry;
+                if (!sorter.next(entry))
+                    return false;
 
-        table->indexes.push_back(std::move(mi));
+                key = std::move(entry.first);
+                row_ptr = entry.second;
+                return true;
+            },
+            cfg_.index_fill_percent
+        );
+    }
+
+    void
+    StdDbInstance::rebuild_indexes(const TableId& table_id)
+    {
+        const auto* table = catalog_->get_table(table_id);
+        if (!table || table->indexes.empty())
+            return;
+
+        const auto* schema = catalog_->get_schema(table->schema_id);
+        for (const auto& mi : table->indexes)
+        {
+            const auto col_idx = table->get_column_idx(mi.column_id);
+            if (col_idx < 0)
+                throw std::runtime_error("Index column not found in table schema");
+
+            IndexKeySorter sorter(cfg_.db_path / ("index_build_" + mi.id.to_string()), cfg_.index_build_bytes);
+            collect_index_keys(*table, static_cast<size_t>(col_idx), sorter);
+            sorter.sort(false);
+
+            // A fresh file replaces the old one, whatever it holds.
+            buffer_pool_->create_table_index(schema->name, *table, mi);
+            load_index(*table, mi, sorter, 0);
+        }
     }
 
     bool
@@ -826,7 +1413,6 @@ namespace storage
         const std::string& index_name, const std::string& table_name, const std::string& schema_name
     )
     {
-        InstanceGuard guard(mtx_);
         return get_index(index_name, table_name, schema_name) != nullptr;
     }
 
@@ -835,7 +1421,6 @@ namespace storage
         const std::string& index_name, const TableIdentifier& table_identifier
     )
     {
-        InstanceGuard guard(mtx_);
         return get_index(index_name, table_identifier) != nullptr;
     }
 
@@ -844,7 +1429,7 @@ namespace storage
         const std::string& index_name, const std::string& table_name, const std::string& schema_name
     )
     {
-        InstanceGuard guard(mtx_);
+        SharedLatch latch(catalog_latch_);
         const auto* schema = catalog_->get_schema(schema_name);
         auto* table = catalog_->get_table(table_name, schema->id);
 
@@ -860,7 +1445,6 @@ namespace storage
         const std::string& index_name, const TableIdentifier& identifier
     )
     {
-        InstanceGuard guard(mtx_);
         std::string schema_name = identifier.schema_name.has_value()
                                       ? identifier.schema_name.value().value
                                       : cfg_.default_schema;
@@ -876,9 +1460,14 @@ namespace storage
         txn::Transaction& txn
     )
     {
-        InstanceGuard guard(mtx_);
-        auto* table = get_table(table_name, schema_name);
-        auto* index = get_index(index_name, table_name, schema_name);
+        ExclusiveLatch latch(catalog_latch_);
+        const auto* schema = catalog_->get_schema(schema_name);
+        auto* table = catalog_->get_table(table_name, schema->id);
+
+        MetaIndex* index = nullptr;
+        for (auto& index_entry : table->indexes)
+            if (index_entry.name == index_name)
+                index = &index_entry;
         if (!index)
             throw std::runtime_error("StdDbInstance::drop_index");
 
@@ -4,6 +4,8 @@
 
 #include "std_storage_serializer.hpp"
 
+#include <algorithm>
+
 namespace storage
 {
     using namespace misc;
@@ -165,15 +167,12 @@ namespace storage
         stream.write(page.table_id.raw(), sizeof(uuid_t));
         stream.write(&page.min_rid, sizeof(page.min_rid));
         stream.write(&page.max_rid, sizeof(page.max_rid));
-        uint64_t rows_count = page.rows.size();
-        stream.write(&rows_count, sizeof(rows_count));
         stream.write(&page.last_lsn, sizeof(page.last_lsn));
+        stream.write(&page.slot_count, sizeof(page.slot_count));
+        stream.write(&page.rows_start, sizeof(page.rows_start));
 
-        for (size_t i = 0; i < page.rows.size(); ++i)
-        {
-            auto serialized_row = serialize_dr(page.rows[i]);
-            stream.append(serialized_row, serialized_row.size());
-        }
+        // The body is stored as it is kept in memory.
+        stream.write(page.body.data(), page.body.size());
 
         stream.seek(0);
         return stream;
@@ -186,20 +185,234 @@ namespace storage
 
         stream.write(file.index_id.raw(), sizeof(uuid_t));
         stream.write(&file.root_page, sizeof(file.root_page));
-        stream.write(&file.last_lsn, sizeof(file.last_lsn));
-        uint64_t pages_count = file.pages.size();
+        stream.write(&file.last_page, sizeof(file.last_page));
+
+        stream.seek(0);
+        return stream;
+    }
+
+    MemoryStream
+    StdStorageSerializer::serialize_fsm(const FreeSpaceMap& fsm) const
+    {
+        MemoryStream stream;
+
+        stream.write(fsm.table_id.raw(), sizeof(uuid_t));
+        stream.write(fsm.head.raw(), sizeof(uuid_t));
+        stream.write(fsm.tail.raw(), sizeof(uuid_t));
+        uint64_t pages_count = fsm.pages().size();
         stream.write(&pages_count, sizeof(pages_count));
 
-        for (const auto& page : file.pages)
+        for (const auto& [page_id, free_bytes] : fsm.pages())
         {
-            auto serialized_page = serialize_ip(page);
-            stream.append(serialized_page, serialized_page.size());
+            stream.write(page_id.raw(), sizeof(uuid_t));
+            stream.write(&free_bytes, sizeof(free_bytes));
         }
 
         stream.seek(0);
         return stream;
     }
 
+    namespace
+    {
+        // How the keys of an index page are laid out after their count.
+        enum class KeyEncoding : uint8_t
+        {
+            // Each key written by serialize_dt.
+            PLAIN = 0,
+            // Keys of one type: the type and the prefix shared by all keys once, then the
+            // remaining bytes of every key.
+            PREFIXED = 1,
+            // Like PREFIXED, but equal neighbouring keys are written once with the number
+            // of entries they cover, so the rows of a repeated key read as a posting list.
+            RUNS = 2,
+        };
+
+        bool
+        can_prefix(const std::vector<DataToken>& keys)
+        {
+            if (keys.empty() || keys.front().type == DataType::_NULL)
+                return false;
+
+            for (const auto& key : keys)
+                if (key.type != keys.front().type || key.bytes.size() > UINT16_MAX)
+                    return false;
+
+            return true;
+        }
+
+        size_t
+        shared_prefix(const std::vector<DataToken>& keys)
+        {
+            size_t prefix = keys.front().bytes.size();
+            for (const auto& key : keys)
+            {
+                const auto& first = keys.front().bytes;
+                const auto mismatch = std::mismatch(
+                    first.begin(), first.begin() + static_cast<long>(prefix),
+                    key.bytes.begin(), key.bytes.end()
+                );
+                prefix = static_cast<size_t>(mismatch.first - first.begin());
+                if (prefix == 0)
+                    break;
+            }
+            return prefix;
+        }
+
+        // Length of the run of keys equal to keys[from], capped to what a run can record.
+        size_t
+        run_length(const std::vector<DataToken>& keys, size_t from)
+        {
+            size_t end = from + 1;
+            while (end < keys.size() && end - from < UINT16_MAX && keys[end].bytes == keys[from].bytes)
+                ++end;
+            return end - from;
+        }
+
+        // Bytes the keys take after the shared prefix, written one by one or as runs.
+        uint64_t
+        suffixes_size(const std::vector<DataToken>& keys, size_t prefix, bool runs)
+        {
+            uint64_t size = 0;
+            for (size_t i = 0; i < keys.size();)
+            {
+                const size_t step = runs ? run_length(keys, i) : 1;
+                size += sizeof(uint16_t) + keys[i].bytes.size() - prefix + (runs ? sizeof(uint16_t) : 0);
+                i += step;
+            }
+            return size;
+        }
+    } // namespace
+
+    void
+    StdStorageSerializer::write_keys(const std::vector<DataToken>& keys, MemoryStream& stream) const
+    {
+        uint64_t keys_count = keys.size();
+        stream.write(&keys_count, sizeof(keys_count));
+
+        if (!can_prefix(keys))
+        {
+            auto encoding = KeyEncoding::PLAIN;
+            stream.write(&encoding, sizeof(encoding));
+            for (const auto& key : keys)
+            {
+                auto serialized_token = serialize_dt(key);
+                stream.append(serialized_token, serialized_token.size());
+            }
+            return;
+        }
+
+        const auto prefix = static_cast<uint16_t>(shared_prefix(keys));
+        const bool runs = suffixes_size(keys, prefix, true) < suffixes_size(keys, prefix, false);
+
+        auto encoding = runs ? KeyEncoding::RUNS : KeyEncoding::PREFIXED;
+        stream.write(&encoding, sizeof(encoding));
+        stream.write(&keys.front().type, sizeof(DataType));
+        stream.write(&prefix, sizeof(prefix));
+        stream.write(keys.front().bytes.data(), prefix);
+
+        for (size_t i = 0; i < keys.size();)
+        {
+            const auto& key = keys[i];
+            const auto suffix = static_cast<uint16_t>(key.bytes.size() - prefix);
+            stream.write(&suffix, sizeof(suffix));
+            stream.write(key.bytes.data() + prefix, suffix);
+
+            if (!runs)
+            {
+                ++i;
+                continue;
+            }
+
+            const auto count = static_cast<uint16_t>(run_length(keys, i));
+            stream.write(&count, sizeof(count));
+            i += count;
+        }
+    }
+
+    bool
+    StdStorageSerializer::read_keys(ReadOnlyMemoryStream& stream, std::vector<DataToken>& out) const
+    {
+        uint64_t keys_count = 0;
+        if (stream.read(&keys_count, sizeof(keys_count)) != sizeof(keys_count))
+            return false;
+
+        KeyEncoding encoding;
+        if (stream.read(&encoding, sizeof(encoding)) != sizeof(encoding))
+            return false;
+
+        out.clear();
+        out.reserve(keys_count);
+
+        if (encoding == KeyEncoding::PLAIN)
+        {
+            for (uint64_t i = 0; i < keys_count; ++i)
+            {
+                DataToken key;
+                if (!deserialize_dt(stream, key))
+                    return false;
+                out.push_back(std::move(key));
+            }
+            return true;
+        }
+
+        if (encoding != KeyEncoding::PREFIXED && encoding != KeyEncoding::RUNS)
+            return false;
+
+        DataType type;
+        if (stream.read(&type, sizeof(type)) != sizeof(type))
+            return false;
+
+        uint16_t prefix_size = 0;
+        if (stream.read(&prefix_size, sizeof(prefix_size)) != sizeof(prefix_size))
+            return false;
+
+        Bytes prefix(prefix_size);
+        if (stream.read(prefix.data(), prefix_size) != prefix_size)
+            return false;
+
+        while (out.size() < keys_count)
+        {
+            uint16_t suffix = 0;
+            if (stream.read(&suffix, sizeof(suffix)) != sizeof(suffix))
+                return false;
+
+            DataToken key(prefix, type);
+            key.bytes.resize(prefix_size + suffix);
+            if (stream.read(key.bytes.data() + prefix_size, suffix) != suffix)
+                return false;
+
+            uint16_t count = 1;
+            if (encoding == KeyEncoding::RUNS &&
+                stream.read(&count, sizeof(count)) != sizeof(count))
+                return false;
+
+            if (count == 0 || out.size() + count > keys_count)
+                return false;
+
+            out.insert(out.end(), count - 1, key);
+            out.push_back(std::move(key));
+        }
+
+        return true;
+    }
+
+    uint64_t
+    StdStorageSerializer::estimate_keys_size(const std::vector<DataToken>& keys) const
+    {
+        uint64_t size = sizeof(uint64_t) + sizeof(KeyEncoding);
+
+        if (!can_prefix(keys))
+        {
+            for (const auto& key : keys)
+                size += sizeof(key.type) + (key.type != DataType::_NULL ? sizeof(uint64_t) + key.bytes.size() : 0);
+            return size;
+        }
+
+        const size_t prefix = shared_prefix(keys);
+        size += sizeof(DataType) + sizeof(uint16_t) + prefix;
+        return size + std::min(suffixes_size(keys, prefix, true), suffixes_size(keys, prefix, false));
+    }
+
     MemoryStream
     StdStorageSerializer::serialize_ip(const IndexPage& page) const
     {
@@ -208,19 +421,14 @@ namespace storage
         stream.write(&page.id, sizeof(page.id));
         stream.write(&page.parent, sizeof(page.parent));
         stream.write(page.index_id.raw(), sizeof(uuid_t));
+        stream.write(&page.last_lsn, sizeof(page.last_lsn));
         stream.write(&page.is_leaf, sizeof(page.is_leaf));
 
         if (std::holds_alternative<InternalIndexNode>(page.data))
         {
             const auto& internal = std::get<InternalIndexNode>(page.data);
 
-            uint64_t keys_count = internal.keys.size();
-            stream.write(&keys_count, sizeof(keys_count));
-            for (const auto& key : internal.keys)
-            {
-                auto serialized_token = serialize_dt(key);
-                stream.append(serialized_token, serialized_token.size());
-            }
+            write_keys(internal.keys, stream);
             uint64_t children_count = internal.children.size();
             stream.write(&children_count, sizeof(children_count));
             for (auto child_id : internal.children)
@@ -232,13 +440,7 @@ namespace storage
         {
             const auto& leaf = std::get<LeafIndexNode>(page.data);
 
-            uint64_t keys_count = leaf.keys.size();
-            stream.write(&keys_count, sizeof(keys_count));
-            for (const auto& key : leaf.keys)
-            {
-                auto serialized_token = serialize_dt(key);
-                stream.append(serialized_token, serialized_token.size());
-            }
+            write_keys(leaf.keys, stream);
 
             uint64_t rows_count = leaf.rows.size();
             stream.write(&rows_count, sizeof(rows_count));
@@ -265,6 +467,8 @@ namespace storage
         MemoryStream stream;
         stream.write(&row.id, sizeof(row.id));
         stream.write(&row.flags, sizeof(row.flags));
+        stream.write(&row.created_by, sizeof(row.created_by));
+        stream.write(&row.deleted_by, sizeof(row.deleted_by));
 
         uint64_t tokens_count = row.tokens.size();
         stream.write(&tokens_count, sizeof(uint64_t));
@@ -290,6 +494,19 @@ namespace storage
         stream.write(&db.planner_type, sizeof(db.planner_type));
         stream.write(&db.serializer_type, sizeof(db.serializer_type));
         stream.write(&db.last_checkpoint_lsn, sizeof(db.last_checkpoint_lsn));
+        stream.write(&db.buffer_pool_bytes, sizeof(db.buffer_pool_bytes));
+        stream.write(&db.index_pool_bytes, sizeof(db.index_pool_bytes));
+        stream.write(&db.buffer_pool_policy, sizeof(db.buffer_pool_policy));
+        stream.write(&db.index_pool_policy, sizeof(db.index_pool_policy));
+        stream.write(&db.page_writer_interval_ms, sizeof(db.page_writer_interval_ms));
+        stream.write(&db.page_writer_dirty_percent, sizeof(db.page_writer_dirty_percent));
+        stream.write(&db.page_writer_max_dirty_age_ms, sizeof(db.page_writer_max_dirty_age_ms));
+        stream.write(&db.wal_commit_delay_us, sizeof(db.wal_commit_delay_us));
+        stream.write(&db.wal_group_commit_records, sizeof(db.wal_group_commit_records));
+        stream.write(&db.checkpoint_interval_ms, sizeof(db.checkpoint_interval_ms));
+        stream.write(&db.wal_segment_bytes, sizeof(db.wal_segment_bytes));
+        stream.write(&db.index_fill_percent, sizeof(db.index_fill_percent));
+        stream.write(&db.index_build_bytes, sizeof(db.index_build_bytes));
         stream.seek(0);
         return stream;
     }
@@ -429,26 +646,24 @@ namespace storage
         if (stream.read(&out.max_rid, sizeof(out.max_rid)) != sizeof(out.max_rid))
             return false;
 
-        if (stream.read(&out.rows_count, sizeof(out.rows_count)) != sizeof(out.rows_count))
-            return false;
-
         if (stream.read(&out.last_lsn, sizeof(out.last_lsn)) != sizeof(out.last_lsn))
             return false;
 
-        uint64_t rows_count = out.rows_count;
+        if (stream.read(&out.slot_count, sizeof(out.slot_count)) != sizeof(out.slot_count))
+            return false;
 
-        out.rows.clear();
-        out.rows.reserve(rows_count);
+        if (stream.read(&out.rows_start, sizeof(out.rows_start)) != sizeof(out.rows_start))
+            return false;
 
-        for (size_t i = 0; i < rows_count; ++i)
-        {
-            DataRow row;
-            if (!deserialize_dr(stream, row))
-                return false;
+        if (out.rows_start > DataPage::BODY_SIZE ||
+            out.slot_count * DataPage::SLOT_SIZE > out.rows_start)
+            return false;
 
-            out.rows.push_back(std::move(row));
-        }
+        out.body.resize(DataPage::BODY_SIZE);
+        if (stream.read(out.body.data(), out.body.size()) != out.body.size())
+            return false;
 
+        out.update_size();
         return true;
     }
 
@@ -461,25 +676,47 @@ namespace storage
         if (content.read(&out.root_page, sizeof(out.root_page)) != sizeof(out.root_page))
             return false;
 
-        if (content.read(&out.last_lsn, sizeof(out.last_lsn)) != sizeof(out.last_lsn))
+        if (content.read(&out.last_page, sizeof(out.last_page)) != sizeof(out.last_page))
+            return false;
+
+        out.dirty = false;
+        return true;
+    }
+
+    bool
+    StdStorageSerializer::deserialize_fsm(ReadOnlyMemoryStream& content, FreeSpaceMap& out) const
+    {
+        TableId table_id;
+        if (content.read(table_id.raw(), sizeof(uuid_t)) != sizeof(uuid_t))
+            return false;
+
+        out = FreeSpaceMap(table_id);
+        if (content.read(out.head.raw(), sizeof(uuid_t)) != sizeof(uuid_t))
+            return false;
+        if (content.read(out.tail.raw(), sizeof(uuid_t)) != sizeof(uuid_t))
             return false;
 
         uint64_t pages_count = 0;
         if (content.read(&pages_count, sizeof(pages_count)) != sizeof(pages_count))
             return false;
 
-        out.pages.clear();
-        out.pages.reserve(pages_count);
-
         for (uint64_t i = 0; i < pages_count; ++i)
         {
-            IndexPage page;
-            if (!deserialize_ip(content, page))
+            DataPageId page_id;
+            uint64_t free_bytes = 0;
+            if (content.read(page_id.raw(), sizeof(uuid_t)) != sizeof(uuid_t))
+                return false;
+            if (content.read(&free_bytes, sizeof(free_bytes)) != sizeof(free_bytes))
                 return false;
 
-            out.pages.push_back(std::move(page));
+            out.set(page_id, free_bytes);
         }
 
+        // Leftover bytes mean a map written in another layout; it is rebuilt instead.
+        if (content.remaining() != 0)
+            return false;
+
+        out.dirty = false;
         return true;
     }
 
@@ -495,6 +732,9 @@ namespace storage
         if (content.read(out.index_id.raw(), sizeof(uuid_t)) != sizeof(uuid_t))
             return false;
 
+        if (content.read(&out.last_lsn, sizeof(out.last_lsn)) != sizeof(out.last_lsn))
+            return false;
+
         if (content.read(&out.is_leaf, sizeof(out.is_leaf)) != sizeof(out.is_leaf))
             return false;
 
@@ -502,20 +742,9 @@ namespace storage
         {
             LeafIndexNode leaf;
 
-            uint64_t keys_count = 0;
-            if (content.read(&keys_count, sizeof(keys_count)) != sizeof(keys_count))
+            if (!read_keys(content, leaf.keys))
                 return false;
 
-            leaf.keys.clear();
-            leaf.keys.reserve(keys_count);
-            for (uint64_t i = 0; i < keys_count; ++i)
-            {
-                DataToken key;
-                if (!deserialize_dt(content, key))
-                    return false;
-                leaf.keys.push_back(std::move(key));
-            }
-
             uint64_t rows_count = 0;
             if (content.read(&rows_count, sizeof(rows_count)) != sizeof(rows_count))
                 return false;
@@ -541,20 +770,9 @@ namespace storage
         {
             InternalIndexNode internal;
 
-            uint64_t keys_count = 0;
-            if (content.read(&keys_count, sizeof(keys_count)) != sizeof(keys_count))
+            if (!read_keys(content, internal.keys))
                 return false;
 
-            internal.keys.clear();
-            internal.keys.reserve(keys_count);
-            for (uint64_t i = 0; i < keys_count; ++i)
-            {
-                DataToken key;
-                if (!deserialize_dt(content, key))
-                    return false;
-                internal.keys.push_back(std::move(key));
-            }
-
             uint64_t children_count = 0;
             if (content.read(&children_count, sizeof(children_count)) != sizeof(children_count))
                 return false;
@@ -606,6 +824,87 @@ namespace storage
             sizeof(out.last_checkpoint_lsn))
             return false;
 
+        // Configs written before the buffer pool budgets existed keep the defaults.
+        if (stream.remaining() == 0)
+            return true;
+
+        if (stream.read(&out.buffer_pool_bytes, sizeof(out.buffer_pool_bytes)) !=
+            sizeof(out.buffer_pool_bytes))
+            return false;
+
+        if (stream.read(&out.index_pool_bytes, sizeof(out.index_pool_bytes)) !=
+            sizeof(out.index_pool_bytes))
+            return false;
+
+        // Configs written before the replacement policies were selectable keep the defaults.
+        if (stream.remaining() == 0)
+            return true;
+
+        if (stream.read(&out.buffer_pool_policy, sizeof(out.buffer_pool_policy)) !=
+            sizeof(out.buffer_pool_policy))
+            return false;
+
+        if (stream.read(&out.index_pool_policy, sizeof(out.index_pool_policy)) !=
+            sizeof(out.index_pool_policy))
+            return false;
+
+        // Configs written before the page writer existed keep its defaults.
+        if (stream.remaining() == 0)
+            return true;
+
+        if (stream.read(&out.page_writer_interval_ms, sizeof(out.page_writer_interval_ms)) !=
+            sizeof(out.page_writer_interval_ms))
+            return false;
+
+        if (stream.read(&out.page_writer_dirty_percent, sizeof(out.page_writer_dirty_percent)) !=
+            sizeof(out.page_writer_dirty_percent))
+            return false;
+
+        if (stream.read(
+                &out.page_writer_max_dirty_age_ms, sizeof(out.page_writer_max_dirty_age_ms)
+            ) != sizeof(out.page_writer_max_dirty_age_ms))
+            return false;
+
+        // Configs written before group commit was configurable keep its defaults.
+        if (stream.remaining() == 0)
+            return true;
+
+        if (stream.read(&out.wal_commit_delay_us, sizeof(out.wal_commit_delay_us)) !=
+            sizeof(out.wal_commit_delay_us))
+            return false;
+
+        if (stream.read(&out.wal_group_commit_records, sizeof(out.wal_group_commit_records)) !=
+            sizeof(out.wal_group_commit_records))
+            return false;
+
+        // Configs written before checkpoints keep the default interval.
+        if (stream.remaining() == 0)
+            return true;
+
+        if (stream.read(&out.checkpoint_interval_ms, sizeof(out.checkpoint_interval_ms)) !=
+            sizeof(out.checkpoint_interval_ms))
+            return false;
+
+        // Configs written before segments were sized in bytes keep the default size.
+        if (stream.remaining() == 0)
+            return true;
+
+        if (stream.read(&out.wal_segment_bytes, sizeof(out.wal_segment_bytes)) !=
+            sizeof(out.wal_segment_bytes))
+            return false;
+
+        // Configs written before index bulk loading keep its defaults.
+        if (stream.remaining() == 0)
+            return true;
+
+        if (stream.read(&out.index_fill_percent, sizeof(out.index_fill_percent)) !=
+            sizeof(out.index_fill_percent))
+            return false;
+
+        if (stream.read(&out.index_build_bytes, sizeof(out.index_build_bytes)) !=
+            sizeof(out.index_build_bytes))
+            return false;
+
         return true;
     }
 
@@ -618,6 +917,12 @@ namespace storage
         if (stream.read(&out.flags, sizeof(out.flags)) != sizeof(out.flags))
             return false;
 
+        if (stream.read(&out.created_by, sizeof(out.created_by)) != sizeof(out.created_by))
+            return false;
+
+        if (stream.read(&out.deleted_by, sizeof(out.deleted_by)) != sizeof(out.deleted_by))
+            return false;
+
         uint64_t tokens_count = 0;
         if (stream.read(&tokens_count, sizeof(uint64_t)) != sizeof(uint64_t))
             return false;
@@ -671,7 +976,9 @@ namespace storage
     uint64_t
     StdStorageSerializer::estimate_size(const DataRow& row) const
     {
-        uint64_t size = sizeof(row.id) + sizeof(row.flags) + sizeof(uint64_t);
+
+        uint64_t size = sizeof(row.id) + sizeof(row.flags) + sizeof(row.created_by) +
+                        sizeof(row.deleted_by) + sizeof(uint64_t);
         for (const auto& token : row.tokens)
             size += estimate_size(token);
         return size;
@@ -688,4 +995,25 @@ namespace storage
 
         return size;
     }
+
+    uint64_t
+    StdStorageSerializer::estimate_size(const IndexPage& page) const
+    {
+        uint64_t size = sizeof(page.id) + sizeof(page.parent) + sizeof(uuid_t) +
+                        sizeof(page.last_lsn) + sizeof(page.is_leaf);
+
+        if (const auto* internal = std::get_if<InternalIndexNode>(&page.data))
+        {
+            size += estimate_keys_size(internal->keys) + sizeof(uint64_t) +
+                    internal->children.size() * sizeof(IndexPageId);
+        }
+        else
+        {
+            const auto& leaf = std::get<LeafIndexNode>(page.data);
+            size += estimate_keys_size(leaf.keys) + sizeof(uint64_t) +
+                    leaf.rows.size() * (sizeof(uuid_t) + sizeof(RowId)) + sizeof(leaf.next_leaf);
+        }
+
+        return size;
+    }
 } // namespace storage
\ No newline at end of file
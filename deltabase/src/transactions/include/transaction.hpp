@@ -6,6 +6,7 @@
 #define DELTABASE_TRANSACTION_HPP
 #include "../../storage/include/buffer_pool.hpp"
 #include "../../types/include/UUID.hpp"
+#include "../../types/include/snapshot.hpp"
 #include "../../types/include/wal_log.hpp"
 #include "../../wal/include/wal_manager.hpp"
 
@@ -15,6 +16,8 @@ namespace txn
 {
     using TxnId = types::UUID;
 
+    class TransactionManager;
+
     enum class TransactionState
     {
         IDLE = 0,
@@ -26,22 +29,51 @@ namespace txn
     class Transaction
     {
         TxnId id_;
+        TransactionManager& manager_;
         wal::IWALManager& wal_manager_;
         storage::BufferPool& buffer_pool_;
         TransactionState state_ = TransactionState::IDLE;
+        types::LSN begin_lsn_ = 0;
         types::LSN last_lsn_ = 0;
+        types::Snapshot snapshot_;
 
-        Transaction(const TxnId& id, wal::IWALManager& wal_manager, storage::BufferPool& buffer_pool);
+        Transaction(
+            const TxnId& id,
+            TransactionManager& manager,
+            wal::IWALManager& wal_manager,
+            storage::BufferPool& buffer_pool
+        );
 
         friend class TransactionManager;
 
     public:
+        Transaction(Transaction&& other) noexcept;
+
+        Transaction(const Transaction&) = delete;
+        Transaction&
+        operator=(const Transaction&) = delete;
+
+        // A transaction dropped while active is given up on; see TransactionManager.
+        ~Transaction();
+
         TxnId
         get_id() const;
 
+        // The LSN of the begin record, which names the transaction in the row versions
+        // it creates and deletes.
+        types::LSN
+        get_begin_lsn() const;
+
         types::LSN
         get_last_lsn() const;
 
+        TransactionState
+        get_state() const;
+
+        // What the transaction reads, fixed when it begins.
+        const types::Snapshot&
+        get_snapshot() const;
+
         void
         begin();
 
@@ -50,6 +82,16 @@ namespace txn
 
         void
         commit();
+
+        // Takes back everything the transaction did, in the pages and indexes of the
+        // buffer pool, and ends it.
+        void
+        rollback();
+
+        // Takes back what the transaction did after savepoint, a value get_last_lsn
+        // returned earlier, and leaves it active: a failed statement is undone this way.
+        void
+        rollback_to(types::LSN savepoint);
     };
 } // namespace txn
 
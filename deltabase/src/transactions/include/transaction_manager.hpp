@@ -7,6 +7,10 @@
 #include "../../storage/include/buffer_pool.hpp"
 #include "transaction.hpp"
 
+#include <functional>
+#include <mutex>
+#include <set>
+
 namespace txn
 {
     class TransactionManager
@@ -14,11 +18,49 @@ namespace txn
         wal::IWALManager& wal_manager_;
         storage::BufferPool& buffer_pool_;
 
+        // Guards the set below. Begin records are appended under it, so that a snapshot
+        // knows of every transaction that began before its horizon.
+        mutable std::mutex mtx_;
+        // Transactions that began and did not finish. One dropped without committing or
+        // rolling back after it wrote something stays here: nothing takes its versions
+        // back out of the pages until a restart undoes it, so they must not be seen.
+        std::set<types::LSN> in_progress_;
+
+        // Set by the instance whose pages the transactions change.
+        std::function<types::LSN(const Transaction&, types::LSN)> undo_;
+
+        types::Snapshot
+        make_snapshot(types::LSN own, types::LSN horizon) const;
+
+        // Called by Transaction.
+        void
+        begin(Transaction& txn);
+
+        // finished: the transaction committed or was rolled back.
+        void
+        end(const Transaction& txn, bool finished);
+
+        // Takes back what the transaction logged after until, 0 for everything, and
+        // returns its last LSN once done.
+        types::LSN
+        undo(const Transaction& txn, types::LSN until);
+
+        friend class Transaction;
+
     public:
         TransactionManager(wal::IWALManager& wal_manager, storage::BufferPool& buffer_pool);
 
         Transaction
-        make_transaction() const;
+        make_transaction();
+
+        // How a transaction is rolled back at runtime; see Transaction::rollback.
+        void
+        set_undo(std::function<types::LSN(const Transaction& txn, types::LSN until)> undo);
+
+        // A snapshot for a reader outside of any transaction: it sees every transaction
+        // that has committed so far.
+        types::Snapshot
+        snapshot() const;
     };
 }
 
@@ -4,41 +4,77 @@
 
 #include "include/transaction.hpp"
 
+#include "include/transaction_manager.hpp"
+
 #include <stdexcept>
-#include <thread>
+#include <utility>
 #include <variant>
 
 namespace txn
 {
     Transaction::Transaction(
-        const TxnId& id, wal::IWALManager& wal_manager, storage::BufferPool& buffer_pool
+        const TxnId& id,
+        TransactionManager& manager,
+        wal::IWALManager& wal_manager,
+        storage::BufferPool& buffer_pool
     )
-        : id_(id), wal_manager_(wal_manager), buffer_pool_(buffer_pool)
+        : id_(id), manager_(manager), wal_manager_(wal_manager), buffer_pool_(buffer_pool)
+    {
+    }
+
+    Transaction::Transaction(Transaction&& other) noexcept
+        : id_(other.id_), manager_(other.manager_), wal_manager_(other.wal_manager_),
+          buffer_pool_(other.buffer_pool_),
+          state_(std::exchange(other.state_, TransactionState::IDLE)),
+          begin_lsn_(other.begin_lsn_), last_lsn_(other.last_lsn_),
+          snapshot_(std::move(other.snapshot_))
     {
     }
 
+    Transaction::~Transaction()
+    {
+        if (state_ == TransactionState::ACTIVE)
+            manager_.end(*this, false);
+    }
+
     TxnId
     Transaction::get_id() const
     {
         return id_;
     }
 
+    types::LSN
+    Transaction::get_begin_lsn() const
+    {
+        return begin_lsn_;
+    }
+
     types::LSN
     Transaction::get_last_lsn() const
     {
         return last_lsn_;
     }
 
+    TransactionState
+    Transaction::get_state() const
+    {
+        return state_;
+    }
+
+    const types::Snapshot&
+    Transaction::get_snapshot() const
+    {
+        return snapshot_;
+    }
+
     void
     Transaction::begin()
     {
         if (state_ != TransactionState::IDLE)
             throw std::runtime_error("Transaction::begin: transaction state not idle");
 
-        // lsn/prev_lsn are assigned in the WAL manager.
-        types::BeginTxnRecord record(0, last_lsn_, id_);
-
-        last_lsn_ = wal_manager_.append_log(record);
+        // Appends the begin record and takes the snapshot.
+        manager_.begin(*this);
         state_ = TransactionState::ACTIVE;
     }
 
@@ -70,13 +106,35 @@ namespace txn
         types::CommitTxnRecord commit_record(0, last_lsn_, id_);
 
         last_lsn_ = wal_manager_.append_log(commit_record);
+        // Dirty frames are written by the background page writer; the WAL alone makes
+        // the commit durable.
         wal_manager_.wait_for_durable(last_lsn_);
-        buffer_pool_.flush_dirty(last_lsn_);
+        // Only now do snapshots taken from here on see the transaction.
+        manager_.end(*this, true);
         state_ = TransactionState::COMMITTED;
+    }
+
+    void
+    Transaction::rollback()
+    {
+        if (state_ != TransactionState::ACTIVE)
+            throw std::runtime_error("Transaction::rollback: transaction state not active");
+
+        last_lsn_ = manager_.undo(*this, 0);
+        // Its versions are all dead or revived now, whatever a snapshot makes of them.
+        manager_.end(*this, true);
+        state_ = TransactionState::ABORTED;
+    }
+
+    void
+    Transaction::rollback_to(types::LSN savepoint)
+    {
+        if (state_ != TransactionState::ACTIVE)
+            throw std::runtime_error("Transaction::rollback_to: transaction state not active");
+
+        if (savepoint < begin_lsn_ || savepoint > last_lsn_)
+            throw std::runtime_error("Transaction::rollback_to: savepoint not in the transaction");
 
-        auto* buffer_pool = &buffer_pool_;
-        // std::thread([buffer_pool] {
-        //     buffer_pool->flush_dirty();
-        // }).detach();
+        last_lsn_ = manager_.undo(*this, savepoint);
     }
 } // namespace txn
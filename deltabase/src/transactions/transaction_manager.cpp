@@ -5,6 +5,9 @@
 #include "include/transaction_manager.hpp"
 
 #include "../storage/include/buffer_pool.hpp"
+
+#include <stdexcept>
+
 namespace txn
 {
     TransactionManager::TransactionManager(
@@ -15,8 +18,62 @@ namespace txn
     }
 
     Transaction
-    TransactionManager::make_transaction() const
+    TransactionManager::make_transaction()
+    {
+        return Transaction(TxnId::make(), *this, wal_manager_, buffer_pool_);
+    }
+
+    void
+    TransactionManager::set_undo(std::function<types::LSN(const Transaction&, types::LSN)> undo)
+    {
+        undo_ = std::move(undo);
+    }
+
+    types::Snapshot
+    TransactionManager::snapshot() const
+    {
+        std::lock_guard guard(mtx_);
+        return make_snapshot(0, wal_manager_.get_next_lsn());
+    }
+
+    types::Snapshot
+    TransactionManager::make_snapshot(types::LSN own, types::LSN horizon) const
     {
-        return Transaction(TxnId::make(), wal_manager_, buffer_pool_);
+        types::Snapshot snapshot;
+        snapshot.own = own;
+        snapshot.horizon = horizon;
+        snapshot.in_progress.assign(in_progress_.begin(), in_progress_.lower_bound(horizon));
+        return snapshot;
+    }
+
+    void
+    TransactionManager::begin(Transaction& txn)
+    {
+        std::lock_guard guard(mtx_);
+
+        // lsn/prev_lsn are assigned in the WAL manager.
+        types::BeginTxnRecord record(0, txn.last_lsn_, txn.id_);
+        txn.last_lsn_ = wal_manager_.append_log(record);
+        txn.begin_lsn_ = txn.last_lsn_;
+
+        txn.snapshot_ = make_snapshot(txn.begin_lsn_, txn.begin_lsn_);
+        in_progress_.insert(txn.begin_lsn_);
+    }
+
+    void
+    TransactionManager::end(const Transaction& txn, bool finished)
+    {
+        std::lock_guard guard(mtx_);
+        if (finished || txn.last_lsn_ == txn.begin_lsn_)
+            in_progress_.erase(txn.begin_lsn_);
+    }
+
+    types::LSN
+    TransactionManager::undo(const Transaction& txn, types::LSN until)
+    {
+        if (!undo_)
+            throw std::runtime_error("TransactionManager::undo: no undo set");
+
+        return undo_(txn, until);
     }
 } // namespace txn
@@ -0,0 +1,100 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "include/data_page.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace types
+{
+    namespace
+    {
+        void
+        read_slot(const Bytes& body, size_t slot, uint16_t& offset, uint16_t& length)
+        {
+            std::memcpy(&offset, body.data() + slot * DataPage::SLOT_SIZE, sizeof(offset));
+            std::memcpy(
+                &length, body.data() + slot * DataPage::SLOT_SIZE + sizeof(offset), sizeof(length)
+            );
+        }
+    } // namespace
+
+    uint64_t
+    DataPage::row_size(const DataRow& row)
+    {
+        return RowView::encoded_size(row) + SLOT_SIZE;
+    }
+
+    RowView
+    DataPage::row(size_t slot) const
+    {
+        if (slot >= slot_count)
+            throw std::out_of_range("DataPage::row: slot out of range");
+
+        uint16_t offset, length;
+        read_slot(body, slot, offset, length);
+        return {body.data() + offset, length};
+    }
+
+    std::optional<size_t>
+    DataPage::find(RowId row_id) const
+    {
+        for (size_t slot = 0; slot < slot_count; ++slot)
+        {
+            if (row(slot).id() == row_id)
+                return slot;
+        }
+
+        return std::nullopt;
+    }
+
+    void
+    DataPage::append(const DataRow& row)
+    {
+        const size_t length = RowView::encoded_size(row);
+        const size_t slots_end = (static_cast<size_t>(slot_count) + 1) * SLOT_SIZE;
+        if (length > rows_start || rows_start - length < slots_end)
+            throw std::runtime_error("DataPage::append: page " + id.to_string() + " is full");
+
+        const auto offset = static_cast<uint16_t>(rows_start - length);
+        RowView::encode(row, body.data() + offset);
+
+        const auto length16 = static_cast<uint16_t>(length);
+        std::memcpy(body.data() + slot_count * SLOT_SIZE, &offset, sizeof(offset));
+        std::memcpy(body.data() + slot_count * SLOT_SIZE + sizeof(offset), &length16, sizeof(length16));
+
+        rows_start = offset;
+        slot_count++;
+        size += length + SLOT_SIZE;
+    }
+
+    void
+    DataPage::set_flags(size_t slot, DataRowFlags flags)
+    {
+        if (slot >= slot_count)
+            throw std::out_of_range("DataPage::set_flags: slot out of range");
+
+        uint16_t offset, length;
+        read_slot(body, slot, offset, length);
+        body[offset + RowView::FLAGS_OFFSET] = static_cast<uint8_t>(flags);
+    }
+
+    void
+    DataPage::set_deleted_by(size_t slot, LSN deleted_by)
+    {
+        if (slot >= slot_count)
+            throw std::out_of_range("DataPage::set_deleted_by: slot out of range");
+
+        uint16_t offset, length;
+        read_slot(body, slot, offset, length);
+        std::memcpy(body.data() + offset + RowView::DELETED_BY_OFFSET, &deleted_by, sizeof(deleted_by));
+    }
+
+    void
+    DataPage::update_size()
+    {
+        size = HEADER_SIZE + slot_count * SLOT_SIZE + (BODY_SIZE - rows_start);
+    }
+} // namespace types
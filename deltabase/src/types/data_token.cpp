@@ -6,6 +6,7 @@
 
 #include "../misc/include/logger.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <stdexcept>
 
@@ -18,6 +19,26 @@ namespace types
         {
             return lhs.type == rhs.type;
         }
+
+        template <typename T>
+        int
+        compare_values(const T& lhs, const T& rhs)
+        {
+            if (lhs < rhs)
+                return -1;
+            return rhs < lhs ? 1 : 0;
+        }
+
+        int
+        compare_bytes(const Bytes& lhs, const Bytes& rhs)
+        {
+            const size_t common = std::min(lhs.size(), rhs.size());
+            if (common > 0)
+                if (const int res = std::memcmp(lhs.data(), rhs.data(), common); res != 0)
+                    return res < 0 ? -1 : 1;
+
+            return compare_values(lhs.size(), rhs.size());
+        }
     } // namespace
 
     DataToken::DataToken(const SqlToken& sql_token)
@@ -84,72 +105,81 @@ namespace types
     {
     }
 
-    bool
-    operator==(const DataToken& lhs, const DataToken& rhs)
+    int
+    compare(const DataToken& lhs, const DataToken& rhs)
     {
         if (!is_same_type(lhs, rhs))
-            return false;
+            return compare_values(static_cast<uint64_t>(lhs.type), static_cast<uint64_t>(rhs.type));
 
         switch (lhs.type)
         {
         case DataType::_NULL:
-            return true;
+            return 0;
         case DataType::INTEGER:
-            return lhs.as<int>() == rhs.as<int>();
+            return compare_values(lhs.as<int>(), rhs.as<int>());
         case DataType::REAL:
-            return lhs.as<double>() == rhs.as<double>();
+            return compare_values(lhs.as<double>(), rhs.as<double>());
         case DataType::CHAR:
-            return lhs.as<char>() == rhs.as<char>();
+            return compare_values(lhs.as<char>(), rhs.as<char>());
         case DataType::BOOL:
-            return lhs.as<bool>() == rhs.as<bool>();
+            return compare_values(lhs.as<bool>(), rhs.as<bool>());
         case DataType::STRING:
-            return lhs.as<std::string>() == rhs.as<std::string>();
+            // Same order as std::string, which compares chars as unsigned.
+            return compare_bytes(lhs.bytes, rhs.bytes);
         default:
         {
             misc::Logger::warn(
                 "Missing comparison operator for data token type " +
                 std::to_string(static_cast<int>(lhs.type))
             );
-            return lhs.bytes == rhs.bytes;
+            return compare_values(lhs.bytes, rhs.bytes);
         }
         }
     }
 
     bool
-    operator!=(const DataToken& lhs, const DataToken& rhs)
-    {
-        return !(lhs == rhs);
-    }
-
-    bool
-    operator<(const DataToken& lhs, const DataToken& rhs)
+    operator==(const DataToken& lhs, const DataToken& rhs)
     {
         if (!is_same_type(lhs, rhs))
-            return static_cast<uint64_t>(lhs.type) < static_cast<uint64_t>(rhs.type);
+            return false;
 
         switch (lhs.type)
         {
+        case DataType::_NULL:
+            return true;
         case DataType::INTEGER:
-            return lhs.as<int>() < rhs.as<int>();
+            return lhs.as<int>() == rhs.as<int>();
         case DataType::REAL:
-            return lhs.as<double>() < rhs.as<double>();
+            return lhs.as<double>() == rhs.as<double>();
         case DataType::CHAR:
-            return lhs.as<char>() < rhs.as<char>();
+            return lhs.as<char>() == rhs.as<char>();
         case DataType::BOOL:
-            return lhs.as<bool>() < rhs.as<bool>();
+            return lhs.as<bool>() == rhs.as<bool>();
         case DataType::STRING:
-            return lhs.as<std::string>() < rhs.as<std::string>();
+            return lhs.bytes == rhs.bytes;
         default:
         {
             misc::Logger::warn(
                 "Missing comparison operator for data token type " +
                 std::to_string(static_cast<int>(lhs.type))
             );
-            return lhs.bytes < rhs.bytes;
+            return lhs.bytes == rhs.bytes;
         }
         }
     }
 
+    bool
+    operator!=(const DataToken& lhs, const DataToken& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    bool
+    operator<(const DataToken& lhs, const DataToken& rhs)
+    {
+        return compare(lhs, rhs) < 0;
+    }
+
     bool
     operator<=(const DataToken& lhs, const DataToken& rhs)
     {
@@ -31,6 +31,11 @@ namespace types
     {
     }
 
+    StreamedResult::~StreamedResult()
+    {
+        executor_->close();
+    }
+
     bool
     StreamedResult::next(DataRow& out)
     {
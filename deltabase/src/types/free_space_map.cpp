@@ -0,0 +1,72 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "include/free_space_map.hpp"
+
+namespace types
+{
+    FreeSpaceMap::FreeSpaceMap(const TableId& table_id) : table_id(table_id)
+    {
+    }
+
+    void
+    FreeSpaceMap::set(const DataPageId& page_id, uint64_t free_bytes)
+    {
+        auto it = free_bytes_.find(page_id);
+        if (it != free_bytes_.end())
+        {
+            if (it->second == free_bytes)
+                return;
+
+            erase(page_id);
+        }
+
+        free_bytes_[page_id] = free_bytes;
+        by_free_.emplace(free_bytes, page_id);
+        dirty = true;
+    }
+
+    void
+    FreeSpaceMap::erase(const DataPageId& page_id)
+    {
+        auto it = free_bytes_.find(page_id);
+        if (it == free_bytes_.end())
+            return;
+
+        auto [first, last] = by_free_.equal_range(it->second);
+        for (auto entry = first; entry != last; ++entry)
+        {
+            if (entry->second == page_id)
+            {
+                by_free_.erase(entry);
+                break;
+            }
+        }
+
+        free_bytes_.erase(it);
+        dirty = true;
+    }
+
+    bool
+    FreeSpaceMap::contains(const DataPageId& page_id) const
+    {
+        return free_bytes_.contains(page_id);
+    }
+
+    std::optional<DataPageId>
+    FreeSpaceMap::find(uint64_t min_free) const
+    {
+        auto it = by_free_.lower_bound(min_free);
+        if (it == by_free_.end())
+            return std::nullopt;
+
+        return it->second;
+    }
+
+    const std::unordered_map<DataPageId, uint64_t>&
+    FreeSpaceMap::pages() const
+    {
+        return free_bytes_;
+    }
+} // namespace types
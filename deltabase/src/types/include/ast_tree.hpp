@@ -30,7 +30,10 @@ namespace types
         CREATE_INDEX,
         DROP_INDEX,
         ALTER_TABLE,
-        ADD_COLUMN
+        ADD_COLUMN,
+        BEGIN,
+        COMMIT,
+        ROLLBACK
     };
 
     enum class AstOperator
@@ -178,7 +181,7 @@ namespace types
         TableIdentifier table;
         SqlToken index_name;
         SqlToken column_name;
-        bool is_unique;
+        bool is_unique = false;
     };
 
     struct DropIndexStatement
@@ -53,6 +53,13 @@ namespace types
             Std = 1,
         };
 
+        enum class CachePolicyType : uint8_t
+        {
+            LRU = 1,
+            Clock,
+            TwoQueue,
+        };
+
     private:
         friend class engine::Engine;
 
@@ -92,8 +99,43 @@ namespace types
         PlannerType planner_type;
         SerializerType serializer_type;
 
+        // LSN of the last complete checkpoint record; recovery starts from it.
         LSN last_checkpoint_lsn = 0;
 
+        // Byte budgets of the buffer pool: cached data pages and cached index pages
+        // are charged against separate limits.
+        uint64_t buffer_pool_bytes = 64ull * 1024 * 1024;
+        uint64_t index_pool_bytes = 16ull * 1024 * 1024;
+
+        // Replacement policies of the two pools. Data pages default to scan-resistant
+        // 2Q so that sequential scans do not flush the hot set.
+        CachePolicyType buffer_pool_policy = CachePolicyType::TwoQueue;
+        CachePolicyType index_pool_policy = CachePolicyType::Clock;
+
+        // Background page writer: how often it wakes up, the share of the data page
+        // budget allowed to stay dirty, and how long a frame may stay dirty at most.
+        uint32_t page_writer_interval_ms = 200;
+        uint32_t page_writer_dirty_percent = 10;
+        uint32_t page_writer_max_dirty_age_ms = 5000;
+
+        // WAL group commit: how long a flush leader may wait for more committers when
+        // others are already waiting, and how many pending records end the wait early.
+        uint32_t wal_commit_delay_us = 0;
+        uint32_t wal_group_commit_records = 64;
+
+        // Size of a WAL segment file. Segments are preallocated to this size and
+        // recycled once a checkpoint no longer needs them.
+        uint64_t wal_segment_bytes = 16ull * 1024 * 1024;
+
+        // How often the checkpointer flushes the pool, logs a checkpoint and drops WAL
+        // segments that recovery no longer needs. Bounds the redo work after a crash.
+        uint32_t checkpoint_interval_ms = 30000;
+
+        // CREATE INDEX: how full the bulk loader packs index pages, and how many bytes of
+        // keys it sorts in memory before spilling sorted runs to disk.
+        uint32_t index_fill_percent = 90;
+        uint64_t index_build_bytes = 64ull * 1024 * 1024;
+
         static Config
         detached()
         {
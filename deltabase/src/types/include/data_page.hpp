@@ -7,32 +7,43 @@
 #include "UUID.hpp"
 #include "data_row.hpp"
 #include "page_id.hpp"
+#include "row_view.hpp"
 #include "typedefs.hpp"
 
 #include <filesystem>
+#include <optional>
 
 namespace types
 {
     using LSN = uint64_t;
 
+    // A slotted page. The body is a fixed buffer: the slot directory grows from its
+    // start, the encoded rows (see RowView) grow down from its end, and the free space
+    // lies in between. Rows are read in place and never move once written.
     struct DataPage
     {
         static constexpr uint64_t MAX_SIZE = 32 * 1024; // 32 kB
         static constexpr uint64_t HEADER_SIZE =
-            sizeof(uuid_t) * 3 + sizeof(RowId) * 2 + sizeof(uint64_t) + sizeof(LSN);
+            sizeof(uuid_t) * 3 + sizeof(RowId) * 2 + sizeof(LSN) + sizeof(uint16_t) * 2;
+        static constexpr uint64_t BODY_SIZE = MAX_SIZE - HEADER_SIZE;
+        // Offset and length of a row in the body.
+        static constexpr uint64_t SLOT_SIZE = sizeof(uint16_t) * 2;
 
         DataPageId id;
         DataPageId next;
         UUID table_id;
         RowId min_rid = 0;
         RowId max_rid = 0;
-        uint64_t rows_count = 0;
         LSN last_lsn = 0;
 
-        uint64_t size; //     |
-        fs::path path; //     | do not serialize
+        uint16_t slot_count = 0;
+        // Start of the lowest row in the body.
+        uint16_t rows_start = BODY_SIZE;
 
-        std::vector<DataRow> rows;
+        uint64_t size = HEADER_SIZE; //     | bytes in use, derived from the slots
+        fs::path path;               //     | do not serialize
+
+        Bytes body = Bytes(BODY_SIZE);
 
         DataPage() = default;
 
@@ -43,11 +54,34 @@ namespace types
             page.id = page_id;
             page.next = DataPageId::null();
             page.table_id = table_id;
-            page.size = HEADER_SIZE;
             page.path = base_path / page.id.to_string();
             return page;
         }
+
+        // Bytes a row takes on a page, its slot included.
+        static uint64_t
+        row_size(const DataRow& row);
+
+        RowView
+        row(size_t slot) const;
+
+        std::optional<size_t>
+        find(RowId row_id) const;
+
+        // Throws if the row does not fit; check size + row_size(row) <= MAX_SIZE first.
+        void
+        append(const DataRow& row);
+
+        void
+        set_flags(size_t slot, DataRowFlags flags);
+
+        void
+        set_deleted_by(size_t slot, LSN deleted_by);
+
+        // Recomputes size from the slot directory, after the body was read.
+        void
+        update_size();
     };
 } // namespace types
 
-#endif // DELTABASE_DATA_PAGE_HPP
\ No newline at end of file
+#endif // DELTABASE_DATA_PAGE_HPP
@@ -59,11 +59,16 @@ namespace types
     }
 
     using RowId = uint64_t;
+    using LSN = uint64_t;
 
     struct DataRow
     {
         RowId id{};
         DataRowFlags flags{};
+        // The transactions that created and deleted this version, named by the LSN of
+        // their begin record; deleted_by is 0 while the version is current.
+        LSN created_by = 0;
+        LSN deleted_by = 0;
         std::vector<DataToken> tokens;
 
         DataRow() = default;
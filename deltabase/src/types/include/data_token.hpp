@@ -77,6 +77,11 @@ namespace types
         }
     };
 
+    // Three-way comparison in the order of operator<: negative, zero or positive.
+    // Compares the stored bytes in place, so it does not allocate.
+    int
+    compare(const DataToken& lhs, const DataToken& rhs);
+
     bool
     operator==(const DataToken& lhs, const DataToken& rhs);
 
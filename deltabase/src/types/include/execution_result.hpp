@@ -38,6 +38,7 @@ namespace types
         output_schema() override;
     };
 
+    // Hands out the rows of an executor that is already open, and closes it when destroyed.
     class StreamedResult final : public IExecutionResult
     {
         std::unique_ptr<exq::INodeExecutor> executor_;
@@ -45,6 +46,8 @@ namespace types
     public:
         StreamedResult(std::unique_ptr<exq::INodeExecutor>&& executor);
 
+        ~StreamedResult() override;
+
         bool
         next(DataRow& out) override;
 
@@ -0,0 +1,53 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#ifndef DELTABASE_FREE_SPACE_MAP_HPP
+#define DELTABASE_FREE_SPACE_MAP_HPP
+#include "page_id.hpp"
+#include "table_id.hpp"
+
+#include <map>
+#include <optional>
+#include <unordered_map>
+
+namespace types
+{
+    // Free bytes of every data page of a table, the first page of its chain, where
+    // scans start, and the page new pages are chained after. It is only a hint: it is
+    // not logged, so callers check the page itself before using the space it reports.
+    struct FreeSpaceMap
+    {
+        TableId table_id;
+        DataPageId head = DataPageId::null();
+        DataPageId tail = DataPageId::null();
+        // Set whenever the map changes, cleared once it is written.
+        bool dirty = false;
+
+        FreeSpaceMap() = default;
+        explicit FreeSpaceMap(const TableId& table_id);
+
+        // Records how many bytes are free on a page.
+        void
+        set(const DataPageId& page_id, uint64_t free_bytes);
+
+        void
+        erase(const DataPageId& page_id);
+
+        bool
+        contains(const DataPageId& page_id) const;
+
+        // The page with the least free space that still has at least min_free bytes.
+        std::optional<DataPageId>
+        find(uint64_t min_free) const;
+
+        const std::unordered_map<DataPageId, uint64_t>&
+        pages() const;
+
+    private:
+        std::multimap<uint64_t, DataPageId> by_free_;
+        std::unordered_map<DataPageId, uint64_t> free_bytes_;
+    };
+} // namespace types
+
+#endif // DELTABASE_FREE_SPACE_MAP_HPP
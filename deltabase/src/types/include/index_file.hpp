@@ -9,13 +9,14 @@
 
 namespace types
 {
+    // Header block of an index file. The pages themselves are buffered one by one.
     struct IndexFile
     {
         IndexId index_id;
         IndexPageId root_page = 0;
         IndexPageId last_page = 0;
-        LSN last_lsn = 0;
-        std::vector<IndexPage> pages;
+        // Set when the header changed since it was last written.
+        bool dirty = false;
     };
 }
 
@@ -8,12 +8,19 @@
 #include "data_token.hpp"
 #include "meta_index.hpp"
 
+#include <functional>
+
 namespace types
 {
     using IndexPageId = uint64_t;
     using RowPtr = std::pair<DataPageId, RowId>;
+    using LSN = uint64_t;
 
+    // Index files are split into blocks of this size: the header in block 0 and page
+    // id N in block N.
     constexpr uint64_t MAX_IP_SIZE = 4 * 1024;
+    // Longest key an index accepts, so that splitting a full page leaves room in both halves.
+    constexpr uint64_t MAX_IP_KEY_SIZE = MAX_IP_SIZE / 8;
 
     struct InternalIndexNode
     {
@@ -34,9 +41,32 @@ namespace types
         IndexPageId parent;
         IndexId index_id;
         bool is_leaf;
+        LSN last_lsn = 0;
 
         std::variant<InternalIndexNode, LeafIndexNode> data;
     };
+
+    // Identifies a buffered page among the pages of every index.
+    struct IndexPageKey
+    {
+        IndexId index_id;
+        IndexPageId page_id = 0;
+
+        bool
+        operator==(const IndexPageKey& other) const = default;
+    };
 } // namespace types
 
+namespace std
+{
+    template <> struct hash<types::IndexPageKey>
+    {
+        size_t
+        operator()(const types::IndexPageKey& key) const noexcept
+        {
+            return std::hash<types::UUID>{}(key.index_id) ^ (std::hash<uint64_t>{}(key.page_id) << 1);
+        }
+    };
+} // namespace std
+
 #endif // DELTABASE_INDEX_PAGE_HPP
@@ -0,0 +1,118 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#ifndef DELTABASE_ROW_VIEW_HPP
+#define DELTABASE_ROW_VIEW_HPP
+#include "data_row.hpp"
+
+#include <span>
+#include <string_view>
+
+namespace types
+{
+    // A value read in place from a page; valid as long as the page is pinned.
+    struct TokenView
+    {
+        DataType type = DataType::_NULL;
+        std::span<const uint8_t> bytes;
+
+        TokenView() = default;
+        TokenView(DataType type, std::span<const uint8_t> bytes);
+        TokenView(const DataToken& token);
+
+        int
+        as_int() const;
+
+        double
+        as_real() const;
+
+        bool
+        as_bool() const;
+
+        char
+        as_char() const;
+
+        std::string_view
+        as_string() const;
+
+        DataToken
+        to_token() const;
+    };
+
+    // A row as it is stored in a data page:
+    //
+    //   RowId id | uint8 flags | uint8 reserved | uint16 columns n
+    //   LSN created_by | LSN deleted_by
+    //   null bitmap, (n + 7) / 8 bytes
+    //   uint8 type of every column
+    //   uint16 end of every value, counted from the start of the values
+    //   values: INTEGER 4, REAL 8, BOOL 1, CHAR 1 bytes, STRING its bytes
+    //
+    // so any column is found without decoding the ones before it.
+    class RowView
+    {
+        const uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+
+        size_t
+        types_offset() const;
+
+        size_t
+        ends_offset() const;
+
+        size_t
+        values_offset() const;
+
+        uint16_t
+        value_end(size_t column) const;
+
+    public:
+        static constexpr size_t FLAGS_OFFSET = sizeof(RowId);
+        static constexpr size_t COUNT_OFFSET = FLAGS_OFFSET + 2;
+        static constexpr size_t CREATED_BY_OFFSET = COUNT_OFFSET + sizeof(uint16_t);
+        static constexpr size_t DELETED_BY_OFFSET = CREATED_BY_OFFSET + sizeof(LSN);
+        static constexpr size_t HEADER_SIZE = DELETED_BY_OFFSET + sizeof(LSN);
+
+        RowView() = default;
+        RowView(const uint8_t* data, size_t size);
+
+        RowId
+        id() const;
+
+        DataRowFlags
+        flags() const;
+
+        LSN
+        created_by() const;
+
+        LSN
+        deleted_by() const;
+
+        size_t
+        column_count() const;
+
+        bool
+        is_null(size_t column) const;
+
+        TokenView
+        token(size_t column) const;
+
+        DataRow
+        to_row() const;
+
+        // Decodes into an existing row, reusing the buffers it already holds.
+        void
+        to_row(DataRow& out) const;
+
+        // Bytes the row takes once encoded.
+        static size_t
+        encoded_size(const DataRow& row);
+
+        // Writes the row to out, which must hold encoded_size(row) bytes.
+        static void
+        encode(const DataRow& row, uint8_t* out);
+    };
+} // namespace types
+
+#endif // DELTABASE_ROW_VIEW_HPP
@@ -5,6 +5,7 @@
 #ifndef DELTABASE_SCAN_CURSOR_HPP
 #define DELTABASE_SCAN_CURSOR_HPP
 #include "meta_table.hpp"
+#include "snapshot.hpp"
 
 namespace types
 {
@@ -15,6 +16,9 @@ namespace types
         int chunk_size;
 
         bool initialized;
+
+        // Rows are returned as the snapshot sees them.
+        Snapshot snapshot;
     };
 }
 
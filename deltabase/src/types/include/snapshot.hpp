@@ -0,0 +1,35 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#ifndef DELTABASE_SNAPSHOT_HPP
+#define DELTABASE_SNAPSHOT_HPP
+#include "row_view.hpp"
+
+#include <vector>
+
+namespace types
+{
+    // The row versions a reader sees: those of transactions that had committed when the
+    // snapshot was taken, and those of the reader's own. Transactions are named by the
+    // LSN of their begin record, which grows with every transaction that begins.
+    struct Snapshot
+    {
+        // The reader's own transaction, or 0 for a reader outside of any.
+        LSN own = 0;
+        // Transactions that begin at or after it are not seen.
+        LSN horizon = 0;
+        // Transactions that began before the horizon but had not committed, sorted.
+        std::vector<LSN> in_progress;
+
+        bool
+        sees(LSN txn) const;
+
+        // A version is visible once its creator is seen, until its deleter is. A version
+        // marked obsolete with no deleter was rolled back and is seen by no one.
+        bool
+        is_visible(const RowView& row) const;
+    };
+} // namespace types
+
+#endif // DELTABASE_SNAPSHOT_HPP
@@ -56,7 +56,10 @@ namespace types
         IS,
         ALTER,
         ADD,
-        COLUMN
+        COLUMN,
+        BEGIN,
+        COMMIT,
+        ROLLBACK
     };
 
     enum class SqlSymbol
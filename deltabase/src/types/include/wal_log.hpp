@@ -12,6 +12,7 @@
 #include <cstdint>
 #include <utility>
 #include <variant>
+#include <vector>
 
 namespace types
 {
@@ -43,7 +44,13 @@ namespace types
         CREATE_INDEX,
         CLR_CREATE_INDEX,
         DROP_INDEX,
-        CLR_DROP_INDEX
+        CLR_DROP_INDEX,
+        CHECKPOINT,
+        TABLE_COUNTERS,
+        CLR_TABLE_COUNTERS,
+        INSERT_ROWS,
+        CLR_INSERT_ROWS,
+        LINK_PAGE
     };
 
     namespace detail
@@ -103,6 +110,39 @@ namespace types
         }
     };
 
+    // Rows appended to one data page by a single multi-row insert.
+    struct InsertRowsRecord
+    {
+        static constexpr auto type = WALRecordType::INSERT_ROWS;
+
+        LSN lsn = 0;
+        LSN prev_lsn = 0;
+        UUID txn_id = UUID::null();
+
+        UUID table_id;
+        DataPageId page_id;
+        std::vector<DataRow> after;
+
+        InsertRowsRecord() = default;
+        InsertRowsRecord(const UUID& table_id, const DataPageId& page_id, std::vector<DataRow> after)
+            : table_id(table_id), page_id(page_id), after(std::move(after))
+        {
+        }
+
+        InsertRowsRecord(
+            LSN lsn,
+            LSN prev_lsn,
+            const UUID& txn_id,
+            const UUID& table_id,
+            const DataPageId& page_id,
+            std::vector<DataRow> after
+        )
+            : lsn(lsn), prev_lsn(prev_lsn), txn_id(txn_id), table_id(table_id), page_id(page_id),
+              after(std::move(after))
+        {
+        }
+    };
+
     struct UpdateRecord
     {
         static constexpr auto type = WALRecordType::UPDATE;
@@ -199,6 +239,36 @@ namespace types
         }
     };
 
+    // Undoing a multi-row insert only marks the rows obsolete, so their ids are enough.
+    struct CLRInsertRowsRecord
+    {
+        static constexpr auto type = WALRecordType::CLR_INSERT_ROWS;
+
+        LSN lsn;
+        LSN prev_lsn;
+        UUID txn_id;
+        UUID table_id;
+        DataPageId page_id;
+        LSN undo_next_lsn;
+        std::vector<RowId> row_ids;
+
+        CLRInsertRowsRecord() = default;
+
+        CLRInsertRowsRecord(
+            LSN lsn,
+            LSN prev_lsn,
+            const UUID& txn_id,
+            const UUID& table_id,
+            const DataPageId& page_id,
+            LSN undo_next_lsn,
+            std::vector<RowId> row_ids
+        )
+            : lsn(lsn), prev_lsn(prev_lsn), txn_id(txn_id), table_id(table_id), page_id(page_id),
+              undo_next_lsn(undo_next_lsn), row_ids(std::move(row_ids))
+        {
+        }
+    };
+
     struct CLRUpdateRecord
     {
         static constexpr auto type = WALRecordType::CLR_UPDATE;
@@ -657,10 +727,138 @@ namespace types
         }
     };
 
+    // Row counters of a table changed by one statement. Redo sets the resulting values,
+    // undo subtracts the deltas; last_rid is a high-water mark and is never lowered, so
+    // row ids handed out to other transactions are not reused.
+    struct TableCountersRecord
+    {
+        static constexpr auto type = WALRecordType::TABLE_COUNTERS;
+
+        LSN lsn = 0;
+        LSN prev_lsn = 0;
+        UUID txn_id = UUID::null();
+
+        TableId table_id;
+        RowId last_rid = 0;
+        int64_t total_rows_delta = 0;
+        int64_t live_rows_delta = 0;
+        uint64_t total_rows = 0;
+        uint64_t live_rows = 0;
+
+        TableCountersRecord() = default;
+        TableCountersRecord(
+            const MetaTable& after, int64_t total_rows_delta, int64_t live_rows_delta
+        )
+            : table_id(after.id), last_rid(after.last_rid), total_rows_delta(total_rows_delta),
+              live_rows_delta(live_rows_delta), total_rows(after.total_rows),
+              live_rows(after.live_rows)
+        {
+        }
+
+        TableCountersRecord(
+            LSN lsn,
+            LSN prev_lsn,
+            const UUID& txn_id,
+            const TableId& table_id,
+            RowId last_rid,
+            int64_t total_rows_delta,
+            int64_t live_rows_delta,
+            uint64_t total_rows,
+            uint64_t live_rows
+        )
+            : lsn(lsn), prev_lsn(prev_lsn), txn_id(txn_id), table_id(table_id),
+              last_rid(last_rid), total_rows_delta(total_rows_delta),
+              live_rows_delta(live_rows_delta), total_rows(total_rows), live_rows(live_rows)
+        {
+        }
+    };
+
+    // Carries the counters as they were after the undo, so that redoing it is idempotent.
+    struct CLRTableCountersRecord
+    {
+        static constexpr auto type = WALRecordType::CLR_TABLE_COUNTERS;
+
+        LSN lsn;
+        LSN prev_lsn;
+        UUID txn_id;
+
+        LSN undo_next_lsn;
+        TableId table_id;
+        uint64_t total_rows;
+        uint64_t live_rows;
+
+        CLRTableCountersRecord() = default;
+        CLRTableCountersRecord(
+            LSN lsn,
+            LSN prev_lsn,
+            const UUID& txn_id,
+            LSN undo_next_lsn,
+            const TableId& table_id,
+            uint64_t total_rows,
+            uint64_t live_rows
+        )
+            : lsn(lsn), prev_lsn(prev_lsn), txn_id(txn_id), undo_next_lsn(undo_next_lsn),
+              table_id(table_id), total_rows(total_rows), live_rows(live_rows)
+        {
+        }
+    };
+
+    // Chains a new data page after the last page of a table. Logged outside of any
+    // transaction and always redone: rows that later transactions put into the new
+    // page depend on the link even when the transaction that created it rolls back.
+    struct LinkPageRecord
+    {
+        static constexpr auto type = WALRecordType::LINK_PAGE;
+
+        LSN lsn = 0;
+        LSN prev_lsn = 0;
+        UUID txn_id = UUID::null();
+
+        TableId table_id;
+        DataPageId page_id;
+        DataPageId next_page_id;
+
+        LinkPageRecord() = default;
+        LinkPageRecord(const TableId& table_id, const DataPageId& page_id, const DataPageId& next_page_id)
+            : table_id(table_id), page_id(page_id), next_page_id(next_page_id)
+        {
+        }
+    };
+
+    // Written by the checkpointer once every change older than redo_lsn is on disk.
+    // Carries the transactions that were active at redo_lsn (with their last LSN) and
+    // the data pages that were still dirty when the record was appended.
+    struct CheckpointRecord
+    {
+        static constexpr auto type = WALRecordType::CHECKPOINT;
+
+        LSN lsn = 0;
+        LSN prev_lsn = 0;
+        UUID txn_id = UUID::null();
+
+        LSN redo_lsn = 0;
+        std::vector<std::pair<UUID, LSN>> active_txns;
+        std::vector<DataPageId> dirty_pages;
+
+        CheckpointRecord() = default;
+        CheckpointRecord(
+            LSN redo_lsn,
+            std::vector<std::pair<UUID, LSN>> active_txns,
+            std::vector<DataPageId> dirty_pages
+        )
+            : redo_lsn(redo_lsn), active_txns(std::move(active_txns)),
+              dirty_pages(std::move(dirty_pages))
+        {
+        }
+    };
+
     using WALRecord = detail::WALRecordVariant<
         InsertRecord,
         CLRInsertRecord,
 
+        InsertRowsRecord,
+        CLRInsertRowsRecord,
+
         UpdateRecord,
         CLRUpdateRecord,
 
@@ -691,15 +889,23 @@ namespace types
         DropIndexRecord,
         CLRDropIndexRecord,
 
+        TableCountersRecord,
+        CLRTableCountersRecord,
+
         BeginTxnRecord,
         CommitTxnRecord,
-        RollbackTxnRecord>;
+        RollbackTxnRecord,
+
+        LinkPageRecord,
+        CheckpointRecord>;
 
     using WALDataRecord = detail::WALRecordVariant<
         InsertRecord,
+        InsertRowsRecord,
         UpdateRecord,
         DeleteRecord,
         CLRInsertRecord,
+        CLRInsertRowsRecord,
         CLRUpdateRecord,
         CLRDeleteRecord>;
 
@@ -711,7 +917,8 @@ namespace types
         UpdateTableRecord,
         DeleteTableRecord,
         CreateIndexRecord,
-        DropIndexRecord>;
+        DropIndexRecord,
+        TableCountersRecord>;
 
     using WALMetaCLRRecord = detail::WALRecordVariant<
         CLRCreateSchemaRecord,
@@ -721,10 +928,12 @@ namespace types
         CLRUpdateTableRecord,
         CLRDeleteTableRecord,
         CLRCreateIndexRecord,
-        CLRDropIndexRecord>;
+        CLRDropIndexRecord,
+        CLRTableCountersRecord>;
 
     using WALCLRRecord = detail::WALRecordVariant<
         CLRInsertRecord,
+        CLRInsertRowsRecord,
         CLRUpdateRecord,
         CLRDeleteRecord,
         CLRCreateSchemaRecord,
@@ -734,7 +943,8 @@ namespace types
         CLRUpdateTableRecord,
         CLRDeleteTableRecord,
         CLRCreateIndexRecord,
-        CLRDropIndexRecord>;
+        CLRDropIndexRecord,
+        CLRTableCountersRecord>;
 
     using WALTxnRecord =
         detail::WALRecordVariant<BeginTxnRecord, CommitTxnRecord, RollbackTxnRecord>;
@@ -766,6 +976,7 @@ namespace types
                 []<typename TRecord>(const TRecord& rec) -> DataPageId
                 {
                     if constexpr (std::is_same_v<std::decay_t<TRecord>, InsertRecord> ||
+                                  std::is_same_v<std::decay_t<TRecord>, InsertRowsRecord> ||
                                   std::is_same_v<std::decay_t<TRecord>, UpdateRecord> ||
                                   std::is_same_v<std::decay_t<TRecord>, DeleteRecord>)
                     {
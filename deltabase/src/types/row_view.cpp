@@ -0,0 +1,240 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "include/row_view.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace types
+{
+    TokenView::TokenView(DataType type, std::span<const uint8_t> bytes) : type(type), bytes(bytes)
+    {
+    }
+
+    TokenView::TokenView(const DataToken& token) : type(token.type), bytes(token.bytes)
+    {
+    }
+
+    int
+    TokenView::as_int() const
+    {
+        int value = 0;
+        std::memcpy(&value, bytes.data(), std::min(bytes.size(), sizeof(value)));
+        return value;
+    }
+
+    double
+    TokenView::as_real() const
+    {
+        double value = 0;
+        std::memcpy(&value, bytes.data(), std::min(bytes.size(), sizeof(value)));
+        return value;
+    }
+
+    bool
+    TokenView::as_bool() const
+    {
+        return !bytes.empty() && bytes[0] != 0;
+    }
+
+    char
+    TokenView::as_char() const
+    {
+        return bytes.empty() ? '\0' : static_cast<char>(bytes[0]);
+    }
+
+    std::string_view
+    TokenView::as_string() const
+    {
+        return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+    }
+
+    DataToken
+    TokenView::to_token() const
+    {
+        return DataToken(Bytes(bytes.begin(), bytes.end()), type);
+    }
+
+    RowView::RowView(const uint8_t* data, size_t size) : data_(data), size_(size)
+    {
+    }
+
+    size_t
+    RowView::types_offset() const
+    {
+        return HEADER_SIZE + (column_count() + 7) / 8;
+    }
+
+    size_t
+    RowView::ends_offset() const
+    {
+        return types_offset() + column_count();
+    }
+
+    size_t
+    RowView::values_offset() const
+    {
+        return ends_offset() + column_count() * sizeof(uint16_t);
+    }
+
+    uint16_t
+    RowView::value_end(size_t column) const
+    {
+        uint16_t end;
+        std::memcpy(&end, data_ + ends_offset() + column * sizeof(uint16_t), sizeof(end));
+        return end;
+    }
+
+    RowId
+    RowView::id() const
+    {
+        RowId id;
+        std::memcpy(&id, data_, sizeof(id));
+        return id;
+    }
+
+    DataRowFlags
+    RowView::flags() const
+    {
+        return static_cast<DataRowFlags>(data_[FLAGS_OFFSET]);
+    }
+
+    LSN
+    RowView::created_by() const
+    {
+        LSN lsn;
+        std::memcpy(&lsn, data_ + CREATED_BY_OFFSET, sizeof(lsn));
+        return lsn;
+    }
+
+    LSN
+    RowView::deleted_by() const
+    {
+        LSN lsn;
+        std::memcpy(&lsn, data_ + DELETED_BY_OFFSET, sizeof(lsn));
+        return lsn;
+    }
+
+    size_t
+    RowView::column_count() const
+    {
+        uint16_t count;
+        std::memcpy(&count, data_ + COUNT_OFFSET, sizeof(count));
+        return count;
+    }
+
+    bool
+    RowView::is_null(size_t column) const
+    {
+        return (data_[HEADER_SIZE + column / 8] >> (column % 8)) & 1;
+    }
+
+    TokenView
+    RowView::token(size_t column) const
+    {
+        if (column >= column_count())
+            throw std::out_of_range("RowView::token: column out of range");
+
+        if (is_null(column))
+            return {};
+
+        const size_t begin = column == 0 ? 0 : value_end(column - 1);
+        const size_t end = value_end(column);
+        const auto type = static_cast<DataType>(data_[types_offset() + column]);
+        return {type, {data_ + values_offset() + begin, end - begin}};
+    }
+
+    DataRow
+    RowView::to_row() const
+    {
+        DataRow row;
+        to_row(row);
+        return row;
+    }
+
+    void
+    RowView::to_row(DataRow& out) const
+    {
+        out.id = id();
+        out.flags = flags();
+        out.created_by = created_by();
+        out.deleted_by = deleted_by();
+
+        const size_t count = column_count();
+        out.tokens.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto& token = out.tokens[i];
+            if (is_null(i))
+            {
+                token.type = DataType::_NULL;
+                token.bytes.clear();
+                continue;
+            }
+
+            const auto view = this->token(i);
+            token.type = view.type;
+            token.bytes.assign(view.bytes.begin(), view.bytes.end());
+        }
+    }
+
+    size_t
+    RowView::encoded_size(const DataRow& row)
+    {
+        const size_t count = row.tokens.size();
+        size_t size = HEADER_SIZE + (count + 7) / 8 + count + count * sizeof(uint16_t);
+        for (const auto& token : row.tokens)
+        {
+            if (token.type != DataType::_NULL)
+                size += token.bytes.size();
+        }
+
+        return size;
+    }
+
+    void
+    RowView::encode(const DataRow& row, uint8_t* out)
+    {
+        const size_t count = row.tokens.size();
+        if (count > std::numeric_limits<uint16_t>::max())
+            throw std::runtime_error("RowView::encode: too many columns");
+
+        std::memset(out, 0, HEADER_SIZE + (count + 7) / 8);
+        std::memcpy(out, &row.id, sizeof(row.id));
+        out[FLAGS_OFFSET] = static_cast<uint8_t>(row.flags);
+        const auto count16 = static_cast<uint16_t>(count);
+        std::memcpy(out + COUNT_OFFSET, &count16, sizeof(count16));
+        std::memcpy(out + CREATED_BY_OFFSET, &row.created_by, sizeof(row.created_by));
+        std::memcpy(out + DELETED_BY_OFFSET, &row.deleted_by, sizeof(row.deleted_by));
+
+        uint8_t* bitmap = out + HEADER_SIZE;
+        uint8_t* types = bitmap + (count + 7) / 8;
+        uint8_t* ends = types + count;
+        uint8_t* values = ends + count * sizeof(uint16_t);
+
+        size_t end = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto& token = row.tokens[i];
+            types[i] = static_cast<uint8_t>(token.type);
+
+            if (token.type == DataType::_NULL)
+                bitmap[i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+            else
+            {
+                std::memcpy(values + end, token.bytes.data(), token.bytes.size());
+                end += token.bytes.size();
+            }
+
+            if (end > std::numeric_limits<uint16_t>::max())
+                throw std::runtime_error("RowView::encode: row is too large");
+
+            const auto end16 = static_cast<uint16_t>(end);
+            std::memcpy(ends + i * sizeof(uint16_t), &end16, sizeof(end16));
+        }
+    }
+} // namespace types
@@ -0,0 +1,32 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "include/snapshot.hpp"
+
+#include <algorithm>
+
+namespace types
+{
+    bool
+    Snapshot::sees(LSN txn) const
+    {
+        if (txn == own)
+            return true;
+
+        return txn < horizon && !std::binary_search(in_progress.begin(), in_progress.end(), txn);
+    }
+
+    bool
+    Snapshot::is_visible(const RowView& row) const
+    {
+        if (!sees(row.created_by()))
+            return false;
+
+        const LSN deleted_by = row.deleted_by();
+        if (deleted_by == 0)
+            return (row.flags() & DataRowFlags::OBSOLETE) == DataRowFlags::NONE;
+
+        return !sees(deleted_by);
+    }
+} // namespace types
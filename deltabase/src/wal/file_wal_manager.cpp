@@ -6,12 +6,19 @@
 
 #include "include/wal_serializer_factory.hpp"
 #include "path.hpp"
+#include "../misc/include/utils.hpp"
 
 #include <algorithm>
+#include <cerrno>
+#include <climits>
 #include <fcntl.h>
 #include <fstream>
+#include <optional>
+#include <ranges>
 #include <stdexcept>
 #include <string>
+#include <sys/uio.h>
+#include <unistd.h>
 
 namespace wal
 {
@@ -19,6 +26,151 @@ namespace wal
     using namespace misc;
     using DbGuard = std::lock_guard<storage::DatabaseIoLockService::Mutex>;
 
+    namespace
+    {
+        // Every segment starts with this header. A first_lsn of 0 marks a recycled segment
+        // waiting to be reused; whatever follows its header is stale.
+        struct SegmentHeader
+        {
+            uint64_t magic;
+            uint32_t version;
+            uint32_t reserved;
+            uint64_t first_lsn;
+        };
+
+        constexpr uint64_t SEGMENT_MAGIC = 0x4C41574244544C44; // "DLTDBWAL"
+        constexpr uint32_t SEGMENT_VERSION = 1;
+
+        // Records follow the header back to back as payload size, CRC-32 of the payload
+        // and payload. A zero size, a bad checksum or an out-of-sequence LSN ends the
+        // segment: the rest is preallocated space or left over from a previous use.
+        constexpr uint64_t RECORD_HEADER_SIZE = sizeof(uint64_t) + sizeof(uint32_t);
+
+        const std::string SEGMENT_EXTENSION = ".wal";
+
+        LSN
+        lsn_of(const WALRecord& record)
+        {
+            return std::visit([](const auto& rec) { return rec.lsn; }, record);
+        }
+
+        // Sidecar file holding the (lsn, offset) index of a sealed segment.
+        const std::string SEGMENT_INDEX_EXTENSION = ".idx";
+
+        fs::path
+        index_path_for(const fs::path& segment_path)
+        {
+            auto path = segment_path;
+            path += SEGMENT_INDEX_EXTENSION;
+            return path;
+        }
+
+        // name without suffix, or nothing if it does not end with it.
+        std::optional<std::string>
+        strip_suffix(const std::string& name, const std::string& suffix)
+        {
+            if (name.size() < suffix.size()
+                || name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+                return std::nullopt;
+
+            return name.substr(0, name.size() - suffix.size());
+        }
+
+        bool
+        is_all_digits(const std::string& value)
+        {
+            return !value.empty()
+                && std::ranges::all_of(value, [](char c) { return c >= '0' && c <= '9'; });
+        }
+
+        // Before segments, the WAL was a series of files named <first lsn>_<last lsn>, each
+        // holding up to 1000 records framed as payload size and payload, with no header.
+        bool
+        is_legacy_log_name(const std::string& name)
+        {
+            const auto underscore = name.find('_');
+            return underscore != std::string::npos
+                && is_all_digits(name.substr(0, underscore))
+                && is_all_digits(name.substr(underscore + 1));
+        }
+
+        // Sequence number of a segment file name, its digits followed by SEGMENT_EXTENSION,
+        // or nothing for any other name.
+        std::optional<uint64_t>
+        segment_seq_of(const std::string& name)
+        {
+            const auto digits = strip_suffix(name, SEGMENT_EXTENSION);
+            if (!digits || !is_all_digits(*digits))
+                return std::nullopt;
+
+            return std::stoull(*digits);
+        }
+
+        bool
+        is_segment_index_name(const std::string& name)
+        {
+            const auto segment = strip_suffix(name, SEGMENT_INDEX_EXTENSION);
+            return segment && segment_seq_of(*segment);
+        }
+
+        bool
+        read_segment_header(const fs::path& path, SegmentHeader& out)
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (!file.read(reinterpret_cast<char*>(&out), sizeof(out)))
+                return false;
+
+            return out.magic == SEGMENT_MAGIC && out.version == SEGMENT_VERSION;
+        }
+
+        void
+        write_segment_header(int fd, LSN first_lsn)
+        {
+            SegmentHeader header{SEGMENT_MAGIC, SEGMENT_VERSION, 0, first_lsn};
+            if (pwrite(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)))
+                throw std::runtime_error("FileWalManager: failed to write a segment header");
+        }
+
+        void
+        fsync_directory(const fs::path& dir)
+        {
+            int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+            if (dir_fd >= 0)
+            {
+                fsync(dir_fd);
+                close(dir_fd);
+            }
+        }
+
+        // writev() until every buffer is written, resuming after short writes.
+        void
+        write_fully(int fd, std::vector<iovec>& iov)
+        {
+            size_t idx = 0;
+            while (idx < iov.size())
+            {
+                const int count = static_cast<int>(std::min<size_t>(iov.size() - idx, IOV_MAX));
+                ssize_t written = writev(fd, iov.data() + idx, count);
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    throw std::runtime_error("FileWalManager::write_logs: writev failed");
+                }
+
+                auto left = static_cast<size_t>(written);
+                while (idx < iov.size() && left >= iov[idx].iov_len)
+                    left -= iov[idx++].iov_len;
+
+                if (left > 0)
+                {
+                    iov[idx].iov_base = static_cast<uint8_t*>(iov[idx].iov_base) + left;
+                    iov[idx].iov_len -= left;
+                }
+            }
+        }
+    } // namespace
+
     FileWalManager::FileWalManager(
         const fs::path& db_path,
         const std::string& db_name,
@@ -32,13 +184,18 @@ namespace wal
         const fs::path& db_path,
         const std::string& db_name,
         Config::SerializerType serializer_type,
-        std::shared_ptr<storage::DatabaseIoLockService> io_lock_service
+        std::shared_ptr<storage::DatabaseIoLockService> io_lock_service,
+        GroupCommit group_commit,
+        uint64_t segment_bytes
     )
         : db_path_(db_path),
           db_name_(db_name),
           next_lsn_(1),
           flushed_lsn_(0),
-          io_lock_service_(std::move(io_lock_service))
+          io_lock_service_(std::move(io_lock_service)),
+          group_commit_(group_commit),
+          segment_bytes_(std::max<uint64_t>(segment_bytes, sizeof(SegmentHeader))),
+          ring_(std::make_unique<Slot[]>(RING_SLOTS))
     {
         if (!io_lock_service_)
             io_lock_service_ = storage::DatabaseIoLockService::shared();
@@ -54,181 +211,463 @@ namespace wal
             fs::create_directories(wal_dir);
         }
 
-        // Ensure a first WAL file exists for an empty WAL directory.
-        if (fs::is_empty(wal_dir))
-        {
-            auto first_file_path =
-                storage::path_db_wal_logfile(db_path_, db_name_, 1, MAX_RECORDS_PER_LOGFILE);
-
-            int fd = open(first_file_path.c_str(), O_WRONLY | O_CREAT, 0644);
-            if (fd < 0)
-                throw std::runtime_error("Failed to create first WAL log file");
+        // The first segment is created by the first write.
+        load_segments();
+    }
 
-            close(fd);
-        }
+    FileWalManager::~FileWalManager()
+    {
+        if (fd_ >= 0)
+            close(fd_);
+    }
 
-        // Hydrate cache: load all existing WAL records into memory
-        hydrate_cache();
+    fs::path
+    FileWalManager::segment_path(uint64_t seq) const
+    {
+        return storage::path_db_wal_segment(db_path_, db_name_, seq);
     }
 
     void
-    FileWalManager::hydrate_cache()
+    FileWalManager::load_segments()
     {
+        DbGuard guard(*db_mutex_);
         auto dir = storage::path_db_wal(db_path_, db_name_);
 
-        // If directory is empty, nothing to hydrate
-        if (!fs::exists(dir) || fs::is_empty(dir))
-            return;
-
-        // Collect all log files and sort by first_lsn
-        std::vector<std::pair<uint64_t, fs::path>> log_files;
-
         for (const auto& entry : fs::directory_iterator(dir))
         {
-            if (!entry.is_regular_file())
-                continue;
+            const auto name = entry.path().filename().string();
+            const auto seq = entry.is_regular_file() ? segment_seq_of(name) : std::nullopt;
 
-            auto filename = entry.path().filename().string();
-            auto underscore_pos = filename.find('_');
-            if (underscore_pos == std::string::npos)
-                continue;
+            if (!seq)
+            {
+                if (entry.is_regular_file() && is_segment_index_name(name))
+                    continue;
+
+                // The records, and the pages they refer to, are in formats this version
+                // does not read, so the database cannot be recovered from them.
+                if (entry.is_regular_file() && is_legacy_log_name(name))
+                    throw std::runtime_error(
+                        "FileWalManager::load_segments: " + entry.path().string() +
+                        " is a WAL file of the layout used before segments. The database was "
+                        "created by an older version, whose WAL and page formats this one "
+                        "cannot read: export its data with that version and load it into a "
+                        "database created by this one"
+                    );
+
+                // Left by a crash in write_segment_index; the index is rebuilt when needed.
+                const auto unrenamed = strip_suffix(name, ".tmp");
+                if (entry.is_regular_file() && unrenamed && is_segment_index_name(*unrenamed))
+                {
+                    fs::remove(entry.path());
+                    continue;
+                }
+
+                // Skipping it could lose records without a word.
+                throw std::runtime_error(
+                    "FileWalManager::load_segments: " + entry.path().string() +
+                    " is neither a WAL segment nor a segment index"
+                );
+            }
 
-            uint64_t first_lsn = std::stoull(filename.substr(0, underscore_pos));
-            log_files.emplace_back(first_lsn, entry.path());
+            next_segment_seq_ = std::max(next_segment_seq_, *seq + 1);
+
+            SegmentHeader header{};
+            if (!read_segment_header(entry.path(), header))
+                throw std::runtime_error(
+                    "FileWalManager::load_segments: " + entry.path().string() +
+                    " is not a WAL segment"
+                );
+
+            if (header.first_lsn == 0)
+                spare_segments_.push_back(entry.path());
+            else
+                segments_[header.first_lsn] = entry.path();
         }
 
-        // Sort by LSN to read in correct order
-        std::sort(
-            log_files.begin(),
-            log_files.end(),
-            [](const auto& a, const auto& b) { return a.first < b.first; }
-        );
+        if (segments_.empty())
+            return;
 
-        // Read each file and populate flushed_ cache
-        for (const auto& [first_lsn, file_path] : log_files)
-        {
-            auto file_logs = read_logs_from_file(file_path);
-            flushed_.insert(flushed_.end(), file_logs.begin(), file_logs.end());
+        // Appending resumes in the newest segment, right after its last valid record;
+        // older segments are indexed lazily when read_log needs them.
+        active_first_lsn_ = segments_.rbegin()->first;
+        active_index_.clear();
+        read_logs_from_file(segments_.rbegin()->second, &active_index_, &active_end_);
+
+        next_lsn_ = active_first_lsn_ + active_index_.size();
+        flushed_lsn_ = next_lsn_ - 1;
+    }
 
-            // Update next_lsn to be after the last loaded record
-            for (const auto& record : file_logs)
+    const FileWalManager::SegmentIndex&
+    FileWalManager::segment_index(uint64_t first_lsn)
+    {
+        DbGuard guard(*db_mutex_);
+        if (first_lsn == active_first_lsn_)
+            return active_index_;
+
+        if (first_lsn == cached_first_lsn_)
+            return cached_index_;
+
+        auto it = segments_.find(first_lsn);
+        if (it == segments_.end())
+            throw std::runtime_error(
+                "FileWalManager::segment_index: no segment starts at LSN " +
+                std::to_string(first_lsn)
+            );
+
+        // Only segments followed by a newer one are sealed; the newest may still grow.
+        const bool sealed = std::next(it) != segments_.end();
+
+        SegmentIndex index;
+        bool loaded = false;
+
+        if (sealed)
+        {
+            std::ifstream file(index_path_for(it->second), std::ios::binary | std::ios::ate);
+            if (file.is_open())
             {
-                auto record_lsn = std::visit([](const auto& rec) { return rec.lsn; }, record);
-                if (record_lsn >= next_lsn_)
-                    next_lsn_ = record_lsn + 1;
+                const auto file_size = static_cast<size_t>(file.tellg());
+                const size_t entry_size = sizeof(SegmentIndex::value_type);
+                if (file_size > 0 && file_size % entry_size == 0)
+                {
+                    index.resize(file_size / entry_size);
+                    file.seekg(0);
+                    loaded = static_cast<bool>(
+                        file.read(reinterpret_cast<char*>(index.data()), file_size)
+                    );
+                }
             }
         }
 
-        // Trust record payload LSNs over filenames to keep correct logical order.
-        std::sort(
-            flushed_.begin(),
-            flushed_.end(),
-            [](const WALRecord& lhs, const WALRecord& rhs)
-            {
-                auto l_lsn = std::visit([](const auto& rec) { return rec.lsn; }, lhs);
-                auto r_lsn = std::visit([](const auto& rec) { return rec.lsn; }, rhs);
-                return l_lsn < r_lsn;
-            }
-        );
+        if (!loaded)
+        {
+            index.clear();
+            read_logs_from_file(it->second, &index);
+            if (sealed && !index.empty())
+                write_segment_index(it->second, index);
+        }
+
+        cached_first_lsn_ = first_lsn;
+        cached_index_ = std::move(index);
+        return cached_index_;
+    }
+
+    void
+    FileWalManager::write_segment_index(const fs::path& segment, const SegmentIndex& index) const
+    {
+        // Written to a temporary file and renamed, so a crash leaves either no index
+        // (rebuilt by scanning the segment) or a complete one.
+        const auto path = index_path_for(segment);
+        auto tmp_path = path;
+        tmp_path += ".tmp";
 
-        if (!flushed_.empty())
         {
-            flushed_lsn_ = std::visit([](const auto& rec) { return rec.lsn; }, flushed_.back());
+            std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+                return;
+
+            file.write(
+                reinterpret_cast<const char*>(index.data()),
+                static_cast<std::streamsize>(index.size() * sizeof(SegmentIndex::value_type))
+            );
+            if (!file)
+                return;
         }
+
+        fs::rename(tmp_path, path);
+    }
+
+    FileWalManager::Slot&
+    FileWalManager::slot_for(LSN lsn) const
+    {
+        return ring_[lsn % RING_SLOTS];
     }
 
     LSN
     FileWalManager::append_log(const WALRecord& record)
     {
-        DbGuard guard(*db_mutex_);
-        std::lock_guard lk(mtx_);
-        auto lsn = next_lsn_++;
+        // The record is copied before its LSN is taken, so nothing can fail between
+        // reserving an LSN and publishing it. Appenders share nothing but the counter.
+        WALRecord copy = record;
+        const LSN lsn = next_lsn_.fetch_add(1, std::memory_order_acq_rel);
 
-        auto record_with_lsn = std::visit(
-            [lsn](auto rec) -> WALRecord
-            {
-                rec.lsn = lsn;
-                return rec;
-            },
-            record
-        );
-
-        dirty_.push_back(record_with_lsn);
+        publish(lsn, std::move(copy));
         return lsn;
     }
 
     LSN
     FileWalManager::append_log(const std::vector<WALRecord>& records)
     {
-        DbGuard guard(*db_mutex_);
-        LSN last_lsn = 0;
-        for (const auto& record : records)
+        if (records.empty())
+            return 0;
+
+        std::vector<WALRecord> copies = records;
+        const LSN first = next_lsn_.fetch_add(copies.size(), std::memory_order_acq_rel);
+
+        // In LSN order: a batch larger than the ring waits for its own first records.
+        for (size_t i = 0; i < copies.size(); ++i)
+            publish(first + i, std::move(copies[i]));
+
+        return first + copies.size() - 1;
+    }
+
+    void
+    FileWalManager::publish(LSN lsn, WALRecord&& record)
+    {
+        // The slot still holds lsn - RING_SLOTS until that record is written. Nobody else
+        // may be flushing, so the appender pushes the log forward itself.
+        if (lsn > RING_SLOTS && flushed_lsn_.load(std::memory_order_acquire) < lsn - RING_SLOTS)
+            wait_for_durable(lsn - RING_SLOTS);
+
+        // Until ready_lsn says lsn, the flusher and readers leave the slot alone.
+        auto& slot = slot_for(lsn);
+        slot.record = std::move(record);
+        std::visit([lsn](auto& rec) { rec.lsn = lsn; }, slot.record);
+
+        slot.serialized = false;
+        try
         {
-            last_lsn = append_log(record);
+            slot.payload = serializer_->serialize(slot.record);
+            slot.size = slot.payload.size();
+            slot.checksum = misc::crc32(slot.payload.data(), slot.payload.size());
+            slot.serialized = true;
         }
+        catch (...)
+        {
+            // The flusher serializes it again and reports the failure.
+        }
+
+        slot.ready_lsn.store(lsn, std::memory_order_release);
+        slot.ready_lsn.notify_all();
 
-        return last_lsn;
+        // Lets a leader that is holding the batch open for followers stop waiting.
+        if (flush_in_progress_.load(std::memory_order_relaxed) &&
+            lsn - flushed_lsn_.load(std::memory_order_relaxed) >= group_commit_.batch_records)
+            cv_.notify_all();
+    }
+
+    void
+    FileWalManager::track_txn(std::unordered_map<UUID, ActiveTxn>& txns, const WALRecord& record)
+    {
+        std::visit(
+            [&txns](const auto& rec)
+            {
+                using R = std::decay_t<decltype(rec)>;
+
+                if constexpr (std::is_same_v<R, BeginTxnRecord>)
+                {
+                    txns[rec.txn_id] = ActiveTxn{rec.txn_id, rec.lsn, rec.lsn};
+                }
+                else if constexpr (std::is_same_v<R, CommitTxnRecord> ||
+                                   std::is_same_v<R, RollbackTxnRecord>)
+                {
+                    txns.erase(rec.txn_id);
+                }
+                else if (auto it = txns.find(rec.txn_id); it != txns.end())
+                {
+                    it->second.last_lsn = rec.lsn;
+                }
+            },
+            record
+        );
     }
 
     WALRecord
     FileWalManager::read_log(LSN lsn)
     {
-        DbGuard guard(*db_mutex_);
-        std::lock_guard lk(mtx_);
-
-        // Check dirty buffer first (most recent records)
-        for (const auto& record : dirty_)
+        while (true)
         {
-            auto record_lsn = std::visit([](const auto& rec) { return rec.lsn; }, record);
-            if (record_lsn == lsn)
-                return record;
-        }
+            std::unique_lock lk(mtx_);
 
-        // Check flushed cache (hydrated from disk at startup)
-        for (const auto& record : flushed_)
-        {
-            auto record_lsn = std::visit([](const auto& rec) { return rec.lsn; }, record);
-            if (record_lsn == lsn)
-                return record;
+            // Records past flushed_lsn_ stay in their slots while mtx_ is held, since only
+            // a flush under it frees them.
+            if (lsn > flushed_lsn_.load(std::memory_order_acquire) &&
+                lsn < next_lsn_.load(std::memory_order_acquire))
+            {
+                auto& slot = slot_for(lsn);
+                const LSN seen = slot.ready_lsn.load(std::memory_order_acquire);
+                if (seen == lsn)
+                    return slot.record;
+
+                // Reserved, but its appender is still filling the slot.
+                lk.unlock();
+                slot.ready_lsn.wait(seen, std::memory_order_acquire);
+                continue;
+            }
+
+            auto by_lsn = [](const WALRecord& record, LSN value) { return lsn_of(record) < value; };
+
+            auto tail_it = std::lower_bound(tail_.begin(), tail_.end(), lsn, by_lsn);
+            if (tail_it != tail_.end() && lsn_of(*tail_it) == lsn)
+                return *tail_it;
+
+            break;
         }
 
+        if (auto record = read_log_from_disk(lsn))
+            return std::move(*record);
+
         // Not found - record doesn't exist
         throw std::runtime_error("WAL record not found: LSN " + std::to_string(lsn));
     }
 
+    std::optional<WALRecord>
+    FileWalManager::read_log_from_disk(LSN lsn)
+    {
+        DbGuard guard(*db_mutex_);
+
+        auto segment_it = segments_.upper_bound(lsn);
+        if (segment_it == segments_.begin())
+            return std::nullopt;
+        --segment_it;
+
+        const auto& index = segment_index(segment_it->first);
+        auto entry = std::lower_bound(
+            index.begin(),
+            index.end(),
+            lsn,
+            [](const auto& indexed, LSN value) { return indexed.first < value; }
+        );
+        if (entry == index.end() || entry->first != lsn)
+            return std::nullopt;
+
+        std::ifstream file(segment_it->second, std::ios::binary);
+        if (!file.is_open())
+            return std::nullopt;
+
+        uint64_t record_size = 0;
+        uint32_t checksum = 0;
+        file.seekg(static_cast<std::streamoff>(entry->second));
+        if (!file.read(reinterpret_cast<char*>(&record_size), sizeof(record_size)) ||
+            !file.read(reinterpret_cast<char*>(&checksum), sizeof(checksum)))
+            return std::nullopt;
+
+        std::vector<uint8_t> buffer(record_size);
+        if (!file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(record_size)))
+            return std::nullopt;
+
+        if (misc::crc32(buffer.data(), buffer.size()) != checksum)
+            throw std::runtime_error(
+                "FileWalManager::read_log: checksum mismatch at LSN " + std::to_string(lsn)
+            );
+
+        ReadOnlyMemoryStream stream(buffer);
+        WALRecord record;
+        if (!serializer_->deserialize(stream, record))
+            throw std::runtime_error("FileWalManager::read_log: failed to deserialize a record");
+
+        return record;
+    }
+
     void
     FileWalManager::wait_for_durable(LSN lsn)
     {
-        DbGuard guard(*db_mutex_);
         std::unique_lock lk(mtx_);
-        while (flushed_lsn_ < lsn)
+        lsn = std::min(lsn, next_lsn_.load(std::memory_order_acquire) - 1);
+
+        ++committers_;
+        try
         {
-            if (!flush_in_progress_)
+            while (flushed_lsn_ < lsn)
             {
-                flush_in_progress_ = true;
+                if (!flush_in_progress_)
+                    flush_as_leader(lk);
+                else
+                    cv_.wait(lk, [&] { return !flush_in_progress_ || flushed_lsn_ >= lsn; });
+            }
+        }
+        catch (...)
+        {
+            --committers_;
+            throw;
+        }
+        --committers_;
+    }
 
-                lk.unlock();
-                try
-                {
-                    flush();
-                }
-                catch (...)
+    void
+    FileWalManager::flush_as_leader(std::unique_lock<std::mutex>& lk)
+    {
+        flush_in_progress_ = true;
+
+        // Only worth delaying when somebody else is committing too.
+        if (group_commit_.delay.count() > 0 && committers_ > 1)
+        {
+            cv_.wait_for(
+                lk,
+                group_commit_.delay,
+                [this]
                 {
-                    lk.lock();
-                    flush_in_progress_ = false;
-                    cv_.notify_all();
-                    throw;
+                    return next_lsn_.load(std::memory_order_acquire) - 1 - flushed_lsn_ >=
+                           group_commit_.batch_records;
                 }
-                lk.lock();
+            );
+        }
 
-                flush_in_progress_ = false;
-                cv_.notify_all();
-            }
-            else
+        // Records go out in LSN order, so the batch ends at the first one its appender is
+        // still filling. Only the leader frees slots, so those it takes stay put.
+        std::vector<Slot*> batch;
+        while (true)
+        {
+            const LSN end = next_lsn_.load(std::memory_order_acquire);
+            LSN lsn = flushed_lsn_ + 1;
+            for (; lsn < end; ++lsn)
             {
-                cv_.wait(lk, [&] { return !flush_in_progress_ || flushed_lsn_ >= lsn; });
+                auto& slot = slot_for(lsn);
+                if (slot.ready_lsn.load(std::memory_order_acquire) != lsn)
+                    break;
+                batch.push_back(&slot);
             }
+
+            if (!batch.empty() || lsn == end)
+                break;
+
+            auto& oldest = slot_for(lsn);
+            lk.unlock();
+            for (LSN seen = oldest.ready_lsn.load(std::memory_order_acquire); seen != lsn;
+                 seen = oldest.ready_lsn.load(std::memory_order_acquire))
+                oldest.ready_lsn.wait(seen, std::memory_order_acquire);
+            lk.lock();
         }
+
+        size_t durable = 0;
+        lk.unlock();
+        try
+        {
+            if (!batch.empty())
+                write_logs(batch, durable);
+        }
+        catch (...)
+        {
+            // Records that did reach the disk must not be written a second time.
+            lk.lock();
+            if (durable > 0)
+                retire(lsn_of(batch[durable - 1]->record));
+            flush_in_progress_ = false;
+            cv_.notify_all();
+            throw;
+        }
+        lk.lock();
+
+        if (!batch.empty())
+            retire(lsn_of(batch.back()->record));
+
+        flush_in_progress_ = false;
+        cv_.notify_all();
+    }
+
+    void
+    FileWalManager::retire(LSN lsn)
+    {
+        for (LSN next = flushed_lsn_ + 1; next <= lsn; ++next)
+        {
+            auto& slot = slot_for(next);
+            track_txn(active_txns_, slot.record);
+            tail_.push_back(std::move(slot.record));
+        }
+        while (tail_.size() > MAX_TAIL_RECORDS)
+            tail_.pop_front();
+
+        // Frees the slots for the appenders waiting on them.
+        flushed_lsn_.store(lsn, std::memory_order_release);
     }
 
     void
@@ -240,120 +679,367 @@ namespace wal
     void
     FileWalManager::flush()
     {
-        DbGuard guard(*db_mutex_);
-        std::vector<WALRecord> to_flush;
-        {
-            std::lock_guard lk(mtx_);
-            if (dirty_.empty())
-                return;
-
-            to_flush.swap(dirty_);
-        }
-
-        write_logs(to_flush);
-
-        auto batch_max_lsn = std::visit([](const auto& rec) { return rec.lsn; }, to_flush.back());
-
-        std::lock_guard lk(mtx_);
-        flushed_.insert(flushed_.end(), to_flush.begin(), to_flush.end());
-        if (batch_max_lsn > flushed_lsn_)
-            flushed_lsn_ = batch_max_lsn;
+        // Joins the group commit protocol, so an explicit flush shares the fdatasync
+        // of a concurrent commit instead of racing it.
+        wait_for_durable(get_next_lsn() - 1);
     }
 
     void
     FileWalManager::sync()
     {
-        DbGuard guard(*db_mutex_);
         flush();
     }
 
-    std::vector<WALRecord>
-    FileWalManager::read_all_logs()
+    // Walks the segments that existed when it was created, one at a time, and stops at
+    // the LSN that was durable at that point.
+    class FileWalIterator final : public IWalIterator
     {
-        DbGuard guard(*db_mutex_);
-        std::lock_guard lk(mtx_);
+        FileWalManager& wal_;
+        std::vector<fs::path> segments_;
+        size_t next_segment_ = 0;
+        LSN from_lsn_;
+        LSN last_lsn_;
+
+        std::vector<WALRecord> records_;
+        size_t position_ = 0;
+
+    public:
+        FileWalIterator(
+            FileWalManager& wal, std::vector<fs::path> segments, LSN from_lsn, LSN last_lsn
+        )
+            : wal_(wal), segments_(std::move(segments)), from_lsn_(from_lsn), last_lsn_(last_lsn)
+        {
+        }
+
+        bool
+        next(WALRecord& out) override
+        {
+            while (true)
+            {
+                while (position_ < records_.size())
+                {
+                    auto& record = records_[position_++];
+                    const LSN lsn = lsn_of(record);
+                    if (lsn < from_lsn_)
+                        continue;
+                    if (lsn > last_lsn_)
+                        return false;
+
+                    out = std::move(record);
+                    return true;
+                }
+
+                if (next_segment_ == segments_.size())
+                    return false;
+
+                records_ = wal_.read_logs_from_file(segments_[next_segment_++]);
+                position_ = 0;
+            }
+        }
+    };
 
-        // Return all cached records (flushed from disk + dirty in memory)
-        std::vector<WALRecord> all_logs;
-        all_logs.reserve(flushed_.size() + dirty_.size());
+    std::unique_ptr<IWalIterator>
+    FileWalManager::iterate(LSN from_lsn)
+    {
+        // Everything appended so far is made durable first, so the iterator only reads files.
+        flush();
+        const LSN last_lsn = get_durable_lsn();
+
+        DbGuard guard(*db_mutex_);
+        std::vector<fs::path> paths;
 
-        // Add all flushed records (already on disk, loaded at startup)
-        all_logs.insert(all_logs.end(), flushed_.begin(), flushed_.end());
+        // The segment holding from_lsn is the last one starting at or before it.
+        auto it = segments_.upper_bound(from_lsn);
+        if (it != segments_.begin())
+            --it;
 
-        // Add all dirty records (not yet flushed to disk)
-        all_logs.insert(all_logs.end(), dirty_.begin(), dirty_.end());
+        for (; it != segments_.end(); ++it)
+            paths.push_back(it->second);
 
-        return all_logs;
+        return std::make_unique<FileWalIterator>(*this, std::move(paths), from_lsn, last_lsn);
     }
 
     LSN
     FileWalManager::get_next_lsn() const
     {
-        DbGuard guard(*db_mutex_);
+        return next_lsn_.load(std::memory_order_acquire);
+    }
+
+    LSN
+    FileWalManager::get_durable_lsn() const
+    {
+        return flushed_lsn_.load(std::memory_order_acquire);
+    }
+
+    TxnSnapshot
+    FileWalManager::snapshot_txns() const
+    {
+        // Every record below next_lsn has to be in its slot before it can be counted.
+        // Waiting holds no lock, as an appender may have to flush to get its slot.
+        const LSN next_lsn = next_lsn_.load(std::memory_order_acquire);
+        for (LSN lsn = flushed_lsn_.load(std::memory_order_acquire) + 1; lsn < next_lsn; ++lsn)
+        {
+            auto& slot = slot_for(lsn);
+            for (LSN seen = slot.ready_lsn.load(std::memory_order_acquire); seen < lsn;
+                 seen = slot.ready_lsn.load(std::memory_order_acquire))
+                slot.ready_lsn.wait(seen, std::memory_order_acquire);
+        }
+
         std::lock_guard lk(mtx_);
-        return next_lsn_;
+
+        // Written records are tracked already; the rest are still in the ring.
+        auto txns = active_txns_;
+        for (LSN lsn = flushed_lsn_ + 1; lsn < next_lsn; ++lsn)
+            track_txn(txns, slot_for(lsn).record);
+
+        TxnSnapshot snapshot;
+        snapshot.next_lsn = next_lsn;
+        snapshot.active.reserve(txns.size());
+        for (const auto& txn : txns | std::views::values)
+            snapshot.active.push_back(txn);
+
+        return snapshot;
     }
 
     void
-    FileWalManager::write_logs(const std::vector<WALRecord>& logs)
+    FileWalManager::truncate(LSN lsn)
     {
         DbGuard guard(*db_mutex_);
-        auto dir = storage::path_db_wal(db_path_, db_name_);
-        if (!fs::exists(dir))
-            fs::create_directories(dir);
 
-        int fd = -1;
-        uint64_t opened_first_lsn = 0;
-
-        for (const auto& record : logs)
+        // A segment can go once the next one starts at or below lsn; the newest segment
+        // has no successor and is always kept.
+        for (auto it = segments_.begin(); it != segments_.end();)
         {
-            auto record_lsn = std::visit([](const auto& rec) { return rec.lsn; }, record);
-            uint64_t file_first_lsn =
-                ((record_lsn - 1) / MAX_RECORDS_PER_LOGFILE) * MAX_RECORDS_PER_LOGFILE + 1;
-            uint64_t file_last_lsn = file_first_lsn + MAX_RECORDS_PER_LOGFILE - 1;
+            auto next = std::next(it);
+            if (next == segments_.end() || next->first > lsn || it->first == active_first_lsn_)
+                break;
+
+            fs::remove(index_path_for(it->second));
 
-            if (fd < 0 || opened_first_lsn != file_first_lsn)
+            bool recycled = false;
+            if (spare_segments_.size() < MAX_SPARE_SEGMENTS)
             {
+                // Clearing the first LSN is all it takes; the file keeps its blocks, so
+                // reusing it later needs no allocation and no metadata sync.
+                int fd = open(it->second.c_str(), O_WRONLY);
                 if (fd >= 0)
                 {
-                    fsync(fd);
+                    try
+                    {
+                        write_segment_header(fd, 0);
+                        recycled = fdatasync(fd) == 0;
+                    }
+                    catch (const std::runtime_error&)
+                    {
+                    }
                     close(fd);
                 }
+            }
 
-                auto file_path =
-                    storage::path_db_wal_logfile(db_path_, db_name_, file_first_lsn, file_last_lsn);
+            if (recycled)
+                spare_segments_.push_back(it->second);
+            else
+                fs::remove(it->second);
 
-                fd = open(file_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
-                if (fd < 0)
-                    throw std::runtime_error("Failed to open WAL log file");
+            if (cached_first_lsn_ == it->first)
+            {
+                cached_first_lsn_ = 0;
+                cached_index_.clear();
+            }
 
-                opened_first_lsn = file_first_lsn;
+            it = segments_.erase(it);
+        }
+    }
+
+    fs::path
+    FileWalManager::create_segment()
+    {
+        auto dir = storage::path_db_wal(db_path_, db_name_);
+        if (!fs::exists(dir))
+            fs::create_directories(dir);
+
+        auto path = segment_path(next_segment_seq_++);
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+        if (fd < 0)
+            throw std::runtime_error("FileWalManager::create_segment: failed to create " + path.string());
+
+        try
+        {
+            // fallocate alone leaves unwritten extents, and converting them on the first
+            // write would cost a metadata sync per commit. Zero-filling once makes every
+            // later fdatasync of this file a pure data sync.
+            if (posix_fallocate(fd, 0, static_cast<off_t>(segment_bytes_)) != 0)
+                throw std::runtime_error("FileWalManager::create_segment: fallocate failed");
+
+            std::vector<uint8_t> zeros(std::min<uint64_t>(segment_bytes_, 1 << 20));
+            for (uint64_t offset = 0; offset < segment_bytes_; offset += zeros.size())
+            {
+                const size_t count = std::min<uint64_t>(zeros.size(), segment_bytes_ - offset);
+                if (pwrite(fd, zeros.data(), count, static_cast<off_t>(offset)) !=
+                    static_cast<ssize_t>(count))
+                    throw std::runtime_error("FileWalManager::create_segment: zero fill failed");
             }
 
-            auto serialized = serializer_->serialize(record);
+            write_segment_header(fd, 0);
+            if (fsync(fd) != 0)
+                throw std::runtime_error("FileWalManager::create_segment: fsync failed");
+        }
+        catch (...)
+        {
+            close(fd);
+            fs::remove(path);
+            throw;
+        }
 
-            uint64_t record_size = serialized.size();
+        close(fd);
+        fsync_directory(dir);
+        return path;
+    }
 
-            if (write(fd, &record_size, sizeof(record_size)) != sizeof(record_size))
-                throw std::runtime_error("Failed to write WAL record size");
+    void
+    FileWalManager::start_segment(LSN first_lsn)
+    {
+        // Rolling over seals the previous segment; its index goes to disk.
+        if (active_first_lsn_ != 0 && !active_index_.empty())
+            write_segment_index(segments_.at(active_first_lsn_), active_index_);
 
-            if (write(fd, serialized.data(), serialized.size()) != (ssize_t)serialized.size())
-                throw std::runtime_error("Failed to write WAL record");
+        if (fd_ >= 0)
+        {
+            close(fd_);
+            fd_ = -1;
         }
 
-        if (fd >= 0)
+        fs::path path;
+        if (!spare_segments_.empty())
         {
-            fsync(fd);
-            close(fd);
+            path = spare_segments_.back();
+            spare_segments_.pop_back();
+        }
+        else
+        {
+            path = create_segment();
+        }
+
+        fd_ = open(path.c_str(), O_WRONLY);
+        if (fd_ < 0)
+            throw std::runtime_error("FileWalManager::start_segment: failed to open " + path.string());
+
+        // The header becomes durable with the first batch written after it.
+        write_segment_header(fd_, first_lsn);
+
+        active_first_lsn_ = first_lsn;
+        active_end_ = sizeof(SegmentHeader);
+        active_index_.clear();
+        segments_[first_lsn] = path;
+    }
+
+    void
+    FileWalManager::open_active_segment()
+    {
+        if (fd_ >= 0)
+            return;
+
+        const auto& path = segments_.at(active_first_lsn_);
+        fd_ = open(path.c_str(), O_WRONLY);
+        if (fd_ < 0)
+            throw std::runtime_error(
+                "FileWalManager::open_active_segment: failed to open " + path.string()
+            );
+    }
+
+    void
+    FileWalManager::write_logs(const std::vector<Slot*>& slots, size_t& durable)
+    {
+        DbGuard guard(*db_mutex_);
+
+        for (auto* slot : slots)
+        {
+            if (slot->serialized)
+                continue;
+
+            slot->payload = serializer_->serialize(slot->record);
+            slot->size = slot->payload.size();
+            slot->checksum = misc::crc32(slot->payload.data(), slot->payload.size());
+            slot->serialized = true;
+        }
+
+        // Every record is framed as size, checksum and payload, all kept in its slot.
+        std::vector<iovec> iov;
+        iov.reserve(slots.size() * 3);
+
+        SegmentIndex written;
+
+        size_t i = 0;
+        while (i < slots.size())
+        {
+            if (active_first_lsn_ == 0)
+                start_segment(lsn_of(slots[i]->record));
+            open_active_segment();
+
+            iov.clear();
+            written.clear();
+            uint64_t end = active_end_;
+            const size_t first = i;
+
+            // A record that does not fit goes to a fresh segment, unless the current one
+            // is still empty: oversized records get a segment of their own.
+            for (; i < slots.size(); ++i)
+            {
+                auto& slot = *slots[i];
+                const uint64_t frame_size = RECORD_HEADER_SIZE + slot.size;
+                if (end + frame_size > segment_bytes_ &&
+                    (i > first || !active_index_.empty()))
+                    break;
+
+                iov.push_back({&slot.size, sizeof(uint64_t)});
+                iov.push_back({&slot.checksum, sizeof(uint32_t)});
+                iov.push_back({slot.payload.data(), slot.payload.size()});
+
+                written.emplace_back(lsn_of(slot.record), end);
+                end += frame_size;
+            }
+
+            if (i == first)
+            {
+                start_segment(lsn_of(slots[i]->record));
+                continue;
+            }
+
+            try
+            {
+                if (lseek(fd_, static_cast<off_t>(active_end_), SEEK_SET) < 0)
+                    throw std::runtime_error("FileWalManager::write_logs: lseek failed");
+
+                write_fully(fd_, iov);
+
+                // The segment is preallocated, so this syncs data only.
+                if (fdatasync(fd_) != 0)
+                    throw std::runtime_error("FileWalManager::write_logs: fdatasync failed");
+            }
+            catch (...)
+            {
+                // active_end_ is left where it was: the retry overwrites the torn bytes,
+                // and readers stop at them in the meantime.
+                close(fd_);
+                fd_ = -1;
+                throw;
+            }
+
+            active_end_ = end;
+            active_index_.insert(active_index_.end(), written.begin(), written.end());
+            durable = i;
         }
     }
 
     std::vector<WALRecord>
-    FileWalManager::read_logs_from_file(const fs::path& file_path)
+    FileWalManager::read_logs_from_file(const fs::path& file_path, SegmentIndex* index, uint64_t* end)
     {
         DbGuard guard(*db_mutex_);
         std::vector<WALRecord> logs;
 
+        if (end)
+            *end = sizeof(SegmentHeader);
+
         std::ifstream file(file_path, std::ios::binary);
         if (!file.is_open())
             return logs;
@@ -367,29 +1053,48 @@ namespace wal
         file.read(reinterpret_cast<char*>(buffer.data()), file_size);
         file.close();
 
-        // Десериализовать все записи из буфера
         ReadOnlyMemoryStream stream(buffer);
 
-        while (stream.remaining() > 0)
+        SegmentHeader header{};
+        if (stream.read(&header, sizeof(header)) != sizeof(header) ||
+            header.magic != SEGMENT_MAGIC || header.first_lsn == 0)
+            return logs;
+
+        // Десериализовать все записи из буфера
+        LSN expected_lsn = header.first_lsn;
+        while (stream.remaining() >= RECORD_HEADER_SIZE)
         {
+            const uint64_t record_offset = stream.tell();
+
             uint64_t record_size;
-            if (!stream.read(&record_size, sizeof(record_size)))
+            uint32_t checksum;
+            stream.read(&record_size, sizeof(record_size));
+            stream.read(&checksum, sizeof(checksum));
+
+            if (record_size == 0 || stream.remaining() < record_size)
                 break;
 
-            if (stream.remaining() < record_size)
+            const uint64_t payload_offset = stream.tell();
+            if (misc::crc32(buffer.data() + payload_offset, record_size) != checksum)
                 break;
 
             WALRecord record;
-            if (serializer_->deserialize(stream, record))
-            {
-                logs.push_back(std::move(record));
-            }
-            else
-            {
+            if (!serializer_->deserialize(stream, record))
                 throw std::runtime_error(
                     "FileWalManager::read_logs_from_file: failed to deserialize a record"
                 );
-            }
+            stream.seek(payload_offset + record_size);
+
+            if (lsn_of(record) != expected_lsn)
+                break;
+
+            if (index)
+                index->emplace_back(expected_lsn, record_offset);
+            if (end)
+                *end = stream.tell();
+
+            logs.push_back(std::move(record));
+            ++expected_lsn;
         }
 
         return logs;
@@ -10,48 +10,162 @@
 #include "wal_manager.hpp"
 #include "wal_serializer.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <filesystem>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
 namespace wal
 {
     namespace fs = std::filesystem;
 
+    // Group commit tuning. A flush leader that sees other committers waiting holds
+    // the batch open for up to `delay`, or until `batch_records` records are pending,
+    // so that they all share a single write and fdatasync.
+    struct GroupCommit
+    {
+        std::chrono::microseconds delay{0};
+        size_t batch_records = 64;
+    };
+
     class FileWalManager : public IWALManager
     {
+        // A record on its way to the disk. Record lsn lives in ring_[lsn % RING_SLOTS];
+        // the appender fills it with no lock held and then stores lsn to ready_lsn.
+        struct Slot
+        {
+            types::WALRecord record;
+            misc::MemoryStream payload;
+            uint64_t size = 0;
+            uint32_t checksum = 0;
+            // False if the appender failed to serialize it; the flusher then tries again.
+            bool serialized = false;
+            std::atomic<types::LSN> ready_lsn = 0;
+        };
+
         fs::path db_path_;
         std::string db_name_;
-        types::LSN next_lsn_;
-        types::LSN flushed_lsn_;
+        // Appenders reserve LSNs with a fetch_add on next_lsn_. A slot is reused for
+        // lsn + RING_SLOTS once flushed_lsn_, which only the flusher advances, reaches lsn.
+        std::atomic<types::LSN> next_lsn_;
+        std::atomic<types::LSN> flushed_lsn_;
         std::shared_ptr<storage::DatabaseIoLockService> io_lock_service_;
         std::shared_ptr<storage::DatabaseIoLockService::Mutex> db_mutex_;
 
         mutable std::mutex mtx_;
         std::condition_variable cv_;
-        bool flush_in_progress_ = false;
+        std::atomic<bool> flush_in_progress_ = false;
+        // Threads currently inside wait_for_durable, the leader included.
+        size_t committers_ = 0;
+        GroupCommit group_commit_;
+
+        // (lsn, file offset) of every record of a segment, ordered by LSN. Sealed
+        // segments keep theirs in a sidecar file next to the segment.
+        using SegmentIndex = std::vector<std::pair<types::LSN, uint64_t>>;
+
+        // Segment files by first LSN, and recycled ones waiting to be reused. Guarded by
+        // db_mutex_, like all WAL file I/O.
+        std::map<uint64_t, fs::path> segments_;
+        std::vector<fs::path> spare_segments_;
+        uint64_t next_segment_seq_ = 1;
+        uint64_t segment_bytes_;
+
+        // Segment currently appended to (0 if none yet), the offset the next record goes
+        // to, its index and its descriptor, which stays open between flushes.
+        uint64_t active_first_lsn_ = 0;
+        uint64_t active_end_ = 0;
+        SegmentIndex active_index_;
+        int fd_ = -1;
+
+        // Index of the last sealed segment read_log() went to disk for.
+        uint64_t cached_first_lsn_ = 0;
+        SegmentIndex cached_index_;
 
         std::unique_ptr<IWalSerializer> serializer_;
 
-        // Cache for performance: flushed records already on disk, dirty records in memory
-        std::vector<types::WALRecord> flushed_;
-        std::vector<types::WALRecord> dirty_;
+        // Records not yet written, between flushed_lsn_ and next_lsn_, and a bounded tail
+        // of the most recently written ones that serves read_log() for recent transactions
+        // without touching the disk. A flush writes the records up to the first one not ready.
+        std::unique_ptr<Slot[]> ring_;
+        std::deque<types::WALRecord> tail_;
+
+        // Transactions with a BEGIN and no COMMIT or ROLLBACK among the written records;
+        // snapshot_txns() adds those still in the ring.
+        std::unordered_map<types::UUID, ActiveTxn> active_txns_;
 
-        static constexpr uint64_t MAX_RECORDS_PER_LOGFILE = 1000;
+        static constexpr size_t RING_SLOTS = 4096;
+        static constexpr size_t MAX_TAIL_RECORDS = 4096;
+        // Segments freed by truncate() beyond this many are deleted instead of recycled.
+        static constexpr size_t MAX_SPARE_SEGMENTS = 4;
+
+        friend class FileWalIterator;
 
         // Helper methods
+        Slot&
+        slot_for(types::LSN lsn) const;
+
+        // Waits for the slot of a reserved lsn to be free, then numbers and serializes the
+        // record in it and marks it ready.
+        void
+        publish(types::LSN lsn, types::WALRecord&& record);
+
+        void
+        flush_as_leader(std::unique_lock<std::mutex>& lk);
+
+        // Moves the written records up to lsn to the tail and frees their slots.
+        void
+        retire(types::LSN lsn);
+
+        static void
+        track_txn(std::unordered_map<types::UUID, ActiveTxn>& txns, const types::WALRecord& record);
+
+        // Writes and syncs the records in order; `durable` counts the records that reached
+        // stable storage, also when an exception is thrown part way.
+        void
+        write_logs(const std::vector<Slot*>& slots, size_t& durable);
+
+        fs::path
+        segment_path(uint64_t seq) const;
+
+        // Preallocates a new segment file of segment_bytes_ and makes it durable.
+        fs::path
+        create_segment();
+
+        // Seals the active segment and starts a recycled or new one at first_lsn.
+        void
+        start_segment(types::LSN first_lsn);
+
         void
-        write_logs(const std::vector<types::WALRecord>& logs);
+        open_active_segment();
 
         std::vector<types::WALRecord>
-        read_logs_from_file(const fs::path& file_path);
+        read_logs_from_file(
+            const fs::path& file_path, SegmentIndex* index = nullptr, uint64_t* end = nullptr
+        );
+
+        const SegmentIndex&
+        segment_index(uint64_t first_lsn);
 
-        // Load all existing WAL records from disk into flushed_ cache
         void
-        hydrate_cache();
+        write_segment_index(const fs::path& segment, const SegmentIndex& index) const;
+
+        std::optional<types::WALRecord>
+        read_log_from_disk(types::LSN lsn);
+
+        // Registers existing segment files and resumes after the records of the last one.
+        void
+        load_segments();
 
     public:
+        static constexpr uint64_t DEFAULT_SEGMENT_BYTES = 16ull * 1024 * 1024;
+
         FileWalManager(
             const fs::path& db_path,
             const std::string& db_name,
@@ -62,9 +176,17 @@ namespace wal
             const fs::path& db_path,
             const std::string& db_name,
             types::Config::SerializerType serializer_type,
-            std::shared_ptr<storage::DatabaseIoLockService> io_lock_service
+            std::shared_ptr<storage::DatabaseIoLockService> io_lock_service,
+            GroupCommit group_commit = {},
+            uint64_t segment_bytes = DEFAULT_SEGMENT_BYTES
         );
 
+        ~FileWalManager() override;
+
+        FileWalManager(const FileWalManager&) = delete;
+        FileWalManager&
+        operator=(const FileWalManager&) = delete;
+
         // IWalManager interface
         types::LSN
         append_log(const types::WALRecord& record) override;
@@ -87,11 +209,20 @@ namespace wal
         void
         sync() override;
 
-        std::vector<types::WALRecord>
-        read_all_logs() override;
+        std::unique_ptr<IWalIterator>
+        iterate(types::LSN from_lsn) override;
 
         types::LSN
         get_next_lsn() const override;
+
+        types::LSN
+        get_durable_lsn() const override;
+
+        TxnSnapshot
+        snapshot_txns() const override;
+
+        void
+        truncate(types::LSN lsn) override;
     };
 } // namespace wal
 
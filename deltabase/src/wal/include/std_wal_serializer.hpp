@@ -25,9 +25,18 @@ namespace wal
         misc::MemoryStream
         serialize(const types::RollbackTxnRecord& record) const;
 
+        misc::MemoryStream
+        serialize(const types::CheckpointRecord& record) const;
+
+        misc::MemoryStream
+        serialize(const types::LinkPageRecord& record) const;
+
         misc::MemoryStream
         serialize(const types::InsertRecord& record) const;
 
+        misc::MemoryStream
+        serialize(const types::InsertRowsRecord& record) const;
+
         misc::MemoryStream
         serialize(const types::UpdateRecord& record) const;
 
@@ -37,6 +46,9 @@ namespace wal
         misc::MemoryStream
         serialize(const types::CLRInsertRecord& record) const;
 
+        misc::MemoryStream
+        serialize(const types::CLRInsertRowsRecord& record) const;
+
         misc::MemoryStream
         serialize(const types::CLRUpdateRecord& record) const;
 
@@ -91,6 +103,12 @@ namespace wal
         misc::MemoryStream
         serialize(const types::CLRDropIndexRecord& record) const;
 
+        misc::MemoryStream
+        serialize(const types::TableCountersRecord& record) const;
+
+        misc::MemoryStream
+        serialize(const types::CLRTableCountersRecord& record) const;
+
     public:
         misc::MemoryStream
         serialize(const types::WALRecord& record) const override;
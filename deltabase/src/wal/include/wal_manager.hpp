@@ -6,10 +6,39 @@
 #define DELTABASE_I_WAL_MANAGER_HPP
 
 #include "../../types/include/wal_log.hpp"
+
+#include <memory>
 #include <vector>
 
 namespace wal
 {
+    // Forward-only cursor over WAL records in LSN order. Only one segment is held in
+    // memory at a time, so a full pass costs O(segment) memory regardless of WAL size.
+    class IWalIterator
+    {
+    public:
+        virtual ~IWalIterator() = default;
+
+        virtual bool
+        next(types::WALRecord& out) = 0;
+    };
+
+    // A transaction that has logged its BEGIN but neither a COMMIT nor a ROLLBACK yet.
+    struct ActiveTxn
+    {
+        types::UUID txn_id;
+        types::LSN first_lsn = 0;
+        types::LSN last_lsn = 0;
+    };
+
+    // Active transactions and the next LSN, read atomically: every record below
+    // next_lsn belongs either to one of these transactions or to one that has ended.
+    struct TxnSnapshot
+    {
+        types::LSN next_lsn = 0;
+        std::vector<ActiveTxn> active;
+    };
+
     class IWALManager
     {
     public:
@@ -33,11 +62,24 @@ namespace wal
         virtual void
         wait_for_durable(types::LSN lsn) = 0;
 
-        virtual std::vector<types::WALRecord>
-        read_all_logs() = 0;
+        // Highest LSN known to be on stable storage.
+        virtual types::LSN
+        get_durable_lsn() const = 0;
+
+        // Streams every record with an LSN of at least from_lsn that was appended before
+        // the call. The iterator must not outlive the manager.
+        virtual std::unique_ptr<IWalIterator>
+        iterate(types::LSN from_lsn) = 0;
 
         virtual types::LSN
         get_next_lsn() const = 0;
+
+        virtual TxnSnapshot
+        snapshot_txns() const = 0;
+
+        // Drops whole segments whose records are all older than lsn.
+        virtual void
+        truncate(types::LSN lsn) = 0;
     };
 } // namespace wal
 
@@ -27,7 +27,15 @@ namespace wal
             {
             case types::Config::IoType::File:
                 return std::make_unique<FileWalManager>(
-                    cfg.db_path, cfg.db_name.value(), cfg.serializer_type, std::move(io_lock_service)
+                    cfg.db_path,
+                    cfg.db_name.value(),
+                    cfg.serializer_type,
+                    std::move(io_lock_service),
+                    GroupCommit{
+                        std::chrono::microseconds(cfg.wal_commit_delay_us),
+                        cfg.wal_group_commit_records
+                    },
+                    cfg.wal_segment_bytes
                 );
             default:
                 throw std::runtime_error("WalManagerFactory::make(): invalid io type " + std::to_string(static_cast<int>(cfg.io_type)));
@@ -36,6 +36,28 @@ namespace wal
         return stream;
     }
 
+    MemoryStream
+    StdWalSerializer::serialize(const InsertRowsRecord& record) const
+    {
+        MemoryStream stream;
+        stream.write(&record.type, sizeof(record.type));
+        stream.write(&record.lsn, sizeof(record.lsn));
+        stream.write(&record.prev_lsn, sizeof(record.prev_lsn));
+        stream.write(&record.txn_id, sizeof(uuid_t));
+        stream.write(&record.table_id, sizeof(uuid_t));
+        stream.write(&record.page_id, sizeof(uuid_t));
+
+        uint64_t row_count = record.after.size();
+        stream.write(&row_count, sizeof(row_count));
+        for (const auto& row : record.after)
+        {
+            auto serialized_row = binary_serializer_.serialize_dr(row);
+            stream.append(serialized_row, serialized_row.size());
+        }
+
+        return stream;
+    }
+
     MemoryStream
     StdWalSerializer::serialize(const UpdateRecord& record) const
     {
@@ -93,6 +115,25 @@ namespace wal
         return stream;
     }
 
+    MemoryStream
+    StdWalSerializer::serialize(const CLRInsertRowsRecord& record) const
+    {
+        MemoryStream stream;
+        stream.write(&record.type, sizeof(record.type));
+        stream.write(&record.lsn, sizeof(record.lsn));
+        stream.write(&record.prev_lsn, sizeof(record.prev_lsn));
+        stream.write(&record.txn_id, sizeof(uuid_t));
+        stream.write(&record.table_id, sizeof(uuid_t));
+        stream.write(&record.page_id, sizeof(uuid_t));
+        stream.write(&record.undo_next_lsn, sizeof(record.undo_next_lsn));
+
+        uint64_t row_count = record.row_ids.size();
+        stream.write(&row_count, sizeof(row_count));
+        stream.write(record.row_ids.data(), row_count * sizeof(RowId));
+
+        return stream;
+    }
+
     MemoryStream
     StdWalSerializer::serialize(const CLRUpdateRecord& record) const
     {
@@ -414,6 +455,78 @@ namespace wal
         return stream;
     }
 
+    MemoryStream
+    StdWalSerializer::serialize(const CheckpointRecord& record) const
+    {
+        MemoryStream stream;
+        stream.write(&record.type, sizeof(record.type));
+        stream.write(&record.lsn, sizeof(record.lsn));
+        stream.write(&record.prev_lsn, sizeof(record.prev_lsn));
+        stream.write(&record.txn_id, sizeof(uuid_t));
+        stream.write(&record.redo_lsn, sizeof(record.redo_lsn));
+
+        uint64_t txn_count = record.active_txns.size();
+        stream.write(&txn_count, sizeof(txn_count));
+        for (const auto& [txn_id, last_lsn] : record.active_txns)
+        {
+            stream.write(&txn_id, sizeof(uuid_t));
+            stream.write(&last_lsn, sizeof(last_lsn));
+        }
+
+        uint64_t page_count = record.dirty_pages.size();
+        stream.write(&page_count, sizeof(page_count));
+        for (const auto& page_id : record.dirty_pages)
+            stream.write(&page_id, sizeof(uuid_t));
+
+        return stream;
+    }
+
+    MemoryStream
+    StdWalSerializer::serialize(const LinkPageRecord& record) const
+    {
+        MemoryStream stream;
+        stream.write(&record.type, sizeof(record.type));
+        stream.write(&record.lsn, sizeof(record.lsn));
+        stream.write(&record.prev_lsn, sizeof(record.prev_lsn));
+        stream.write(&record.txn_id, sizeof(uuid_t));
+        stream.write(&record.table_id, sizeof(uuid_t));
+        stream.write(&record.page_id, sizeof(uuid_t));
+        stream.write(&record.next_page_id, sizeof(uuid_t));
+        return stream;
+    }
+
+    MemoryStream
+    StdWalSerializer::serialize(const TableCountersRecord& record) const
+    {
+        MemoryStream stream;
+        stream.write(&record.type, sizeof(record.type));
+        stream.write(&record.lsn, sizeof(record.lsn));
+        stream.write(&record.prev_lsn, sizeof(record.prev_lsn));
+        stream.write(&record.txn_id, sizeof(uuid_t));
+        stream.write(&record.table_id, sizeof(uuid_t));
+        stream.write(&record.last_rid, sizeof(record.last_rid));
+        stream.write(&record.total_rows_delta, sizeof(record.total_rows_delta));
+        stream.write(&record.live_rows_delta, sizeof(record.live_rows_delta));
+        stream.write(&record.total_rows, sizeof(record.total_rows));
+        stream.write(&record.live_rows, sizeof(record.live_rows));
+        return stream;
+    }
+
+    MemoryStream
+    StdWalSerializer::serialize(const CLRTableCountersRecord& record) const
+    {
+        MemoryStream stream;
+        stream.write(&record.type, sizeof(record.type));
+        stream.write(&record.lsn, sizeof(record.lsn));
+        stream.write(&record.prev_lsn, sizeof(record.prev_lsn));
+        stream.write(&record.txn_id, sizeof(uuid_t));
+        stream.write(&record.undo_next_lsn, sizeof(record.undo_next_lsn));
+        stream.write(&record.table_id, sizeof(uuid_t));
+        stream.write(&record.total_rows, sizeof(record.total_rows));
+        stream.write(&record.live_rows, sizeof(record.live_rows));
+        return stream;
+    }
+
     MemoryStream
     StdWalSerializer::serialize(const WALRecord& record) const
     {
@@ -1039,6 +1152,181 @@ namespace wal
             return true;
         }
 
+        case WALRecordType::CHECKPOINT:
+        {
+            CheckpointRecord record;
+            uint64_t txn_count;
+            uint64_t page_count;
+
+            if (!stream.read(&record.lsn, sizeof(record.lsn)))
+                return false;
+            if (!stream.read(&record.prev_lsn, sizeof(record.prev_lsn)))
+                return false;
+            if (!stream.read(record.txn_id.raw(), sizeof(uuid_t)))
+                return false;
+            if (!stream.read(&record.redo_lsn, sizeof(record.redo_lsn)))
+                return false;
+
+            if (!stream.read(&txn_count, sizeof(txn_count)))
+                return false;
+            if (txn_count > stream.remaining() / (sizeof(uuid_t) + sizeof(LSN)))
+                return false;
+            record.active_txns.resize(txn_count);
+            for (auto& [txn_id, last_lsn] : record.active_txns)
+            {
+                if (!stream.read(txn_id.raw(), sizeof(uuid_t)))
+                    return false;
+                if (!stream.read(&last_lsn, sizeof(last_lsn)))
+                    return false;
+            }
+
+            if (!stream.read(&page_count, sizeof(page_count)))
+                return false;
+            if (page_count > stream.remaining() / sizeof(uuid_t))
+                return false;
+            record.dirty_pages.resize(page_count);
+            for (auto& page_id : record.dirty_pages)
+            {
+                if (!stream.read(page_id.raw(), sizeof(uuid_t)))
+                    return false;
+            }
+
+            out = std::move(record);
+            return true;
+        }
+
+        case WALRecordType::TABLE_COUNTERS:
+        {
+            TableCountersRecord record;
+
+            if (!stream.read(&record.lsn, sizeof(record.lsn)))
+                return false;
+            if (!stream.read(&record.prev_lsn, sizeof(record.prev_lsn)))
+                return false;
+            if (!stream.read(record.txn_id.raw(), sizeof(uuid_t)))
+                return false;
+            if (!stream.read(record.table_id.raw(), sizeof(uuid_t)))
+                return false;
+            if (!stream.read(&record.last_rid, sizeof(record.last_rid)))
+                return false;
+            if (!stream.read(&record.total_rows_delta, sizeof(record.total_rows_delta)))
+                return false;
+            if (!stream.read(&record.live_rows_delta, sizeof(record.live_rows_delta)))
+                return false;
+            if (!stream.read(&record.total_rows, sizeof(record.total_rows)))
+                return false;
+            if (!stream.read(&record.live_rows, sizeof(record.live_rows)))
+                return false;
+
+            out = record;
+            return true;
+        }
+
+        case WALRecordType::CLR_TABLE_COUNTERS:
+        {
+            CLRTableCountersRecord record;
+
+            if (!stream.read(&record.lsn, sizeof(record.lsn)))
+                return false;
+            if (!stream.read(&record.prev_lsn, sizeof(record.prev_lsn)))
+                return false;
+            if (!stream.read(record.txn_id.raw(), sizeof(uuid_t)))
+                return false;
+            if (!stream.read(&record.undo_next_lsn, sizeof(record.undo_next_lsn)))
+                return false;
+            if (!stream.read(record.table_id.raw(), sizeof(uuid_t)))
+                return false;
+            if (!stream.read(&record.total_rows, sizeof(record.total_rows)))
+                return false;
+            if (!stream.read(&record.live_rows, sizeof(record.live_rows)))
+                return false;
+
+            out = record;
+            return true;
+        }
+
+        case WALRecordType::INSERT_ROWS:
+        {
+            InsertRowsRecord record;
+            uint64_t row_count;
+
+            if (!stream.read(&record.lsn, sizeof(record.lsn)))
+                return false;
+            if (!stream.read(&record.prev_lsn, sizeof(record.prev_lsn)))
+                return false;
+            if (!stream.read(record.txn_id.raw(), sizeof(uuid_t)))
+                return false;
+            if (!stream.read(record.table_id.raw(), sizeof(uuid_t)))
+                return false;
+            if (!stream.read(record.page_id.raw(), sizeof(uuid_t)))
+                return false;
+
+            if (!stream.read(&row_count, sizeof(row_count)))
+                return false;
+            if (row_count > stream.remaining())
+                return false;
+            record.after.resize(row_count);
+            for (auto& row : record.after)
+            {
+                if (!binary_serializer_.deserialize_dr(stream, row))
+                    return false;
+            }
+
+            out = std::move(record);
+            return true;
+        }
+
+        case WALRecordType::CLR_INSERT_ROWS:
+        {
+            CLRInsertRowsRecord record;
+            uint64_t row_count;
+
+            if (!stream.read(&record.lsn, sizeof(record.lsn)))
+                return false;
+            if (!stream.read(&record.prev_lsn, sizeof(record.prev_lsn)))
+                return false;
+            if (!stream.read(record.txn_id.raw(), sizeof(uuid_t)))
+                return false;
+            if (!stream.read(record.table_id.raw(), sizeof(uuid_t)))
+                return false;
+            if (!stream.read(record.page_id.raw(), sizeof(uuid_t)))
+                return false;
+            if (!stream.read(&record.undo_next_lsn, sizeof(record.undo_next_lsn)))
+                return false;
+
+            if (!stream.read(&row_count, sizeof(row_count)))
+                return false;
+            if (row_count > stream.remaining() / sizeof(RowId))
+                return false;
+            record.row_ids.resize(row_count);
+            if (row_count > 0 && !stream.read(record.row_ids.data(), row_count * sizeof(RowId)))
+                return false;
+
+            out = std::move(record);
+            return true;
+        }
+
+        case WALRecordType::LINK_PAGE:
+        {
+            LinkPageRecord record;
+
+            if (!stream.read(&record.lsn, sizeof(record.lsn)))
+                return false;
+            if (!stream.read(&record.prev_lsn, sizeof(record.prev_lsn)))
+                return false;
+            if (!stream.read(record.txn_id.raw(), sizeof(uuid_t)))
+                return false;
+            if (!stream.read(record.table_id.raw(), sizeof(uuid_t)))
+                return false;
+            if (!stream.read(record.page_id.raw(), sizeof(uuid_t)))
+                return false;
+            if (!stream.read(record.next_page_id.raw(), sizeof(uuid_t)))
+                return false;
+
+            out = record;
+            return true;
+        }
+
         default:
             return false;
         }
@@ -0,0 +1,337 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "test_support.hpp"
+#include "../src/misc/include/LRU_policy.hpp"
+#include "../src/misc/include/cache.hpp"
+#include "../src/misc/include/replacement_policy.hpp"
+
+#include <iostream>
+
+namespace tests
+{
+    namespace
+    {
+        using StringCache = misc::Cache<int, std::string, cache::LRUPolicy<int>>;
+
+        StringCache
+        make_string_cache(std::size_t capacity_bytes)
+        {
+            return StringCache(
+                cache::LRUPolicy<int>(),
+                capacity_bytes,
+                [](const std::string& value) { return value.size(); }
+            );
+        }
+
+        void
+        expect_within_budget(const StringCache& cache)
+        {
+            if (cache.used_bytes() > cache.capacity_bytes())
+            {
+                throw std::runtime_error(
+                    "Cache holds " + std::to_string(cache.used_bytes()) + " bytes over a budget of "
+                    + std::to_string(cache.capacity_bytes())
+                );
+            }
+        }
+
+        // Entries are charged by their size, not counted, and a value that grew in place is
+        // charged again when it is marked dirty.
+        void
+        run_byte_budget_test()
+        {
+            auto cache = make_string_cache(100);
+            int flushed = 0;
+            const auto flush = [&](StringCache::CacheEntry&) { flushed++; };
+
+            for (int key = 0; key < 10; ++key)
+            {
+                cache.put(key, std::string(30, 'a'), flush);
+                cache.mark_dirty(key);
+                expect_within_budget(cache);
+            }
+
+            if (cache.size() != 3 || cache.used_bytes() != 90)
+            {
+                throw std::runtime_error("Cache did not keep exactly three 30 byte entries");
+            }
+
+            if (flushed != 7)
+            {
+                throw std::runtime_error("Evicted dirty entries were not all flushed");
+            }
+
+            cache.get(9)->value.append(20, 'b');
+            cache.mark_dirty(9);
+            if (cache.used_bytes() != 110)
+            {
+                throw std::runtime_error("Entry that grew in place was not charged again");
+            }
+
+            // Two 30 byte entries have to go before 50 more bytes fit.
+            cache.put(10, std::string(50, 'c'), flush);
+            expect_within_budget(cache);
+            if (cache.size() != 2 || cache.get(9) == nullptr || cache.get(10) == nullptr)
+            {
+                throw std::runtime_error("Cache evicted other entries than the least recently used");
+            }
+
+            std::cout << "Byte budget test passed." << std::endl;
+        }
+
+        // A pinned entry stays resident and keeps its address; when everything is pinned the
+        // cache goes over budget rather than drop an entry someone still points into.
+        void
+        run_pinned_entries_test()
+        {
+            auto cache = make_string_cache(100);
+            const auto flush = [](StringCache::CacheEntry&) {};
+
+            for (int key = 0; key < 3; ++key)
+            {
+                cache.put(key, std::string(30, 'a'), flush);
+            }
+
+            auto oldest = cache.pin(0);
+            const std::string* value = oldest.get();
+            for (int key = 3; key < 10; ++key)
+            {
+                cache.put(key, std::string(30, 'b'), flush);
+            }
+
+            if (cache.get(0) == nullptr || &cache.get(0)->value != value)
+            {
+                throw std::runtime_error("Pinned entry was evicted");
+            }
+
+            auto second = cache.pin(8);
+            auto third = cache.pin(9);
+            cache.put(10, std::string(30, 'c'), flush);
+            if (cache.size() != 4 || cache.used_bytes() <= cache.capacity_bytes())
+            {
+                throw std::runtime_error("Cache did not go over budget with every entry pinned");
+            }
+
+            oldest.reset();
+            cache.put(11, std::string(30, 'd'), flush);
+            if (cache.get(0) != nullptr || cache.get(8) == nullptr || cache.get(9) == nullptr)
+            {
+                throw std::runtime_error("Cache did not evict the entry that was unpinned");
+            }
+
+            std::cout << "Pinned entries test passed." << std::endl;
+        }
+
+        void
+        insert_padded_rows(engine::Engine& engine, const std::string& table, int rows)
+        {
+            const std::string padding(200, 'x');
+            for (int id = 0; id < rows; ++id)
+            {
+                engine.execute_query(
+                    "insert into common." + table + "(id, payload) values (" + std::to_string(id)
+                    + ", '" + padding + "')"
+                );
+            }
+        }
+
+        // Each table fits the budget on its own, both together do not, so moving between
+        // them pushes the other table's pages out and back in.
+        void
+        run_small_pool_test()
+        {
+            const std::string db_name = make_test_db_name("small_pool_test");
+            remove_test_db(db_name);
+
+            {
+                auto config = types::Config::std(db_name);
+                config.buffer_pool_bytes = 8 * types::DataPage::MAX_SIZE;
+
+                engine::Engine bootstrap;
+                bootstrap.create_db(config);
+                bootstrap.execute_query("create table common.test_first(id integer, payload string)");
+                bootstrap.execute_query("create table common.test_second(id integer, payload string)");
+            }
+
+            const auto check = [](engine::Engine& engine)
+            {
+                expect_rows(engine, "select * from common.test_first", 800);
+                expect_rows(engine, "select * from common.test_second", 800);
+                expect_rows(engine, "select * from common.test_first where id == 100", 1);
+                expect_rows(engine, "select * from common.test_second where id == 799", 1);
+            };
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+
+                insert_padded_rows(engine, "test_first", 800);
+                insert_padded_rows(engine, "test_second", 800);
+                check(engine);
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                check(engine);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Small pool test passed." << std::endl;
+        }
+
+        // Scans and inserts keep the pages they work on pinned, so a pool of two pages still
+        // serves a table several times its size.
+        void
+        run_tiny_pool_test()
+        {
+            const std::string db_name = make_test_db_name("tiny_pool_test");
+            remove_test_db(db_name);
+
+            {
+                auto config = types::Config::std(db_name);
+                config.buffer_pool_bytes = 2 * types::DataPage::MAX_SIZE;
+
+                engine::Engine bootstrap;
+                bootstrap.create_db(config);
+                bootstrap.execute_query("create table common.test_first(id integer, payload string)");
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                insert_padded_rows(engine, "test_first", 800);
+                expect_rows(engine, "select * from common.test_first", 800);
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_first", 800);
+                expect_rows(engine, "select * from common.test_first where id == 400", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Tiny pool test passed." << std::endl;
+        }
+
+        using PolicyCache = misc::Cache<int, int, cache::ReplacementPolicy<int>>;
+
+        // Makes keys 0..3 hot on a twenty entry cache, reads 100 other keys once each, then
+        // reports how many of the hot keys are still resident.
+        int
+        hot_keys_after_scan(cache::ReplacementPolicy<int> policy)
+        {
+            PolicyCache cache(std::move(policy), 20, [](const int&) { return std::size_t{1}; });
+            const auto flush = [](PolicyCache::CacheEntry&) {};
+            const auto access = [&](int key)
+            {
+                if (cache.get(key) == nullptr)
+                {
+                    cache.put(key, int(key), flush);
+                }
+            };
+
+            for (int key = 0; key < 4; ++key)
+            {
+                access(key);
+            }
+            for (int key = 100; key < 120; ++key)
+            {
+                access(key);
+            }
+            // Hot keys come back after they were pushed out once.
+            for (int key = 0; key < 4; ++key)
+            {
+                access(key);
+                access(key);
+            }
+
+            for (int key = 200; key < 300; ++key)
+            {
+                access(key);
+            }
+
+            int resident = 0;
+            for (int key = 0; key < 4; ++key)
+            {
+                if (cache.peek(key) != nullptr)
+                {
+                    resident++;
+                }
+            }
+
+            return resident;
+        }
+
+        // A one-off scan flushes the hot set out of LRU but only cycles through 2Q's FIFO.
+        void
+        run_scan_resistance_test()
+        {
+            const int lru = hot_keys_after_scan(cache::LRUPolicy<int>());
+            const int two_queue = hot_keys_after_scan(cache::TwoQueuePolicy<int>());
+
+            if (lru != 0)
+            {
+                throw std::runtime_error("LRU kept hot keys through a scan five times its size");
+            }
+            if (two_queue != 4)
+            {
+                throw std::runtime_error(
+                    "2Q kept " + std::to_string(two_queue) + " of 4 hot keys through a scan"
+                );
+            }
+
+            std::cout << "Scan resistance test passed." << std::endl;
+        }
+
+        // Every policy a pool can be configured with serves a table larger than the pool.
+        void
+        run_pool_policies_test()
+        {
+            using Policy = types::Config::CachePolicyType;
+            for (const auto policy : {Policy::LRU, Policy::Clock, Policy::TwoQueue})
+            {
+                const std::string db_name = make_test_db_name("pool_policy_test");
+                remove_test_db(db_name);
+
+                {
+                    auto config = types::Config::std(db_name);
+                    config.buffer_pool_bytes = 2 * types::DataPage::MAX_SIZE;
+                    config.buffer_pool_policy = policy;
+                    config.index_pool_policy = policy;
+
+                    engine::Engine bootstrap;
+                    bootstrap.create_db(config);
+                    bootstrap.execute_query("create table common.test_first(id integer, payload string)");
+                    bootstrap.execute_query("create unique index test_first_id on common.test_first(id)");
+                }
+
+                {
+                    engine::Engine engine;
+                    engine.attach_db(db_name);
+                    insert_padded_rows(engine, "test_first", 60);
+                    expect_rows(engine, "select * from common.test_first", 60);
+                    expect_rows(engine, "select * from common.test_first where id == 30", 1);
+                }
+
+                remove_test_db(db_name);
+            }
+
+            std::cout << "Pool policies test passed." << std::endl;
+        }
+    }
+
+    void
+    run_buffer_pool_tests()
+    {
+        run_byte_budget_test();
+        run_small_pool_test();
+        run_pinned_entries_test();
+        run_tiny_pool_test();
+        run_scan_resistance_test();
+        run_pool_policies_test();
+    }
+}
@@ -0,0 +1,449 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "test_support.hpp"
+
+#include <iostream>
+
+namespace tests
+{
+    namespace
+    {
+        constexpr int TEST_ROWS = 1500;
+        // Few categories, so that the rows of one span several leaves.
+        constexpr int TEST_CATEGORIES = 5;
+
+        // Inserts ids 0 to TEST_ROWS - 1 in scrambled order, in category id % TEST_CATEGORIES.
+        void
+        insert_test_rows(engine::Engine& engine)
+        {
+            constexpr int batch = 500;
+            for (int first = 0; first < TEST_ROWS; first += batch)
+            {
+                std::string query = "insert into common.test_index(id, cat) values ";
+                for (int i = first; i < first + batch; ++i)
+                {
+                    const int id = static_cast<int>((i * 7919LL) % TEST_ROWS);
+                    query += "(" + std::to_string(id) + ", " + std::to_string(id % TEST_CATEGORIES) + "), ";
+                }
+                query.resize(query.size() - 2);
+                engine.execute_query(query);
+            }
+        }
+
+        void
+        create_test_db(const types::Config& config, bool indexes_first = true)
+        {
+            remove_test_db(*config.db_name);
+
+            {
+                engine::Engine bootstrap;
+                bootstrap.create_db(config);
+                bootstrap.execute_query("create table common.test_index(id integer, cat integer)");
+                if (indexes_first)
+                {
+                    bootstrap.execute_query("create unique index test_index_id on common.test_index(id)");
+                    bootstrap.execute_query("create index test_index_cat on common.test_index(cat)");
+                }
+            }
+
+            engine::Engine engine;
+            engine.attach_db(*config.db_name);
+            insert_test_rows(engine);
+
+            if (!indexes_first)
+            {
+                engine.execute_query("create unique index test_index_id on common.test_index(id)");
+                engine.execute_query("create index test_index_cat on common.test_index(cat)");
+            }
+        }
+
+        void
+        create_test_db(const std::string& db_name)
+        {
+            create_test_db(types::Config::std(db_name));
+        }
+
+        std::uintmax_t
+        index_files_size(const std::string& db_name)
+        {
+            const auto index_dir = misc::StaticStorage::get_executable_path() / "data" / db_name
+                                   / "common" / "test_index" / "index";
+
+            std::uintmax_t size = 0;
+            for (const auto& entry : std::filesystem::directory_iterator(index_dir))
+            {
+                size += entry.file_size();
+            }
+
+            return size;
+        }
+
+        // An index too large for one block is spread over pages that are written and read
+        // back one by one.
+        void
+        run_index_pages_test()
+        {
+            const std::string db_name = make_test_db_name("index_pages_test");
+            create_test_db(db_name);
+
+            const auto size = index_files_size(db_name);
+            if (size < 8 * types::MAX_IP_SIZE || size % types::MAX_IP_SIZE != 0)
+            {
+                throw std::runtime_error("Index file is not a run of several page blocks");
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_index where id == 0", 1);
+                expect_rows(engine, "select * from common.test_index where id == 777", 1);
+                expect_rows(engine, "select * from common.test_index where id == 1499", 1);
+                expect_rows(engine, "select * from common.test_index where id == 1500", 0);
+
+                expect_failure(engine, "insert into common.test_index(id, cat) values (777, 0)");
+                engine.execute_query("insert into common.test_index(id, cat) values (1500, 0)");
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_index", TEST_ROWS + 1);
+                expect_rows(engine, "select * from common.test_index where id == 1500", 1);
+                expect_failure(engine, "insert into common.test_index(id, cat) values (1500, 1)");
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Index pages test passed." << std::endl;
+        }
+
+        // Point lookups descend to the one leaf that can hold the key: present keys are found
+        // wherever they landed, keys between, below and above them are not.
+        void
+        run_point_lookup_test()
+        {
+            const std::string db_name = make_test_db_name("index_point_lookup_test");
+            remove_test_db(db_name);
+
+            {
+                engine::Engine bootstrap;
+                bootstrap.create_db(types::Config::std(db_name));
+                bootstrap.execute_query("create table common.test_index(id integer, cat integer)");
+                bootstrap.execute_query("create unique index test_index_id on common.test_index(id)");
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+
+                // Even ids from 2 on, largest first, so every insert goes to the leftmost leaf.
+                constexpr int batch = 250;
+                for (int first = 2 * TEST_ROWS; first > 0; first -= 2 * batch)
+                {
+                    std::string query = "insert into common.test_index(id, cat) values ";
+                    for (int id = first; id > first - 2 * batch; id -= 2)
+                    {
+                        query += "(" + std::to_string(id) + ", 0), ";
+                    }
+                    query.resize(query.size() - 2);
+                    engine.execute_query(query);
+                }
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                for (int id = 1; id < 2 * TEST_ROWS; id += 37)
+                {
+                    expect_rows(
+                        engine, "select * from common.test_index where id == " + std::to_string(id), id % 2 == 0
+                    );
+                }
+
+                expect_rows(engine, "select * from common.test_index where id == 0", 0);
+                expect_rows(engine, "select * from common.test_index where id == 2", 1);
+                expect_rows(engine, "select * from common.test_index where id == 3000", 1);
+                expect_rows(engine, "select * from common.test_index where id == 3002", 0);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Point lookup test passed." << std::endl;
+        }
+
+        std::string
+        make_prefixed_key(int n)
+        {
+            std::string digits = std::to_string(n);
+            return "customers/region-eu-west/accounts/" + std::string(6 - digits.size(), '0') + digits;
+        }
+
+        // Keys sharing a long prefix are stored prefix-compressed in their pages; lookups
+        // still match them whole, and keys that only share the prefix are not found.
+        void
+        run_prefixed_keys_test()
+        {
+            const std::string db_name = make_test_db_name("index_prefixed_keys_test");
+            remove_test_db(db_name);
+
+            {
+                engine::Engine bootstrap;
+                bootstrap.create_db(types::Config::std(db_name));
+                bootstrap.execute_query("create table common.test_keys(name string, n integer)");
+                bootstrap.execute_query("create unique index test_keys_name on common.test_keys(name)");
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+
+                constexpr int batch = 250;
+                for (int first = 0; first < TEST_ROWS; first += batch)
+                {
+                    std::string query = "insert into common.test_keys(name, n) values ";
+                    for (int i = first; i < first + batch; ++i)
+                    {
+                        const int n = static_cast<int>((i * 7919LL) % TEST_ROWS);
+                        query += "('" + make_prefixed_key(n) + "', " + std::to_string(n) + "), ";
+                    }
+                    query.resize(query.size() - 2);
+                    engine.execute_query(query);
+                }
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+
+                const auto lookup = [](const std::string& name)
+                {
+                    return "select * from common.test_keys where name == '" + name + "'";
+                };
+                for (int n = 0; n < TEST_ROWS; n += 97)
+                {
+                    expect_rows(engine, lookup(make_prefixed_key(n)), 1);
+                }
+                expect_rows(engine, lookup(make_prefixed_key(TEST_ROWS - 1)), 1);
+                expect_rows(engine, lookup(make_prefixed_key(TEST_ROWS)), 0);
+                expect_rows(engine, lookup("customers/region-eu-west/accounts/"), 0);
+                expect_rows(engine, lookup(make_prefixed_key(5) + "x"), 0);
+
+                expect_failure(
+                    engine, "insert into common.test_keys(name, n) values ('" + make_prefixed_key(42) + "', 0)"
+                );
+                engine.execute_query(
+                    "insert into common.test_keys(name, n) values ('" + make_prefixed_key(42) + "x', 0)"
+                );
+                expect_rows(engine, lookup(make_prefixed_key(42) + "x"), 1);
+                expect_rows(engine, lookup(make_prefixed_key(42)), 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Prefixed keys test passed." << std::endl;
+        }
+
+        // Key ranges start at the leaf holding their lower bound and follow the leaf chain;
+        // open ends, empty ranges and rows deleted from the middle are all honoured.
+        void
+        run_index_range_test()
+        {
+            const std::string db_name = make_test_db_name("index_range_test");
+            create_test_db(db_name);
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+
+                expect_rows(engine, "select * from common.test_index where id < 100", 100);
+                expect_rows(engine, "select * from common.test_index where id <= 99", 100);
+                expect_rows(engine, "select * from common.test_index where id > 1399", 100);
+                expect_rows(engine, "select * from common.test_index where id >= 750", 750);
+                expect_rows(engine, "select * from common.test_index where id < 0", 0);
+                expect_rows(engine, "select * from common.test_index where id > 1499", 0);
+                expect_rows(engine, "select * from common.test_index where id != 777", TEST_ROWS - 1);
+
+                engine.execute_query("delete from common.test_index where id == 20");
+                engine.execute_query("delete from common.test_index where id == 1450");
+                expect_rows(engine, "select * from common.test_index where id < 100", 99);
+                expect_rows(engine, "select * from common.test_index where id > 1399", 99);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Index range test passed." << std::endl;
+        }
+
+        // A non-unique index keeps every row of a key, even when they span several leaves,
+        // and drops exactly the rows that are deleted.
+        void
+        run_duplicate_keys_test()
+        {
+            const std::string db_name = make_test_db_name("index_duplicate_keys_test");
+            create_test_db(db_name);
+
+            const int per_category = TEST_ROWS / TEST_CATEGORIES;
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+
+                expect_rows(engine, "select * from common.test_index where cat == 2", per_category);
+                expect_rows(engine, "select * from common.test_index where cat < 2", 2 * per_category);
+                expect_rows(engine, "select * from common.test_index where cat > 3", per_category);
+                expect_rows(engine, "select * from common.test_index where cat == 5", 0);
+
+                // Both ids are in category 2.
+                engine.execute_query("delete from common.test_index where id == 7");
+                engine.execute_query("delete from common.test_index where id == 1447");
+                engine.execute_query("insert into common.test_index(id, cat) values (1500, 2)");
+                engine.execute_query("insert into common.test_index(id, cat) values (1501, 2)");
+                expect_rows(engine, "select * from common.test_index where cat == 2", per_category);
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_index where cat == 2", per_category);
+                expect_rows(engine, "select * from common.test_index where id == 1501", 1);
+                expect_failure(engine, "insert into common.test_index(id, cat) values (1501, 3)");
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Duplicate keys test passed." << std::endl;
+        }
+
+        void
+        expect_lookups(engine::Engine& engine)
+        {
+            const int per_category = TEST_ROWS / TEST_CATEGORIES;
+
+            expect_rows(engine, "select * from common.test_index", TEST_ROWS);
+            expect_rows(engine, "select * from common.test_index where id == 0", 1);
+            expect_rows(engine, "select * from common.test_index where id == 1234", 1);
+            expect_rows(engine, "select * from common.test_index where id == 1499", 1);
+            expect_rows(engine, "select * from common.test_index where id == 1500", 0);
+            expect_rows(engine, "select * from common.test_index where id < 100", 100);
+            expect_rows(engine, "select * from common.test_index where id > 1399", 100);
+            expect_rows(engine, "select * from common.test_index where id >= 750", 750);
+            expect_rows(engine, "select * from common.test_index where cat == 2", per_category);
+            expect_rows(engine, "select * from common.test_index where cat < 2", 2 * per_category);
+            expect_rows(engine, "select * from common.test_index where cat > 3", per_category);
+        }
+
+        // CREATE INDEX over existing rows bulk-loads the same contents the row by row path
+        // builds, also when the sort spills to runs on disk, and a unique index over
+        // duplicated keys is refused without leaving anything behind.
+        void
+        run_index_bulk_load_test()
+        {
+            const std::string db_name = make_test_db_name("index_bulk_load_test");
+
+            // A sort budget of a few KB, far below the keys of either index.
+            auto config = types::Config::std(db_name);
+            config.index_build_bytes = 8 * 1024;
+            create_test_db(config, false);
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_lookups(engine);
+
+                expect_failure(
+                    engine, "create unique index test_index_cat_unique on common.test_index(cat)"
+                );
+                expect_failure(engine, "insert into common.test_index(id, cat) values (1234, 0)");
+                engine.execute_query("insert into common.test_index(id, cat) values (1500, 2)");
+                expect_rows(engine, "select * from common.test_index where id == 1500", 1);
+                expect_rows(
+                    engine, "select * from common.test_index where cat == 2", TEST_ROWS / TEST_CATEGORIES + 1
+                );
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_index where id >= 750", 751);
+                expect_rows(
+                    engine, "select * from common.test_index where cat == 2", TEST_ROWS / TEST_CATEGORIES + 1
+                );
+            }
+
+            remove_test_db(db_name);
+
+            // The indexes filled row by row answer the same.
+            create_test_db(db_name);
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_lookups(engine);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Index bulk load test passed." << std::endl;
+        }
+
+        // An index created while a transaction has rows deleted or replaced keeps the old
+        // versions: when the transaction rolls back, the rows it brings back are found
+        // through the index.
+        void
+        run_index_build_versions_test()
+        {
+            const std::string db_name = make_test_db_name("index_build_versions_test");
+            remove_test_db(db_name);
+
+            {
+                engine::Engine bootstrap;
+                bootstrap.create_db(types::Config::std(db_name));
+                bootstrap.execute_query("create table common.test_index(id integer, cat integer)");
+            }
+
+            {
+                engine::Engine writer;
+                writer.attach_db(db_name);
+                std::string query = "insert into common.test_index(id, cat) values ";
+                for (int id = 0; id < 100; ++id)
+                {
+                    query += "(" + std::to_string(id) + ", " + std::to_string(id % TEST_CATEGORIES) + "), ";
+                }
+                query.resize(query.size() - 2);
+                writer.execute_query(query);
+
+                engine::Engine builder;
+                builder.attach_db(db_name);
+
+                writer.execute_query("begin");
+                writer.execute_query("update common.test_index set cat = 9 where id == 7");
+                writer.execute_query("delete from common.test_index where id == 8");
+
+                // The old and the new version of row 7 share its id without breaking uniqueness.
+                builder.execute_query("create unique index test_index_id on common.test_index(id)");
+                builder.execute_query("create index test_index_cat on common.test_index(cat)");
+                expect_rows(builder, "select * from common.test_index where id == 7", 1);
+                expect_rows(builder, "select * from common.test_index where id == 8", 1);
+                expect_rows(builder, "select * from common.test_index where cat == 2", 20);
+
+                writer.execute_query("rollback");
+
+                expect_rows(builder, "select * from common.test_index where id == 7", 1);
+                expect_rows(builder, "select * from common.test_index where id == 8", 1);
+                expect_rows(builder, "select * from common.test_index where cat == 2", 20);
+                expect_rows(builder, "select * from common.test_index where cat == 3", 20);
+                expect_rows(builder, "select * from common.test_index where cat == 9", 0);
+                expect_failure(builder, "insert into common.test_index(id, cat) values (8, 0)");
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Index build versions test passed." << std::endl;
+        }
+    }
+
+    void
+    run_index_tests()
+    {
+        run_index_pages_test();
+        run_point_lookup_test();
+        run_prefixed_keys_test();
+        run_index_range_test();
+        run_duplicate_keys_test();
+        run_index_bulk_load_test();
+        run_index_build_versions_test();
+    }
+}
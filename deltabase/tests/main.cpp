@@ -1,5 +1,7 @@
 #include "../src/engine/include/engine.hpp"
+#include "../src/storage/include/io_manager_factory.hpp"
 #include "static_storage.hpp"
+#include "test_support.hpp"
 
 #include <chrono>
 #include <csignal>
@@ -8,7 +10,9 @@
 #include <stdexcept>
 #include <string>
 #include <sys/wait.h>
+#include <unordered_map>
 #include <unistd.h>
+#include <vector>
 
 namespace
 {
@@ -23,7 +27,7 @@ namespace
     }
 
     int
-    run_insert_worker(const std::string& db_name, int start_id, int rows, int start_read_fd)
+    run_insert_worker(const std::string& db_name, int rows, int start_read_fd)
     {
         char start_signal = 0;
         if (read(start_read_fd, &start_signal, 1) != 1)
@@ -31,34 +35,50 @@ namespace
             return 2;
         }
 
-        engine::Engine engine;
-        engine.attach_db(db_name);
-
-        for (int i = 0; i < rows; ++i)
+        // The worker is a forked copy of the runner: an escaping exception would carry on
+        // with the remaining suites in the child.
+        try
         {
-            const int id = start_id + i;
-            const std::string query =
-                std::string("insert into common.test_concurrent(id, payload) values (")
-                + std::to_string(id)
-                + ", 'worker_"
-                + std::to_string(start_id)
-                + "')";
-
-            engine.execute_query(query);
+            engine::Engine engine;
+            engine.attach_db(db_name);
+
+            for (int id = 0; id < rows; ++id)
+            {
+                engine.execute_query(
+                    "insert into common.test_concurrent(id, payload) values (" + std::to_string(id)
+                    + ", 'worker')"
+                );
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << "Insert worker failed: " << ex.what() << std::endl;
+            return 1;
         }
 
         return 0;
     }
 
+    size_t
+    count_pages(const std::unordered_map<types::TableId, std::vector<types::DataPageId>>& pages)
+    {
+        size_t count = 0;
+        for (const auto& [table_id, ids] : pages)
+        {
+            count += ids.size();
+        }
+
+        return count;
+    }
+
+    // The runner keeps its own file directory of the database open while a worker process
+    // attached to the same database fills a table. The pages the worker wrote have to be
+    // found through that directory afterwards, both on a lookup miss and when listing.
     void
     run_concurrent_two_processes_test()
     {
-        const auto executable_path = misc::StaticStorage::get_executable_path();
         const std::string db_name = make_test_db_name();
-        const auto db_path = executable_path / "data" / db_name;
-
-        std::error_code ec;
-        std::filesystem::remove_all(db_path, ec);
+        tests::remove_test_db(db_name);
 
         {
             engine::Engine bootstrap;
@@ -66,101 +86,103 @@ namespace
             bootstrap.execute_query("create table common.test_concurrent(id integer, payload string)");
         }
 
-        int start_pipe_1[2] = {-1, -1};
-        int start_pipe_2[2] = {-1, -1};
-        if (pipe(start_pipe_1) != 0 || pipe(start_pipe_2) != 0)
-        {
-            throw std::runtime_error("Failed to create synchronization pipes");
-        }
-
-        constexpr int rows_per_worker = 100;
+        const auto config = types::Config::std(db_name);
+        const storage::IOManagerFactory io_factory;
+        const auto observer = io_factory.make(config);
+        const size_t pages_before = count_pages(observer->map_data_pages_for_table());
 
-        const pid_t worker_1 = fork();
-        if (worker_1 < 0)
+        int start_pipe[2] = {-1, -1};
+        if (pipe(start_pipe) != 0)
         {
-            throw std::runtime_error("Failed to fork first worker");
+            throw std::runtime_error("Failed to create synchronization pipe");
         }
 
-        if (worker_1 == 0)
-        {
-            close(start_pipe_1[1]);
-            close(start_pipe_2[0]);
-            close(start_pipe_2[1]);
-            const int code = run_insert_worker(db_name, 0, rows_per_worker, start_pipe_1[0]);
-            close(start_pipe_1[0]);
-            _exit(code);
-        }
+        constexpr int rows = 100;
 
-        const pid_t worker_2 = fork();
-        if (worker_2 < 0)
+        const pid_t worker = fork();
+        if (worker < 0)
         {
-            kill(worker_1, SIGTERM);
-            throw std::runtime_error("Failed to fork second worker");
+            throw std::runtime_error("Failed to fork worker");
         }
 
-        if (worker_2 == 0)
+        if (worker == 0)
         {
-            close(start_pipe_2[1]);
-            close(start_pipe_1[0]);
-            close(start_pipe_1[1]);
-            const int code = run_insert_worker(db_name, 100000, rows_per_worker, start_pipe_2[0]);
-            close(start_pipe_2[0]);
+            close(start_pipe[1]);
+            const int code = run_insert_worker(db_name, rows, start_pipe[0]);
+            close(start_pipe[0]);
             _exit(code);
         }
 
-        close(start_pipe_1[0]);
-        close(start_pipe_2[0]);
+        close(start_pipe[0]);
 
         const char start_signal = 'S';
-        if (write(start_pipe_1[1], &start_signal, 1) != 1 || write(start_pipe_2[1], &start_signal, 1) != 1)
+        if (write(start_pipe[1], &start_signal, 1) != 1)
         {
-            kill(worker_1, SIGTERM);
-            kill(worker_2, SIGTERM);
-            throw std::runtime_error("Failed to send start signal to workers");
+            kill(worker, SIGTERM);
+            throw std::runtime_error("Failed to send start signal to worker");
         }
 
-        close(start_pipe_1[1]);
-        close(start_pipe_2[1]);
-
-        int status_1 = 0;
-        int status_2 = 0;
+        close(start_pipe[1]);
 
-        if (waitpid(worker_1, &status_1, 0) < 0 || waitpid(worker_2, &status_2, 0) < 0)
+        int status = 0;
+        if (waitpid(worker, &status, 0) < 0)
         {
-            throw std::runtime_error("Failed waiting for workers");
+            throw std::runtime_error("Failed waiting for worker");
         }
 
-        const bool worker_1_ok = WIFEXITED(status_1) && WEXITSTATUS(status_1) == 0;
-        const bool worker_2_ok = WIFEXITED(status_2) && WEXITSTATUS(status_2) == 0;
-
-        if (!worker_1_ok || !worker_2_ok)
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
         {
-            throw std::runtime_error("At least one worker failed during concurrent insert");
+            throw std::runtime_error("Worker failed during insert");
         }
 
-        engine::Engine verifier;
-        verifier.attach_db(db_name);
+        // Ids of the worker's pages come from a directory built after it finished; the
+        // observer built its own before any of them existed.
+        const auto written = io_factory.make(config)->map_data_pages_for_table();
+        if (count_pages(written) <= pages_before)
+        {
+            throw std::runtime_error("Worker wrote no data pages");
+        }
 
-        auto result = verifier.execute_query("select * from common.test_concurrent");
-        types::DataRow row;
         int total_rows = 0;
-        while (result->next(row))
+        for (const auto& [table_id, ids] : written)
         {
-            total_rows++;
+            for (const auto& page_id : ids)
+            {
+                const auto page = observer->read_data_page(page_id);
+                if (!page)
+                {
+                    throw std::runtime_error(
+                        "Page " + page_id.to_string() + " written by another process was not found"
+                    );
+                }
+
+                total_rows += page->slot_count;
+            }
         }
 
-        const int expected_rows = rows_per_worker * 2;
-        if (total_rows != expected_rows)
+        if (total_rows != rows)
         {
             throw std::runtime_error(
-                std::string("Unexpected row count after concurrent writes. Expected ")
-                + std::to_string(expected_rows)
+                std::string("Unexpected row count in pages written by the worker. Expected ")
+                + std::to_string(rows)
                 + ", got "
                 + std::to_string(total_rows)
             );
         }
 
-        std::cout << "Concurrent multi-process insert test passed. Rows: " << total_rows << std::endl;
+        if (count_pages(observer->map_data_pages_for_table()) != count_pages(written))
+        {
+            throw std::runtime_error("Listing pages missed pages written by another process");
+        }
+
+        {
+            engine::Engine verifier;
+            verifier.attach_db(db_name);
+            tests::expect_rows(verifier, "select * from common.test_concurrent", rows);
+        }
+
+        tests::remove_test_db(db_name);
+        std::cout << "Concurrent multi-process test passed. Rows: " << total_rows << std::endl;
     }
 }
 
@@ -192,14 +214,31 @@ int main(int argc, char** argv) {
     //
     // }
 
-    try
+    const std::vector<void (*)()> suites = {
+        run_concurrent_two_processes_test,
+        tests::run_registry_tests,
+        tests::run_storage_tests,
+        tests::run_buffer_pool_tests,
+        tests::run_recovery_tests,
+        tests::run_wal_tests,
+        tests::run_index_tests,
+        tests::run_transaction_tests,
+    };
+
+    // Every suite runs even if an earlier one failed.
+    int failed = 0;
+    for (const auto& test : suites)
     {
-        run_concurrent_two_processes_test();
-        return 0;
-    }
-    catch (const std::exception& ex)
-    {
-        std::cerr << "Test failed: " << ex.what() << std::endl;
-        return 1;
+        try
+        {
+            test();
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << "Test failed: " << ex.what() << std::endl;
+            failed++;
+        }
     }
+
+    return failed == 0 ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,370 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "test_support.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace tests
+{
+    namespace
+    {
+        constexpr int TEST_ROWS = 300;
+
+        void
+        create_test_table(const types::Config& config)
+        {
+            remove_test_db(*config.db_name);
+
+            engine::Engine bootstrap;
+            bootstrap.create_db(config);
+            bootstrap.execute_query("create table common.test_recovery(id integer, payload string)");
+        }
+
+        void
+        insert_padded_rows(engine::Engine& engine, int first_id, int rows)
+        {
+            const std::string padding(200, 'x');
+            for (int id = first_id; id < first_id + rows; ++id)
+            {
+                engine.execute_query(
+                    "insert into common.test_recovery(id, payload) values (" + std::to_string(id)
+                    + ", '" + padding + "')"
+                );
+            }
+        }
+
+        std::uintmax_t
+        data_pages_size(const std::string& db_name)
+        {
+            const auto data_dir = misc::StaticStorage::get_executable_path() / "data" / db_name
+                                  / "common" / "test_recovery" / "data";
+
+            std::uintmax_t size = 0;
+            for (const auto& entry : std::filesystem::directory_iterator(data_dir))
+            {
+                size += entry.file_size();
+            }
+
+            return size;
+        }
+
+        // Commits only wait for the WAL, so rows committed long before the next page write
+        // come back from redo.
+        void
+        run_crash_before_page_write_test()
+        {
+            const std::string db_name = make_test_db_name("recovery_redo_test");
+
+            auto config = types::Config::std(db_name);
+            config.page_writer_interval_ms = 60000;
+            config.page_writer_max_dirty_age_ms = 60000;
+            create_test_table(config);
+
+            run_and_crash(
+                db_name,
+                [](engine::Engine& engine)
+                {
+                    insert_padded_rows(engine, 0, TEST_ROWS);
+                    engine.execute_query("update common.test_recovery set payload = 'updated' where id == 7");
+                }
+            );
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_recovery", TEST_ROWS);
+                expect_rows(engine, "select * from common.test_recovery where payload == 'updated'", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Crash before page write test passed." << std::endl;
+        }
+
+        // The page writer writes committed frames out on its own while the session is idle.
+        void
+        run_background_page_writer_test()
+        {
+            const std::string db_name = make_test_db_name("recovery_page_writer_test");
+
+            auto config = types::Config::std(db_name);
+            config.page_writer_interval_ms = 20;
+            config.page_writer_max_dirty_age_ms = 0;
+            create_test_table(config);
+
+            run_and_crash(
+                db_name,
+                [](engine::Engine& engine)
+                {
+                    insert_padded_rows(engine, 0, TEST_ROWS);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                }
+            );
+
+            if (data_pages_size(db_name) < TEST_ROWS * 200)
+            {
+                throw std::runtime_error("Page writer left committed rows only in the WAL");
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_recovery", TEST_ROWS);
+                insert_padded_rows(engine, TEST_ROWS, 10);
+                expect_rows(engine, "select * from common.test_recovery", TEST_ROWS + 10);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Background page writer test passed." << std::endl;
+        }
+
+        // Row counters come back from their delta records, so rows inserted after recovery
+        // get row ids of their own and statements address exactly the rows they match.
+        void
+        run_counters_recovery_test()
+        {
+            const std::string db_name = make_test_db_name("recovery_counters_test");
+
+            auto config = types::Config::std(db_name);
+            config.page_writer_interval_ms = 60000;
+            create_test_table(config);
+
+            run_and_crash(
+                db_name,
+                [](engine::Engine& engine)
+                {
+                    insert_padded_rows(engine, 0, 200);
+                    engine.execute_query("update common.test_recovery set payload = 'updated' where id == 10");
+                    engine.execute_query("delete from common.test_recovery where id == 20");
+                    engine.execute_query("delete from common.test_recovery where id == 30");
+                }
+            );
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_recovery", 198);
+
+                insert_padded_rows(engine, 200, 50);
+                engine.execute_query("update common.test_recovery set payload = 'after' where id == 220");
+                engine.execute_query("delete from common.test_recovery where id == 230");
+
+                expect_rows(engine, "select * from common.test_recovery", 247);
+                expect_rows(engine, "select * from common.test_recovery where payload == 'after'", 1);
+                expect_rows(engine, "select * from common.test_recovery where payload == 'updated'", 1);
+                expect_rows(engine, "select * from common.test_recovery where id == 20", 0);
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_recovery", 247);
+                expect_rows(engine, "select * from common.test_recovery where id == 220", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Counters recovery test passed." << std::endl;
+        }
+
+        // One statement inserting rows over several pages logs a record per page; redo
+        // brings back every row of it.
+        void
+        run_multi_row_insert_recovery_test()
+        {
+            const std::string db_name = make_test_db_name("recovery_multi_row_test");
+
+            auto config = types::Config::std(db_name);
+            config.page_writer_interval_ms = 60000;
+            create_test_table(config);
+
+            const std::string padding(200, 'x');
+            run_and_crash(
+                db_name,
+                [&](engine::Engine& engine)
+                {
+                    std::string query = "insert into common.test_recovery(id, payload) values ";
+                    for (int id = 0; id < 500; ++id)
+                    {
+                        query += "(" + std::to_string(id) + ", '" + padding + "'), ";
+                    }
+                    query.resize(query.size() - 2);
+                    engine.execute_query(query);
+
+                    engine.execute_query(
+                        "insert into common.test_recovery(id, payload) values (500, 'last'), (501, 'last')"
+                    );
+                }
+            );
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_recovery", 502);
+                expect_rows(engine, "select * from common.test_recovery where id == 250", 1);
+                expect_rows(engine, "select * from common.test_recovery where payload == 'last'", 2);
+
+                insert_padded_rows(engine, 502, 10);
+                expect_rows(engine, "select * from common.test_recovery", 512);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Multi-row insert recovery test passed." << std::endl;
+        }
+
+        // Index pages are not logged, so the committed rows the WAL brings back after a
+        // crash must reach the index too.
+        void
+        run_crash_recovery_with_index_test()
+        {
+            const std::string db_name = make_test_db_name("recovery_index_test");
+            remove_test_db(db_name);
+
+            {
+                // Nothing writes pages in the background before the crash.
+                auto config = types::Config::std(db_name);
+                config.page_writer_interval_ms = 60000;
+                config.checkpoint_interval_ms = 60000;
+
+                engine::Engine bootstrap;
+                bootstrap.create_db(config);
+                bootstrap.execute_query("create table common.test_recovery(id integer, payload string)");
+                bootstrap.execute_query("create unique index test_recovery_id on common.test_recovery(id)");
+            }
+
+            run_and_crash(
+                db_name,
+                [](engine::Engine& engine)
+                {
+                    std::string query = "insert into common.test_recovery(id, payload) values ";
+                    for (int id = 0; id < 400; ++id)
+                    {
+                        query += "(" + std::to_string(id) + ", 'bulk'), ";
+                    }
+                    query.resize(query.size() - 2);
+                    engine.execute_query(query);
+
+                    for (int id = 400; id < 500; ++id)
+                    {
+                        engine.execute_query(
+                            "insert into common.test_recovery(id, payload) values ("
+                            + std::to_string(id) + ", 'single')"
+                        );
+                    }
+                }
+            );
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+
+                expect_rows(engine, "select * from common.test_recovery", 500);
+                expect_rows(engine, "select * from common.test_recovery where id == 321", 1);
+                expect_rows(engine, "select * from common.test_recovery where id == 499", 1);
+                expect_rows(engine, "select * from common.test_recovery where id >= 450", 50);
+                expect_rows(engine, "select * from common.test_recovery where id < 100", 100);
+
+                expect_failure(engine, "insert into common.test_recovery(id, payload) values (321, 'again')");
+                engine.execute_query("insert into common.test_recovery(id, payload) values (500, 'after')");
+                expect_rows(engine, "select * from common.test_recovery where id == 500", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Crash recovery with index test passed." << std::endl;
+        }
+
+        // A crash while a file is being replaced leaves its next version behind under a
+        // temporary name; the files themselves stay whole and the leftover is ignored.
+        void
+        run_leftover_temp_files_test()
+        {
+            const std::string db_name = make_test_db_name("recovery_temp_files_test");
+            create_test_table(types::Config::std(db_name));
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                insert_padded_rows(engine, 0, TEST_ROWS);
+            }
+
+            const auto db_dir = misc::StaticStorage::get_executable_path() / "data" / db_name;
+            const auto table_dir = db_dir / "common" / "test_recovery";
+            std::vector<std::filesystem::path> leftovers = {
+                db_dir / (db_name + ".meta.tmp"),
+                table_dir / "test_recovery.meta.tmp",
+            };
+            for (const auto& entry : std::filesystem::directory_iterator(table_dir / "data"))
+            {
+                auto leftover = entry.path();
+                leftover += ".tmp";
+                leftovers.push_back(leftover);
+            }
+
+            for (const auto& leftover : leftovers)
+            {
+                std::ofstream(leftover, std::ios::binary) << "torn";
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_recovery", TEST_ROWS);
+                insert_padded_rows(engine, TEST_ROWS, 10);
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_recovery", TEST_ROWS + 10);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Leftover temp files test passed." << std::endl;
+        }
+
+        // A shutdown checkpoint that fails is logged rather than thrown out of the closing
+        // instance, and the next attach recovers from the checkpoint before it.
+        void
+        run_failed_shutdown_checkpoint_test()
+        {
+            const std::string db_name = make_test_db_name("recovery_shutdown_checkpoint_test");
+            create_test_table(types::Config::std(db_name));
+
+            // A directory in the place of the config's temporary file breaks the checkpoint.
+            const auto db_dir = misc::StaticStorage::get_executable_path() / "data" / db_name;
+            const auto blocker = db_dir / (db_name + ".meta.tmp");
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                insert_padded_rows(engine, 0, TEST_ROWS);
+                std::filesystem::create_directory(blocker);
+            }
+            std::filesystem::remove(blocker);
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_recovery", TEST_ROWS);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Failed shutdown checkpoint test passed." << std::endl;
+        }
+    }
+
+    void
+    run_recovery_tests()
+    {
+        run_crash_before_page_write_test();
+        run_background_page_writer_test();
+        run_counters_recovery_test();
+        run_multi_row_insert_recovery_test();
+        run_crash_recovery_with_index_test();
+        run_leftover_temp_files_test();
+        run_failed_shutdown_checkpoint_test();
+    }
+}
@@ -0,0 +1,169 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "test_support.hpp"
+#include "../src/storage/include/db_instance_registry.hpp"
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace tests
+{
+    namespace
+    {
+        void
+        create_test_table(const std::string& db_name)
+        {
+            remove_test_db(db_name);
+
+            engine::Engine bootstrap;
+            bootstrap.create_db(types::Config::std(db_name));
+            bootstrap.execute_query("create table common.test_registry(id integer, payload string)");
+        }
+
+        void
+        insert_rows(engine::Engine& engine, int first_id, int rows)
+        {
+            for (int id = first_id; id < first_id + rows; ++id)
+            {
+                engine.execute_query(
+                    "insert into common.test_registry(id, payload) values (" + std::to_string(id)
+                    + ", 'session')"
+                );
+            }
+        }
+
+        // Sessions of one database share its instance, so each sees what the other wrote
+        // without going through the disk.
+        void
+        run_shared_instance_test()
+        {
+            const std::string db_name = make_test_db_name("registry_shared_test");
+            create_test_table(db_name);
+
+            const auto registry = storage::DbInstanceRegistry::shared();
+            const auto config = types::Config::std(db_name);
+
+            auto first = registry->acquire(config);
+            auto second = registry->acquire(config);
+            if (first != second)
+            {
+                throw std::runtime_error("Two acquires of one database returned different instances");
+            }
+
+            {
+                engine::Engine writer;
+                writer.attach_db(db_name);
+                engine::Engine reader;
+                reader.attach_db(db_name);
+
+                insert_rows(writer, 0, 20);
+                expect_rows(reader, "select * from common.test_registry", 20);
+                insert_rows(reader, 20, 5);
+                expect_rows(writer, "select * from common.test_registry", 25);
+            }
+
+            const std::weak_ptr<storage::StdDbInstance> observer = first;
+            first.reset();
+            if (observer.expired())
+            {
+                throw std::runtime_error("Instance was closed while a session still held it");
+            }
+
+            second.reset();
+            if (!observer.expired())
+            {
+                throw std::runtime_error("Instance outlived the last session that held it");
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Shared instance test passed." << std::endl;
+        }
+
+        // Closing the last session writes the database out; the next attach opens it anew.
+        void
+        run_reopen_after_release_test()
+        {
+            const std::string db_name = make_test_db_name("registry_reopen_test");
+            create_test_table(db_name);
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                insert_rows(engine, 0, 30);
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_registry", 30);
+                expect_rows(engine, "select * from common.test_registry where id == 17", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Reopen after release test passed." << std::endl;
+        }
+
+        // Attaches racing on a database that is not open yet share the one instance the
+        // first of them opens, while another database opens alongside.
+        void
+        run_concurrent_acquire_test()
+        {
+            const std::string db_name = make_test_db_name("registry_concurrent_test");
+            const std::string other_name = make_test_db_name("registry_concurrent_other_test");
+            create_test_table(db_name);
+            create_test_table(other_name);
+
+            const auto registry = storage::DbInstanceRegistry::shared();
+            const auto config = types::Config::std(db_name);
+
+            constexpr size_t threads_count = 8;
+            std::vector<std::shared_ptr<storage::StdDbInstance>> instances(threads_count);
+            std::shared_ptr<storage::StdDbInstance> other;
+            {
+                std::vector<std::thread> threads;
+                for (size_t i = 0; i < threads_count; ++i)
+                {
+                    threads.emplace_back([&, i] { instances[i] = registry->acquire(config); });
+                }
+                threads.emplace_back([&] { other = registry->acquire(types::Config::std(other_name)); });
+
+                for (auto& thread : threads)
+                {
+                    thread.join();
+                }
+            }
+
+            for (const auto& instance : instances)
+            {
+                if (!instance || instance != instances.front())
+                {
+                    throw std::runtime_error("Concurrent acquires of one database returned different instances");
+                }
+            }
+
+            if (!other || other == instances.front())
+            {
+                throw std::runtime_error("Another database was not opened on its own");
+            }
+
+            instances.clear();
+            other.reset();
+
+            remove_test_db(db_name);
+            remove_test_db(other_name);
+            std::cout << "Concurrent acquire test passed." << std::endl;
+        }
+    }
+
+    void
+    run_registry_tests()
+    {
+        run_shared_instance_test();
+        run_reopen_after_release_test();
+        run_concurrent_acquire_test();
+    }
+}
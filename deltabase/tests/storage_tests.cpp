@@ -0,0 +1,352 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "test_support.hpp"
+
+#include <iostream>
+#include <map>
+
+namespace tests
+{
+    namespace
+    {
+        void
+        insert_padded_rows(engine::Engine& engine, const std::string& table, int first_id, int rows)
+        {
+            const std::string padding(200, 'x');
+            for (int id = first_id; id < first_id + rows; ++id)
+            {
+                engine.execute_query(
+                    "insert into common." + table + "(id, payload) values (" + std::to_string(id)
+                    + ", '" + padding + "')"
+                );
+            }
+        }
+
+        std::filesystem::path
+        table_dir(const std::string& db_name, const std::string& table)
+        {
+            return misc::StaticStorage::get_executable_path() / "data" / db_name / "common" / table;
+        }
+
+        size_t
+        count_data_pages(const std::string& db_name, const std::string& table)
+        {
+            size_t pages = 0;
+            for (const auto& entry : std::filesystem::directory_iterator(table_dir(db_name, table) / "data"))
+            {
+                if (entry.is_regular_file())
+                {
+                    pages++;
+                }
+            }
+
+            return pages;
+        }
+
+        // Pages and index files created after the file directory was first built have to be
+        // found through it, both by the session that created them and after a reopen.
+        void
+        run_file_directory_test()
+        {
+            const std::string db_name = make_test_db_name("file_directory_test");
+            remove_test_db(db_name);
+
+            {
+                engine::Engine bootstrap;
+                bootstrap.create_db(types::Config::std(db_name));
+                bootstrap.execute_query("create table common.test_first(id integer, payload string)");
+            }
+
+            const auto check = [](engine::Engine& engine)
+            {
+                expect_rows(engine, "select * from common.test_first", 600);
+                expect_rows(engine, "select * from common.test_first where id == 599", 1);
+                expect_rows(engine, "select * from common.test_second", 40);
+                expect_rows(engine, "select * from common.test_second where id == 25", 1);
+            };
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+
+                // Spans several data pages.
+                insert_padded_rows(engine, "test_first", 0, 600);
+
+                engine.execute_query("create table common.test_second(id integer, payload string)");
+                engine.execute_query("create unique index test_second_id on common.test_second(id)");
+                insert_padded_rows(engine, "test_second", 0, 40);
+
+                check(engine);
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                check(engine);
+                expect_failure(
+                    engine, "insert into common.test_second(id, payload) values (25, 'again')"
+                );
+            }
+
+            remove_test_db(db_name);
+            std::cout << "File directory test passed." << std::endl;
+        }
+
+        // Small rows go into the room large rows left on existing pages, and appends keep
+        // going to the tail page, whether the free space map was saved or has to be rebuilt.
+        void
+        run_free_space_map_test()
+        {
+            const std::string db_name = make_test_db_name("free_space_map_test");
+            remove_test_db(db_name);
+
+            {
+                engine::Engine bootstrap;
+                bootstrap.create_db(types::Config::std(db_name));
+                bootstrap.execute_query("create table common.test_fsm(id integer, payload string)");
+            }
+
+            const std::string large(1000, 'l');
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+
+                std::string query = "insert into common.test_fsm(id, payload) values ";
+                for (int id = 0; id < 300; ++id)
+                {
+                    query += "(" + std::to_string(id) + ", '" + large + "'), ";
+                }
+                query.resize(query.size() - 2);
+                engine.execute_query(query);
+            }
+
+            const size_t pages = count_data_pages(db_name, "test_fsm");
+            if (pages < 5)
+            {
+                throw std::runtime_error("Large rows did not span several pages");
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                for (int id = 300; id < 340; ++id)
+                {
+                    engine.execute_query(
+                        "insert into common.test_fsm(id, payload) values (" + std::to_string(id) + ", 'small')"
+                    );
+                }
+                expect_rows(engine, "select * from common.test_fsm", 340);
+            }
+
+            if (count_data_pages(db_name, "test_fsm") != pages)
+            {
+                throw std::runtime_error("Small rows were put on new pages instead of free space");
+            }
+
+            // The map is only a hint: without it the pages are measured again.
+            std::filesystem::remove(table_dir(db_name, "test_fsm") / "test_fsm.fsm");
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                for (int id = 340; id < 380; ++id)
+                {
+                    engine.execute_query(
+                        "insert into common.test_fsm(id, payload) values (" + std::to_string(id) + ", 'small')"
+                    );
+                }
+                expect_rows(engine, "select * from common.test_fsm", 380);
+                expect_rows(engine, "select * from common.test_fsm where payload == 'small'", 80);
+            }
+
+            if (count_data_pages(db_name, "test_fsm") != pages)
+            {
+                throw std::runtime_error("Rebuilt free space map did not find the free space");
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Free space map test passed." << std::endl;
+        }
+
+        using Payloads = std::map<int, std::string>;
+
+        void
+        expect_payloads(engine::Engine& engine, const std::string& table, const Payloads& expected)
+        {
+            Payloads actual;
+            auto result = engine.execute_query("select * from common." + table);
+            types::DataRow row;
+            while (result->next(row))
+            {
+                actual[row.tokens[0].as<int>()] = row.tokens[1].as<std::string>();
+            }
+
+            if (actual != expected)
+            {
+                throw std::runtime_error("Rows of " + table + " differ from what was written");
+            }
+        }
+
+        // Tuples of very different sizes survive inserts, in-place flag flips and updates that
+        // move a row to another page, both in the pool and through redo after a crash.
+        void
+        run_slotted_page_test()
+        {
+            const std::string db_name = make_test_db_name("slotted_page_test");
+            remove_test_db(db_name);
+
+            {
+                auto config = types::Config::std(db_name);
+                config.page_writer_interval_ms = 60000;
+
+                engine::Engine bootstrap;
+                bootstrap.create_db(config);
+                bootstrap.execute_query("create table common.test_slotted(id integer, payload string)");
+            }
+
+            Payloads inserted;
+            for (int id = 0; id < 300; ++id)
+            {
+                inserted[id] = std::string(1 + id * 7 % 1500, static_cast<char>('a' + id % 26));
+            }
+
+            // Grown versions no longer fit where the old ones were.
+            const std::string grown(3000, 'u');
+            Payloads expected = inserted;
+            for (int id = 0; id < 300; id += 10)
+            {
+                expected[id] = grown;
+            }
+            for (int id = 1; id < 300; id += 15)
+            {
+                expected.erase(id);
+            }
+
+            run_and_crash(
+                db_name,
+                [&](engine::Engine& engine)
+                {
+                    for (int first = 0; first < 300; first += 50)
+                    {
+                        std::string query = "insert into common.test_slotted(id, payload) values ";
+                        for (int id = first; id < first + 50; ++id)
+                        {
+                            query += "(" + std::to_string(id) + ", '" + inserted.at(id) + "'), ";
+                        }
+                        query.resize(query.size() - 2);
+                        engine.execute_query(query);
+                    }
+
+                    for (int id = 0; id < 300; id += 10)
+                    {
+                        engine.execute_query(
+                            "update common.test_slotted set payload = '" + grown + "' where id == "
+                            + std::to_string(id)
+                        );
+                    }
+
+                    for (int id = 1; id < 300; id += 15)
+                    {
+                        engine.execute_query("delete from common.test_slotted where id == " + std::to_string(id));
+                    }
+
+                    expect_payloads(engine, "test_slotted", expected);
+                }
+            );
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_payloads(engine, "test_slotted", expected);
+            }
+
+            // Once more from the pages recovery wrote out on close.
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_payloads(engine, "test_slotted", expected);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Slotted page test passed." << std::endl;
+        }
+
+        // Scans expected to return many rows stream them from an open executor instead of
+        // materializing them, and a stream dropped halfway leaves the table usable.
+        void
+        run_streamed_scan_test()
+        {
+            const std::string db_name = make_test_db_name("streamed_scan_test");
+            remove_test_db(db_name);
+
+            constexpr int rows = 3000;
+            {
+                engine::Engine bootstrap;
+                bootstrap.create_db(types::Config::std(db_name));
+                bootstrap.execute_query("create table common.test_first(id integer, payload string)");
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+
+                for (int first = 0; first < rows; first += 500)
+                {
+                    std::string query = "insert into common.test_first(id, payload) values ";
+                    for (int id = first; id < first + 500; ++id)
+                    {
+                        query += "(" + std::to_string(id) + ", '" + (id % 2 == 0 ? "even" : "odd") + "'), ";
+                    }
+                    query.resize(query.size() - 2);
+                    engine.execute_query(query);
+                }
+
+                auto result = engine.execute_query("select * from common.test_first");
+                if (dynamic_cast<types::StreamedResult*>(result.get()) == nullptr)
+                {
+                    throw std::runtime_error("Scan over " + std::to_string(rows) + " rows was not streamed");
+                }
+
+                types::DataRow row;
+                int streamed = 0;
+                while (result->next(row))
+                {
+                    streamed++;
+                }
+                if (streamed != rows)
+                {
+                    throw std::runtime_error(
+                        "Streamed scan returned " + std::to_string(streamed) + " of " + std::to_string(rows)
+                        + " rows"
+                    );
+                }
+                result.reset();
+
+                expect_rows(engine, "select * from common.test_first where payload == 'even'", rows / 2);
+
+                result = engine.execute_query("select * from common.test_first");
+                for (int i = 0; i < 10 && result->next(row); ++i)
+                {
+                }
+                result.reset();
+
+                engine.execute_query("insert into common.test_first(id, payload) values (3000, 'last')");
+                expect_rows(engine, "select * from common.test_first", rows + 1);
+                expect_rows(engine, "select * from common.test_first where payload == 'last'", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Streamed scan test passed." << std::endl;
+        }
+    }
+
+    void
+    run_storage_tests()
+    {
+        run_file_directory_test();
+        run_free_space_map_test();
+        run_slotted_page_test();
+        run_streamed_scan_test();
+    }
+}
@@ -0,0 +1,141 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#ifndef DELTABASE_TEST_SUPPORT_HPP
+#define DELTABASE_TEST_SUPPORT_HPP
+
+#include "../src/engine/include/engine.hpp"
+#include "static_storage.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace tests
+{
+    inline std::string
+    make_test_db_name(const std::string& prefix)
+    {
+        const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+
+        return prefix + "_" + std::to_string(getpid()) + "_" + std::to_string(now);
+    }
+
+    inline void
+    remove_test_db(const std::string& db_name)
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(misc::StaticStorage::get_executable_path() / "data" / db_name, ec);
+    }
+
+    inline int
+    count_rows(engine::Engine& engine, const std::string& query)
+    {
+        auto result = engine.execute_query(query);
+        types::DataRow row;
+        int rows = 0;
+        while (result->next(row))
+        {
+            rows++;
+        }
+
+        return rows;
+    }
+
+    inline void
+    expect_rows(engine::Engine& engine, const std::string& query, int expected)
+    {
+        const int actual = count_rows(engine, query);
+        if (actual != expected)
+        {
+            throw std::runtime_error(
+                std::string("Unexpected row count of '") + query + "'. Expected "
+                + std::to_string(expected) + ", got " + std::to_string(actual)
+            );
+        }
+    }
+
+    inline void
+    expect_failure(engine::Engine& engine, const std::string& query)
+    {
+        try
+        {
+            engine.execute_query(query);
+        }
+        catch (const std::exception&)
+        {
+            return;
+        }
+
+        throw std::runtime_error(std::string("Expected '") + query + "' to fail");
+    }
+
+    // Runs work on the database in a child process that then dies with the database still
+    // attached, leaving it as a crash would.
+    inline void
+    run_and_crash(const std::string& db_name, const std::function<void(engine::Engine&)>& work)
+    {
+        const pid_t child = fork();
+        if (child < 0)
+        {
+            throw std::runtime_error("Failed to fork crashing worker");
+        }
+
+        if (child == 0)
+        {
+            try
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                work(engine);
+                _exit(0);
+            }
+            catch (...)
+            {
+            }
+            _exit(1);
+        }
+
+        int status = 0;
+        if (waitpid(child, &status, 0) < 0)
+        {
+            throw std::runtime_error("Failed waiting for crashing worker");
+        }
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            throw std::runtime_error("Crashing worker failed before the crash");
+        }
+    }
+
+    // Suites, one per file; each throws on the first check that fails.
+    void
+    run_registry_tests();
+
+    void
+    run_storage_tests();
+
+    void
+    run_buffer_pool_tests();
+
+    void
+    run_recovery_tests();
+
+    void
+    run_wal_tests();
+
+    void
+    run_index_tests();
+
+    void
+    run_transaction_tests();
+}
+
+#endif // DELTABASE_TEST_SUPPORT_HPP
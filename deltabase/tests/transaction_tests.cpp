@@ -0,0 +1,558 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "test_support.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace tests
+{
+    namespace
+    {
+        // Creates the database with common.test_txn, indexed by id, holding ids 0 to rows - 1.
+        void
+        create_test_table(const types::Config& config, int rows)
+        {
+            const std::string& db_name = *config.db_name;
+            remove_test_db(db_name);
+
+            {
+                engine::Engine bootstrap;
+                bootstrap.create_db(config);
+                bootstrap.execute_query("create table common.test_txn(id integer, payload string)");
+                bootstrap.execute_query("create unique index test_txn_id on common.test_txn(id)");
+            }
+
+            engine::Engine engine;
+            engine.attach_db(db_name);
+
+            std::string query = "insert into common.test_txn(id, payload) values ";
+            for (int id = 0; id < rows; ++id)
+            {
+                query += "(" + std::to_string(id) + ", 'base'), ";
+            }
+            query.resize(query.size() - 2);
+            engine.execute_query(query);
+        }
+
+        // Sessions inserting into one table through its index, into a second table, updating
+        // and reading at the same time all complete, and every change is there afterwards.
+        void
+        run_concurrent_workload_test()
+        {
+            const std::string db_name = make_test_db_name("txn_concurrent_test");
+            create_test_table(types::Config::std(db_name), 500);
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                engine.execute_query("create table common.test_other(id integer, payload string)");
+            }
+
+            constexpr int writers = 4;
+            constexpr int rows_per_writer = 250;
+            std::atomic<int> failures = 0;
+            std::atomic<int> writers_done = 0;
+            std::vector<std::thread> sessions;
+
+            const auto run_session = [&](const std::function<void(engine::Engine&)>& work)
+            {
+                sessions.emplace_back(
+                    [&, work]
+                    {
+                        try
+                        {
+                            engine::Engine engine;
+                            engine.attach_db(db_name);
+                            work(engine);
+                        }
+                        catch (const std::exception& ex)
+                        {
+                            std::cerr << "Concurrent session failed: " << ex.what() << std::endl;
+                            failures++;
+                        }
+                    }
+                );
+            };
+
+            for (int writer = 0; writer < writers; ++writer)
+            {
+                run_session(
+                    [&, writer](engine::Engine& engine)
+                    {
+                        const int first = 1000 + writer * rows_per_writer;
+                        for (int id = first; id < first + rows_per_writer; ++id)
+                        {
+                            const std::string table = id % 2 == 0 ? "test_txn" : "test_other";
+                            engine.execute_query(
+                                "insert into common." + table + "(id, payload) values (" + std::to_string(id)
+                                + ", 'writer_" + std::to_string(writer) + "')"
+                            );
+                        }
+                        writers_done++;
+                    }
+                );
+            }
+
+            run_session(
+                [&](engine::Engine& engine)
+                {
+                    for (int id = 0; id < 500; id += 5)
+                    {
+                        engine.execute_query(
+                            "update common.test_txn set payload = 'updated' where id == " + std::to_string(id)
+                        );
+                    }
+                }
+            );
+
+            for (int reader = 0; reader < 2; ++reader)
+            {
+                run_session(
+                    [&](engine::Engine& engine)
+                    {
+                        // Scans only have to succeed: without snapshots their row count
+                        // depends on how far the writers got.
+                        while (writers_done < writers)
+                        {
+                            expect_rows(engine, "select * from common.test_txn where id == 251", 1);
+                            count_rows(engine, "select * from common.test_txn");
+                            count_rows(engine, "select * from common.test_other");
+                        }
+                    }
+                );
+            }
+
+            for (auto& session : sessions)
+            {
+                session.join();
+            }
+
+            if (failures != 0)
+            {
+                throw std::runtime_error("At least one session failed during the concurrent workload");
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                const int half = writers * rows_per_writer / 2;
+                expect_rows(engine, "select * from common.test_txn", 500 + half);
+                expect_rows(engine, "select * from common.test_other", half);
+                expect_rows(engine, "select * from common.test_txn where id >= 1000", half);
+                expect_rows(engine, "select * from common.test_txn where payload == 'updated'", 100);
+                expect_rows(
+                    engine, "select * from common.test_other where payload == 'writer_3'", rows_per_writer / 2
+                );
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Concurrent workload test passed." << std::endl;
+        }
+
+        // Every scan reads one snapshot, so updates that move rows between pages while it runs
+        // neither hide a row from it nor show it one twice.
+        void
+        run_statement_snapshot_test()
+        {
+            const std::string db_name = make_test_db_name("txn_statement_snapshot_test");
+            create_test_table(types::Config::std(db_name), 500);
+
+            std::atomic<bool> updating = true;
+            std::atomic<int> failures = 0;
+
+            std::thread updater(
+                [&]
+                {
+                    try
+                    {
+                        engine::Engine engine;
+                        engine.attach_db(db_name);
+                        // Versions of alternating size, so some no longer fit their page.
+                        for (int round = 0; round < 4; ++round)
+                        {
+                            const std::string payload(round % 2 == 0 ? 400 : 10, 'a' + round);
+                            for (int id = 0; id < 500; id += 3)
+                            {
+                                engine.execute_query(
+                                    "update common.test_txn set payload = '" + payload + "' where id == "
+                                    + std::to_string(id)
+                                );
+                            }
+                        }
+                    }
+                    catch (const std::exception& ex)
+                    {
+                        std::cerr << "Updater failed: " << ex.what() << std::endl;
+                        failures++;
+                    }
+                    updating = false;
+                }
+            );
+
+            try
+            {
+                engine::Engine reader;
+                reader.attach_db(db_name);
+                while (updating)
+                {
+                    expect_rows(reader, "select * from common.test_txn", 500);
+                    expect_rows(reader, "select * from common.test_txn where id == 300", 1);
+                    expect_rows(reader, "select * from common.test_txn where id < 30", 30);
+                }
+            }
+            catch (...)
+            {
+                updater.join();
+                throw;
+            }
+
+            updater.join();
+            if (failures != 0)
+            {
+                throw std::runtime_error("Updater failed while scans were running");
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_txn", 500);
+                expect_rows(engine, "select * from common.test_txn where payload == 'base'", 333);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Statement snapshot test passed." << std::endl;
+        }
+
+        void
+        run_session_commit_test()
+        {
+            const std::string db_name = make_test_db_name("txn_commit_test");
+            create_test_table(types::Config::std(db_name), 100);
+
+            {
+                engine::Engine writer;
+                writer.attach_db(db_name);
+                engine::Engine reader;
+                reader.attach_db(db_name);
+
+                writer.execute_query("begin");
+                for (int id = 100; id < 120; ++id)
+                {
+                    writer.execute_query(
+                        "insert into common.test_txn(id, payload) values (" + std::to_string(id) + ", 'txn')"
+                    );
+                }
+                writer.execute_query("delete from common.test_txn where id == 5");
+
+                expect_rows(writer, "select * from common.test_txn", 119);
+                expect_rows(writer, "select * from common.test_txn where id == 110", 1);
+                expect_rows(reader, "select * from common.test_txn", 100);
+                expect_rows(reader, "select * from common.test_txn where id == 110", 0);
+                expect_rows(reader, "select * from common.test_txn where id == 5", 1);
+
+                writer.execute_query("commit");
+
+                expect_rows(reader, "select * from common.test_txn", 119);
+                expect_rows(reader, "select * from common.test_txn where id == 110", 1);
+                expect_rows(reader, "select * from common.test_txn where id == 5", 0);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Session commit test passed." << std::endl;
+        }
+
+        void
+        run_session_rollback_test()
+        {
+            const std::string db_name = make_test_db_name("txn_rollback_test");
+            create_test_table(types::Config::std(db_name), 100);
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+
+                engine.execute_query("begin");
+                for (int id = 100; id < 150; ++id)
+                {
+                    engine.execute_query(
+                        "insert into common.test_txn(id, payload) values (" + std::to_string(id) + ", 'txn')"
+                    );
+                }
+                engine.execute_query("update common.test_txn set payload = 'changed' where id == 3");
+                engine.execute_query("delete from common.test_txn where id == 4");
+                expect_rows(engine, "select * from common.test_txn", 149);
+
+                engine.execute_query("rollback");
+
+                expect_rows(engine, "select * from common.test_txn", 100);
+                expect_rows(engine, "select * from common.test_txn where id == 120", 0);
+                expect_rows(engine, "select * from common.test_txn where id >= 100", 0);
+                expect_rows(engine, "select * from common.test_txn where id == 4", 1);
+                expect_rows(engine, "select * from common.test_txn where payload == 'changed'", 0);
+                expect_rows(engine, "select * from common.test_txn where id == 3", 1);
+
+                // The rolled back keys left the unique index too.
+                engine.execute_query("insert into common.test_txn(id, payload) values (120, 'again')");
+                expect_rows(engine, "select * from common.test_txn where id == 120", 1);
+                expect_failure(engine, "insert into common.test_txn(id, payload) values (4, 'again')");
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Session rollback test passed." << std::endl;
+        }
+
+        // A transaction reads the rows as they were when it began, through the index too.
+        void
+        run_snapshot_visibility_test()
+        {
+            const std::string db_name = make_test_db_name("txn_snapshot_test");
+            create_test_table(types::Config::std(db_name), 100);
+
+            {
+                engine::Engine reader;
+                reader.attach_db(db_name);
+                engine::Engine writer;
+                writer.attach_db(db_name);
+
+                reader.execute_query("begin");
+                expect_rows(reader, "select * from common.test_txn", 100);
+
+                for (int id = 100; id < 110; ++id)
+                {
+                    writer.execute_query(
+                        "insert into common.test_txn(id, payload) values (" + std::to_string(id) + ", 'new')"
+                    );
+                }
+                writer.execute_query("update common.test_txn set payload = 'new' where id == 3");
+                writer.execute_query("update common.test_txn set id = 500 where id == 10");
+                writer.execute_query("delete from common.test_txn where id == 4");
+
+                expect_rows(reader, "select * from common.test_txn", 100);
+                expect_rows(reader, "select * from common.test_txn where payload == 'new'", 0);
+                expect_rows(reader, "select * from common.test_txn where id == 105", 0);
+                expect_rows(reader, "select * from common.test_txn where id >= 100", 0);
+                expect_rows(reader, "select * from common.test_txn where id == 4", 1);
+                expect_rows(reader, "select * from common.test_txn where id == 10", 1);
+                expect_rows(reader, "select * from common.test_txn where id == 500", 0);
+
+                expect_rows(writer, "select * from common.test_txn", 109);
+                expect_rows(writer, "select * from common.test_txn where payload == 'new'", 11);
+                expect_rows(writer, "select * from common.test_txn where id == 10", 0);
+                expect_rows(writer, "select * from common.test_txn where id == 500", 1);
+
+                reader.execute_query("commit");
+                expect_rows(reader, "select * from common.test_txn", 109);
+                expect_rows(reader, "select * from common.test_txn where id == 4", 0);
+                expect_rows(reader, "select * from common.test_txn where id == 500", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Snapshot visibility test passed." << std::endl;
+        }
+
+        // The first of two transactions writing one row wins: the second fails while the
+        // first is in progress or once it committed after the second began, and goes ahead
+        // once the first rolled back.
+        void
+        run_write_conflict_test()
+        {
+            const std::string db_name = make_test_db_name("txn_write_conflict_test");
+            create_test_table(types::Config::std(db_name), 100);
+
+            {
+                engine::Engine first;
+                first.attach_db(db_name);
+                engine::Engine second;
+                second.attach_db(db_name);
+
+                first.execute_query("begin");
+                second.execute_query("begin");
+                first.execute_query("update common.test_txn set payload = 'first' where id == 3");
+
+                expect_failure(second, "update common.test_txn set payload = 'second' where id == 3");
+                expect_failure(second, "delete from common.test_txn where id == 3");
+
+                first.execute_query("rollback");
+                second.execute_query("update common.test_txn set payload = 'second' where id == 3");
+                second.execute_query("commit");
+
+                expect_rows(first, "select * from common.test_txn where id == 3", 1);
+                expect_rows(first, "select * from common.test_txn where payload == 'second'", 1);
+                expect_rows(first, "select * from common.test_txn where payload == 'first'", 0);
+
+                second.execute_query("begin");
+                first.execute_query("update common.test_txn set payload = 'committed' where id == 5");
+
+                expect_failure(second, "delete from common.test_txn where id == 5");
+                expect_failure(second, "update common.test_txn set payload = 'late' where id == 5");
+                second.execute_query("update common.test_txn set payload = 'other' where id == 6");
+                second.execute_query("commit");
+
+                expect_rows(first, "select * from common.test_txn", 100);
+                expect_rows(first, "select * from common.test_txn where payload == 'committed'", 1);
+                expect_rows(first, "select * from common.test_txn where payload == 'late'", 0);
+                expect_rows(first, "select * from common.test_txn where payload == 'other'", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Write conflict test passed." << std::endl;
+        }
+
+        // A key deleted by a transaction still in progress stays taken: the deletion may be
+        // rolled back and bring the row back. Once it committed, or within the deleting
+        // transaction itself, the key is free again.
+        void
+        run_unique_key_delete_test()
+        {
+            const std::string db_name = make_test_db_name("txn_unique_delete_test");
+            create_test_table(types::Config::std(db_name), 100);
+
+            {
+                engine::Engine first;
+                first.attach_db(db_name);
+                engine::Engine second;
+                second.attach_db(db_name);
+
+                first.execute_query("begin");
+                first.execute_query("delete from common.test_txn where id == 7");
+                expect_failure(second, "insert into common.test_txn(id, payload) values (7, 'second')");
+                first.execute_query("rollback");
+
+                expect_rows(second, "select * from common.test_txn where id == 7", 1);
+                expect_rows(second, "select * from common.test_txn where payload == 'second'", 0);
+
+                first.execute_query("delete from common.test_txn where id == 8");
+                second.execute_query("insert into common.test_txn(id, payload) values (8, 'second')");
+
+                first.execute_query("begin");
+                first.execute_query("delete from common.test_txn where id == 9");
+                first.execute_query("insert into common.test_txn(id, payload) values (9, 'first')");
+                first.execute_query("commit");
+
+                expect_rows(second, "select * from common.test_txn", 100);
+                expect_rows(second, "select * from common.test_txn where id == 8", 1);
+                expect_rows(second, "select * from common.test_txn where payload == 'second'", 1);
+                expect_rows(second, "select * from common.test_txn where payload == 'first'", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Unique key delete test passed." << std::endl;
+        }
+
+        std::string
+        make_failing_insert(int first_id, int rows)
+        {
+            // The last row repeats a key the table already has.
+            std::string query = "insert into common.test_txn(id, payload) values ";
+            for (int id = first_id; id < first_id + rows; ++id)
+            {
+                query += "(" + std::to_string(id) + ", 'batch'), ";
+            }
+            return query + "(5, 'duplicate')";
+        }
+
+        // A statement that fails takes back what it did, and only that.
+        void
+        run_statement_rollback_test()
+        {
+            const std::string db_name = make_test_db_name("txn_statement_test");
+            create_test_table(types::Config::std(db_name), 100);
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+
+                expect_failure(engine, make_failing_insert(100, 200));
+                expect_rows(engine, "select * from common.test_txn", 100);
+                expect_rows(engine, "select * from common.test_txn where id == 150", 0);
+                engine.execute_query("insert into common.test_txn(id, payload) values (150, 'again')");
+                expect_rows(engine, "select * from common.test_txn where id == 150", 1);
+
+                expect_failure(engine, "update common.test_txn set id = 1 where id == 2");
+                expect_rows(engine, "select * from common.test_txn where id == 2", 1);
+                expect_rows(engine, "select * from common.test_txn where id == 1", 1);
+
+                engine.execute_query("begin");
+                engine.execute_query("insert into common.test_txn(id, payload) values (300, 'kept')");
+                expect_failure(engine, make_failing_insert(400, 200));
+                expect_rows(engine, "select * from common.test_txn where id == 300", 1);
+                expect_rows(engine, "select * from common.test_txn where id == 450", 0);
+                engine.execute_query("commit");
+
+                engine::Engine reader;
+                reader.attach_db(db_name);
+                expect_rows(reader, "select * from common.test_txn", 102);
+                expect_rows(reader, "select * from common.test_txn where id == 300", 1);
+                expect_rows(reader, "select * from common.test_txn where id >= 400", 0);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Statement rollback test passed." << std::endl;
+        }
+
+        // A transaction left open by a crash is undone when the database is reopened,
+        // including pages the checkpointer wrote while it was running.
+        void
+        run_restart_undo_test()
+        {
+            const std::string db_name = make_test_db_name("txn_restart_undo_test");
+            auto config = types::Config::std(db_name);
+            config.checkpoint_interval_ms = 50;
+            create_test_table(config, 100);
+
+            run_and_crash(
+                db_name,
+                [](engine::Engine& engine)
+                {
+                    engine.execute_query("begin");
+                    for (int id = 1000; id < 1100; ++id)
+                    {
+                        engine.execute_query(
+                            "insert into common.test_txn(id, payload) values (" + std::to_string(id)
+                            + ", 'lost')"
+                        );
+                    }
+                    engine.execute_query("update common.test_txn set payload = 'lost' where id == 3");
+                    engine.execute_query("delete from common.test_txn where id == 7");
+                    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+                }
+            );
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+
+                expect_rows(engine, "select * from common.test_txn", 100);
+                expect_rows(engine, "select * from common.test_txn where id == 1050", 0);
+                expect_rows(engine, "select * from common.test_txn where id >= 1000", 0);
+                expect_rows(engine, "select * from common.test_txn where payload == 'lost'", 0);
+                expect_rows(engine, "select * from common.test_txn where id == 7", 1);
+
+                engine.execute_query("insert into common.test_txn(id, payload) values (1050, 'again')");
+                expect_rows(engine, "select * from common.test_txn where id == 1050", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Restart undo test passed." << std::endl;
+        }
+    }
+
+    void
+    run_transaction_tests()
+    {
+        run_concurrent_workload_test();
+        run_statement_snapshot_test();
+        run_session_commit_test();
+        run_session_rollback_test();
+        run_snapshot_visibility_test();
+        run_write_conflict_test();
+        run_unique_key_delete_test();
+        run_statement_rollback_test();
+        run_restart_undo_test();
+    }
+}
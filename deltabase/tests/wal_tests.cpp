@@ -0,0 +1,541 @@
+//
+// Created by poproshaikin on 10/17/26.
+//
+
+#include "test_support.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace tests
+{
+    namespace
+    {
+        constexpr int WRITERS = 4;
+        constexpr int ROWS_PER_WRITER = 250;
+
+        types::Config
+        make_small_segment_config(const std::string& db_name, uint32_t checkpoint_interval_ms)
+        {
+            auto config = types::Config::std(db_name);
+            config.wal_segment_bytes = 16 * 1024;
+            config.checkpoint_interval_ms = checkpoint_interval_ms;
+            return config;
+        }
+
+        void
+        create_test_table(const types::Config& config)
+        {
+            remove_test_db(*config.db_name);
+
+            engine::Engine bootstrap;
+            bootstrap.create_db(config);
+            bootstrap.execute_query("create table common.test_wal(id integer, payload string)");
+        }
+
+        // Commits ROWS_PER_WRITER rows from each of WRITERS sessions at once, ids from
+        // first_id on.
+        void
+        insert_concurrently(const std::string& db_name, int first_id)
+        {
+            std::atomic<int> failed_writers = 0;
+            std::vector<std::thread> writers;
+            for (int writer = 0; writer < WRITERS; ++writer)
+            {
+                writers.emplace_back(
+                    [&, writer]
+                    {
+                        try
+                        {
+                            engine::Engine engine;
+                            engine.attach_db(db_name);
+
+                            const int first = first_id + writer * ROWS_PER_WRITER;
+                            for (int id = first; id < first + ROWS_PER_WRITER; ++id)
+                            {
+                                engine.execute_query(
+                                    "insert into common.test_wal(id, payload) values ("
+                                    + std::to_string(id) + ", 'writer_" + std::to_string(writer) + "')"
+                                );
+                            }
+                        }
+                        catch (const std::exception&)
+                        {
+                            failed_writers++;
+                        }
+                    }
+                );
+            }
+
+            for (auto& writer : writers)
+            {
+                writer.join();
+            }
+
+            if (failed_writers != 0)
+            {
+                throw std::runtime_error("At least one writer failed during concurrent commits");
+            }
+        }
+
+        void
+        expect_writer_rows(engine::Engine& engine, int rows_per_writer)
+        {
+            for (int writer = 0; writer < WRITERS; ++writer)
+            {
+                expect_rows(
+                    engine,
+                    "select * from common.test_wal where payload == 'writer_" + std::to_string(writer) + "'",
+                    rows_per_writer
+                );
+            }
+        }
+
+        // Commits that share one WAL flush are each durable once they return: a crash right
+        // after the last one loses none of them.
+        void
+        run_group_commit_test()
+        {
+            const std::string db_name = make_test_db_name("wal_group_commit_test");
+
+            auto config = types::Config::std(db_name);
+            config.wal_commit_delay_us = 200;
+            config.wal_group_commit_records = 8;
+            create_test_table(config);
+
+            run_and_crash(db_name, [&](engine::Engine&) { insert_concurrently(db_name, 0); });
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_wal", WRITERS * ROWS_PER_WRITER);
+                expect_writer_rows(engine, ROWS_PER_WRITER);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Group commit test passed." << std::endl;
+        }
+
+        size_t
+        count_wal_files(const std::string& db_name, const std::string& extension)
+        {
+            const auto wal_dir = misc::StaticStorage::get_executable_path() / "data" / db_name / "wal";
+            size_t files = 0;
+            for (const auto& entry : std::filesystem::directory_iterator(wal_dir))
+            {
+                if (entry.path().extension() == extension)
+                {
+                    files++;
+                }
+            }
+
+            return files;
+        }
+
+        // The WAL keeps only a tail of its records in memory; recovery after a crash streams
+        // the older ones from sealed segments through their offset indexes.
+        void
+        run_wal_tail_test()
+        {
+            const std::string db_name = make_test_db_name("wal_tail_test");
+            create_test_table(make_small_segment_config(db_name, 60000));
+
+            // Several records per commit, far more than the in-memory tail holds.
+            constexpr int rows = 2000;
+            run_and_crash(
+                db_name,
+                [](engine::Engine& engine)
+                {
+                    for (int id = 0; id < rows; ++id)
+                    {
+                        engine.execute_query(
+                            "insert into common.test_wal(id, payload) values (" + std::to_string(id)
+                            + ", 'row_" + std::to_string(id) + "')"
+                        );
+                    }
+                }
+            );
+
+            if (count_wal_files(db_name, ".idx") == 0)
+            {
+                throw std::runtime_error("Sealed WAL segments have no offset index");
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_wal", rows);
+                expect_rows(engine, "select * from common.test_wal where payload == 'row_3'", 1);
+                expect_rows(engine, "select * from common.test_wal where payload == 'row_1999'", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "WAL tail test passed." << std::endl;
+        }
+
+        // Checkpoints taken while commits go on let the WAL drop the segments before their
+        // redo point, and recovery then starts from the last checkpoint.
+        void
+        run_checkpoint_test()
+        {
+            const std::string db_name = make_test_db_name("wal_checkpoint_test");
+
+            auto config = types::Config::std(db_name);
+            config.checkpoint_interval_ms = 50;
+            create_test_table(config);
+
+            // Five segments of records or more.
+            constexpr int rows = 1800;
+            run_and_crash(
+                db_name,
+                [](engine::Engine& engine)
+                {
+                    for (int id = 0; id < rows; ++id)
+                    {
+                        engine.execute_query(
+                            "insert into common.test_wal(id, payload) values (" + std::to_string(id)
+                            + ", 'row_" + std::to_string(id) + "')"
+                        );
+                    }
+                }
+            );
+
+            if (count_wal_files(db_name, ".wal") > 3)
+            {
+                throw std::runtime_error("Checkpoints did not drop old WAL segments");
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_wal", rows);
+                expect_rows(engine, "select * from common.test_wal where payload == 'row_0'", 1);
+                expect_rows(engine, "select * from common.test_wal where payload == 'row_1799'", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Checkpoint test passed." << std::endl;
+        }
+
+        // Concurrent commits fill several segments; a clean reopen and a reopen after a
+        // crash both read every committed record back across the segment boundaries.
+        void
+        run_wal_rollover_test()
+        {
+            const std::string db_name = make_test_db_name("wal_rollover_test");
+            create_test_table(make_small_segment_config(db_name, 60000));
+
+            constexpr int rows = WRITERS * ROWS_PER_WRITER;
+            insert_concurrently(db_name, 0);
+
+            if (count_wal_files(db_name, ".wal") < 3)
+            {
+                throw std::runtime_error("Expected the WAL to roll over to several segments");
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_wal", rows);
+                expect_writer_rows(engine, ROWS_PER_WRITER);
+            }
+
+            run_and_crash(
+                db_name,
+                [](engine::Engine& engine)
+                {
+                    for (int id = rows; id < rows + 500; ++id)
+                    {
+                        engine.execute_query(
+                            "insert into common.test_wal(id, payload) values (" + std::to_string(id)
+                            + ", 'before_crash')"
+                        );
+                    }
+                }
+            );
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_wal", rows + 500);
+                expect_rows(engine, "select * from common.test_wal where payload == 'before_crash'", 500);
+                expect_rows(engine, "select * from common.test_wal where id == 1499", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "WAL rollover test passed." << std::endl;
+        }
+
+        // With frequent checkpoints, segments recovery no longer needs are recycled while
+        // commits go on; what a crash leaves is still recovered from the ones kept.
+        void
+        run_wal_recycle_test()
+        {
+            const std::string db_name = make_test_db_name("wal_recycle_test");
+            create_test_table(make_small_segment_config(db_name, 50));
+
+            constexpr int rows = WRITERS * ROWS_PER_WRITER;
+            insert_concurrently(db_name, 0);
+
+            run_and_crash(
+                db_name,
+                [](engine::Engine& engine)
+                {
+                    for (int id = rows; id < rows + 500; ++id)
+                    {
+                        engine.execute_query(
+                            "insert into common.test_wal(id, payload) values (" + std::to_string(id)
+                            + ", 'before_crash')"
+                        );
+                    }
+                }
+            );
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_wal", rows + 500);
+                expect_rows(engine, "select * from common.test_wal where id == 777", 1);
+                expect_rows(engine, "select * from common.test_wal where payload == 'before_crash'", 500);
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                engine.execute_query("insert into common.test_wal(id, payload) values (5000, 'reopened')");
+                expect_rows(engine, "select * from common.test_wal", rows + 501);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "WAL recycle test passed." << std::endl;
+        }
+
+        // Sessions appending multi-record statements at once, across segment boundaries,
+        // get distinct LSNs: after a crash every row comes back exactly once.
+        void
+        run_concurrent_append_test()
+        {
+            const std::string db_name = make_test_db_name("wal_concurrent_append_test");
+            create_test_table(make_small_segment_config(db_name, 60000));
+
+            constexpr int batches = 25;
+            constexpr int batch_rows = 10;
+            run_and_crash(
+                db_name,
+                [&](engine::Engine&)
+                {
+                    std::atomic<int> failed_writers = 0;
+                    std::vector<std::thread> writers;
+                    for (int writer = 0; writer < WRITERS; ++writer)
+                    {
+                        writers.emplace_back(
+                            [&, writer]
+                            {
+                                try
+                                {
+                                    engine::Engine engine;
+                                    engine.attach_db(db_name);
+
+                                    const std::string payload = "'writer_" + std::to_string(writer) + "'";
+                                    int id = writer * batches * batch_rows;
+                                    for (int batch = 0; batch < batches; ++batch)
+                                    {
+                                        std::string query = "insert into common.test_wal(id, payload) values ";
+                                        for (int row = 0; row < batch_rows; ++row, ++id)
+                                        {
+                                            query += "(" + std::to_string(id) + ", " + payload + "), ";
+                                        }
+                                        query.resize(query.size() - 2);
+                                        engine.execute_query(query);
+                                    }
+                                }
+                                catch (const std::exception&)
+                                {
+                                    failed_writers++;
+                                }
+                            }
+                        );
+                    }
+
+                    for (auto& writer : writers)
+                    {
+                        writer.join();
+                    }
+
+                    if (failed_writers != 0)
+                    {
+                        throw std::runtime_error("At least one writer failed during concurrent appends");
+                    }
+                }
+            );
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_wal", WRITERS * batches * batch_rows);
+                expect_writer_rows(engine, batches * batch_rows);
+                expect_rows(engine, "select * from common.test_wal where id == 777", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Concurrent append test passed." << std::endl;
+        }
+
+        // A transaction logging more records than the append ring holds has to flush its
+        // own first records to get their slots back, and still commits all of them.
+        void
+        run_wal_ring_wrap_test()
+        {
+            const std::string db_name = make_test_db_name("wal_ring_wrap_test");
+            create_test_table(types::Config::std(db_name));
+
+            constexpr int rows = 5000;
+            run_and_crash(
+                db_name,
+                [&](engine::Engine& engine)
+                {
+                    engine.execute_query("begin");
+                    for (int id = 0; id < rows; ++id)
+                    {
+                        engine.execute_query(
+                            "insert into common.test_wal(id, payload) values ("
+                            + std::to_string(id) + ", 'wrapped')"
+                        );
+                    }
+                    engine.execute_query("commit");
+                }
+            );
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_wal where payload == 'wrapped'", rows);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "WAL ring wrap test passed." << std::endl;
+        }
+
+        // A file in the WAL directory that is neither a segment nor a segment index stops
+        // the database from opening instead of having its records skipped.
+        void
+        run_foreign_wal_file_test()
+        {
+            const std::string db_name = make_test_db_name("wal_foreign_file_test");
+            create_test_table(types::Config::std(db_name));
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                engine.execute_query("insert into common.test_wal(id, payload) values (1, 'kept')");
+            }
+
+            const auto wal_dir = misc::StaticStorage::get_executable_path() / "data" / db_name / "wal";
+            for (const auto* name : {"0000000000000001.log", "notes.txt"})
+            {
+                const auto path = wal_dir / name;
+                std::ofstream(path) << "not a segment";
+
+                bool refused = false;
+                try
+                {
+                    engine::Engine engine;
+                    engine.attach_db(db_name);
+                }
+                catch (const std::exception&)
+                {
+                    refused = true;
+                }
+
+                if (!refused)
+                {
+                    throw std::runtime_error(
+                        std::string("Database opened with ") + name + " in its WAL directory"
+                    );
+                }
+
+                std::filesystem::remove(path);
+            }
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_wal where payload == 'kept'", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Foreign WAL file test passed." << std::endl;
+        }
+
+        // A database whose WAL is still in the <first lsn>_<last lsn> layout used before
+        // segments is refused with an error that says how to move its data, and nothing in
+        // the WAL directory is touched.
+        void
+        run_legacy_wal_test()
+        {
+            const std::string db_name = make_test_db_name("wal_legacy_layout_test");
+            create_test_table(types::Config::std(db_name));
+
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                engine.execute_query("insert into common.test_wal(id, payload) values (1, 'kept')");
+            }
+
+            // Only the name matters: the file is refused before it is read.
+            const auto wal_dir = misc::StaticStorage::get_executable_path() / "data" / db_name / "wal";
+            const auto legacy = wal_dir / "1_1000";
+            std::ofstream(legacy, std::ios::binary) << "records of an older version";
+
+            std::string error;
+            try
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+            }
+            catch (const std::exception& e)
+            {
+                error = e.what();
+            }
+
+            if (error.find("older version") == std::string::npos)
+            {
+                throw std::runtime_error(
+                    "Database with a WAL file of the old layout was not refused as such: " + error
+                );
+            }
+
+            if (!std::filesystem::exists(legacy))
+            {
+                throw std::runtime_error("The refused WAL file was removed");
+            }
+
+            std::filesystem::remove(legacy);
+            {
+                engine::Engine engine;
+                engine.attach_db(db_name);
+                expect_rows(engine, "select * from common.test_wal where payload == 'kept'", 1);
+            }
+
+            remove_test_db(db_name);
+            std::cout << "Legacy WAL layout test passed." << std::endl;
+        }
+    }
+
+    void
+    run_wal_tests()
+    {
+        run_group_commit_test();
+        run_wal_tail_test();
+        run_checkpoint_test();
+        run_wal_rollover_test();
+        run_wal_recycle_test();
+        run_concurrent_append_test();
+        run_wal_ring_wrap_test();
+        run_foreign_wal_file_test();
+        run_legacy_wal_test();
+    }
+}